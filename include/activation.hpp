@@ -0,0 +1,29 @@
+#pragma once
+
+#include "engine.hpp"
+#include <Eigen/Dense>
+#include <optional>
+#include <string>
+
+namespace micrograd {
+
+enum class Activation {
+    Identity,
+    ReLU,
+    Sigmoid,
+    Tanh,
+    GELU,
+    LeakyReLU,
+    SiLU
+};
+
+// Registry lookups by name ("relu", "gelu", ...), e.g. for model configs
+std::optional<Activation> activation_from_name(const std::string& name);
+const char* activation_name(Activation activation);
+
+// Applies the activation as a graph op
+Value activate(Activation activation, const Value& x, double negative_slope = 0.01);
+// Graph-free version for inference
+Eigen::MatrixXd activate(Activation activation, const Eigen::MatrixXd& x, double negative_slope = 0.01);
+
+} // namespace micrograd
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <cstdint>
+
+namespace micrograd {
+
+// Random image augmentation for batches whose rows are row-major images with
+// pixels in [0, 1], as returned by MNISTLoader::get_batch. Each row gets its
+// own random affine warp (rotation, scale, shift) plus an optional elastic
+// distortion, resampled bilinearly with zero padding, then optional Gaussian
+// noise. Rows are processed in parallel on the thread pool from
+// parallel.hpp. Like Dropout, each row's randomness is derived from
+// (seed, sample counter), so results do not depend on the thread count.
+class Augmenter {
+public:
+    struct Options {
+        int image_rows = 28;
+        int image_cols = 28;
+        // Rotation drawn uniformly from [-max_rotation, max_rotation] degrees
+        double max_rotation = 10.0;
+        // Scale drawn uniformly from [1 - max_scale, 1 + max_scale]
+        double max_scale = 0.1;
+        // Shift per axis drawn uniformly from [-max_shift, max_shift] pixels
+        double max_shift = 2.0;
+        // Elastic distortion: a uniform random displacement field smoothed by a
+        // Gaussian of width elastic_sigma and scaled by elastic_alpha pixels.
+        // Disabled when elastic_alpha is 0.
+        double elastic_alpha = 0.0;
+        double elastic_sigma = 4.0;
+        // Standard deviation of additive noise; the result is clamped to [0, 1]
+        double noise_std = 0.0;
+    };
+
+    Options options;
+    uint64_t seed;
+    // Samples augmented so far
+    uint64_t counter = 0;
+
+    explicit Augmenter(Options options);
+    Augmenter();
+
+    // Augments every row of batch in place
+    void apply(Eigen::MatrixXd& batch);
+
+private:
+    // Rows of a column-major batch are strided
+    void augment_row(Eigen::Ref<Eigen::RowVectorXd, 0, Eigen::InnerStride<>> image, uint64_t sample) const;
+
+    // Pixel coordinates relative to the image centre, in row-major pixel order
+    Eigen::ArrayXd grid_x;
+    Eigen::ArrayXd grid_y;
+    // Gaussian smoothing matrices for the elastic field: field -> smooth_rows * field * smooth_cols^T
+    Eigen::MatrixXd smooth_rows;
+    Eigen::MatrixXd smooth_cols;
+};
+
+} // namespace micrograd
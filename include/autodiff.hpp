@@ -0,0 +1,47 @@
+#pragma once
+
+#include "engine.hpp"
+#include <Eigen/Dense>
+#include <functional>
+#include <vector>
+
+namespace micrograd {
+
+// Gradients of output with respect to each of inputs, seeded with grad_output
+// (all ones when null). Gradients are partial: the walk stops at the inputs,
+// so a path from one input through another is not followed. Inputs that
+// output does not depend on get zeros. The graph is left in place and
+// parameter grads are untouched.
+//
+// With create_graph the backward pass is built from Value ops (each node's
+// _backward_graph), so the returned gradients can be differentiated again;
+// an op on the way without one throws std::invalid_argument. Otherwise it
+// runs the matrix backward and returns constants.
+std::vector<Value> grad(const Value& output, const std::vector<Value*>& inputs,
+                        const Value* grad_output = nullptr, bool create_graph = false);
+
+// v^T J for y = f(): one forward and one backward pass
+std::vector<Eigen::MatrixXd> vjp(const std::function<Value()>& f, const std::vector<Value*>& inputs,
+                                 const Eigen::MatrixXd& v);
+
+// J t for y = f(), where t holds one tangent per input. Computed by
+// differentiating the (linear in u) vjp u^T J with respect to u, which costs
+// one forward and two backward passes.
+Eigen::MatrixXd jvp(const std::function<Value()>& f, const std::vector<Value*>& inputs,
+                    const std::vector<Eigen::MatrixXd>& tangents);
+
+// H v for a scalar loss f(): differentiates g . v, where g is the gradient
+// built with create_graph. Exact, unlike finite differences of gradients.
+std::vector<Eigen::MatrixXd> hvp(const std::function<Value()>& f, const std::vector<Value*>& params,
+                                 const std::vector<Eigen::MatrixXd>& vs);
+
+// Checks the gradients of f at the given points against central differences.
+// The output is weighted by a fixed random matrix before differentiating, so
+// every output element takes part. Both backward implementations are
+// checked: the matrix one and the Value-op one used with create_graph.
+// Returns the largest |analytic - numeric| / max(1, |numeric|) over all
+// input elements.
+double gradcheck(const std::function<Value(const std::vector<Value>&)>& f,
+                 const std::vector<Eigen::MatrixXd>& inputs, double eps = 1e-6);
+
+} // namespace micrograd
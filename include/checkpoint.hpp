@@ -0,0 +1,55 @@
+#pragma once
+
+#include "engine.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace micrograd {
+
+class Module;
+
+// Writes parameter snapshots on a background thread so that training is not
+// blocked on file I/O. Each file is written to a temporary path and renamed
+// over the current one; the previous max_retained - 1 checkpoints are kept as
+// path.1, path.2, ... (path.1 being the most recent).
+class AsyncCheckpointer {
+public:
+    AsyncCheckpointer(const std::string& path, int max_retained = 1);
+    ~AsyncCheckpointer();
+
+    AsyncCheckpointer(const AsyncCheckpointer&) = delete;
+    AsyncCheckpointer& operator=(const AsyncCheckpointer&) = delete;
+
+    // Copies the parameter data into the staging buffer and returns. A snapshot
+    // that is still waiting for the writer is replaced by the newer one.
+    void save(const std::vector<Value*>& params);
+    // Snapshots Module::state(), i.e. the parameters followed by buffers such as running statistics
+    void save(Module& model);
+    // Blocks until every queued snapshot has been written.
+    void wait();
+    int num_written() const;
+
+private:
+    void run();
+    bool write(const std::vector<Eigen::MatrixXd>& snapshot);
+    bool rotate();
+
+    std::string path;
+    int max_retained;
+
+    std::vector<Eigen::MatrixXd> staging;
+    std::vector<Eigen::MatrixXd> writing;
+    bool pending = false;
+    bool busy = false;
+    bool stopping = false;
+    int written = 0;
+
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    std::thread writer;
+};
+
+} // namespace micrograd
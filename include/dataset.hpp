@@ -0,0 +1,174 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <cstdint>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace micrograd {
+
+// Random-access source of labelled feature rows. Out-of-range reads are
+// reported and return no rows.
+class Dataset {
+public:
+    virtual ~Dataset() = default;
+
+    virtual long long size() const = 0;
+    virtual int num_features() const = 0;
+    // Reads records [begin, begin + count) into the rows of features and labels.
+    // Must be safe to call from several threads at once.
+    virtual void read(long long begin, int count, Eigen::MatrixXd& features, Eigen::VectorXi& labels) const = 0;
+};
+
+// Dataset over matrices already in memory
+class TensorDataset : public Dataset {
+public:
+    Eigen::MatrixXd features;
+    Eigen::VectorXi labels;
+
+    TensorDataset(const Eigen::MatrixXd& features, const Eigen::VectorXi& labels);
+
+    long long size() const override { return features.rows(); }
+    int num_features() const override { return features.cols(); }
+    void read(long long begin, int count, Eigen::MatrixXd& features, Eigen::VectorXi& labels) const override;
+};
+
+enum class FeatureType : uint32_t {
+    UInt8 = 0,
+    Float16 = 1
+};
+
+// Sharded binary format. `<prefix>.index` holds the header
+//   "MGDS" | uint32 version | uint32 feature type | uint32 num_features |
+//   uint32 records_per_shard | uint64 num_records | float64 scale
+// and the records live in `<prefix>-NNNNN.shard`, records_per_shard per file
+// (the last may be short). A record is an int32 label followed by the
+// features as uint8 or fp16, all little-endian. Records have a fixed width,
+// so record i is located by arithmetic alone. Features are multiplied by
+// `scale` when read, e.g. 1/255 for pixels.
+class ShardWriter {
+public:
+    ShardWriter(const std::string& prefix, int num_features, FeatureType type, double scale = 1.0,
+                int records_per_shard = 65536);
+    ~ShardWriter();
+
+    ShardWriter(const ShardWriter&) = delete;
+    ShardWriter& operator=(const ShardWriter&) = delete;
+
+    // Features are stored unscaled: uint8 values are rounded and clamped to [0, 255].
+    // Labels must be non-negative.
+    bool write(const Eigen::Ref<const Eigen::RowVectorXd>& features, int label);
+    // Finishes the last shard and writes the index. Nothing is readable as a
+    // dataset until this succeeds; on failure the files are removed as by abort().
+    bool close();
+    // Deletes the shards written so far and the index, e.g. after a failed
+    // conversion. The destructor calls it if close() was never called.
+    void abort();
+
+    long long size() const { return num_records; }
+
+private:
+    bool open_shard();
+
+    std::string prefix;
+    int num_features;
+    FeatureType type;
+    double scale;
+    int records_per_shard;
+    long long num_records = 0;
+    // Shard files created so far
+    int shards = 0;
+    std::ofstream shard;
+    std::vector<unsigned char> record;
+    bool ok = true;
+    bool closed = false;
+};
+
+class ShardedDataset : public Dataset {
+public:
+    ShardedDataset() = default;
+    ~ShardedDataset() override;
+
+    ShardedDataset(const ShardedDataset&) = delete;
+    ShardedDataset& operator=(const ShardedDataset&) = delete;
+
+    bool open(const std::string& prefix);
+
+    long long size() const override { return num_records; }
+    int num_features() const override { return features_per_record; }
+    int num_shards() const { return shard_fds.size(); }
+    int shard_size() const { return records_per_shard; }
+    // Reads with one pread per shard touched. A negative label, which only a
+    // corrupt or foreign file can hold, is reported and no rows are returned.
+    void read(long long begin, int count, Eigen::MatrixXd& features, Eigen::VectorXi& labels) const override;
+
+private:
+    void close();
+    int record_bytes() const;
+
+    FeatureType type = FeatureType::UInt8;
+    int features_per_record = 0;
+    int records_per_shard = 0;
+    long long num_records = 0;
+    double scale = 1.0;
+    std::vector<int> shard_fds;
+};
+
+// Streams a dataset in batches. Without a shuffle buffer records arrive in
+// storage order. With one, the dataset is read in blocks of block_size
+// consecutive records, visited in a random order, and every sample is drawn
+// at random from a buffer of shuffle_buffer records. Reads stay sequential
+// while samples still mix across blocks and shards. Randomness comes from
+// the global generator.
+class DataLoader {
+public:
+    struct Options {
+        int batch_size = 128;
+        int shuffle_buffer = 0;
+        int block_size = 1024;
+    };
+
+    DataLoader(const Dataset& dataset, Options options);
+    explicit DataLoader(const Dataset& dataset);
+
+    // Starts a new pass over the dataset
+    void reset();
+    // Fills the next batch; returns false once the pass is exhausted, or from
+    // the first read that fails until the next reset()
+    bool next(Eigen::MatrixXd& features, Eigen::VectorXi& labels);
+
+    int batch_size() const { return options.batch_size; }
+    int num_batches() const;
+    const Dataset& dataset() const { return source; }
+
+private:
+    // Appends the next block to the shuffle buffer; false if it cannot be read
+    bool load_block();
+
+    const Dataset& source;
+    Options options;
+    // Shuffles for this loader only, since next() may run on a prefetch
+    // thread; seeded from global_generator() on construction
+    std::mt19937_64 generator;
+    long long cursor = 0;
+    std::vector<long long> blocks;
+    size_t next_block = 0;
+    Eigen::MatrixXd buffer;
+    Eigen::VectorXi buffer_labels;
+    int fill = 0;
+    bool failed = false;
+    Eigen::MatrixXd block_features;
+    Eigen::VectorXi block_labels;
+};
+
+// Streams an IDX image/label pair (e.g. MNIST) into uint8 shards read back
+// scaled to [0, 1], matching MNISTLoader
+bool convert_idx(const std::string& images_path, const std::string& labels_path, const std::string& prefix,
+                 int records_per_shard = 65536);
+// Converts a CSV file of numeric columns, one of which holds the integer label
+bool convert_csv(const std::string& csv_path, const std::string& prefix, int label_column = 0,
+                 bool has_header = true, FeatureType type = FeatureType::Float16, int records_per_shard = 65536);
+
+} // namespace micrograd
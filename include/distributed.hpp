@@ -0,0 +1,145 @@
+#pragma once
+
+#include "nn.hpp"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace micrograd {
+
+enum class Compression {
+    None,
+    // Values travel as fp16; partial sums are still accumulated in double
+    FP16,
+    // Each rank sends only its largest-magnitude entries and carries the rest
+    // over to the next step (error feedback)
+    TopK
+};
+
+// One process's end of a ring of world_size processes connected over TCP.
+// Rank r listens on base_port + r, connects to rank r + 1 and accepts rank
+// r - 1, so the whole group can run on one host over loopback. Collectives
+// must be called by every rank in the same order.
+class ProcessGroup {
+public:
+    const int rank;
+    const int world_size;
+
+    ProcessGroup(int rank, int world_size, const std::string& host = "127.0.0.1", int base_port = 29500);
+    ~ProcessGroup();
+
+    ProcessGroup(const ProcessGroup&) = delete;
+    ProcessGroup& operator=(const ProcessGroup&) = delete;
+
+    // Sets up the ring, retrying the connection for up to timeout_ms while the
+    // neighbour starts
+    bool connect(int timeout_ms = 10000);
+
+    // Sums data over all ranks in place with a ring reduce-scatter followed by
+    // an all-gather. Every rank ends up with identical values.
+    bool all_reduce(double* data, int count, Compression compression = Compression::None);
+    // Sums sparse contributions into the dense out[count]. The contributions
+    // are all-gathered around the ring and added in rank order, so every rank
+    // ends up with identical values.
+    bool sparse_all_reduce(const std::vector<int>& indices, const std::vector<double>& values, double* out, int count);
+    // Replaces data with root's copy
+    bool broadcast(double* data, int count, int root = 0);
+
+    long long bytes_sent() const { return sent; }
+
+private:
+    // Sends to the next rank while receiving from the previous one
+    bool exchange(const void* send_buf, size_t send_bytes, void* recv_buf, size_t recv_bytes);
+
+    std::string host;
+    int base_port;
+    int listen_fd = -1;
+    int next_fd = -1;
+    int prev_fd = -1;
+    long long sent = 0;
+};
+
+struct CommStats {
+    // Time the communication thread spent reducing buckets
+    double communication_seconds = 0.0;
+    // Part of it that synchronize() waited for, i.e. not hidden behind backward
+    double blocked_seconds = 0.0;
+    long long bytes_sent = 0;
+    int steps = 0;
+};
+
+// Data-parallel training across a ProcessGroup. Every rank runs forward and
+// backward on its own shard; gradients are then averaged over the ranks so
+// an unchanged Optimizer::step() applies the same update everywhere.
+// Parameters are grouped into buckets in reverse order, since the last
+// layers' gradients are ready first. With overlap on, a bucket is reduced on
+// a background thread as soon as its gradients are complete, while backward
+// continues through the earlier layers.
+class DistributedDataParallel {
+public:
+    struct Options {
+        Compression compression = Compression::None;
+        // Fraction of each bucket's entries a rank sends under TopK
+        double topk_ratio = 0.01;
+        // Target bucket size in doubles
+        int bucket_size = 1 << 16;
+        bool overlap = true;
+    };
+
+    // When false, backward() only accumulates local gradients, e.g. for all
+    // but the last micro-batch of a gradient accumulation step
+    bool require_sync = true;
+
+    // Copies rank 0's parameters and buffers to every rank and installs the
+    // gradient hooks. Throws std::runtime_error if the broadcast fails.
+    DistributedDataParallel(Module& model, ProcessGroup& group, Options options);
+    DistributedDataParallel(Module& model, ProcessGroup& group);
+    ~DistributedDataParallel();
+
+    DistributedDataParallel(const DistributedDataParallel&) = delete;
+    DistributedDataParallel& operator=(const DistributedDataParallel&) = delete;
+
+    // Finishes reducing every bucket and leaves the averaged gradients in the
+    // parameters; call between backward() and Optimizer::step()
+    bool synchronize();
+    CommStats stats() const;
+
+private:
+    struct Bucket {
+        std::vector<int> params;
+        std::vector<double> buffer;
+        // Error feedback for TopK
+        std::vector<double> residual;
+        int remaining = 0;
+        bool ready = false;
+    };
+
+    void grad_ready(int param);
+    void launch_ready_buckets();
+    void launch(int bucket);
+    bool reduce(Bucket& bucket);
+    void run();
+
+    std::vector<Value*> params;
+    ProcessGroup& group;
+    Options options;
+    std::vector<Bucket> buckets;
+    std::vector<int> bucket_of;
+    // Buckets launch strictly in order so every rank reduces them in the same sequence
+    int next_launch = 0;
+
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<int> queue;
+    int completed = 0;
+    bool failed = false;
+    bool stopping = false;
+    CommStats counters;
+    long long bytes_at_start = 0;
+    std::thread comm_thread;
+};
+
+} // namespace micrograd
@@ -1,25 +1,52 @@
 #pragma once
 
+#include "memory_pool.hpp"
+#include "precision.hpp"
 #include <Eigen/Dense>
 #include <memory>
 #include <vector>
 #include <functional>
 #include <set>
+#include <string>
 
 namespace micrograd {
 
+// Graph ownership: every graph vertex is a heap-allocated node (a Value whose
+// _self points at itself). Op results returned by value are handles: copies
+// that keep their node alive and receive its gradient after backward(). A
+// Value created on the stack becomes a handle the first time it enters an
+// op. Nodes own their inputs through _prev only, so a graph is freed as soon
+// as the last handle to its output goes away or the graph is released.
+// Backward reads a node's own data: a handle's data is a copy taken when it
+// was bound, and changing it does not change a node that is still in use.
+// Instead, the next op that uses the changed handle binds it to a new node
+// with its current data, so forward and backward always see the same values.
+//
+// Nodes, and the data and grad of every Value, come from the memory pool
+// (memory_pool.hpp) and go back to it when the Value is destroyed.
 class Value {
 public:
     Eigen::MatrixXd data;
     Eigen::MatrixXd grad;
 
     Value(const Eigen::MatrixXd& data);
+    // Takes over data's buffer
+    Value(Eigen::MatrixXd&& data);
     Value(double scalar);
+    Value(const Value& other);
+    Value(Value&& other) noexcept;
+    Value& operator=(const Value& other);
+    Value& operator=(Value&& other) noexcept;
+    ~Value();
 
     // Self-pointer for graph connectivity
     void set_self(const std::shared_ptr<Value>& ptr);
+    // Returns the node backing this value, binding a stack value to a new node
     std::shared_ptr<Value> get_self_ptr() const;
 
+    // Number of Value objects currently alive, for leak checks
+    static long long live_count();
+
     // Operations
     Value operator+(const Value& other) const;
     Value operator+(double scalar) const;
@@ -33,28 +60,82 @@ public:
     Value pow(double exponent) const;
     Value relu() const;
     Value sigmoid() const;
+    Value tanh() const;
+    // Tanh approximation of GELU
+    Value gelu() const;
+    Value leaky_relu(double negative_slope = 0.01) const;
+    // x * sigmoid(x)
+    Value silu() const;
+    Value softmax() const;
     Value transpose() const;
+    // Column-major reshape, like Eigen::Map over the same storage
+    Value reshape(int rows, int cols) const;
     Value flatten() const;
-
-    // Backward propagation
-    void backward();
+    // Sums over the axes where the target size is 1; inverse of broadcast_to
+    Value sum_to(int rows, int cols) const;
+    // Repeats a row, column or scalar to the target shape
+    Value broadcast_to(int rows, int cols) const;
+    Value sum() const;
+    // Rounds data (and, on the way back, grad) to a lower storage precision
+    Value cast(Precision precision) const;
+
+    // Backward propagation. Unless retain_graph is set, the graph below this
+    // value is released afterwards so its intermediate nodes are freed.
+    // Releasing throws std::logic_error, leaving the graph intact, if an op
+    // result in it is also an input of another live graph.
+    void backward(bool retain_graph = false);
+    // Drops the graph below this value without running backward
+    void release_graph();
     void zero_grad();
 
     // Shape utilities
     int rows() const { return data.rows(); }
     int cols() const { return data.cols(); }
 
-    std::vector<std::shared_ptr<Value>> _prev;
+    using NodeList = std::vector<std::shared_ptr<Value>, PoolAllocator<std::shared_ptr<Value>>>;
+    NodeList _prev;
     std::function<void()> _backward;
+    // The same backward step written with Value ops, so that gradients can be
+    // differentiated again. Returns the gradient for each entry of _prev.
+    std::function<std::vector<Value>(const Value& grad)> _backward_graph;
     std::string _op;
-    std::weak_ptr<Value> _self;
+    // Op arguments that are not graph inputs, such as the scalar in x * 2.0
+    // or a pow exponent, kept so the graph can be exported
+    std::vector<double, PoolAllocator<double>> _attrs;
+    mutable std::weak_ptr<Value> _self;
+    // Called during backward() as soon as this node's gradient is complete,
+    // e.g. to start communicating a parameter's gradient while backward runs
+    // on. Not copied, and kept when the graph is released.
+    std::function<void()> _grad_ready;
+
+    // Creates a graph node holding an op result
+    static std::shared_ptr<Value> make_node(const Eigen::MatrixXd& data, const char* op, NodeList prev);
+    static std::shared_ptr<Value> make_node(Eigen::MatrixXd&& data, const char* op, NodeList prev);
 
 private:
-    void build_topo(std::shared_ptr<Value> v, std::set<std::shared_ptr<Value>>& visited,
-                    std::vector<std::shared_ptr<Value>>& topo);
+    // Strong reference from a handle to its node; empty for nodes and unbound values
+    mutable std::shared_ptr<Value> _node;
+    // Handles bound to this node, refreshed with its gradient after backward
+    std::vector<Value*, PoolAllocator<Value*>> _handles;
+
+    void bind(const std::shared_ptr<Value>& node) const;
+    void unbind();
+    bool is_node() const;
+    void copy_binding(const Value& other);
+
+    using NodeSet = std::set<std::shared_ptr<Value>, std::less<std::shared_ptr<Value>>,
+                             PoolAllocator<std::shared_ptr<Value>>>;
+
+    void build_topo(std::shared_ptr<Value> v, NodeSet& visited, NodeList& topo);
+    static void release(NodeList& topo);
 
+    // grad summed down to the target shape, in a pooled buffer
     static Eigen::MatrixXd broadcast_backward(const Eigen::MatrixXd& grad,
                                               int target_rows, int target_cols);
+    // target += scale * grad, summed down to target's shape. Without
+    // broadcasting, or for a row broadcast across the batch, this needs no
+    // temporary.
+    static void accumulate(Eigen::MatrixXd& target, const Eigen::MatrixXd& grad, double scale = 1.0);
 
     friend class ValuePtr;
 };
@@ -87,6 +168,7 @@ public:
     ValuePtr sigmoid() const;
     ValuePtr transpose() const;
     ValuePtr flatten() const;
+    ValuePtr cast(Precision precision) const;
 };
 
 } // namespace micrograd
@@ -0,0 +1,303 @@
+#pragma once
+
+#include "autodiff.hpp"
+#include "engine.hpp"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace micrograd {
+namespace expr {
+
+// Lazy elementwise expressions. Operators on lazy(...) operands build an
+// expression tree instead of graph nodes; fuse() evaluates the whole tree in a
+// single loop and records it as one "fused" node whose backward is a single
+// loop as well. Scalars are folded into the tree as constants.
+//
+//     Value c = fuse(lazy(a) * lazy(b) + pow(lazy(a), 2.0));
+//
+// Like an Eigen expression, a lazy expression refers to its operands, which
+// must outlive the fuse() call.
+//
+// Operands may be full-sized or broadcast along rows (1 x C), columns (R x 1)
+// or both (1 x 1). Combining operands of other shapes throws
+// std::invalid_argument when the expression is built.
+//
+// value(i, j) caches each node's result in v, and backward(i, j, g) reads
+// those cached values instead of re-evaluating subtrees, so a backward pass
+// must directly follow a value(i, j) call on the root for the same element.
+//
+// graph(rows, cols) rebuilds the expression from regular Value ops; the fused
+// node uses it for create_graph backward passes, which are rare enough that
+// they need not be fused.
+
+template <typename Derived>
+struct Expr {
+    // Result of the last value(i, j) call on this node
+    mutable double v = 0.0;
+
+    const Derived& derived() const { return static_cast<const Derived&>(*this); }
+};
+
+struct Leaf : Expr<Leaf> {
+    // Kept alive by the operand until fuse() and by the fused node's _prev
+    // afterwards; the backward closures copy the tree, so a shared_ptr here
+    // would give every input an owner outside the graph
+    Value* node;
+
+    explicit Leaf(const Value& v) : node(v.get_self_ptr().get()) {}
+
+    int rows() const { return node->data.rows(); }
+    int cols() const { return node->data.cols(); }
+
+    double value(int i, int j) const {
+        return v = node->data(node->data.rows() == 1 ? 0 : i, node->data.cols() == 1 ? 0 : j);
+    }
+    void backward(int i, int j, double g) const {
+        // Writing to the broadcast coordinate sums the gradient over the broadcast axis
+        node->grad(node->data.rows() == 1 ? 0 : i, node->data.cols() == 1 ? 0 : j) += g;
+    }
+    void leaves(std::vector<Value*>& out) const { out.push_back(node); }
+    Value graph(int rows, int cols) const { return node->broadcast_to(rows, cols); }
+};
+
+struct Const : Expr<Const> {
+    double c;
+
+    explicit Const(double c) : c(c) {}
+
+    int rows() const { return 1; }
+    int cols() const { return 1; }
+
+    double value(int, int) const { return v = c; }
+    void backward(int, int, double) const {}
+    void leaves(std::vector<Value*>&) const {}
+    Value graph(int rows, int cols) const { return Value(Eigen::MatrixXd::Constant(rows, cols, c)); }
+};
+
+template <typename L, typename R>
+struct Binary {
+    L l;
+    R r;
+
+    Binary(const L& l, const R& r) : l(l), r(r) {
+        // value(i, j) reads a size-1 axis at index 0, so any other mismatch would read out of bounds
+        auto compatible = [](int a, int b) { return a == b || a == 1 || b == 1; };
+        if (!compatible(l.rows(), r.rows()) || !compatible(l.cols(), r.cols())) {
+            throw std::invalid_argument("expr: cannot broadcast " + std::to_string(l.rows()) + "x" +
+                                        std::to_string(l.cols()) + " with " + std::to_string(r.rows()) + "x" +
+                                        std::to_string(r.cols()));
+        }
+    }
+
+    int rows() const { return std::max(l.rows(), r.rows()); }
+    int cols() const { return std::max(l.cols(), r.cols()); }
+    void leaves(std::vector<Value*>& out) const {
+        l.leaves(out);
+        r.leaves(out);
+    }
+};
+
+template <typename A>
+struct Unary {
+    A a;
+
+    explicit Unary(const A& a) : a(a) {}
+
+    int rows() const { return a.rows(); }
+    int cols() const { return a.cols(); }
+    void leaves(std::vector<Value*>& out) const { a.leaves(out); }
+};
+
+template <typename L, typename R>
+struct Add : Expr<Add<L, R>>, Binary<L, R> {
+    using Binary<L, R>::Binary;
+    double value(int i, int j) const { return this->v = this->l.value(i, j) + this->r.value(i, j); }
+    Value graph(int rows, int cols) const { return this->l.graph(rows, cols) + this->r.graph(rows, cols); }
+    void backward(int i, int j, double g) const {
+        this->l.backward(i, j, g);
+        this->r.backward(i, j, g);
+    }
+};
+
+template <typename L, typename R>
+struct Sub : Expr<Sub<L, R>>, Binary<L, R> {
+    using Binary<L, R>::Binary;
+    double value(int i, int j) const { return this->v = this->l.value(i, j) - this->r.value(i, j); }
+    Value graph(int rows, int cols) const { return this->l.graph(rows, cols) - this->r.graph(rows, cols); }
+    void backward(int i, int j, double g) const {
+        this->l.backward(i, j, g);
+        this->r.backward(i, j, -g);
+    }
+};
+
+template <typename L, typename R>
+struct Mul : Expr<Mul<L, R>>, Binary<L, R> {
+    using Binary<L, R>::Binary;
+    double value(int i, int j) const { return this->v = this->l.value(i, j) * this->r.value(i, j); }
+    Value graph(int rows, int cols) const { return this->l.graph(rows, cols) * this->r.graph(rows, cols); }
+    void backward(int i, int j, double g) const {
+        this->l.backward(i, j, g * this->r.v);
+        this->r.backward(i, j, g * this->l.v);
+    }
+};
+
+template <typename L, typename R>
+struct Div : Expr<Div<L, R>>, Binary<L, R> {
+    using Binary<L, R>::Binary;
+    double value(int i, int j) const { return this->v = this->l.value(i, j) / this->r.value(i, j); }
+    Value graph(int rows, int cols) const { return this->l.graph(rows, cols) / this->r.graph(rows, cols); }
+    void backward(int i, int j, double g) const {
+        const double r = this->r.v;
+        this->l.backward(i, j, g / r);
+        this->r.backward(i, j, -g * this->l.v / (r * r));
+    }
+};
+
+template <typename A>
+struct Pow : Expr<Pow<A>>, Unary<A> {
+    double exponent;
+
+    Pow(const A& a, double exponent) : Unary<A>(a), exponent(exponent) {}
+    double value(int i, int j) const { return this->v = std::pow(this->a.value(i, j), exponent); }
+    Value graph(int rows, int cols) const { return this->a.graph(rows, cols).pow(exponent); }
+    void backward(int i, int j, double g) const {
+        this->a.backward(i, j, g * exponent * std::pow(this->a.v, exponent - 1));
+    }
+};
+
+template <typename A>
+struct Relu : Expr<Relu<A>>, Unary<A> {
+    using Unary<A>::Unary;
+    double value(int i, int j) const { return this->v = std::max(this->a.value(i, j), 0.0); }
+    Value graph(int rows, int cols) const { return this->a.graph(rows, cols).relu(); }
+    void backward(int i, int j, double g) const {
+        if (this->a.v > 0.0) {
+            this->a.backward(i, j, g);
+        }
+    }
+};
+
+template <typename A>
+struct Sigmoid : Expr<Sigmoid<A>>, Unary<A> {
+    using Unary<A>::Unary;
+    double value(int i, int j) const { return this->v = 1.0 / (1.0 + std::exp(-this->a.value(i, j))); }
+    Value graph(int rows, int cols) const { return this->a.graph(rows, cols).sigmoid(); }
+    void backward(int i, int j, double g) const {
+        const double s = this->v;
+        this->a.backward(i, j, g * s * (1.0 - s));
+    }
+};
+
+inline Leaf lazy(const Value& v) { return Leaf(v); }
+
+template <typename L, typename R>
+Add<L, R> operator+(const Expr<L>& l, const Expr<R>& r) { return {l.derived(), r.derived()}; }
+template <typename L>
+Add<L, Const> operator+(const Expr<L>& l, double r) { return {l.derived(), Const(r)}; }
+template <typename R>
+Add<Const, R> operator+(double l, const Expr<R>& r) { return {Const(l), r.derived()}; }
+template <typename L>
+Add<L, Leaf> operator+(const Expr<L>& l, const Value& r) { return {l.derived(), Leaf(r)}; }
+template <typename R>
+Add<Leaf, R> operator+(const Value& l, const Expr<R>& r) { return {Leaf(l), r.derived()}; }
+
+template <typename L, typename R>
+Sub<L, R> operator-(const Expr<L>& l, const Expr<R>& r) { return {l.derived(), r.derived()}; }
+template <typename L>
+Sub<L, Const> operator-(const Expr<L>& l, double r) { return {l.derived(), Const(r)}; }
+template <typename R>
+Sub<Const, R> operator-(double l, const Expr<R>& r) { return {Const(l), r.derived()}; }
+template <typename L>
+Sub<L, Leaf> operator-(const Expr<L>& l, const Value& r) { return {l.derived(), Leaf(r)}; }
+template <typename R>
+Sub<Leaf, R> operator-(const Value& l, const Expr<R>& r) { return {Leaf(l), r.derived()}; }
+template <typename A>
+Mul<A, Const> operator-(const Expr<A>& a) { return {a.derived(), Const(-1.0)}; }
+
+template <typename L, typename R>
+Mul<L, R> operator*(const Expr<L>& l, const Expr<R>& r) { return {l.derived(), r.derived()}; }
+template <typename L>
+Mul<L, Const> operator*(const Expr<L>& l, double r) { return {l.derived(), Const(r)}; }
+template <typename R>
+Mul<Const, R> operator*(double l, const Expr<R>& r) { return {Const(l), r.derived()}; }
+template <typename L>
+Mul<L, Leaf> operator*(const Expr<L>& l, const Value& r) { return {l.derived(), Leaf(r)}; }
+template <typename R>
+Mul<Leaf, R> operator*(const Value& l, const Expr<R>& r) { return {Leaf(l), r.derived()}; }
+
+template <typename L, typename R>
+Div<L, R> operator/(const Expr<L>& l, const Expr<R>& r) { return {l.derived(), r.derived()}; }
+template <typename L>
+Mul<L, Const> operator/(const Expr<L>& l, double r) { return {l.derived(), Const(1.0 / r)}; }
+template <typename R>
+Div<Const, R> operator/(double l, const Expr<R>& r) { return {Const(l), r.derived()}; }
+template <typename L>
+Div<L, Leaf> operator/(const Expr<L>& l, const Value& r) { return {l.derived(), Leaf(r)}; }
+template <typename R>
+Div<Leaf, R> operator/(const Value& l, const Expr<R>& r) { return {Leaf(l), r.derived()}; }
+
+template <typename A>
+Pow<A> pow(const Expr<A>& a, double exponent) { return {a.derived(), exponent}; }
+template <typename A>
+Relu<A> relu(const Expr<A>& a) { return Relu<A>(a.derived()); }
+template <typename A>
+Sigmoid<A> sigmoid(const Expr<A>& a) { return Sigmoid<A>(a.derived()); }
+
+template <typename E>
+Value fuse(const Expr<E>& e) {
+    const E& x = e.derived();
+    const int rows = x.rows();
+    const int cols = x.cols();
+
+    // Evaluated straight into a pooled buffer that the node then takes over
+    Eigen::MatrixXd result = pool_acquire(rows, cols);
+    for (int j = 0; j < cols; ++j) {
+        for (int i = 0; i < rows; ++i) {
+            result(i, j) = x.value(i, j);
+        }
+    }
+
+    // Keep leaves in first-use order so _prev does not depend on heap addresses
+    std::vector<Value*> leaves;
+    x.leaves(leaves);
+    Value::NodeList prev;
+    std::unordered_set<const Value*> seen;
+    for (auto* leaf : leaves) {
+        if (seen.insert(leaf).second) {
+            prev.push_back(leaf->_self.lock());
+        }
+    }
+
+    auto out_ptr = Value::make_node(std::move(result), "fused", std::move(prev));
+
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [x, out]() {
+        for (int j = 0; j < out->grad.cols(); ++j) {
+            for (int i = 0; i < out->grad.rows(); ++i) {
+                x.value(i, j);
+                x.backward(i, j, out->grad(i, j));
+            }
+        }
+    };
+    out_ptr->_backward_graph = [x, out](const Value& g) {
+        std::vector<Value*> inputs;
+        for (auto& leaf : out->_prev) {
+            inputs.push_back(leaf.get());
+        }
+        return grad(x.graph(out->rows(), out->cols()), inputs, &g, true);
+    };
+
+    return *out_ptr;
+}
+
+} // namespace expr
+
+using expr::fuse;
+using expr::lazy;
+
+} // namespace micrograd
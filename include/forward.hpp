@@ -0,0 +1,82 @@
+#pragma once
+
+#include "activation.hpp"
+#include "nn.hpp"
+#include "precision.hpp"
+#include <Eigen/Dense>
+#include <functional>
+#include <vector>
+
+namespace micrograd {
+
+// Forward-mode value carrying K tangent directions alongside its data. The
+// tangents are stacked vertically: rows [k * rows(), (k + 1) * rows()) of
+// `tangent` hold direction k, so elementwise ops and products with constant
+// right-hand sides touch all directions in one Eigen expression. Ops and
+// broadcasting rules mirror Value.
+class Dual {
+public:
+    Eigen::MatrixXd data;
+    Eigen::MatrixXd tangent;
+    int num_tangents;
+
+    // A constant: all tangents are zero
+    Dual(const Eigen::MatrixXd& data, int num_tangents = 0);
+    Dual(double scalar, int num_tangents = 0);
+    // tangent must be stacked as described above
+    Dual(const Eigen::MatrixXd& data, const Eigen::MatrixXd& tangent, int num_tangents);
+
+    // Seeds one tangent per direction; each direction has the shape of data
+    static Dual variable(const Eigen::MatrixXd& data, const std::vector<Eigen::MatrixXd>& directions);
+
+    int rows() const { return data.rows(); }
+    int cols() const { return data.cols(); }
+
+    Eigen::Block<Eigen::MatrixXd> tangent_at(int k);
+    Eigen::Block<const Eigen::MatrixXd> tangent_at(int k) const;
+
+    Dual operator+(const Dual& other) const;
+    Dual operator+(double scalar) const;
+    Dual operator*(const Dual& other) const;
+    Dual operator*(double scalar) const;
+    Dual operator-(const Dual& other) const;
+    Dual operator-(double scalar) const;
+    Dual operator/(const Dual& other) const;
+    Dual operator/(double scalar) const;
+    Dual matmul(const Dual& other) const;
+    // Product with a constant, e.g. a weight matrix: a single GEMM for all tangents
+    Dual matmul(const Eigen::MatrixXd& other) const;
+    Dual pow(double exponent) const;
+    Dual relu() const;
+    Dual sigmoid() const;
+    Dual softmax() const;
+    Dual transpose() const;
+    Dual reshape(int rows, int cols) const;
+    Dual flatten() const;
+    Dual sum() const;
+    Dual cast(Precision precision) const;
+
+private:
+    // Tangent with every direction broadcast to rows x cols
+    Eigen::MatrixXd broadcast_tangent(int rows, int cols, int k) const;
+};
+
+Dual activate(Activation activation, const Dual& x, double negative_slope = 0.01);
+
+// Forward passes with weights held constant, so tangents are derivatives
+// with respect to the input. MLP norms and dropout run in eval mode.
+Dual forward(const Layer& layer, const Dual& x);
+Dual forward(const MLP& model, const Dual& x);
+
+// Scalar losses matching CrossEntropyLoss and MSELoss
+Dual cross_entropy(const Dual& logits, const Eigen::VectorXi& labels);
+Dual mse(const Dual& y_pred, const Eigen::MatrixXd& y_true);
+
+// Jacobian of vec(f(x)) with respect to vec(x) (column-major), built from
+// forward passes that each push chunk_size basis directions through f.
+// Costs ceil(x.size() / chunk_size) forward passes regardless of the number
+// of outputs.
+Eigen::MatrixXd jacobian(const std::function<Dual(const Dual&)>& f, const Eigen::MatrixXd& x,
+                         int chunk_size = 16);
+
+} // namespace micrograd
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "engine.hpp"
+#include <Eigen/Dense>
+#include <string>
+#include <vector>
+
+namespace micrograd {
+
+// One operation of an exported graph. op is the engine op name (Value::_op),
+// or "input" for a graph input and "param" for any other leaf, whose value is
+// stored in data. Matrices are column-major, as in Eigen.
+struct IRNode {
+    std::string op;
+    int rows = 0;
+    int cols = 0;
+    // Indices of earlier nodes
+    std::vector<int> inputs;
+    // Value::_attrs of the traced node
+    std::vector<double> attrs;
+    Eigen::MatrixXd data;
+};
+
+// A traced inference graph with fixed shapes, in topological order
+struct IRGraph {
+    std::vector<IRNode> nodes;
+    // Indices of the "input" nodes, in the order the inputs were given
+    std::vector<int> inputs;
+    int output = -1;
+
+    // Reference interpreter; returns an empty matrix on error
+    Eigen::MatrixXd run(const std::vector<Eigen::MatrixXd>& values) const;
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+};
+
+// Captures the graph below output, e.g. from model.forward(x) in eval mode.
+// Leaves listed in inputs become graph inputs; every other leaf is stored as
+// a parameter. Fails on ops that have no fixed inference form, such as
+// dropout or batch norm in training mode, and on fused training ops.
+bool export_graph(const Value& output, const std::vector<Value*>& inputs, IRGraph& graph);
+
+// Runs model.forward on an example batch in eval mode and exports the graph,
+// which is then specialized to the example's shape
+template <typename Model>
+bool trace(Model& model, const Eigen::MatrixXd& example, IRGraph& graph) {
+    const bool was_training = model.training;
+    model.eval();
+    Value x(example);
+    Value y = model.forward(x);
+    const bool ok = export_graph(y, {&x}, graph);
+    y.release_graph();
+    model.train(was_training);
+    return ok;
+}
+
+// Writes a standalone C++ source file implementing the graph's forward pass
+//
+//     void <function_name>(const double* input0, ..., double* output);
+//
+// with every shape fixed, the parameters inlined as constant arrays and
+// intermediates in static buffers that are reused once their last consumer
+// has run. Only <cmath>, <cstdint> and <cstring> are needed to build it. The
+// buffers are column-major like Eigen::MatrixXd::data(). Not reentrant, since
+// the buffers are shared between calls.
+bool generate_cpp(const IRGraph& graph, const std::string& path, const std::string& function_name = "forward");
+
+} // namespace micrograd
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "nn.hpp"
+#include <Eigen/Dense>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace micrograd {
+
+struct InferenceStats {
+    long long requests = 0;
+    long long batches = 0;
+    int queue_depth = 0;
+    int max_queue_depth = 0;
+    // latency_histogram[k] counts requests that completed in [2^k, 2^(k+1)) microseconds
+    std::vector<long long> latency_histogram;
+
+    double mean_batch_size() const;
+    // Upper bound of the histogram bucket containing the given percentile (0-100)
+    double latency_percentile_us(double percentile) const;
+};
+
+// Serves single-sample requests by coalescing them into batches of up to
+// max_batch_size rows, waiting at most max_delay_us after the oldest request
+// for the batch to fill, and running one graph-free forward pass per batch.
+class InferenceServer {
+public:
+    struct Options {
+        int max_batch_size = 64;
+        int max_delay_us = 1000;
+        int num_workers = 1;
+    };
+
+    // Serves a private copy of the model's weights
+    InferenceServer(const MLP& model, Options options);
+    explicit InferenceServer(const MLP& model);
+    ~InferenceServer();
+
+    InferenceServer(const InferenceServer&) = delete;
+    InferenceServer& operator=(const InferenceServer&) = delete;
+
+    // A sample whose size is not input_size() gets a std::invalid_argument result
+    std::future<Eigen::RowVectorXd> submit(const Eigen::RowVectorXd& sample);
+    Eigen::RowVectorXd infer(const Eigen::RowVectorXd& sample);
+    InferenceStats stats() const;
+    // Finishes the queued requests and joins the workers
+    void stop();
+
+    int input_size() const { return model.layers.front().w->data.rows(); }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    struct Request {
+        Eigen::RowVectorXd input;
+        std::promise<Eigen::RowVectorXd> result;
+        clock::time_point enqueued;
+    };
+
+    void worker();
+
+    MLP model;
+    Options options;
+
+    std::deque<Request> queue;
+    bool stopping = false;
+    InferenceStats counters;
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::thread> workers;
+};
+
+// Unix-domain socket front end for local testing. A request is a uint32
+// feature count followed by that many doubles; the reply has the same layout.
+// Each connection may send any number of requests; a request of the wrong
+// size closes the connection.
+class UnixSocketFrontend {
+public:
+    UnixSocketFrontend(InferenceServer& server, const std::string& socket_path);
+    ~UnixSocketFrontend();
+
+    UnixSocketFrontend(const UnixSocketFrontend&) = delete;
+    UnixSocketFrontend& operator=(const UnixSocketFrontend&) = delete;
+
+    bool start();
+    void stop();
+
+private:
+    void accept_loop();
+    void serve(int fd);
+
+    InferenceServer& server;
+    std::string socket_path;
+    int listen_fd = -1;
+    std::thread acceptor;
+    std::mutex mutex;
+    // Handler thread of each open connection, by socket
+    std::unordered_map<int, std::thread> connections;
+    // Handlers that have returned, joined by the acceptor or by stop()
+    std::vector<std::thread> finished;
+    std::condition_variable drained;
+};
+
+// Client side of the UnixSocketFrontend protocol; opens one connection per call
+bool unix_socket_infer(const std::string& socket_path, const Eigen::RowVectorXd& sample,
+                       Eigen::RowVectorXd& output);
+
+} // namespace micrograd
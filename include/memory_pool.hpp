@@ -0,0 +1,109 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <cstddef>
+#include <memory>
+
+namespace micrograd {
+
+// Caches for the memory a training step churns through, so that a loop whose
+// shapes repeat stops going to the heap once it has run a step. Two pools,
+// both thread-safe:
+//
+// - Matrix buffers, grouped by element count so a cached buffer can be
+//   reused without reallocating. Values take their data and gradient from it
+//   and give them back when they are destroyed, e.g. when a graph is released.
+// - Small blocks in power-of-two size classes up to 64 KiB, for graph nodes
+//   and the containers that hold them (see PoolAllocator).
+
+// Counters since the last reset_pool_stats(), covering both pools
+struct PoolStats {
+    // Matrices and blocks handed out, and how many reused a cached one
+    long long requests = 0;
+    long long hits = 0;
+    // Bytes handed out and not yet returned, counted per element count: a
+    // returned matrix of a size with buffers outstanding settles one of them,
+    // whichever buffer it holds, so replacing a Value's data by assignment
+    // does not leave it counted. Returns of a size with none outstanding were
+    // allocated elsewhere and are not counted.
+    long long bytes_live = 0;
+    // Bytes held for reuse
+    long long bytes_cached = 0;
+
+    // Requests that had to allocate from the heap
+    long long heap_allocations() const { return requests - hits; }
+    double hit_rate() const { return requests > 0 ? double(hits) / requests : 1.0; }
+};
+
+PoolStats pool_stats();
+// Zeroes the request and hit counters; byte counts are kept
+void reset_pool_stats();
+// Frees every cached buffer and block
+void clear_pool();
+// Most bytes of matrix buffers kept for reuse (default 1 GiB); beyond that
+// returned buffers are freed
+void set_pool_capacity(std::size_t bytes);
+
+// A rows x cols matrix with unspecified contents
+Eigen::MatrixXd pool_acquire(int rows, int cols);
+Eigen::MatrixXd pool_zeros(int rows, int cols);
+// Caches m's buffer and leaves m empty
+void pool_release(Eigen::MatrixXd& m);
+
+// Evaluates an expression into a pooled buffer
+template <typename Derived>
+Eigen::MatrixXd pool_eval(const Eigen::MatrixBase<Derived>& expr) {
+    Eigen::MatrixXd m = pool_acquire(expr.rows(), expr.cols());
+    m.noalias() = expr;
+    return m;
+}
+
+template <typename Derived>
+Eigen::MatrixXd pool_eval(const Eigen::ArrayBase<Derived>& expr) {
+    Eigen::MatrixXd m = pool_acquire(expr.rows(), expr.cols());
+    m.array() = expr;
+    return m;
+}
+
+// A matrix that goes back to the pool when destroyed, for buffers kept by a
+// backward closure. Copies draw from the pool too, since std::function
+// requires copyable closures.
+struct PooledMatrix {
+    Eigen::MatrixXd matrix;
+
+    explicit PooledMatrix(Eigen::MatrixXd&& m) : matrix(std::move(m)) {}
+    PooledMatrix(const PooledMatrix& other) : matrix(pool_eval(other.matrix)) {}
+    PooledMatrix(PooledMatrix&& other) noexcept = default;
+    PooledMatrix& operator=(const PooledMatrix&) = delete;
+    ~PooledMatrix() { pool_release(matrix); }
+};
+
+// Blocks of at least `bytes`; larger than 64 KiB goes straight to the heap
+void* pool_allocate(std::size_t bytes);
+void pool_deallocate(void* p, std::size_t bytes);
+
+// Standard allocator over the block pool, e.g. for std::allocate_shared
+template <typename T>
+struct PoolAllocator {
+    using value_type = T;
+    static_assert(alignof(T) <= alignof(std::max_align_t), "PoolAllocator blocks are max_align_t aligned");
+
+    PoolAllocator() = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) {}
+
+    T* allocate(std::size_t n) { return static_cast<T*>(pool_allocate(n * sizeof(T))); }
+    void deallocate(T* p, std::size_t n) { pool_deallocate(p, n * sizeof(T)); }
+};
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&) {
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&) {
+    return false;
+}
+
+} // namespace micrograd
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <vector>
+
+namespace micrograd {
+
+// Streaming classification metrics over batches of logits. Each row is
+// reduced to a handful of counters as it arrives: the rank of the true label
+// (for accuracy and top-k), a confusion matrix entry, its log-loss via
+// log-sum-exp, and a calibration bin for the top-class confidence, so
+// probabilities are never materialized. Rows of a batch are split across the
+// threads of parallel.hpp, each filling its own accumulator.
+class Metrics {
+public:
+    // Calibration error uses num_bins equal-width confidence bins
+    explicit Metrics(int num_classes, int num_bins = 15);
+
+    void update(const Eigen::MatrixXd& logits, const Eigen::VectorXi& labels);
+    // Adds another accumulator's counts, e.g. from a different data shard
+    void merge(const Metrics& other);
+    void reset();
+
+    int num_classes() const { return counts.confusion.rows(); }
+    long long count() const { return counts.total; }
+
+    double accuracy() const;
+    // Fraction of samples whose true label is among the k largest logits
+    double top_k_accuracy(int k) const;
+    // Mean negative log-likelihood of the true label under softmax(logits)
+    double log_loss() const;
+    // Expected calibration error: the sample-weighted mean over confidence bins
+    // of |accuracy - mean confidence|
+    double calibration_error() const;
+    // Rows are true labels, columns predicted labels
+    const Eigen::MatrixXi& confusion_matrix() const { return counts.confusion; }
+
+private:
+    // Counters for a contiguous range of samples
+    struct Accumulator {
+        // rank_counts[r] counts samples whose true label had r logits ranked above it
+        std::vector<long long> rank_counts;
+        Eigen::MatrixXi confusion;
+        double loss_sum = 0.0;
+        std::vector<long long> bin_counts;
+        std::vector<long long> bin_correct;
+        std::vector<double> bin_confidence;
+        long long total = 0;
+
+        Accumulator(int num_classes, int num_bins);
+        void add(const Accumulator& other);
+    };
+
+    void accumulate(const Eigen::MatrixXd& logits, const Eigen::VectorXi& labels, int begin, int end,
+                    Accumulator& acc) const;
+
+    Accumulator counts;
+};
+
+} // namespace micrograd
@@ -16,10 +16,15 @@ public:
 
     MNISTLoader() = default;
     bool load(const std::string& images_path, const std::string& labels_path);
-    void get_batch(int batch_idx, int batch_size, Eigen::MatrixXd& batch_images, Eigen::VectorXi& batch_labels);
+    void get_batch(int batch_idx, int batch_size, Eigen::MatrixXd& batch_images, Eigen::VectorXi& batch_labels) const;
     int get_num_batches(int batch_size) const;
+    // Permutes the order get_batch draws samples in, using the global generator
+    void shuffle();
 
 private:
+    // Sample order for get_batch; empty means file order
+    std::vector<int> order;
+
     static int reverse_int(int i);
 };
 
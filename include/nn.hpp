@@ -1,16 +1,37 @@
 #pragma once
 
+#include "activation.hpp"
 #include "engine.hpp"
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <utility>
 #include <vector>
 #include <string>
 
 namespace micrograd {
 
+// Serializes matrices in the save_weights format: a parameter count, then
+// rows, cols and column-major data for each matrix.
+void write_weights(std::ostream& out, const std::vector<const Eigen::MatrixXd*>& weights);
+// Reads the write_weights format into matrices of the expected count and
+// shapes; reports a mismatch and returns false otherwise.
+bool read_weights(std::istream& in, const std::vector<Eigen::MatrixXd*>& weights);
+
 class Module {
 public:
+    // Training mode; modules such as BatchNorm1d and Dropout behave differently in eval mode
+    bool training = true;
+
     virtual ~Module() = default;
     virtual std::vector<Value*> parameters() = 0;
+    // Non-trainable state that is saved with the weights, e.g. running statistics
+    virtual std::vector<Eigen::MatrixXd*> buffers() { return {}; }
+    // Everything save_weights writes: parameter data followed by buffers
+    std::vector<Eigen::MatrixXd*> state();
     virtual void zero_grad();
+    virtual void train(bool mode = true) { training = mode; }
+    void eval() { train(false); }
     void save_weights(const std::string& path);
     void load_weights(const std::string& path);
 };
@@ -20,19 +41,95 @@ public:
     std::shared_ptr<Value> w;
     std::shared_ptr<Value> b;
     bool nonlin;
+    // Applied to the output when nonlin is set
+    Activation activation = Activation::ReLU;
+    // Storage precision of the activations this layer produces
+    Precision precision = Precision::FP64;
 
     Layer(int nin, int nout, bool nonlin = true);
+    Layer(int nin, int nout, Activation activation);
     Value forward(const Value& x) const;
+    // Inference-only forward pass on raw matrices, without building a graph
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& x) const;
     std::vector<Value*> parameters() override;
 };
 
+// Normalizes each feature over the batch and applies a learned affine map.
+// Training mode uses batch statistics and updates the running averages; eval
+// mode uses the running averages.
+class BatchNorm1d : public Module {
+public:
+    std::shared_ptr<Value> gamma;
+    std::shared_ptr<Value> beta;
+    Eigen::MatrixXd running_mean;
+    Eigen::MatrixXd running_var;
+    double momentum;
+    double eps;
+
+    BatchNorm1d(int num_features, double momentum = 0.1, double eps = 1e-5);
+    Value forward(const Value& x);
+    // Eval-mode forward pass on raw matrices
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& x) const;
+    // Eval mode as y = x * scale + shift, both 1 x num_features
+    std::pair<Eigen::MatrixXd, Eigen::MatrixXd> eval_affine() const;
+    std::vector<Value*> parameters() override;
+    std::vector<Eigen::MatrixXd*> buffers() override;
+};
+
+// Zeroes each element with probability p in training mode and scales the rest
+// by 1 / (1 - p); the identity in eval mode. Masks come from a counter-based
+// hash of (seed, call, element), so no generator state is shared between
+// elements, and are kept for backward as one bit per element.
+class Dropout : public Module {
+public:
+    double p;
+    uint64_t seed;
+    // Forward calls so far; each call draws a fresh mask
+    uint64_t counter = 0;
+
+    // Throws std::invalid_argument unless 0 <= p < 1
+    explicit Dropout(double p = 0.5);
+    Value forward(const Value& x);
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& x) const { return x; }
+    std::vector<Value*> parameters() override { return {}; }
+};
+
+// A parameter-free activation, for use between other modules in a Sequential
+class ActivationLayer : public Module {
+public:
+    Activation activation;
+    double negative_slope;
+
+    explicit ActivationLayer(Activation activation, double negative_slope = 0.01);
+    Value forward(const Value& x) const { return activate(activation, x, negative_slope); }
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& x) const { return activate(activation, x, negative_slope); }
+    std::vector<Value*> parameters() override { return {}; }
+};
+
 class MLP : public Module {
 public:
+    struct Options {
+        // BatchNorm1d between each hidden linear map and its ReLU
+        bool batch_norm = false;
+        // Dropout probability after each hidden activation; 0 disables it
+        double dropout = 0.0;
+    };
+
     std::vector<Layer> layers;
+    // One per hidden layer when enabled, empty otherwise
+    std::vector<BatchNorm1d> norms;
+    std::vector<Dropout> dropouts;
 
     MLP(int nin, const std::vector<int>& nouts);
-    Value forward(const Value& x) const;
+    MLP(int nin, const std::vector<int>& nouts, const Options& options);
+    Value forward(const Value& x);
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& x) const;
     std::vector<Value*> parameters() override;
+    std::vector<Eigen::MatrixXd*> buffers() override;
+    void train(bool mode = true) override;
+    void set_precision(Precision precision);
+    // Deep copy with its own parameter storage
+    MLP clone() const;
 };
 
 } // namespace micrograd
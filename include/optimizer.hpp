@@ -1,22 +1,45 @@
 #pragma once
 
 #include "engine.hpp"
+#include "precision.hpp"
 #include <vector>
 
 namespace micrograd {
 
 class Optimizer {
 public:
+    std::vector<Value*> parameters;
+    double lr;
+
+    Optimizer(const std::vector<Value*>& params, double learning_rate)
+        : parameters(params), lr(learning_rate) {}
     virtual ~Optimizer() = default;
     virtual void step() = 0;
     virtual void zero_grad() = 0;
+
+    // Keeps fp32 master copies of the parameters and updates those instead;
+    // after every step the parameters hold the master weights rounded to `storage`.
+    void use_master_weights(Precision storage);
+
+protected:
+    template <typename Derived>
+    void apply_update(size_t i, const Eigen::MatrixBase<Derived>& delta) {
+        if (master.empty()) {
+            parameters[i]->data += delta;
+        } else {
+            master[i] += delta.template cast<float>();
+            // Assigned in place, so the parameter keeps its pooled buffer
+            parameters[i]->data = master[i].cast<double>();
+            round_in_place(parameters[i]->data, storage);
+        }
+    }
+
+    Precision storage = Precision::FP64;
+    std::vector<Eigen::MatrixXf> master;
 };
 
 class SGD : public Optimizer {
 public:
-    std::vector<Value*> parameters;
-    double lr;
-
     SGD(const std::vector<Value*>& params, double learning_rate = 0.01);
     void step() override;
     void zero_grad() override;
@@ -24,8 +47,6 @@ public:
 
 class NesterovSGD : public Optimizer {
 public:
-    std::vector<Value*> parameters;
-    double lr;
     double mu;
     std::vector<Eigen::MatrixXd> v;
 
@@ -34,4 +55,81 @@ public:
     void zero_grad() override;
 };
 
+// Layer-wise adaptive rate scaling: momentum SGD where each parameter's step is
+// scaled by the trust ratio eta * ||w|| / (||g|| + weight_decay * ||w||), or
+// by 1 when either norm is zero.
+class LARS : public Optimizer {
+public:
+    double mu;
+    double weight_decay;
+    double eta;
+    std::vector<Eigen::MatrixXd> v;
+
+    LARS(const std::vector<Value*>& params, double learning_rate = 0.1, double momentum = 0.9,
+         double weight_decay = 1e-4, double eta = 0.001);
+    void step() override;
+    void zero_grad() override;
+};
+
+// Layer-wise adaptive moments: Adam update directions rescaled per parameter
+// by the trust ratio ||w|| / ||update||.
+class LAMB : public Optimizer {
+public:
+    double beta1;
+    double beta2;
+    double eps;
+    double weight_decay;
+    int t = 0;
+    std::vector<Eigen::MatrixXd> m;
+    std::vector<Eigen::MatrixXd> v;
+
+    LAMB(const std::vector<Value*>& params, double learning_rate = 0.001, double beta1 = 0.9,
+         double beta2 = 0.999, double eps = 1e-6, double weight_decay = 0.01);
+    void step() override;
+    void zero_grad() override;
+};
+
+// Learning rate as a function of the optimizer step: linear warmup from 0 to
+// base_lr over warmup_steps, then constant, linear or cosine decay to min_lr
+// at total_steps.
+class LRSchedule {
+public:
+    enum class Decay {
+        Constant,
+        Linear,
+        Cosine
+    };
+
+    double base_lr;
+    int warmup_steps;
+    int total_steps;
+    Decay decay;
+    double min_lr;
+
+    LRSchedule(double base_lr, int warmup_steps = 0, int total_steps = 0,
+               Decay decay = Decay::Constant, double min_lr = 0.0);
+    double at(int step) const;
+};
+
+// Scales the loss up before backward so that small gradients survive low-precision
+// storage, and scales them back down before the optimizer step. The scale backs off
+// whenever a step overflows and grows again after growth_interval clean steps.
+class DynamicLossScaler {
+public:
+    double scale;
+    double growth_factor;
+    double backoff_factor;
+    int growth_interval;
+
+    DynamicLossScaler(double init_scale = 65536.0, double growth_factor = 2.0,
+                      double backoff_factor = 0.5, int growth_interval = 2000);
+
+    // Divides the gradients by the scale. Returns false if any gradient is not
+    // finite, in which case the step should be skipped.
+    bool unscale(const std::vector<Value*>& params);
+
+private:
+    int good_steps = 0;
+};
+
 } // namespace micrograd
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <functional>
+
+namespace micrograd {
+
+// Threads used by parallel_for and the reductions below, counting the
+// calling thread. Defaults to 1, which runs everything inline.
+void set_num_threads(int n);
+int get_num_threads();
+
+// In deterministic mode reductions split their input into chunks whose
+// boundaries depend only on the input size, and combine the partial results
+// in a fixed pairwise tree. Results are then bit-identical for any number of
+// threads. Otherwise the input is split into one chunk per thread.
+void set_deterministic(bool enabled);
+bool is_deterministic();
+
+// Runs fn(chunk) for chunk in [0, num_chunks) across the worker threads and
+// returns when all chunks are done
+void parallel_for(int num_chunks, const std::function<void(int)>& fn);
+
+// How the reductions below split [0, rows): `count` chunks of `size` rows,
+// the last possibly shorter. Chunks have a fixed size in deterministic mode.
+struct RowChunks {
+    int count;
+    int size;
+};
+RowChunks row_chunks(int rows);
+
+// Column sums (1 x cols), i.e. m.colwise().sum()
+Eigen::MatrixXd sum_rows(const Eigen::MatrixXd& m);
+// Sum of all elements
+double sum_all(const Eigen::MatrixXd& m);
+// a^T * b, a reduction over the shared row dimension (e.g. a weight gradient
+// summed over the batch)
+Eigen::MatrixXd matmul_tn(const Eigen::MatrixXd& a, const Eigen::MatrixXd& b);
+
+// target += scale * sum_rows(m) and target += a^T * b, for gradients. On one
+// chunk they accumulate straight into target; split across threads, the
+// partial results come from the memory pool.
+void add_sum_rows(Eigen::MatrixXd& target, const Eigen::MatrixXd& m, double scale = 1.0);
+void add_matmul_tn(Eigen::MatrixXd& target, const Eigen::MatrixXd& a, const Eigen::MatrixXd& b);
+
+} // namespace micrograd
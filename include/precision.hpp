@@ -0,0 +1,26 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <cstdint>
+
+namespace micrograd {
+
+enum class Precision {
+    FP64,
+    FP32,
+    BF16,
+    FP16
+};
+
+// 16-bit float encodings, rounding to nearest even
+uint16_t float_to_bf16(float value);
+float bf16_to_float(uint16_t bits);
+uint16_t float_to_fp16(float value);
+float fp16_to_float(uint16_t bits);
+
+// Rounds every element to the nearest value representable in the given precision
+Eigen::MatrixXd round_to(const Eigen::MatrixXd& m, Precision precision);
+// The same, in m's own buffer
+void round_in_place(Eigen::MatrixXd& m, Precision precision);
+
+} // namespace micrograd
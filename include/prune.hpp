@@ -0,0 +1,70 @@
+#pragma once
+
+#include "activation.hpp"
+#include "nn.hpp"
+#include <Eigen/Dense>
+#include <Eigen/SparseCore>
+#include <string>
+#include <vector>
+
+namespace micrograd {
+
+// Which Layer::w entries pruning removed. Pruned weights are zeroed once;
+// call apply() after every optimizer step while fine-tuning so they stay zero.
+struct PruningMask {
+    std::vector<Value*> weights;
+    // 1 keeps an entry, 0 prunes it; same shape as the matching weight
+    std::vector<Eigen::MatrixXd> masks;
+
+    void apply() const;
+    // Fraction of masked weight entries that are pruned
+    double sparsity() const;
+};
+
+// Unstructured pruning with one magnitude threshold across every layer, so
+// layers with many small weights (typically the input layer) lose the most
+PruningMask prune_magnitude(MLP& model, double sparsity);
+
+// N:M structured sparsity: for every output neuron, keeps the n largest of
+// each group of m consecutive input weights
+PruningMask prune_n_m(MLP& model, int n, int m);
+
+// Removes the given fraction of each hidden layer's neurons, those with the
+// smallest outgoing-weight L2 norm, physically shrinking that layer's nout,
+// the following layer's nin and any BatchNorm1d in between. Optimizer state
+// no longer matches the parameter shapes afterwards, so create optimizers
+// after pruning.
+void prune_neurons(MLP& model, double fraction);
+
+// Inference-only MLP holding each weight matrix in compressed sparse column
+// form. predict() adds every stored weight times the matching input column to
+// an output column, so its cost follows the number of nonzeros, not nin * nout.
+class SparseMLP {
+public:
+    struct SparseLayer {
+        // nin x nout
+        Eigen::SparseMatrix<double> w;
+        Eigen::RowVectorXd b;
+        bool nonlin = false;
+        Activation activation = Activation::ReLU;
+        // Folded eval-mode BatchNorm1d, followed by ReLU, when has_norm is set
+        bool has_norm = false;
+        Eigen::RowVectorXd norm_scale;
+        Eigen::RowVectorXd norm_shift;
+    };
+
+    std::vector<SparseLayer> layers;
+
+    SparseMLP() = default;
+    // Drops the model's exact zeros; dropout is the identity at inference
+    explicit SparseMLP(const MLP& model);
+
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& x) const;
+    long long nonzeros() const;
+
+    // Stores the nonzeros only, with 16-bit row indices where nin allows it
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+};
+
+} // namespace micrograd
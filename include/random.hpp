@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+
+namespace micrograd {
+
+// Seeds the generator used for weight initialization, dropout seeds and data
+// shuffling, as well as std::rand (and therefore Eigen's Random()). Without a
+// call the generator is seeded from std::random_device on first use.
+void manual_seed(uint64_t seed);
+
+// Process-wide generator. Not synchronized: draw from it on one thread, e.g.
+// while building models and between epochs.
+std::mt19937_64& global_generator();
+
+// splitmix64 finalizer: a stateless hash, so per-element random streams can be
+// derived from (seed, index) and drawn in any order or on any thread
+inline uint64_t splitmix64(uint64_t z) {
+    z += 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+} // namespace micrograd
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "nn.hpp"
+#include <Eigen/Dense>
+#include <vector>
+
+namespace micrograd {
+
+// Recurrent layers over sequences stacked time-major: for a batch of B
+// sequences of T steps, rows [t * B, (t + 1) * B) of a (T * B) x features
+// matrix hold step t of every sequence. forward() returns the hidden state of
+// every step in the same layout.
+//
+// The whole sequence is one graph node. The input projections of all steps
+// are computed with a single GEMM up front, the recurrence then runs step by
+// step on raw matrices, and backward walks the steps in reverse in one
+// closure, so a sequence costs one node rather than several per step.
+//
+// Truncated BPTT: set bptt_window to stop gradients flowing back more than
+// that many steps within a sequence, and/or split a long sequence into
+// chunks and carry state between forward() calls, which passes the last
+// hidden state on as a constant.
+
+// h_t = tanh(x_t W_ih + h_{t-1} W_hh + b)
+class RNN : public Module {
+public:
+    std::shared_ptr<Value> w_ih;
+    std::shared_ptr<Value> w_hh;
+    std::shared_ptr<Value> b;
+    int input_size;
+    int hidden_size;
+    // Steps gradients flow back through the recurrence; 0 for the whole sequence
+    int bptt_window = 0;
+
+    RNN(int input_size, int hidden_size);
+    // Starts from a zero state
+    Value forward(const Value& x, int batch) const;
+    // Starts from state (batch x hidden_size) and leaves the last hidden state in it
+    Value forward(const Value& x, Eigen::MatrixXd& state) const;
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& x, int batch) const;
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& x, Eigen::MatrixXd& state) const;
+    std::vector<Value*> parameters() override;
+};
+
+// Gated recurrent unit, with gates r, z and candidate n stored in that order
+// as column blocks of the weights:
+//   r = sigmoid(x W_ir + b_ir + h W_hr + b_hr)
+//   z = sigmoid(x W_iz + b_iz + h W_hz + b_hz)
+//   n = tanh(x W_in + b_in + r * (h W_hn + b_hn))
+//   h' = (1 - z) * n + z * h
+class GRU : public Module {
+public:
+    // input_size x 3 * hidden_size
+    std::shared_ptr<Value> w_ih;
+    // hidden_size x 3 * hidden_size
+    std::shared_ptr<Value> w_hh;
+    std::shared_ptr<Value> b_ih;
+    std::shared_ptr<Value> b_hh;
+    int input_size;
+    int hidden_size;
+    // Steps gradients flow back through the recurrence; 0 for the whole sequence
+    int bptt_window = 0;
+
+    GRU(int input_size, int hidden_size);
+    // Starts from a zero state
+    Value forward(const Value& x, int batch) const;
+    // Starts from state (batch x hidden_size) and leaves the last hidden state in it
+    Value forward(const Value& x, Eigen::MatrixXd& state) const;
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& x, int batch) const;
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& x, Eigen::MatrixXd& state) const;
+    std::vector<Value*> parameters() override;
+};
+
+} // namespace micrograd
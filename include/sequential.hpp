@@ -0,0 +1,52 @@
+#pragma once
+
+#include "activation.hpp"
+#include "engine.hpp"
+#include "nn.hpp"
+#include <Eigen/Dense>
+#include <variant>
+#include <vector>
+
+namespace micrograd {
+
+// Ordered container of heterogeneous modules. Entries are stored by value in
+// a std::variant, so forward dispatches with std::visit on the variant index
+// instead of a virtual call through a pointer per module. The feature count
+// is tracked as modules are appended, so the builders size each new module
+// from the previous one and add() rejects modules that do not fit.
+//
+//     Sequential model(784);
+//     model.linear(128, Activation::GELU).batch_norm().dropout(0.1).linear(10);
+class Sequential : public Module {
+public:
+    using Entry = std::variant<Layer, BatchNorm1d, Dropout, ActivationLayer>;
+
+    std::vector<Entry> modules;
+
+    explicit Sequential(int in_features);
+
+    Sequential& linear(int out_features, Activation activation = Activation::Identity);
+    Sequential& batch_norm(double momentum = 0.1, double eps = 1e-5);
+    Sequential& dropout(double p);
+    Sequential& activation(Activation activation, double negative_slope = 0.01);
+    // Appends a prebuilt module; returns false if its input size does not match
+    bool add(Entry module);
+
+    int in_features() const { return inputs; }
+    int out_features() const { return features; }
+
+    Value forward(const Value& x);
+    // Inference-only forward pass in eval mode, without building a graph
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& x) const;
+    std::vector<Value*> parameters() override;
+    std::vector<Eigen::MatrixXd*> buffers() override;
+    void train(bool mode = true) override;
+    // Deep copy with its own parameter storage
+    Sequential clone() const;
+
+private:
+    int inputs;
+    int features;
+};
+
+} // namespace micrograd
@@ -0,0 +1,302 @@
+#pragma once
+
+#include "nn.hpp"
+#include "random.hpp"
+#include <Eigen/Dense>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace micrograd {
+
+// Dense layer whose shape is known at compile time. Weights are stored
+// column-major as nin x nout, the same layout as Layer::w.
+template <int In, int Out>
+struct StaticLinear {
+    static constexpr int nin = In;
+    static constexpr int nout = Out;
+
+    using WeightMatrix = Eigen::Matrix<double, In, Out>;
+    using BiasVector = Eigen::Matrix<double, 1, Out>;
+
+    alignas(64) std::array<double, In * Out> w;
+    alignas(64) std::array<double, Out> b;
+    alignas(64) std::array<double, In * Out> w_grad;
+    alignas(64) std::array<double, Out> b_grad;
+
+    Eigen::Map<WeightMatrix, Eigen::Aligned64> weight() { return Eigen::Map<WeightMatrix, Eigen::Aligned64>(w.data()); }
+    Eigen::Map<const WeightMatrix, Eigen::Aligned64> weight() const {
+        return Eigen::Map<const WeightMatrix, Eigen::Aligned64>(w.data());
+    }
+    Eigen::Map<BiasVector, Eigen::Aligned64> bias() { return Eigen::Map<BiasVector, Eigen::Aligned64>(b.data()); }
+    Eigen::Map<const BiasVector, Eigen::Aligned64> bias() const {
+        return Eigen::Map<const BiasVector, Eigen::Aligned64>(b.data());
+    }
+    Eigen::Map<WeightMatrix, Eigen::Aligned64> weight_grad() {
+        return Eigen::Map<WeightMatrix, Eigen::Aligned64>(w_grad.data());
+    }
+    Eigen::Map<BiasVector, Eigen::Aligned64> bias_grad() { return Eigen::Map<BiasVector, Eigen::Aligned64>(b_grad.data()); }
+};
+
+// MLP with a compile-time topology, e.g. StaticMLP<784, 32, 16, 10>. Hidden
+// layers use ReLU and the last layer is linear, as in MLP. All parameters live
+// in one aligned object (allocate it on the heap for large models) and the
+// per-batch workspace is only resized when the batch size changes, so steady
+// state forward/backward does not allocate. Weight files are interchangeable
+// with MLP::save_weights / load_weights for the same topology.
+template <int... Dims>
+class StaticMLP {
+    static_assert(sizeof...(Dims) >= 2, "StaticMLP needs an input and at least one layer size");
+
+public:
+    static constexpr int dims[sizeof...(Dims)] = {Dims...};
+    static constexpr size_t num_layers = sizeof...(Dims) - 1;
+    static constexpr int nin = dims[0];
+    static constexpr int nout = dims[num_layers];
+
+    using Input = Eigen::Matrix<double, Eigen::Dynamic, nin>;
+    using Output = Eigen::Matrix<double, Eigen::Dynamic, nout>;
+
+private:
+    template <size_t... I>
+    static auto make_layers(std::index_sequence<I...>) -> std::tuple<StaticLinear<dims[I], dims[I + 1]>...>;
+    template <size_t... I>
+    static auto make_buffers(std::index_sequence<I...>)
+        -> std::tuple<Eigen::Matrix<double, Eigen::Dynamic, dims[I + 1]>...>;
+
+    using Layers = decltype(make_layers(std::make_index_sequence<num_layers>()));
+    using Buffers = decltype(make_buffers(std::make_index_sequence<num_layers>()));
+
+public:
+    Layers layers;
+
+    StaticMLP() {
+        auto& gen = global_generator();
+        for_each_layer([&gen](auto& layer) {
+            // He initialization, as in Layer
+            std::normal_distribution<> d(0.0, std::sqrt(2.0 / layer.nin));
+            for (auto& v : layer.w) {
+                v = d(gen);
+            }
+            layer.b.fill(0.0);
+        });
+    }
+
+    // Returns the logits of the last forward pass. x must stay alive until the
+    // matching backward() call, which reads it for the first layer's gradient.
+    const Output& forward(const Eigen::MatrixXd& x) {
+        eigen_assert(x.cols() == nin);
+        input_data = x.data();
+        input_rows = x.rows();
+        forward_layer<0>(input());
+        return std::get<num_layers - 1>(acts);
+    }
+
+    // Backpropagates dL/dlogits through the last forward pass. Parameter
+    // gradients are overwritten rather than accumulated.
+    void backward(const Output& grad_logits) {
+        std::get<num_layers - 1>(deltas) = grad_logits;
+        backward_layer<num_layers - 1>();
+    }
+
+    // Mean cross-entropy of the last forward pass; also runs backward for it
+    double cross_entropy_backward(const Eigen::VectorXi& labels) {
+        const Output& logits = std::get<num_layers - 1>(acts);
+        Output& delta = std::get<num_layers - 1>(deltas);
+        const int n = logits.rows();
+
+        delta.resize(n, Eigen::NoChange);
+        double loss = 0.0;
+        for (int i = 0; i < n; ++i) {
+            const double max_val = logits.row(i).maxCoeff();
+            delta.row(i) = (logits.row(i).array() - max_val).exp();
+            const double sum = delta.row(i).sum();
+            loss -= logits(i, labels(i)) - max_val - std::log(sum);
+            delta.row(i) /= sum;
+            delta(i, labels(i)) -= 1.0;
+        }
+        delta /= n;
+
+        backward_layer<num_layers - 1>();
+        return loss / n;
+    }
+
+    void sgd_step(const double lr) {
+        for_each_layer([lr](auto& layer) {
+            layer.weight() -= lr * layer.weight_grad();
+            layer.bias() -= lr * layer.bias_grad();
+        });
+    }
+
+    bool copy_from(MLP& model) {
+        auto params = model.parameters();
+        if (params.size() != 2 * num_layers) {
+            std::cerr << "Error: Architecture mismatch. Model has " << params.size() / 2
+                      << " layers, expected " << num_layers << std::endl;
+            return false;
+        }
+        // Check every shape first so a mismatch leaves all layers untouched
+        size_t i = 0;
+        bool ok = true;
+        for_each_layer([&](const auto& layer) {
+            const Eigen::MatrixXd& w = params[i++]->data;
+            const Eigen::MatrixXd& b = params[i++]->data;
+            ok = ok && w.rows() == layer.nin && w.cols() == layer.nout && b.size() == layer.nout;
+        });
+        if (!ok) {
+            std::cerr << "Error: Shape mismatch for parameter" << std::endl;
+            return false;
+        }
+        i = 0;
+        for_each_layer([&](auto& layer) {
+            layer.weight() = params[i++]->data;
+            layer.bias() = params[i++]->data;
+        });
+        return true;
+    }
+
+    bool copy_to(MLP& model) const {
+        auto params = model.parameters();
+        if (params.size() != 2 * num_layers) {
+            std::cerr << "Error: Architecture mismatch. Model has " << params.size() / 2
+                      << " layers, expected " << num_layers << std::endl;
+            return false;
+        }
+        // Same check-first pass as copy_from. With matching shapes the writes
+        // land in the existing (pooled) buffers, so data keeps grad's shape.
+        size_t i = 0;
+        bool ok = true;
+        for_each_layer([&](const auto& layer) {
+            const Eigen::MatrixXd& w = params[i++]->data;
+            const Eigen::MatrixXd& b = params[i++]->data;
+            ok = ok && w.rows() == layer.nin && w.cols() == layer.nout && b.size() == layer.nout;
+        });
+        if (!ok) {
+            std::cerr << "Error: Shape mismatch for parameter" << std::endl;
+            return false;
+        }
+        i = 0;
+        for_each_layer([&](const auto& layer) {
+            params[i++]->data = layer.weight();
+            params[i++]->data = layer.bias();
+        });
+        return true;
+    }
+
+    // Same binary format as Module::save_weights
+    void save_weights(const std::string& path) const {
+        std::ofstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open file " << path << " for writing" << std::endl;
+            return;
+        }
+
+        std::vector<Eigen::MatrixXd> matrices = to_matrices();
+        std::vector<const Eigen::MatrixXd*> weights;
+        for (const auto& m : matrices) {
+            weights.push_back(&m);
+        }
+        write_weights(file, weights);
+
+        file.close();
+        std::cout << "Model saved to " << path << std::endl;
+    }
+
+    void load_weights(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open file " << path << " for reading" << std::endl;
+            return;
+        }
+
+        // Read into temporaries so a bad file leaves the parameters untouched
+        std::vector<Eigen::MatrixXd> matrices = to_matrices();
+        std::vector<Eigen::MatrixXd*> weights;
+        for (auto& m : matrices) {
+            weights.push_back(&m);
+        }
+        if (!read_weights(file, weights)) {
+            return;
+        }
+        size_t i = 0;
+        for_each_layer([&matrices, &i](auto& layer) {
+            layer.weight() = matrices[i++];
+            layer.bias() = matrices[i++];
+        });
+
+        file.close();
+        std::cout << "Model loaded from " << path << std::endl;
+    }
+
+private:
+    Buffers acts;
+    Buffers deltas;
+    const double* input_data = nullptr;
+    int input_rows = 0;
+
+    Eigen::Map<const Input> input() const { return Eigen::Map<const Input>(input_data, input_rows, nin); }
+
+    template <typename F>
+    void for_each_layer(F&& f) {
+        std::apply([&f](auto&... layer) { (f(layer), ...); }, layers);
+    }
+    template <typename F>
+    void for_each_layer(F&& f) const {
+        std::apply([&f](const auto&... layer) { (f(layer), ...); }, layers);
+    }
+
+    template <size_t I, typename Derived>
+    void forward_layer(const Eigen::MatrixBase<Derived>& x) {
+        auto& layer = std::get<I>(layers);
+        auto& out = std::get<I>(acts);
+
+        out.resize(x.rows(), Eigen::NoChange);
+        out.noalias() = x * layer.weight();
+        out.rowwise() += layer.bias();
+
+        if constexpr (I + 1 < num_layers) {
+            out = out.cwiseMax(0.0);
+            forward_layer<I + 1>(out);
+        }
+    }
+
+    template <size_t I>
+    void backward_layer() {
+        auto& layer = std::get<I>(layers);
+        auto& delta = std::get<I>(deltas);
+
+        if constexpr (I == 0) {
+            layer.weight_grad().noalias() = input().transpose() * delta;
+        } else {
+            layer.weight_grad().noalias() = std::get<I - 1>(acts).transpose() * delta;
+        }
+        layer.bias_grad() = delta.colwise().sum();
+
+        if constexpr (I > 0) {
+            auto& prev = std::get<I - 1>(deltas);
+            const auto& prev_act = std::get<I - 1>(acts);
+            prev.resize(delta.rows(), Eigen::NoChange);
+            prev.noalias() = delta * layer.weight().transpose();
+            prev.array() *= (prev_act.array() > 0.0).template cast<double>();
+            backward_layer<I - 1>();
+        }
+    }
+
+    // Weights and biases in parameter order, as MLP::parameters() returns them
+    std::vector<Eigen::MatrixXd> to_matrices() const {
+        std::vector<Eigen::MatrixXd> matrices;
+        for_each_layer([&matrices](const auto& layer) {
+            matrices.emplace_back(layer.weight());
+            matrices.emplace_back(layer.bias());
+        });
+        return matrices;
+    }
+};
+
+} // namespace micrograd
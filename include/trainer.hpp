@@ -0,0 +1,144 @@
+#pragma once
+
+#include "engine.hpp"
+#include "nn.hpp"
+#include "loss.hpp"
+#include "optimizer.hpp"
+#include "mnist_loader.hpp"
+#include "dataset.hpp"
+#include "augment.hpp"
+#include "distributed.hpp"
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace micrograd {
+
+struct EpochStats {
+    int epoch;
+    int steps;
+    int samples;
+    double loss;
+    double accuracy;
+    double seconds;
+    double samples_per_sec;
+    // Wall time spent in each phase of the training steps
+    double data_seconds;
+    double forward_seconds;
+    double backward_seconds;
+    double optimizer_seconds;
+    // Time waiting for gradient all-reduces that backward did not hide
+    double communication_seconds;
+};
+
+struct EvalStats {
+    int epoch;
+    int correct;
+    int total;
+    double accuracy;
+    double seconds;
+    double top5_accuracy;
+    double log_loss;
+    double calibration_error;
+};
+
+// Number of rows whose largest logit is at the true label
+int count_correct(const Eigen::MatrixXd& logits, const Eigen::VectorXi& labels);
+
+// Loads batches in order on one background thread, at most one batch ahead
+// of the consumer. The thread lives as long as the prefetcher and serves
+// every epoch in turn.
+class BatchPrefetcher {
+public:
+    using Load = std::function<void(int, Eigen::MatrixXd&, Eigen::VectorXi&)>;
+
+    BatchPrefetcher();
+    ~BatchPrefetcher();
+
+    BatchPrefetcher(const BatchPrefetcher&) = delete;
+    BatchPrefetcher& operator=(const BatchPrefetcher&) = delete;
+
+    // Starts loading batches 0 .. num_batches - 1 with load
+    void start(int num_batches, Load load);
+    // Blocks until the next batch is ready and swaps it into images and
+    // labels. Rethrows an exception thrown by load.
+    void next(Eigen::MatrixXd& images, Eigen::VectorXi& labels);
+    // Waits for a load in progress and drops the remaining batches, after
+    // which load is no longer called
+    void stop();
+
+private:
+    void run();
+
+    Load load;
+    int num_batches = 0;
+    int next_batch = 0;
+    // The one-batch slot between the worker and next()
+    Eigen::MatrixXd images;
+    Eigen::VectorXi labels;
+    std::exception_ptr error;
+    bool full = false;
+    bool busy = false;
+    bool stopping = false;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread worker;
+};
+
+// Classification training loop. Each optimizer step accumulates gradients over
+// accumulation_steps micro-batches of batch_size samples, and the learning rate
+// follows `schedule` when one is set. The next batch is loaded, and augmented
+// when `augmentation` is set, on a background thread while the current one
+// trains. Validation runs on a background thread against a snapshot of the
+// weights, so it overlaps with the next training epoch.
+class Trainer {
+public:
+    int batch_size;
+    int accumulation_steps = 1;
+    int log_interval = 100;
+    std::optional<LRSchedule> schedule;
+    // Applied to each training batch on the prefetch thread; evaluation is not augmented
+    std::optional<Augmenter> augmentation;
+    // When set, gradients are averaged across its process group before each
+    // optimizer step; the loaders should then hold this rank's shard. If the
+    // averaging fails, train_epoch throws std::runtime_error before stepping.
+    DistributedDataParallel* distributed = nullptr;
+    // Optimizer steps taken so far; the schedule is evaluated at this step
+    int step = 0;
+
+    Trainer(MLP& model, Optimizer& optimizer, int batch_size);
+    ~Trainer();
+
+    EpochStats train_epoch(const MNISTLoader& loader);
+    // Resets the loader and trains on one full pass, in batches of loader.batch_size()
+    EpochStats train_epoch(DataLoader& loader);
+
+    // Copies the current weights into the snapshot and evaluates it asynchronously.
+    // Waits for any evaluation still in flight first.
+    void start_evaluation(const MNISTLoader& loader);
+    bool evaluation_pending() const;
+    EvalStats wait_evaluation();
+    // The weights the most recent evaluation ran on
+    MLP& snapshot() { return snapshot_model; }
+
+    static EvalStats evaluate(const MLP& model, const MNISTLoader& loader, int batch_size);
+
+private:
+    EpochStats run_epoch(int num_batches, int batch_size, long long num_samples,
+                         const std::function<void(int, Eigen::MatrixXd&, Eigen::VectorXi&)>& get_batch);
+
+    MLP& model;
+    Optimizer& optimizer;
+    CrossEntropyLoss criterion;
+    MLP snapshot_model;
+    int epoch = 0;
+    std::future<EvalStats> pending_eval;
+    BatchPrefetcher prefetcher;
+};
+
+} // namespace micrograd
@@ -0,0 +1,80 @@
+#include "activation.hpp"
+#include <cmath>
+#include <utility>
+
+namespace micrograd {
+
+namespace {
+
+const std::pair<const char*, Activation> REGISTRY[] = {
+    {"identity", Activation::Identity},
+    {"relu", Activation::ReLU},
+    {"sigmoid", Activation::Sigmoid},
+    {"tanh", Activation::Tanh},
+    {"gelu", Activation::GELU},
+    {"leaky_relu", Activation::LeakyReLU},
+    {"silu", Activation::SiLU},
+};
+
+} // namespace
+
+std::optional<Activation> activation_from_name(const std::string& name) {
+    for (const auto& entry : REGISTRY) {
+        if (name == entry.first) {
+            return entry.second;
+        }
+    }
+    return std::nullopt;
+}
+
+const char* activation_name(const Activation activation) {
+    for (const auto& entry : REGISTRY) {
+        if (activation == entry.second) {
+            return entry.first;
+        }
+    }
+    return "unknown";
+}
+
+Value activate(const Activation activation, const Value& x, const double negative_slope) {
+    switch (activation) {
+        case Activation::ReLU:
+            return x.relu();
+        case Activation::Sigmoid:
+            return x.sigmoid();
+        case Activation::Tanh:
+            return x.tanh();
+        case Activation::GELU:
+            return x.gelu();
+        case Activation::LeakyReLU:
+            return x.leaky_relu(negative_slope);
+        case Activation::SiLU:
+            return x.silu();
+        case Activation::Identity:
+            break;
+    }
+    return *x.get_self_ptr();
+}
+
+Eigen::MatrixXd activate(const Activation activation, const Eigen::MatrixXd& x, const double negative_slope) {
+    const auto a = x.array();
+    switch (activation) {
+        case Activation::ReLU:
+            return a.max(0.0);
+        case Activation::Sigmoid:
+            return 1.0 / (1.0 + (-a).exp());
+        case Activation::Tanh:
+            return a.tanh();
+        case Activation::GELU:
+            return 0.5 * a * (1.0 + (std::sqrt(2.0 / M_PI) * (a + 0.044715 * a.cube())).tanh());
+        case Activation::LeakyReLU:
+            return (a > 0.0).select(a, negative_slope * a);
+        case Activation::SiLU:
+            return a / (1.0 + (-a).exp());
+        case Activation::Identity:
+            break;
+    }
+    return x;
+}
+
+} // namespace micrograd
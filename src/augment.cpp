@@ -0,0 +1,114 @@
+#include "augment.hpp"
+#include "parallel.hpp"
+#include "random.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+namespace micrograd {
+
+namespace {
+
+using RowMajorMap = Eigen::Map<Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>>;
+
+// Row-normalized Gaussian blur along one axis
+Eigen::MatrixXd gaussian_smoothing(const int n, const double sigma) {
+    Eigen::MatrixXd g(n, n);
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            g(i, j) = std::exp(-0.5 * (i - j) * (i - j) / (sigma * sigma));
+        }
+    }
+    return g.array().colwise() / g.rowwise().sum().array();
+}
+
+} // namespace
+
+Augmenter::Augmenter(const Options options) : options(options), seed(global_generator()()) {
+    const int rows = options.image_rows;
+    const int cols = options.image_cols;
+    grid_x.resize(rows * cols);
+    grid_y.resize(rows * cols);
+    for (int y = 0; y < rows; ++y) {
+        for (int x = 0; x < cols; ++x) {
+            grid_x(y * cols + x) = x - (cols - 1) / 2.0;
+            grid_y(y * cols + x) = y - (rows - 1) / 2.0;
+        }
+    }
+    if (options.elastic_alpha > 0.0) {
+        smooth_rows = gaussian_smoothing(rows, options.elastic_sigma);
+        smooth_cols = gaussian_smoothing(cols, options.elastic_sigma);
+    }
+}
+
+Augmenter::Augmenter() : Augmenter(Options()) {}
+
+void Augmenter::apply(Eigen::MatrixXd& batch) {
+    if (batch.cols() != options.image_rows * options.image_cols) {
+        std::cerr << "Error: Augmenter expected rows of " << options.image_rows << "x" << options.image_cols
+                  << " images, got " << batch.cols() << " columns" << std::endl;
+        return;
+    }
+
+    const uint64_t first = counter;
+    parallel_for(batch.rows(), [&](const int i) { augment_row(batch.row(i), first + i); });
+    counter += batch.rows();
+}
+
+void Augmenter::augment_row(Eigen::Ref<Eigen::RowVectorXd, 0, Eigen::InnerStride<>> image, const uint64_t sample) const {
+    const int rows = options.image_rows;
+    const int cols = options.image_cols;
+    const double cx = (cols - 1) / 2.0;
+    const double cy = (rows - 1) / 2.0;
+
+    std::mt19937_64 rng(splitmix64(seed ^ splitmix64(sample)));
+    std::uniform_real_distribution<double> unit(-1.0, 1.0);
+    const double angle = options.max_rotation * unit(rng) * M_PI / 180.0;
+    const double scale = 1.0 + options.max_scale * unit(rng);
+    const double tx = options.max_shift * unit(rng);
+    const double ty = options.max_shift * unit(rng);
+
+    // Inverse map from output pixels to source coordinates: undo the shift,
+    // then rotate by -angle and divide by the scale
+    const double c = std::cos(angle) / scale;
+    const double s = std::sin(angle) / scale;
+    Eigen::ArrayXd src_x = c * (grid_x - tx) + s * (grid_y - ty) + cx;
+    Eigen::ArrayXd src_y = -s * (grid_x - tx) + c * (grid_y - ty) + cy;
+
+    if (options.elastic_alpha > 0.0) {
+        Eigen::MatrixXd field_x(rows, cols), field_y(rows, cols);
+        for (Eigen::Index k = 0; k < field_x.size(); ++k) {
+            field_x(k) = unit(rng);
+            field_y(k) = unit(rng);
+        }
+        RowMajorMap(src_x.data(), rows, cols) += options.elastic_alpha * smooth_rows * field_x * smooth_cols.transpose();
+        RowMajorMap(src_y.data(), rows, cols) += options.elastic_alpha * smooth_rows * field_y * smooth_cols.transpose();
+    }
+
+    const Eigen::ArrayXd x0 = src_x.floor();
+    const Eigen::ArrayXd y0 = src_y.floor();
+    const Eigen::ArrayXd fx = src_x - x0;
+    const Eigen::ArrayXd fy = src_y - y0;
+
+    const Eigen::RowVectorXd source = image;
+    auto pixel = [&](const int y, const int x) {
+        return x >= 0 && x < cols && y >= 0 && y < rows ? source(y * cols + x) : 0.0;
+    };
+    for (Eigen::Index p = 0; p < image.size(); ++p) {
+        const int x = static_cast<int>(x0(p));
+        const int y = static_cast<int>(y0(p));
+        const double top = (1.0 - fx(p)) * pixel(y, x) + fx(p) * pixel(y, x + 1);
+        const double bottom = (1.0 - fx(p)) * pixel(y + 1, x) + fx(p) * pixel(y + 1, x + 1);
+        image(p) = (1.0 - fy(p)) * top + fy(p) * bottom;
+    }
+
+    if (options.noise_std > 0.0) {
+        std::normal_distribution<double> noise(0.0, options.noise_std);
+        for (Eigen::Index p = 0; p < image.size(); ++p) {
+            image(p) = std::clamp(image(p) + noise(rng), 0.0, 1.0);
+        }
+    }
+}
+
+} // namespace micrograd
@@ -0,0 +1,238 @@
+#include "autodiff.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <stdexcept>
+
+namespace micrograd {
+
+namespace {
+
+struct Graph {
+    // Nodes reachable from the output without passing through an input,
+    // children first. Inputs appear but are not expanded.
+    std::vector<Value*> topo;
+    // Nodes through which some input is reachable
+    std::set<Value*> relevant;
+};
+
+Graph build_graph(Value* output, const std::vector<Value*>& input_nodes) {
+    Graph graph;
+    std::set<Value*> inputs(input_nodes.begin(), input_nodes.end());
+    std::set<Value*> visited{output};
+
+    // Iterative post-order walk: a node is finished once all its children
+    // are, at which point their relevance is known
+    std::vector<std::pair<Value*, size_t>> stack{{output, 0}};
+    while (!stack.empty()) {
+        auto& [v, next] = stack.back();
+        const bool expand = !inputs.count(v);
+        if (expand && next < v->_prev.size()) {
+            Value* child = v->_prev[next++].get();
+            if (visited.insert(child).second) {
+                stack.emplace_back(child, 0);
+            }
+            continue;
+        }
+
+        bool reaches = !expand;
+        for (size_t i = 0; expand && i < v->_prev.size(); ++i) {
+            reaches = reaches || graph.relevant.count(v->_prev[i].get()) > 0;
+        }
+        if (reaches) {
+            graph.relevant.insert(v);
+        }
+        graph.topo.push_back(v);
+        stack.pop_back();
+    }
+    return graph;
+}
+
+std::vector<Value> grad_matrix(Value* out, const std::vector<Value*>& inputs, const Eigen::MatrixXd& seed) {
+    const Graph graph = build_graph(out, inputs);
+    const std::set<Value*> input_set(inputs.begin(), inputs.end());
+
+    // Run the regular backward on scratch gradients and restore the old ones
+    std::vector<Eigen::MatrixXd> saved;
+    saved.reserve(graph.topo.size());
+    for (auto* node : graph.topo) {
+        saved.push_back(node->grad);
+        node->grad.setZero();
+    }
+
+    out->grad = seed;
+    for (auto it = graph.topo.rbegin(); it != graph.topo.rend(); ++it) {
+        if (graph.relevant.count(*it) && !input_set.count(*it)) {
+            (*it)->_backward();
+        }
+    }
+
+    std::vector<Value> grads;
+    for (auto* input : inputs) {
+        grads.emplace_back(input->grad);
+    }
+
+    for (size_t i = 0; i < graph.topo.size(); ++i) {
+        graph.topo[i]->grad = std::move(saved[i]);
+    }
+    return grads;
+}
+
+std::vector<Value> grad_graph(Value* out, const std::vector<Value*>& inputs, const Value& seed) {
+    const Graph graph = build_graph(out, inputs);
+    const std::set<Value*> input_set(inputs.begin(), inputs.end());
+
+    std::map<Value*, Value> grads;
+    grads.emplace(out, seed);
+
+    for (auto it = graph.topo.rbegin(); it != graph.topo.rend(); ++it) {
+        Value* node = *it;
+        auto g = grads.find(node);
+        if (g == grads.end() || !graph.relevant.count(node) || input_set.count(node)) {
+            continue;
+        }
+        if (!node->_backward_graph) {
+            // Skipping the node would silently drop every path through it
+            throw std::invalid_argument("grad: op '" + node->_op + "' does not support create_graph");
+        }
+
+        const std::vector<Value> child_grads = node->_backward_graph(g->second);
+        for (size_t i = 0; i < node->_prev.size(); ++i) {
+            Value* child = node->_prev[i].get();
+            if (!graph.relevant.count(child)) {
+                continue;
+            }
+            auto existing = grads.find(child);
+            if (existing == grads.end()) {
+                grads.emplace(child, child_grads[i]);
+            } else {
+                existing->second = existing->second + child_grads[i];
+            }
+        }
+    }
+
+    std::vector<Value> result;
+    for (auto* input : inputs) {
+        auto g = grads.find(input);
+        result.push_back(g != grads.end() ? g->second
+                                          : Value(Eigen::MatrixXd::Zero(input->rows(), input->cols())));
+    }
+    return result;
+}
+
+} // namespace
+
+std::vector<Value> grad(const Value& output, const std::vector<Value*>& inputs, const Value* grad_output,
+                        const bool create_graph) {
+    auto out = output.get_self_ptr();
+
+    std::vector<std::shared_ptr<Value>> input_ptrs;
+    std::vector<Value*> input_nodes;
+    for (auto* input : inputs) {
+        input_ptrs.push_back(input->get_self_ptr());
+        input_nodes.push_back(input_ptrs.back().get());
+    }
+
+    if (create_graph) {
+        // Seed with the caller's node itself so the result can be differentiated with respect to it
+        Value seed = grad_output ? *grad_output->get_self_ptr() : Value(Eigen::MatrixXd::Ones(out->rows(), out->cols()));
+        return grad_graph(out.get(), input_nodes, seed);
+    }
+    return grad_matrix(out.get(), input_nodes,
+                       grad_output ? grad_output->data : Eigen::MatrixXd::Ones(out->rows(), out->cols()));
+}
+
+std::vector<Eigen::MatrixXd> vjp(const std::function<Value()>& f, const std::vector<Value*>& inputs,
+                                 const Eigen::MatrixXd& v) {
+    Value y = f();
+    Value seed(v);
+
+    std::vector<Eigen::MatrixXd> result;
+    for (auto& g : grad(y, inputs, &seed)) {
+        result.push_back(g.data);
+    }
+    return result;
+}
+
+Eigen::MatrixXd jvp(const std::function<Value()>& f, const std::vector<Value*>& inputs,
+                    const std::vector<Eigen::MatrixXd>& tangents) {
+    Value y = f();
+    // Any u works since u^T J is linear in u; zeros keep the values finite
+    Value u(Eigen::MatrixXd::Zero(y.rows(), y.cols()));
+    std::vector<Value> g = grad(y, inputs, &u, true);
+
+    Value dot(0.0);
+    for (size_t i = 0; i < g.size(); ++i) {
+        dot = dot + (g[i] * Value(tangents[i])).sum();
+    }
+    return grad(dot, {&u})[0].data;
+}
+
+std::vector<Eigen::MatrixXd> hvp(const std::function<Value()>& f, const std::vector<Value*>& params,
+                                 const std::vector<Eigen::MatrixXd>& vs) {
+    Value loss = f();
+    std::vector<Value> g = grad(loss, params, nullptr, true);
+
+    Value dot(0.0);
+    for (size_t i = 0; i < g.size(); ++i) {
+        dot = dot + (g[i] * Value(vs[i])).sum();
+    }
+
+    std::vector<Eigen::MatrixXd> result;
+    for (auto& hv : grad(dot, params)) {
+        result.push_back(hv.data);
+    }
+    return result;
+}
+
+double gradcheck(const std::function<Value(const std::vector<Value>&)>& f,
+                 const std::vector<Eigen::MatrixXd>& inputs, const double eps) {
+    std::vector<Value> values(inputs.begin(), inputs.end());
+    std::vector<Value*> input_ptrs;
+    for (auto& v : values) {
+        input_ptrs.push_back(&v);
+    }
+    Value y = f(values);
+
+    // Fixed weights, drawn without touching the global generator
+    std::mt19937_64 gen(42);
+    std::normal_distribution<double> normal;
+    Value weights(Eigen::MatrixXd::NullaryExpr(y.rows(), y.cols(), [&]() { return normal(gen); }));
+
+    std::vector<Eigen::MatrixXd> analytic, analytic_graph;
+    for (auto& g : grad(y, input_ptrs, &weights)) {
+        analytic.push_back(g.data);
+    }
+    for (auto& g : grad(y, input_ptrs, &weights, true)) {
+        analytic_graph.push_back(g.data);
+    }
+    y.release_graph();
+
+    auto weighted_output = [&](const std::vector<Eigen::MatrixXd>& points) {
+        const std::vector<Value> shifted(points.begin(), points.end());
+        return f(shifted).data.cwiseProduct(weights.data).sum();
+    };
+
+    double max_error = 0.0;
+    std::vector<Eigen::MatrixXd> points = inputs;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        for (Eigen::Index j = 0; j < inputs[i].size(); ++j) {
+            points[i](j) = inputs[i](j) + eps;
+            const double plus = weighted_output(points);
+            points[i](j) = inputs[i](j) - eps;
+            const double minus = weighted_output(points);
+            points[i](j) = inputs[i](j);
+
+            const double numeric = (plus - minus) / (2 * eps);
+            const double scale = std::max(1.0, std::abs(numeric));
+            max_error = std::max({max_error, std::abs(analytic[i](j) - numeric) / scale,
+                                  std::abs(analytic_graph[i](j) - numeric) / scale});
+        }
+    }
+    return max_error;
+}
+
+} // namespace micrograd
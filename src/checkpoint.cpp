@@ -0,0 +1,183 @@
+#include "checkpoint.hpp"
+#include "nn.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace micrograd {
+
+namespace {
+
+bool copy_file(const std::string& from, const std::string& to) {
+    std::ifstream in(from, std::ios::binary);
+    std::ofstream out(to, std::ios::binary);
+    out << in.rdbuf();
+    return in && out;
+}
+
+// Flushes a file, or a directory's entries, to disk
+bool sync_path(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    const bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+std::string parent_directory(const std::string& path) {
+    const size_t slash = path.find_last_of('/');
+    if (slash == std::string::npos) {
+        return ".";
+    }
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+} // namespace
+
+AsyncCheckpointer::AsyncCheckpointer(const std::string& path, const int max_retained)
+    : path(path), max_retained(std::max(1, max_retained)) {
+    writer = std::thread(&AsyncCheckpointer::run, this);
+}
+
+AsyncCheckpointer::~AsyncCheckpointer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    writer.join();
+}
+
+void AsyncCheckpointer::save(const std::vector<Value*>& params) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        staging.resize(params.size());
+        for (size_t i = 0; i < params.size(); ++i) {
+            // Same-shaped assignment reuses the staging buffer
+            staging[i] = params[i]->data;
+        }
+        pending = true;
+    }
+    cv.notify_all();
+}
+
+void AsyncCheckpointer::save(Module& model) {
+    auto state = model.state();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        staging.resize(state.size());
+        for (size_t i = 0; i < state.size(); ++i) {
+            staging[i] = *state[i];
+        }
+        pending = true;
+    }
+    cv.notify_all();
+}
+
+void AsyncCheckpointer::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this]() { return !pending && !busy; });
+}
+
+int AsyncCheckpointer::num_written() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return written;
+}
+
+void AsyncCheckpointer::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cv.wait(lock, [this]() { return pending || stopping; });
+        if (!pending) {
+            return;
+        }
+
+        std::swap(staging, writing);
+        pending = false;
+        busy = true;
+
+        lock.unlock();
+        const bool ok = write(writing);
+        lock.lock();
+
+        busy = false;
+        if (ok) {
+            written++;
+        }
+        cv.notify_all();
+    }
+}
+
+bool AsyncCheckpointer::write(const std::vector<Eigen::MatrixXd>& snapshot) {
+    const std::string tmp_path = path + ".tmp";
+    std::ofstream file(tmp_path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file " << tmp_path << " for writing" << std::endl;
+        return false;
+    }
+
+    std::vector<const Eigen::MatrixXd*> weights;
+    for (auto& w : snapshot) {
+        weights.push_back(&w);
+    }
+    write_weights(file, weights);
+
+    // The data must be on disk before the rename makes it current, or a crash
+    // could leave an empty or truncated checkpoint in its place
+    file.close();
+    if (!file || !sync_path(tmp_path)) {
+        std::cerr << "Error: Failed to write checkpoint " << tmp_path << std::endl;
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+
+    // rotate() leaves path in place, so the rename replaces it atomically and a
+    // current checkpoint exists at every point, even if the rename fails
+    if (!rotate()) {
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "Error: Could not rename " << tmp_path << " to " << path << std::endl;
+        return false;
+    }
+    // Makes the rename itself, and the rotation before it, durable
+    if (!sync_path(parent_directory(path))) {
+        std::cerr << "Error: Could not sync the directory of " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool AsyncCheckpointer::rotate() {
+    // Shift path.(k-1) -> path.k, dropping whatever was at path.(max_retained - 1)
+    for (int k = max_retained - 1; k >= 2; --k) {
+        const std::string from = path + "." + std::to_string(k - 1);
+        const std::string to = path + "." + std::to_string(k);
+        std::rename(from.c_str(), to.c_str());
+    }
+    if (max_retained == 1) {
+        return true;
+    }
+
+    // The current checkpoint is linked (or copied) to path.1 rather than moved
+    const std::string first = path + ".1";
+    std::remove(first.c_str());
+    if (link(path.c_str(), first.c_str()) == 0 || errno == ENOENT) {
+        return true;
+    }
+    if (!copy_file(path, first)) {
+        std::cerr << "Error: Could not keep " << path << " as " << first << std::endl;
+        std::remove(first.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace micrograd
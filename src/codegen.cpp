@@ -0,0 +1,391 @@
+#include "graph_ir.hpp"
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace micrograd {
+
+namespace {
+
+// Emitted only when the graph contains casts; the same rounding as precision.cpp
+const char* ROUNDING_HELPERS = R"(inline double round_fp32(double x) {
+    return static_cast<double>(static_cast<float>(x));
+}
+
+inline double round_bf16(double x) {
+    const float value = static_cast<float>(x);
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    if ((bits & 0x7FFFFFFF) > 0x7F800000) {
+        return x;
+    }
+    bits += 0x7FFF + ((bits >> 16) & 1);
+    bits &= 0xFFFF0000u;
+    float rounded;
+    std::memcpy(&rounded, &bits, sizeof(rounded));
+    return rounded;
+}
+
+inline double round_fp16(double x) {
+    const float value = static_cast<float>(x);
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint32_t abs = bits & 0x7FFFFFFF;
+    if (abs > 0x7F800000) {
+        return x;
+    }
+    const float sign = (bits >> 31) ? -1.0f : 1.0f;
+    if (abs >= 0x477FF000) {
+        return sign * HUGE_VALF;
+    }
+    if (abs < 0x38800000) {
+        float magnitude;
+        std::memcpy(&magnitude, &abs, sizeof(magnitude));
+        return sign * std::ldexp(std::nearbyint(magnitude * 16777216.0f), -24);
+    }
+    uint32_t rounded = (abs + 0x0FFF + ((abs >> 13) & 1)) & ~0x1FFFu;
+    rounded |= bits & 0x80000000u;
+    float result;
+    std::memcpy(&result, &rounded, sizeof(result));
+    return result;
+}
+
+)";
+
+std::string literal(const double v) {
+    if (std::isnan(v)) {
+        return "NAN";
+    }
+    if (std::isinf(v)) {
+        return v > 0 ? "HUGE_VAL" : "-HUGE_VAL";
+    }
+    std::ostringstream out;
+    out.precision(17);
+    out << v;
+    std::string s = out.str();
+    if (s.find_first_of(".eE") == std::string::npos) {
+        s += ".0";
+    }
+    return s;
+}
+
+void write_array(std::ostream& out, const std::string& name, const double* data, const long long size) {
+    out << "alignas(64) const double " << name << "[" << size << "] = {";
+    for (long long k = 0; k < size; ++k) {
+        out << (k % 6 == 0 ? "\n    " : " ") << literal(data[k]) << (k + 1 < size ? "," : "");
+    }
+    out << "\n};\n\n";
+}
+
+// Element (i, j) of a buffer of the given shape read at an output position,
+// repeating row and column vectors
+std::string element(const std::string& name, const IRNode& node, const bool flat) {
+    if (flat) {
+        return name + "[k]";
+    }
+    std::string index = node.rows == 1 ? "" : "i";
+    if (node.cols != 1) {
+        const std::string col = node.rows == 1 ? "j" : "j * " + std::to_string(node.rows);
+        index = index.empty() ? col : index + " + " + col;
+    }
+    return name + "[" + (index.empty() ? "0" : index) + "]";
+}
+
+class Emitter {
+public:
+    Emitter(const IRGraph& graph, std::ostream& out) : graph(graph), out(out) {}
+
+    bool emit(const std::string& function_name);
+
+private:
+    bool emit_node(int i);
+    // out[k] = expr over the operands; a flat loop when no operand is broadcast
+    void elementwise(int i, const std::string& expr_template);
+
+    const IRGraph& graph;
+    std::ostream& out;
+    std::vector<std::string> names;
+};
+
+void Emitter::elementwise(const int i, const std::string& expr_template) {
+    const IRNode& node = graph.nodes[i];
+    bool flat = true;
+    for (int input : node.inputs) {
+        flat = flat && graph.nodes[input].rows == node.rows && graph.nodes[input].cols == node.cols;
+    }
+
+    // $0, $1 in the template stand for the operands
+    std::string expr = expr_template;
+    for (size_t k = 0; k < node.inputs.size(); ++k) {
+        const std::string token = "$" + std::to_string(k);
+        const std::string value = element(names[node.inputs[k]], graph.nodes[node.inputs[k]], flat);
+        for (size_t pos = expr.find(token); pos != std::string::npos; pos = expr.find(token, pos + value.size())) {
+            expr.replace(pos, token.size(), value);
+        }
+    }
+
+    if (flat) {
+        out << "    for (int k = 0; k < " << node.rows * node.cols << "; ++k) {\n";
+        out << "        " << names[i] << "[k] = " << expr << ";\n";
+        out << "    }\n";
+    } else {
+        out << "    for (int j = 0; j < " << node.cols << "; ++j) {\n";
+        out << "        for (int i = 0; i < " << node.rows << "; ++i) {\n";
+        out << "            " << names[i] << "[i + j * " << node.rows << "] = " << expr << ";\n";
+        out << "        }\n";
+        out << "    }\n";
+    }
+}
+
+bool Emitter::emit_node(const int i) {
+    const IRNode& node = graph.nodes[i];
+    const std::string& op = node.op;
+    const std::string o = names[i];
+    const int r = node.rows;
+    const int c = node.cols;
+    out << "    // " << op << " -> " << r << "x" << c << "\n";
+
+    if (op == "+" && node.inputs.size() == 1) {
+        elementwise(i, "$0 + " + literal(node.attrs[0]));
+    } else if (op == "*" && node.inputs.size() == 1) {
+        elementwise(i, "$0 * " + literal(node.attrs[0]));
+    } else if (op == "+" || op == "-" || op == "*" || op == "/") {
+        elementwise(i, "$0 " + op + " $1");
+    } else if (op == "pow") {
+        elementwise(i, "std::pow($0, " + literal(node.attrs[0]) + ")");
+    } else if (op == "relu") {
+        elementwise(i, "$0 > 0.0 ? $0 : 0.0");
+    } else if (op == "sigmoid") {
+        elementwise(i, "1.0 / (1.0 + std::exp(-$0))");
+    } else if (op == "tanh") {
+        elementwise(i, "std::tanh($0)");
+    } else if (op == "gelu") {
+        const std::string k = literal(std::sqrt(2.0 / M_PI));
+        elementwise(i, "0.5 * $0 * (1.0 + std::tanh(" + k + " * ($0 + 0.044715 * ($0 * $0 * $0))))");
+    } else if (op == "leaky_relu") {
+        elementwise(i, "$0 > 0.0 ? $0 : " + literal(node.attrs[0]) + " * $0");
+    } else if (op == "silu") {
+        elementwise(i, "$0 * (1.0 / (1.0 + std::exp(-$0)))");
+    } else if (op == "cast") {
+        const int precision = static_cast<int>(node.attrs[0]);
+        const char* fn[] = {"", "round_fp32", "round_bf16", "round_fp16"};
+        elementwise(i, precision >= 1 && precision <= 3 ? std::string(fn[precision]) + "($0)" : "$0");
+    } else if (op == "broadcast_to") {
+        elementwise(i, "$0");
+    } else if (op == "reshape") {
+        out << "    std::memcpy(" << o << ", " << names[node.inputs[0]] << ", sizeof(double) * " << r * c << ");\n";
+    } else if (op == "T") {
+        const std::string a = names[node.inputs[0]];
+        out << "    for (int j = 0; j < " << r << "; ++j) {\n";
+        out << "        for (int i = 0; i < " << c << "; ++i) {\n";
+        out << "            " << o << "[j + i * " << r << "] = " << a << "[i + j * " << c << "];\n";
+        out << "        }\n";
+        out << "    }\n";
+    } else if (op == "@") {
+        const IRNode& a = graph.nodes[node.inputs[0]];
+        const std::string an = names[node.inputs[0]];
+        const std::string bn = names[node.inputs[1]];
+        const int k = a.cols;
+        // Column-major GEMM as a sequence of axpys over the contiguous columns of a
+        out << "    for (int j = 0; j < " << c << "; ++j) {\n";
+        out << "        double* col = " << o << " + j * " << r << ";\n";
+        out << "        for (int i = 0; i < " << r << "; ++i) {\n";
+        out << "            col[i] = 0.0;\n";
+        out << "        }\n";
+        out << "        for (int p = 0; p < " << k << "; ++p) {\n";
+        out << "            const double s = " << bn << "[p + j * " << k << "];\n";
+        out << "            const double* a = " << an << " + p * " << r << ";\n";
+        out << "            for (int i = 0; i < " << r << "; ++i) {\n";
+        out << "                col[i] += a[i] * s;\n";
+        out << "            }\n";
+        out << "        }\n";
+        out << "    }\n";
+    } else if (op == "sum_to") {
+        const IRNode& a = graph.nodes[node.inputs[0]];
+        const std::string an = names[node.inputs[0]];
+        out << "    for (int k = 0; k < " << r * c << "; ++k) {\n";
+        out << "        " << o << "[k] = 0.0;\n";
+        out << "    }\n";
+        out << "    for (int j = 0; j < " << a.cols << "; ++j) {\n";
+        out << "        for (int i = 0; i < " << a.rows << "; ++i) {\n";
+        out << "            " << element(o, node, false) << " += " << an << "[i + j * " << a.rows << "];\n";
+        out << "        }\n";
+        out << "    }\n";
+    } else if (op == "softmax") {
+        const std::string a = names[node.inputs[0]];
+        out << "    for (int i = 0; i < " << r << "; ++i) {\n";
+        out << "        double m = " << a << "[i];\n";
+        out << "        for (int j = 1; j < " << c << "; ++j) {\n";
+        out << "            m = std::fmax(m, " << a << "[i + j * " << r << "]);\n";
+        out << "        }\n";
+        out << "        double total = 0.0;\n";
+        out << "        for (int j = 0; j < " << c << "; ++j) {\n";
+        out << "            " << o << "[i + j * " << r << "] = std::exp(" << a << "[i + j * " << r << "] - m);\n";
+        out << "            total += " << o << "[i + j * " << r << "];\n";
+        out << "        }\n";
+        out << "        for (int j = 0; j < " << c << "; ++j) {\n";
+        out << "            " << o << "[i + j * " << r << "] /= total;\n";
+        out << "        }\n";
+        out << "    }\n";
+    } else if (op == "batchnorm") {
+        const std::string x = names[node.inputs[0]];
+        const std::string gamma = names[node.inputs[1]];
+        const std::string beta = names[node.inputs[2]];
+        out << "    for (int j = 0; j < " << c << "; ++j) {\n";
+        out << "        for (int i = 0; i < " << r << "; ++i) {\n";
+        const std::string norm = "norm" + std::to_string(i);
+        out << "            " << o << "[i + j * " << r << "] = (" << x << "[i + j * " << r << "] - " << norm
+            << "_mean[j]) * " << norm << "_inv_std[j] * " << gamma << "[j] + " << beta << "[j];\n";
+        out << "        }\n";
+        out << "    }\n";
+    } else {
+        std::cerr << "Error: No code generator for op '" << op << "'" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Emitter::emit(const std::string& function_name) {
+    const int n = static_cast<int>(graph.nodes.size());
+    if (graph.output < 0 || graph.output >= n) {
+        std::cerr << "Error: Graph has no output" << std::endl;
+        return false;
+    }
+
+    // Last consumer of each node, for buffer reuse
+    std::vector<int> last_use(n, -1);
+    for (int i = 0; i < n; ++i) {
+        for (int input : graph.nodes[i].inputs) {
+            last_use[input] = std::max(last_use[input], i);
+        }
+    }
+
+    // Assign storage: inputs and parameters keep their own arrays, the output
+    // writes to the caller's buffer and every other node takes a free static
+    // buffer, growing it if needed
+    names.assign(n, "");
+    std::vector<long long> capacity;
+    std::vector<int> free_buffers;
+    std::vector<int> buffer_of(n, -1);
+    bool has_cast = false;
+    for (size_t k = 0; k < graph.inputs.size(); ++k) {
+        names[graph.inputs[k]] = "input" + std::to_string(k);
+    }
+    for (int i = 0; i < n; ++i) {
+        const IRNode& node = graph.nodes[i];
+        if (node.op == "input") {
+            continue;
+        }
+        if (node.op == "param") {
+            names[i] = "p" + std::to_string(i);
+            continue;
+        }
+        has_cast = has_cast || node.op == "cast";
+        if (i == graph.output) {
+            names[i] = "output";
+        } else {
+            int b;
+            if (free_buffers.empty()) {
+                b = static_cast<int>(capacity.size());
+                capacity.push_back(0);
+            } else {
+                b = free_buffers.back();
+                free_buffers.pop_back();
+            }
+            capacity[b] = std::max(capacity[b], static_cast<long long>(node.rows) * node.cols);
+            buffer_of[i] = b;
+            names[i] = "buffer" + std::to_string(b);
+        }
+        // Operands are released only after the result has its own buffer
+        for (int input : node.inputs) {
+            if (last_use[input] == i && buffer_of[input] >= 0) {
+                free_buffers.push_back(buffer_of[input]);
+                buffer_of[input] = -1;
+            }
+        }
+    }
+
+    const IRNode& result = graph.nodes[graph.output];
+    out << "// Generated by micrograd generate_cpp. Forward pass with fixed shapes:\n";
+    out << "//\n";
+    out << "//     void " << function_name << "(";
+    for (size_t k = 0; k < graph.inputs.size(); ++k) {
+        const IRNode& input = graph.nodes[graph.inputs[k]];
+        out << "const double* input" << k << " /* " << input.rows << "x" << input.cols << " */, ";
+    }
+    out << "double* output /* " << result.rows << "x" << result.cols << " */);\n";
+    out << "//\n";
+    out << "// All buffers are column-major. Not reentrant: intermediates live in static storage.\n\n";
+    out << "#include <cmath>\n#include <cstdint>\n#include <cstring>\n\n";
+    out << "namespace {\n\n";
+    if (has_cast) {
+        out << ROUNDING_HELPERS;
+    }
+    for (int i = 0; i < n; ++i) {
+        const IRNode& node = graph.nodes[i];
+        if (node.op == "param") {
+            write_array(out, names[i], node.data.data(), node.data.size());
+        } else if (node.op == "batchnorm") {
+            write_array(out, "norm" + std::to_string(i) + "_mean", node.attrs.data(), node.cols);
+            write_array(out, "norm" + std::to_string(i) + "_inv_std", node.attrs.data() + node.cols, node.cols);
+        }
+    }
+    for (size_t b = 0; b < capacity.size(); ++b) {
+        out << "alignas(64) double buffer" << b << "[" << capacity[b] << "];\n";
+    }
+    out << "\n} // namespace\n\n";
+
+    out << "void " << function_name << "(";
+    for (size_t k = 0; k < graph.inputs.size(); ++k) {
+        out << "const double* input" << k << ", ";
+    }
+    out << "double* output) {\n";
+    for (size_t k = 0; k < graph.inputs.size(); ++k) {
+        if (last_use[graph.inputs[k]] < 0 && graph.inputs[k] != graph.output) {
+            out << "    (void)input" << k << ";\n";
+        }
+    }
+
+    // A bare input or parameter as the output is a copy
+    const std::string& output_op = result.op;
+    if (output_op == "input" || output_op == "param") {
+        out << "    std::memcpy(output, " << names[graph.output] << ", sizeof(double) * " << result.rows * result.cols
+            << ");\n";
+    }
+    for (int i = 0; i < n; ++i) {
+        const IRNode& node = graph.nodes[i];
+        if (node.op == "input" || node.op == "param") {
+            continue;
+        }
+        if (!emit_node(i)) {
+            return false;
+        }
+    }
+    out << "}\n";
+    return true;
+}
+
+} // namespace
+
+bool generate_cpp(const IRGraph& graph, const std::string& path, const std::string& function_name) {
+    std::ostringstream source;
+    Emitter emitter(graph, source);
+    if (!emitter.emit(function_name)) {
+        return false;
+    }
+
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file " << path << " for writing" << std::endl;
+        return false;
+    }
+    file << source.str();
+    if (!file) {
+        std::cerr << "Error: Failed writing " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace micrograd
@@ -0,0 +1,559 @@
+#include "dataset.hpp"
+#include "precision.hpp"
+#include "random.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <memory>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+
+namespace micrograd {
+
+namespace {
+
+const char INDEX_MAGIC[4] = {'M', 'G', 'D', 'S'};
+const uint32_t INDEX_VERSION = 1;
+
+std::string shard_path(const std::string& prefix, const int shard) {
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), "-%05d.shard", shard);
+    return prefix + suffix;
+}
+
+int feature_bytes(const FeatureType type) {
+    return type == FeatureType::UInt8 ? 1 : 2;
+}
+
+// The index and the records are little-endian whatever the host byte order
+template <typename U>
+void store_little_endian(unsigned char* p, const U bits) {
+    for (size_t i = 0; i < sizeof(U); ++i) {
+        p[i] = static_cast<unsigned char>(bits >> (8 * i));
+    }
+}
+
+template <typename U>
+U load_little_endian(const unsigned char* p) {
+    U bits = 0;
+    for (size_t i = 0; i < sizeof(U); ++i) {
+        bits |= static_cast<U>(p[i]) << (8 * i);
+    }
+    return bits;
+}
+
+// Same-sized unsigned integer for the bytes of a 4- or 8-byte value
+template <typename T>
+using Bits = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+
+template <typename T>
+void write_pod(std::ofstream& file, const T& value) {
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "index fields are 4 or 8 bytes");
+    Bits<T> bits;
+    std::memcpy(&bits, &value, sizeof(T));
+    unsigned char bytes[sizeof(T)];
+    store_little_endian(bytes, bits);
+    file.write(reinterpret_cast<const char*>(bytes), sizeof(T));
+}
+
+template <typename T>
+bool read_pod(std::ifstream& file, T& value) {
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "index fields are 4 or 8 bytes");
+    unsigned char bytes[sizeof(T)];
+    if (!file.read(reinterpret_cast<char*>(bytes), sizeof(T))) {
+        return false;
+    }
+    const Bits<T> bits = load_little_endian<Bits<T>>(bytes);
+    std::memcpy(&value, &bits, sizeof(T));
+    return true;
+}
+
+// IDX headers are big-endian
+bool read_big_endian(std::ifstream& file, int& value) {
+    unsigned char bytes[4];
+    if (!file.read(reinterpret_cast<char*>(bytes), 4)) {
+        return false;
+    }
+    value = (bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+    return true;
+}
+
+} // namespace
+
+TensorDataset::TensorDataset(const Eigen::MatrixXd& features, const Eigen::VectorXi& labels)
+    : features(features), labels(labels) {}
+
+void TensorDataset::read(const long long begin, const int count, Eigen::MatrixXd& out_features,
+                         Eigen::VectorXi& out_labels) const {
+    if (begin < 0 || count < 0 || begin + count > size()) {
+        std::cerr << "Error: Records [" << begin << ", " << begin + count << ") out of range for dataset of "
+                  << size() << std::endl;
+        out_features.resize(0, features.cols());
+        out_labels.resize(0);
+        return;
+    }
+    out_features = features.middleRows(begin, count);
+    out_labels = labels.segment(begin, count);
+}
+
+ShardWriter::ShardWriter(const std::string& prefix, const int num_features, const FeatureType type,
+                         const double scale, const int records_per_shard)
+    : prefix(prefix), num_features(num_features), type(type), scale(scale),
+      records_per_shard(std::max(1, records_per_shard)),
+      record(sizeof(int32_t) + num_features * feature_bytes(type)) {}
+
+ShardWriter::~ShardWriter() {
+    if (!closed) {
+        abort();
+    }
+}
+
+bool ShardWriter::open_shard() {
+    shard.close();
+    if (shards == 0) {
+        // An index left from an earlier dataset at this prefix would describe the shards being overwritten
+        std::remove((prefix + ".index").c_str());
+    }
+    const std::string path = shard_path(prefix, num_records / records_per_shard);
+    shard.open(path, std::ios::binary | std::ios::trunc);
+    shards++;
+    if (!shard.is_open()) {
+        std::cerr << "Error: Could not open " << path << " for writing" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ShardWriter::write(const Eigen::Ref<const Eigen::RowVectorXd>& features, const int label) {
+    if (!ok || closed) {
+        return false;
+    }
+    if (features.size() != num_features) {
+        std::cerr << "Error: ShardWriter expected " << num_features << " features, got " << features.size()
+                  << std::endl;
+        return false;
+    }
+    if (label < 0) {
+        std::cerr << "Error: ShardWriter got negative label " << label << std::endl;
+        return false;
+    }
+    if (num_records % records_per_shard == 0 && !open_shard()) {
+        ok = false;
+        return false;
+    }
+
+    store_little_endian(record.data(), static_cast<uint32_t>(label));
+    unsigned char* p = record.data() + sizeof(int32_t);
+    for (int j = 0; j < num_features; ++j) {
+        if (type == FeatureType::UInt8) {
+            p[j] = static_cast<uint8_t>(std::clamp(std::round(features(j)), 0.0, 255.0));
+        } else {
+            store_little_endian(p + 2 * j, float_to_fp16(static_cast<float>(features(j))));
+        }
+    }
+
+    if (!shard.write(reinterpret_cast<const char*>(record.data()), record.size())) {
+        std::cerr << "Error: Failed writing shard of " << prefix << std::endl;
+        ok = false;
+        return false;
+    }
+    num_records++;
+    return true;
+}
+
+bool ShardWriter::close() {
+    if (closed) {
+        return ok;
+    }
+    closed = true;
+    shard.close();
+    if (!ok) {
+        abort();
+        return false;
+    }
+
+    std::ofstream index(prefix + ".index", std::ios::binary | std::ios::trunc);
+    if (!index.is_open()) {
+        std::cerr << "Error: Could not open " << prefix << ".index for writing" << std::endl;
+        abort();
+        return false;
+    }
+    index.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    write_pod(index, INDEX_VERSION);
+    write_pod(index, static_cast<uint32_t>(type));
+    write_pod(index, static_cast<uint32_t>(num_features));
+    write_pod(index, static_cast<uint32_t>(records_per_shard));
+    write_pod(index, static_cast<uint64_t>(num_records));
+    write_pod(index, scale);
+    index.close();
+    if (!index) {
+        std::cerr << "Error: Failed writing " << prefix << ".index" << std::endl;
+        abort();
+        return false;
+    }
+    return true;
+}
+
+void ShardWriter::abort() {
+    closed = true;
+    ok = false;
+    shard.close();
+    for (int s = 0; s < shards; ++s) {
+        std::remove(shard_path(prefix, s).c_str());
+    }
+    std::remove((prefix + ".index").c_str());
+}
+
+ShardedDataset::~ShardedDataset() {
+    close();
+}
+
+void ShardedDataset::close() {
+    for (int fd : shard_fds) {
+        ::close(fd);
+    }
+    shard_fds.clear();
+    num_records = 0;
+}
+
+int ShardedDataset::record_bytes() const {
+    return sizeof(int32_t) + features_per_record * feature_bytes(type);
+}
+
+bool ShardedDataset::open(const std::string& prefix) {
+    close();
+
+    std::ifstream index(prefix + ".index", std::ios::binary);
+    if (!index.is_open()) {
+        std::cerr << "Cannot open dataset index: " << prefix << ".index" << std::endl;
+        return false;
+    }
+
+    char magic[4];
+    uint32_t version = 0, type_id = 0, features = 0, shard_records = 0;
+    uint64_t records = 0;
+    double file_scale = 1.0;
+    if (!index.read(magic, sizeof(magic)) || std::memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0 ||
+        !read_pod(index, version) || version != INDEX_VERSION) {
+        std::cerr << "Invalid dataset index: " << prefix << ".index" << std::endl;
+        return false;
+    }
+    if (!read_pod(index, type_id) || !read_pod(index, features) || !read_pod(index, shard_records) ||
+        !read_pod(index, records) || !read_pod(index, file_scale) || type_id > 1 || shard_records == 0) {
+        std::cerr << "Truncated or corrupt dataset index: " << prefix << ".index" << std::endl;
+        return false;
+    }
+
+    type = static_cast<FeatureType>(type_id);
+    features_per_record = features;
+    records_per_shard = shard_records;
+    scale = file_scale;
+
+    const long long num_shards = (records + shard_records - 1) / shard_records;
+    for (long long s = 0; s < num_shards; ++s) {
+        const std::string path = shard_path(prefix, s);
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        const long long expected = std::min<long long>(shard_records, records - s * shard_records) * record_bytes();
+        struct stat st = {};
+        if (fd < 0 || ::fstat(fd, &st) != 0 || st.st_size < expected) {
+            std::cerr << "Missing or truncated shard: " << path << std::endl;
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            close();
+            return false;
+        }
+        shard_fds.push_back(fd);
+    }
+    num_records = records;
+    return true;
+}
+
+void ShardedDataset::read(const long long begin, const int count, Eigen::MatrixXd& features,
+                          Eigen::VectorXi& labels) const {
+    if (begin < 0 || count < 0 || begin + count > num_records) {
+        std::cerr << "Error: Records [" << begin << ", " << begin + count << ") out of range for dataset of "
+                  << num_records << std::endl;
+        features.resize(0, features_per_record);
+        labels.resize(0);
+        return;
+    }
+
+    features.resize(count, features_per_record);
+    labels.resize(count);
+
+    const int stride = record_bytes();
+    std::vector<unsigned char> bytes;
+    long long pos = begin;
+    int row = 0;
+    while (row < count) {
+        const int shard = pos / records_per_shard;
+        const int offset = pos % records_per_shard;
+        const int n = std::min(count - row, records_per_shard - offset);
+
+        // One contiguous read per shard
+        bytes.resize(static_cast<size_t>(n) * stride);
+        size_t done = 0;
+        while (done < bytes.size()) {
+            const ssize_t r = ::pread(shard_fds[shard], bytes.data() + done, bytes.size() - done,
+                                      static_cast<off_t>(offset) * stride + done);
+            if (r <= 0) {
+                std::cerr << "Error: Failed reading shard " << shard << std::endl;
+                features.resize(0, features_per_record);
+                labels.resize(0);
+                return;
+            }
+            done += r;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            const unsigned char* record = bytes.data() + static_cast<size_t>(i) * stride;
+            const int32_t label = static_cast<int32_t>(load_little_endian<uint32_t>(record));
+            if (label < 0) {
+                // Labels index class scores, so a negative one would be read out of bounds downstream
+                std::cerr << "Error: Negative label " << label << " in record " << pos + i << std::endl;
+                features.resize(0, features_per_record);
+                labels.resize(0);
+                return;
+            }
+            labels(row + i) = label;
+            const unsigned char* p = record + sizeof(label);
+            for (int j = 0; j < features_per_record; ++j) {
+                if (type == FeatureType::UInt8) {
+                    features(row + i, j) = p[j] * scale;
+                } else {
+                    features(row + i, j) = fp16_to_float(load_little_endian<uint16_t>(p + 2 * j)) * scale;
+                }
+            }
+        }
+
+        row += n;
+        pos += n;
+    }
+}
+
+DataLoader::DataLoader(const Dataset& dataset, const Options options)
+    : source(dataset), options(options), generator(global_generator()()) {
+    this->options.batch_size = std::max(1, options.batch_size);
+    this->options.block_size = std::max(1, options.block_size);
+    reset();
+}
+
+DataLoader::DataLoader(const Dataset& dataset) : DataLoader(dataset, Options()) {}
+
+int DataLoader::num_batches() const {
+    return (source.size() + options.batch_size - 1) / options.batch_size;
+}
+
+void DataLoader::reset() {
+    failed = false;
+    cursor = 0;
+    fill = 0;
+    next_block = 0;
+    blocks.clear();
+    if (options.shuffle_buffer <= 0) {
+        return;
+    }
+
+    for (long long start = 0; start < source.size(); start += options.block_size) {
+        blocks.push_back(start);
+    }
+    std::shuffle(blocks.begin(), blocks.end(), generator);
+    buffer.resize(options.shuffle_buffer + options.block_size, source.num_features());
+    buffer_labels.resize(buffer.rows());
+}
+
+bool DataLoader::load_block() {
+    const long long start = blocks[next_block++];
+    const int n = std::min<long long>(options.block_size, source.size() - start);
+    source.read(start, n, block_features, block_labels);
+    if (block_labels.size() != n) {
+        return false;
+    }
+    buffer.middleRows(fill, block_features.rows()) = block_features;
+    buffer_labels.segment(fill, block_labels.size()) = block_labels;
+    fill += block_labels.size();
+    return true;
+}
+
+bool DataLoader::next(Eigen::MatrixXd& features, Eigen::VectorXi& labels) {
+    if (failed) {
+        return false;
+    }
+    if (options.shuffle_buffer <= 0) {
+        if (cursor >= source.size()) {
+            return false;
+        }
+        const int n = std::min<long long>(options.batch_size, source.size() - cursor);
+        source.read(cursor, n, features, labels);
+        cursor += n;
+        failed = labels.size() == 0;
+        return !failed;
+    }
+
+    features.resize(options.batch_size, source.num_features());
+    labels.resize(options.batch_size);
+    int n = 0;
+    while (n < options.batch_size) {
+        // Top the buffer up before each draw so it stays close to shuffle_buffer records
+        if (fill < options.shuffle_buffer && next_block < blocks.size() && !load_block()) {
+            // A block that cannot be read fails the batch, as on the sequential path
+            failed = true;
+            return false;
+        }
+        if (fill == 0) {
+            break;
+        }
+
+        std::uniform_int_distribution<int> pick(0, fill - 1);
+        const int r = pick(generator);
+        features.row(n) = buffer.row(r);
+        labels(n) = buffer_labels(r);
+        // Fill the hole with the last buffered record
+        fill--;
+        buffer.row(r) = buffer.row(fill);
+        buffer_labels(r) = buffer_labels(fill);
+        n++;
+    }
+
+    if (n < options.batch_size) {
+        features.conservativeResize(n, Eigen::NoChange);
+        labels.conservativeResize(n);
+    }
+    return n > 0;
+}
+
+bool convert_idx(const std::string& images_path, const std::string& labels_path, const std::string& prefix,
+                 const int records_per_shard) {
+    std::ifstream image_file(images_path, std::ios::binary);
+    std::ifstream label_file(labels_path, std::ios::binary);
+    if (!image_file.is_open() || !label_file.is_open()) {
+        std::cerr << "Cannot open IDX files: " << images_path << ", " << labels_path << std::endl;
+        return false;
+    }
+
+    int image_magic = 0, num_images = 0, rows = 0, cols = 0, label_magic = 0, num_labels = 0;
+    if (!read_big_endian(image_file, image_magic) || image_magic != 2051 || !read_big_endian(image_file, num_images) ||
+        !read_big_endian(image_file, rows) || !read_big_endian(image_file, cols)) {
+        std::cerr << "Invalid IDX image file!" << std::endl;
+        return false;
+    }
+    if (!read_big_endian(label_file, label_magic) || label_magic != 2049 || !read_big_endian(label_file, num_labels)) {
+        std::cerr << "Invalid IDX label file!" << std::endl;
+        return false;
+    }
+    if (num_labels != num_images) {
+        std::cerr << "Number of labels does not match number of images!" << std::endl;
+        return false;
+    }
+
+    const int image_size = rows * cols;
+    ShardWriter writer(prefix, image_size, FeatureType::UInt8, 1.0 / 255.0, records_per_shard);
+    std::vector<unsigned char> pixels(image_size);
+    Eigen::RowVectorXd features(image_size);
+    for (int i = 0; i < num_images; ++i) {
+        unsigned char label = 0;
+        if (!image_file.read(reinterpret_cast<char*>(pixels.data()), image_size) ||
+            !label_file.read(reinterpret_cast<char*>(&label), 1)) {
+            std::cerr << "IDX files truncated at record " << i << std::endl;
+            return false;
+        }
+        for (int j = 0; j < image_size; ++j) {
+            features(j) = pixels[j];
+        }
+        if (!writer.write(features, label)) {
+            return false;
+        }
+    }
+
+    if (!writer.close()) {
+        return false;
+    }
+    std::cout << "Converted " << num_images << " images (" << rows << "x" << cols << ") to " << prefix << std::endl;
+    return true;
+}
+
+bool convert_csv(const std::string& csv_path, const std::string& prefix, const int label_column,
+                 const bool has_header, const FeatureType type, const int records_per_shard) {
+    std::ifstream file(csv_path);
+    if (!file.is_open()) {
+        std::cerr << "Cannot open CSV file: " << csv_path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    if (has_header) {
+        std::getline(file, line);
+    }
+
+    std::unique_ptr<ShardWriter> writer;
+    std::vector<double> values;
+    Eigen::RowVectorXd features;
+    int line_number = has_header ? 1 : 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        if (line.empty() || line == "\r") {
+            continue;
+        }
+
+        values.clear();
+        const char* p = line.c_str();
+        while (true) {
+            char* end = nullptr;
+            values.push_back(std::strtod(p, &end));
+            if (end == p) {
+                std::cerr << "Error: Non-numeric field on line " << line_number << " of " << csv_path << std::endl;
+                return false;
+            }
+            while (*end == ' ' || *end == '\r') {
+                end++;
+            }
+            if (*end != ',') {
+                break;
+            }
+            p = end + 1;
+        }
+
+        const int num_columns = values.size();
+        if (!writer) {
+            if (label_column < 0 || label_column >= num_columns) {
+                std::cerr << "Error: Label column " << label_column << " out of range for " << num_columns
+                          << " columns" << std::endl;
+                return false;
+            }
+            writer = std::make_unique<ShardWriter>(prefix, num_columns - 1, type, 1.0, records_per_shard);
+            features.resize(num_columns - 1);
+        }
+        if (num_columns != features.size() + 1) {
+            std::cerr << "Error: Line " << line_number << " has " << num_columns << " columns, expected "
+                      << features.size() + 1 << std::endl;
+            return false;
+        }
+
+        for (int c = 0, j = 0; c < num_columns; ++c) {
+            if (c != label_column) {
+                features(j++) = values[c];
+            }
+        }
+        if (!writer->write(features, static_cast<int>(values[label_column]))) {
+            return false;
+        }
+    }
+
+    if (!writer) {
+        std::cerr << "Error: No records in " << csv_path << std::endl;
+        return false;
+    }
+    if (!writer->close()) {
+        return false;
+    }
+    std::cout << "Converted " << writer->size() << " CSV records to " << prefix << std::endl;
+    return true;
+}
+
+} // namespace micrograd
@@ -0,0 +1,487 @@
+#include "distributed.hpp"
+#include "precision.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <numeric>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace micrograd {
+
+namespace {
+
+const int IO_TIMEOUT_MS = 60000;
+
+sockaddr_in make_address(const std::string& host, const int port) {
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    ::inet_pton(AF_INET, host.c_str(), &addr.sin_addr);
+    return addr;
+}
+
+void set_no_delay(const int fd) {
+    const int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+// Chunk c of a ring collective covers [chunk_begin(c), chunk_begin(c + 1))
+int chunk_begin(const int chunk, const int count, const int world_size) {
+    return static_cast<long long>(chunk) * count / world_size;
+}
+
+double seconds_since(const std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+ProcessGroup::ProcessGroup(const int rank, const int world_size, const std::string& host, const int base_port)
+    : rank(rank), world_size(world_size), host(host), base_port(base_port) {}
+
+ProcessGroup::~ProcessGroup() {
+    for (int fd : {listen_fd, next_fd, prev_fd}) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+}
+
+bool ProcessGroup::connect(const int timeout_ms) {
+    if (world_size <= 1) {
+        return true;
+    }
+
+    listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        std::cerr << "Error: Rank " << rank << " could not create a socket" << std::endl;
+        return false;
+    }
+    const int one = 1;
+    ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr = make_address(host, base_port + rank);
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(listen_fd, 4) < 0) {
+        std::cerr << "Error: Rank " << rank << " could not listen on port " << base_port + rank << std::endl;
+        return false;
+    }
+
+    // The next rank may not be listening yet; its backlog accepts us before it calls accept()
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    const int next = (rank + 1) % world_size;
+    sockaddr_in next_addr = make_address(host, base_port + next);
+    while (true) {
+        next_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (next_fd < 0) {
+            std::cerr << "Error: Rank " << rank << " could not create a socket" << std::endl;
+            return false;
+        }
+        if (::connect(next_fd, reinterpret_cast<sockaddr*>(&next_addr), sizeof(next_addr)) == 0) {
+            break;
+        }
+        ::close(next_fd);
+        next_fd = -1;
+        if (std::chrono::steady_clock::now() > deadline) {
+            std::cerr << "Error: Rank " << rank << " timed out connecting to rank " << next << std::endl;
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    const int32_t my_rank = rank;
+    if (::send(next_fd, &my_rank, sizeof(my_rank), MSG_NOSIGNAL) != sizeof(my_rank)) {
+        return false;
+    }
+
+    pollfd pfd = {listen_fd, POLLIN, 0};
+    if (::poll(&pfd, 1, timeout_ms) <= 0 || (prev_fd = ::accept(listen_fd, nullptr, nullptr)) < 0) {
+        std::cerr << "Error: Rank " << rank << " timed out waiting for its predecessor" << std::endl;
+        return false;
+    }
+    int32_t prev_rank = -1;
+    if (::recv(prev_fd, &prev_rank, sizeof(prev_rank), MSG_WAITALL) != sizeof(prev_rank) ||
+        prev_rank != (rank + world_size - 1) % world_size) {
+        std::cerr << "Error: Rank " << rank << " got an unexpected peer (rank " << prev_rank << ")" << std::endl;
+        return false;
+    }
+
+    set_no_delay(next_fd);
+    set_no_delay(prev_fd);
+    ::close(listen_fd);
+    listen_fd = -1;
+    return true;
+}
+
+bool ProcessGroup::exchange(const void* send_buf, const size_t send_bytes, void* recv_buf, const size_t recv_bytes) {
+    // Non-blocking I/O on both sockets: if every rank blocked in send() with
+    // full socket buffers, the ring would deadlock
+    size_t sent_bytes = 0;
+    size_t received = 0;
+    while (sent_bytes < send_bytes || received < recv_bytes) {
+        pollfd fds[2];
+        int n = 0;
+        int send_slot = -1;
+        int recv_slot = -1;
+        if (sent_bytes < send_bytes) {
+            send_slot = n;
+            fds[n++] = {next_fd, POLLOUT, 0};
+        }
+        if (received < recv_bytes) {
+            recv_slot = n;
+            fds[n++] = {prev_fd, POLLIN, 0};
+        }
+        if (::poll(fds, n, IO_TIMEOUT_MS) <= 0) {
+            std::cerr << "Error: Rank " << rank << " timed out in a collective" << std::endl;
+            return false;
+        }
+
+        if (send_slot >= 0 && fds[send_slot].revents) {
+            const ssize_t w = ::send(next_fd, static_cast<const char*>(send_buf) + sent_bytes, send_bytes - sent_bytes,
+                                     MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (w < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                std::cerr << "Error: Rank " << rank << " lost its connection to the next rank" << std::endl;
+                return false;
+            }
+            sent_bytes += std::max<ssize_t>(w, 0);
+        }
+        if (recv_slot >= 0 && fds[recv_slot].revents) {
+            const ssize_t r =
+                ::recv(prev_fd, static_cast<char*>(recv_buf) + received, recv_bytes - received, MSG_DONTWAIT);
+            if (r == 0 || (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                std::cerr << "Error: Rank " << rank << " lost its connection to the previous rank" << std::endl;
+                return false;
+            }
+            received += std::max<ssize_t>(r, 0);
+        }
+    }
+    sent += send_bytes;
+    return true;
+}
+
+bool ProcessGroup::all_reduce(double* data, const int count, const Compression compression) {
+    if (world_size <= 1) {
+        return true;
+    }
+
+    const bool half = compression == Compression::FP16;
+    const size_t value_bytes = half ? sizeof(uint16_t) : sizeof(double);
+    const int max_chunk = (count + world_size - 1) / world_size + 1;
+    std::vector<char> send_buf(max_chunk * value_bytes);
+    std::vector<char> recv_buf(max_chunk * value_bytes);
+
+    auto encode = [&](const int chunk) {
+        const int begin = chunk_begin(chunk, count, world_size);
+        const int n = chunk_begin(chunk + 1, count, world_size) - begin;
+        if (half) {
+            auto* out = reinterpret_cast<uint16_t*>(send_buf.data());
+            for (int i = 0; i < n; ++i) {
+                out[i] = float_to_fp16(static_cast<float>(data[begin + i]));
+            }
+        } else {
+            std::memcpy(send_buf.data(), data + begin, n * sizeof(double));
+        }
+        return n * value_bytes;
+    };
+    auto decoded = [&](const int i) {
+        return half ? static_cast<double>(fp16_to_float(reinterpret_cast<const uint16_t*>(recv_buf.data())[i]))
+                    : reinterpret_cast<const double*>(recv_buf.data())[i];
+    };
+
+    // Reduce-scatter: after world_size - 1 steps rank r holds the full sum of chunk r + 1
+    for (int step = 0; step < world_size - 1; ++step) {
+        const int send_chunk = (rank - step + world_size) % world_size;
+        const int recv_chunk = (rank - step - 1 + world_size) % world_size;
+        const int begin = chunk_begin(recv_chunk, count, world_size);
+        const int n = chunk_begin(recv_chunk + 1, count, world_size) - begin;
+        if (!exchange(send_buf.data(), encode(send_chunk), recv_buf.data(), n * value_bytes)) {
+            return false;
+        }
+        for (int i = 0; i < n; ++i) {
+            data[begin + i] += decoded(i);
+        }
+    }
+
+    // The owner rounds its chunk too, so all ranks end with identical values
+    const int owned = (rank + 1) % world_size;
+    if (half) {
+        const int begin = chunk_begin(owned, count, world_size);
+        const int end = chunk_begin(owned + 1, count, world_size);
+        for (int i = begin; i < end; ++i) {
+            data[i] = fp16_to_float(float_to_fp16(static_cast<float>(data[i])));
+        }
+    }
+
+    // All-gather the reduced chunks around the ring
+    for (int step = 0; step < world_size - 1; ++step) {
+        const int send_chunk = (owned - step + world_size) % world_size;
+        const int recv_chunk = (rank - step + world_size) % world_size;
+        const int begin = chunk_begin(recv_chunk, count, world_size);
+        const int n = chunk_begin(recv_chunk + 1, count, world_size) - begin;
+        if (!exchange(send_buf.data(), encode(send_chunk), recv_buf.data(), n * value_bytes)) {
+            return false;
+        }
+        for (int i = 0; i < n; ++i) {
+            data[begin + i] = decoded(i);
+        }
+    }
+    return true;
+}
+
+bool ProcessGroup::sparse_all_reduce(const std::vector<int>& indices, const std::vector<double>& values, double* out,
+                                     const int count) {
+    // contributions[origin] holds that rank's (indices, values), serialized
+    std::vector<std::vector<char>> contributions(world_size);
+    auto& own = contributions[rank];
+    const int32_t n = indices.size();
+    own.resize(sizeof(n) + n * (sizeof(int32_t) + sizeof(double)));
+    std::memcpy(own.data(), &n, sizeof(n));
+    for (int i = 0; i < n; ++i) {
+        const int32_t index = indices[i];
+        std::memcpy(own.data() + sizeof(n) + i * sizeof(int32_t), &index, sizeof(index));
+    }
+    std::memcpy(own.data() + sizeof(n) + n * sizeof(int32_t), values.data(), n * sizeof(double));
+
+    // Ring all-gather: at each step forward the contribution received last
+    for (int step = 0; step < world_size - 1; ++step) {
+        const int send_origin = (rank - step + world_size) % world_size;
+        const int recv_origin = (rank - step - 1 + world_size) % world_size;
+        const auto& outgoing = contributions[send_origin];
+        const uint64_t send_size = outgoing.size();
+        uint64_t recv_size = 0;
+        if (!exchange(&send_size, sizeof(send_size), &recv_size, sizeof(recv_size))) {
+            return false;
+        }
+        contributions[recv_origin].resize(recv_size);
+        if (!exchange(outgoing.data(), send_size, contributions[recv_origin].data(), recv_size)) {
+            return false;
+        }
+    }
+
+    std::fill(out, out + count, 0.0);
+    for (const auto& contribution : contributions) {
+        int32_t m;
+        std::memcpy(&m, contribution.data(), sizeof(m));
+        const char* index_data = contribution.data() + sizeof(m);
+        const char* value_data = index_data + m * sizeof(int32_t);
+        for (int i = 0; i < m; ++i) {
+            int32_t index;
+            double value;
+            std::memcpy(&index, index_data + i * sizeof(int32_t), sizeof(index));
+            std::memcpy(&value, value_data + i * sizeof(double), sizeof(value));
+            if (index >= 0 && index < count) {
+                out[index] += value;
+            }
+        }
+    }
+    return true;
+}
+
+bool ProcessGroup::broadcast(double* data, const int count, const int root) {
+    if (world_size <= 1) {
+        return true;
+    }
+    // Pass the data along the ring, stopping before it returns to the root
+    const size_t bytes = count * sizeof(double);
+    if (rank != root && !exchange(nullptr, 0, data, bytes)) {
+        return false;
+    }
+    if ((rank + 1) % world_size != root && !exchange(data, bytes, nullptr, 0)) {
+        return false;
+    }
+    return true;
+}
+
+DistributedDataParallel::DistributedDataParallel(Module& model, ProcessGroup& group, const Options options)
+    : params(model.parameters()), group(group), options(options) {
+    // Ranks that kept their own initial weights would silently train different models
+    for (auto* m : model.state()) {
+        if (!group.broadcast(m->data(), m->size(), 0)) {
+            throw std::runtime_error("DistributedDataParallel: initial parameter broadcast failed on rank " +
+                                     std::to_string(group.rank));
+        }
+    }
+    bytes_at_start = group.bytes_sent();
+
+    // Reverse parameter order: the output layer's gradients are complete first
+    bucket_of.assign(params.size(), 0);
+    int bucket_fill = 0;
+    for (int i = static_cast<int>(params.size()) - 1; i >= 0; --i) {
+        if (buckets.empty() || bucket_fill >= options.bucket_size) {
+            buckets.emplace_back();
+            bucket_fill = 0;
+        }
+        buckets.back().params.push_back(i);
+        bucket_fill += params[i]->data.size();
+        bucket_of[i] = buckets.size() - 1;
+    }
+    for (auto& bucket : buckets) {
+        int size = 0;
+        for (int p : bucket.params) {
+            size += params[p]->data.size();
+        }
+        bucket.buffer.assign(size, 0.0);
+        if (options.compression == Compression::TopK) {
+            bucket.residual.assign(size, 0.0);
+        }
+        bucket.remaining = bucket.params.size();
+    }
+
+    for (size_t i = 0; i < params.size(); ++i) {
+        params[i]->_grad_ready = [this, i]() { grad_ready(i); };
+    }
+    comm_thread = std::thread(&DistributedDataParallel::run, this);
+}
+
+DistributedDataParallel::DistributedDataParallel(Module& model, ProcessGroup& group)
+    : DistributedDataParallel(model, group, Options()) {}
+
+DistributedDataParallel::~DistributedDataParallel() {
+    for (auto* p : params) {
+        p->_grad_ready = nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    comm_thread.join();
+}
+
+void DistributedDataParallel::grad_ready(const int param) {
+    if (!require_sync || !options.overlap) {
+        return;
+    }
+    Bucket& bucket = buckets[bucket_of[param]];
+    if (bucket.remaining > 0 && --bucket.remaining == 0) {
+        bucket.ready = true;
+        launch_ready_buckets();
+    }
+}
+
+void DistributedDataParallel::launch_ready_buckets() {
+    while (next_launch < static_cast<int>(buckets.size()) && buckets[next_launch].ready) {
+        launch(next_launch++);
+    }
+}
+
+void DistributedDataParallel::launch(const int index) {
+    // Gradients are copied on the backward thread, where they are known to be final
+    Bucket& bucket = buckets[index];
+    int offset = 0;
+    for (int p : bucket.params) {
+        const Eigen::MatrixXd& grad = params[p]->grad;
+        const int size = params[p]->data.size();
+        if (grad.size() == size) {
+            std::copy(grad.data(), grad.data() + size, bucket.buffer.begin() + offset);
+        } else {
+            std::fill(bucket.buffer.begin() + offset, bucket.buffer.begin() + offset + size, 0.0);
+        }
+        offset += size;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(index);
+    }
+    cv.notify_all();
+}
+
+bool DistributedDataParallel::reduce(Bucket& bucket) {
+    const int n = bucket.buffer.size();
+    if (options.compression != Compression::TopK) {
+        return group.all_reduce(bucket.buffer.data(), n, options.compression);
+    }
+
+    // Send the k largest entries of gradient + carried-over residual; keep the rest
+    for (int i = 0; i < n; ++i) {
+        bucket.residual[i] += bucket.buffer[i];
+    }
+    const int k = std::clamp(static_cast<int>(std::ceil(options.topk_ratio * n)), 1, std::max(1, n));
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::nth_element(order.begin(), order.begin() + std::min(k, n) - 1, order.end(), [&](const int a, const int b) {
+        return std::abs(bucket.residual[a]) > std::abs(bucket.residual[b]);
+    });
+    order.resize(std::min(k, n));
+    std::sort(order.begin(), order.end());
+
+    std::vector<double> values(order.size());
+    for (size_t j = 0; j < order.size(); ++j) {
+        values[j] = bucket.residual[order[j]];
+        bucket.residual[order[j]] = 0.0;
+    }
+    return group.sparse_all_reduce(order, values, bucket.buffer.data(), n);
+}
+
+void DistributedDataParallel::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cv.wait(lock, [this]() { return !queue.empty() || stopping; });
+        if (queue.empty()) {
+            return;
+        }
+        const int index = queue.front();
+        queue.pop_front();
+
+        lock.unlock();
+        const auto start = std::chrono::steady_clock::now();
+        const bool ok = reduce(buckets[index]);
+        const double elapsed = seconds_since(start);
+        lock.lock();
+
+        counters.communication_seconds += elapsed;
+        counters.bytes_sent = group.bytes_sent() - bytes_at_start;
+        failed = failed || !ok;
+        completed++;
+        cv.notify_all();
+    }
+}
+
+bool DistributedDataParallel::synchronize() {
+    const auto start = std::chrono::steady_clock::now();
+
+    // Buckets not launched during backward: overlap off, require_sync unset, or unused parameters
+    while (next_launch < static_cast<int>(buckets.size())) {
+        launch(next_launch++);
+    }
+
+    bool ok;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this]() { return completed == static_cast<int>(buckets.size()); });
+        completed = 0;
+        ok = !failed;
+        counters.blocked_seconds += seconds_since(start);
+        counters.steps++;
+    }
+
+    const double scale = 1.0 / group.world_size;
+    for (auto& bucket : buckets) {
+        int offset = 0;
+        for (int p : bucket.params) {
+            Eigen::MatrixXd& grad = params[p]->grad;
+            grad = Eigen::Map<const Eigen::MatrixXd>(bucket.buffer.data() + offset, params[p]->data.rows(),
+                                                     params[p]->data.cols()) *
+                   scale;
+            offset += grad.size();
+        }
+        bucket.remaining = bucket.params.size();
+        bucket.ready = false;
+    }
+    next_launch = 0;
+    return ok;
+}
+
+CommStats DistributedDataParallel::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+} // namespace micrograd
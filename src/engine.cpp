@@ -1,18 +1,121 @@
 #include "engine.hpp"
+#include "parallel.hpp"
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
 
 namespace micrograd {
 
-Value::Value(const Eigen::MatrixXd& data) : data(data) {
-    grad = Eigen::MatrixXd::Zero(data.rows(), data.cols());
+namespace {
+
+std::atomic<long long> live_values{0};
+
+// dst = src, trading dst's buffer for a pooled one when the sizes differ
+void pool_assign(Eigen::MatrixXd& dst, const Eigen::MatrixXd& src) {
+    if (dst.size() != src.size()) {
+        pool_release(dst);
+        dst = pool_acquire(src.rows(), src.cols());
+    }
+    dst = src;
+}
+
+} // namespace
+
+Value::Value(const Eigen::MatrixXd& data) : data(pool_eval(data)), grad(pool_zeros(data.rows(), data.cols())) {
+    _backward = []() {};
+    live_values++;
+}
+
+Value::Value(Eigen::MatrixXd&& data)
+    : data(std::move(data)), grad(pool_zeros(this->data.rows(), this->data.cols())) {
+    _backward = []() {};
+    live_values++;
+}
+
+Value::Value(const double scalar) : data(pool_eval(Eigen::MatrixXd::Constant(1, 1, scalar))), grad(pool_zeros(1, 1)) {
+    _backward = []() {};
+    live_values++;
+}
+
+// Copies never take over the graph structure: a copy of a node or handle is a
+// handle of the same node, and a copy of an unbound value is unbound.
+Value::Value(const Value& other) : data(pool_eval(other.data)), grad(pool_eval(other.grad)), _op(other._op) {
     _backward = []() {};
+    copy_binding(other);
+    live_values++;
 }
 
-Value::Value(const double scalar) : data(Eigen::MatrixXd::Constant(1, 1, scalar)) {
-    grad = Eigen::MatrixXd::Zero(1, 1);
+Value::Value(Value&& other) noexcept
+    : data(std::move(other.data)), grad(std::move(other.grad)), _op(std::move(other._op)) {
     _backward = []() {};
+    copy_binding(other);
+    live_values++;
+}
+
+Value& Value::operator=(const Value& other) {
+    if (this != &other) {
+        pool_assign(data, other.data);
+        pool_assign(grad, other.grad);
+        // A node keeps its identity; everything else follows the source's binding
+        if (!is_node()) {
+            _op = other._op;
+            unbind();
+            copy_binding(other);
+        }
+    }
+    return *this;
+}
+
+Value& Value::operator=(Value&& other) noexcept {
+    if (this != &other) {
+        data = std::move(other.data);
+        grad = std::move(other.grad);
+        if (!is_node()) {
+            _op = std::move(other._op);
+            unbind();
+            copy_binding(other);
+        }
+    }
+    return *this;
+}
+
+Value::~Value() {
+    unbind();
+    pool_release(data);
+    pool_release(grad);
+    live_values--;
+}
+
+long long Value::live_count() {
+    return live_values.load();
+}
+
+bool Value::is_node() const {
+    return !_node && _self.lock().get() == this;
+}
+
+void Value::bind(const std::shared_ptr<Value>& node) const {
+    _node = node;
+    _self = node;
+    node->_handles.push_back(const_cast<Value*>(this));
+}
+
+void Value::unbind() {
+    if (_node) {
+        auto& handles = _node->_handles;
+        handles.erase(std::remove(handles.begin(), handles.end(), this), handles.end());
+        _node.reset();
+        _self.reset();
+    }
+}
+
+void Value::copy_binding(const Value& other) {
+    if (auto node = other._self.lock()) {
+        bind(node);
+    }
 }
 
 void Value::set_self(const std::shared_ptr<Value>& ptr) {
@@ -21,27 +124,86 @@ void Value::set_self(const std::shared_ptr<Value>& ptr) {
 
 std::shared_ptr<Value> Value::get_self_ptr() const {
     auto ptr = _self.lock();
-    if (ptr) {
+    if (!ptr) {
+        // Unbound (stack) value: copy it into a node and become a handle of it, so
+        // every use shares one node and the gradient comes back after backward()
+        auto node = std::allocate_shared<Value>(PoolAllocator<Value>(), data);
+        node->set_self(node);
+        bind(node);
+        return node;
+    }
+    if (ptr.get() == this) {
+        return ptr;
+    }
+    // The node owns the data that backward reads, and ops compute forward from
+    // the handle's data, so the two must agree. A leaf node held by this handle
+    // alone is in no graph, so it takes the handle's current data: changes to a
+    // stack parameter (an optimizer step) then reach the next graph it enters.
+    if (ptr->_prev.empty() && ptr->_handles.size() == 1 && ptr.use_count() == 2) {
+        pool_assign(ptr->data, data);
         return ptr;
     }
-    // If no self-pointer exists, create a new shared_ptr (for temporary values)
-    return std::make_shared<Value>(*this);
+    // Any other node may still be read by a live graph or another handle, so a
+    // handle whose data has changed moves to a node of its own instead. Bitwise
+    // comparison, so that NaNs do not count as changes.
+    if (ptr->data.rows() != data.rows() || ptr->data.cols() != data.cols() ||
+        std::memcmp(ptr->data.data(), data.data(), data.size() * sizeof(double)) != 0) {
+        const_cast<Value*>(this)->unbind();
+        auto node = std::allocate_shared<Value>(PoolAllocator<Value>(), data);
+        node->set_self(node);
+        bind(node);
+        return node;
+    }
+    return ptr;
+}
+
+std::shared_ptr<Value> Value::make_node(const Eigen::MatrixXd& data, const char* op, NodeList prev) {
+    auto node = std::allocate_shared<Value>(PoolAllocator<Value>(), data);
+    node->set_self(node);
+    node->_op = op;
+    node->_prev = std::move(prev);
+    return node;
+}
+
+std::shared_ptr<Value> Value::make_node(Eigen::MatrixXd&& data, const char* op, NodeList prev) {
+    auto node = std::allocate_shared<Value>(PoolAllocator<Value>(), std::move(data));
+    node->set_self(node);
+    node->_op = op;
+    node->_prev = std::move(prev);
+    return node;
+}
+
+void Value::accumulate(Eigen::MatrixXd& target, const Eigen::MatrixXd& grad, const double scale) {
+    if (grad.rows() == target.rows() && grad.cols() == target.cols()) {
+        target += scale * grad;
+    } else if (target.rows() == 1 && target.cols() == grad.cols()) {
+        // A bias broadcast across the batch: sum the rows straight into target
+        add_sum_rows(target, grad, scale);
+    } else {
+        Eigen::MatrixXd summed = broadcast_backward(grad, target.rows(), target.cols());
+        target += scale * summed;
+        pool_release(summed);
+    }
 }
 
 Eigen::MatrixXd Value::broadcast_backward(const Eigen::MatrixXd& grad,
                                           int target_rows, int target_cols) {
     if (grad.rows() == target_rows && grad.cols() == target_cols) {
-        return grad;
+        return pool_eval(grad);
     }
 
-    Eigen::MatrixXd result = grad;
-
     // Sum over broadcasting dimensions
+    Eigen::MatrixXd result;
     if (target_rows == 1 && grad.rows() > 1) {
-        result = grad.colwise().sum();
+        result = pool_zeros(1, grad.cols());
+        add_sum_rows(result, grad);
+    } else {
+        result = pool_eval(grad);
     }
-    if (target_cols == 1 && grad.cols() > 1) {
-        result = result.rowwise().sum();
+    if (target_cols == 1 && result.cols() > 1) {
+        Eigen::MatrixXd summed = pool_eval(result.rowwise().sum());
+        pool_release(result);
+        result = std::move(summed);
     }
 
     return result;
@@ -51,64 +213,126 @@ Value Value::operator+(const Value& other) const {
     Eigen::MatrixXd result;
 
     if (data.rows() == other.data.rows() && data.cols() == other.data.cols()) {
-        result = data + other.data;
+        result = pool_eval(data + other.data);
     } else if (other.data.rows() == 1 && data.cols() == other.data.cols()) {
         // Broadcast other (bias) across rows
-        result = data.rowwise() + other.data.row(0);
+        result = pool_eval(data.rowwise() + other.data.row(0));
     } else if (data.rows() == 1 && data.cols() == other.data.cols()) {
         // Broadcast self across rows
-        result = other.data.rowwise() + data.row(0);
+        result = pool_eval(other.data.rowwise() + data.row(0));
     } else {
-        result = data + other.data;
+        result = pool_eval(data + other.data);
     }
 
-    Value out(result);
-    out._op = "+";
-
     auto self_ptr = this->get_self_ptr();
     auto other_ptr = other.get_self_ptr();
-    auto out_ptr = std::make_shared<Value>(out);
-    out_ptr->set_self(out_ptr);
-
-    out_ptr->_prev = {self_ptr, other_ptr};
-    out_ptr->_backward = [self_ptr, other_ptr, out_ptr]() {
-        self_ptr->grad += broadcast_backward(out_ptr->grad, self_ptr->data.rows(), self_ptr->data.cols());
-        other_ptr->grad += broadcast_backward(out_ptr->grad, other_ptr->data.rows(), other_ptr->data.cols());
+    auto out_ptr = make_node(std::move(result), "+", {self_ptr, other_ptr});
+
+    // Closures hold raw pointers: the inputs are owned through _prev and the
+    // output owns the closure, so capturing shared_ptrs would only add cycles.
+    // A backward closure of at most two pointers fits in std::function's
+    // inline storage, so binary ops read their inputs back from out->_prev and
+    // scalar ops read their argument from out->_attrs. Ops that keep forward
+    // intermediates for backward, such as gelu and silu, capture those instead.
+    Value* a = self_ptr.get();
+    Value* b = other_ptr.get();
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [out]() {
+        accumulate(out->_prev[0]->grad, out->grad);
+        accumulate(out->_prev[1]->grad, out->grad);
+    };
+    out_ptr->_backward_graph = [a, b](const Value& g) {
+        return std::vector<Value>{g.sum_to(a->rows(), a->cols()), g.sum_to(b->rows(), b->cols())};
     };
 
     return *out_ptr;
 }
 
 Value Value::operator+(const double scalar) const {
-    return *this + Value(scalar);
+    auto self_ptr = this->get_self_ptr();
+    auto out_ptr = make_node(pool_eval(data.array() + scalar), "+", {self_ptr});
+    out_ptr->_attrs = {scalar};
+
+    Value* a = self_ptr.get();
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [a, out]() {
+        a->grad += out->grad;
+    };
+    out_ptr->_backward_graph = [](const Value& g) {
+        return std::vector<Value>{g};
+    };
+
+    return *out_ptr;
 }
 
 Value Value::operator*(const Value& other) const {
-    Value out(data.array() * other.data.array());
-    out._op = "*";
-
     auto self_ptr = this->get_self_ptr();
     auto other_ptr = other.get_self_ptr();
-    auto out_ptr = std::make_shared<Value>(out);
-    out_ptr->set_self(out_ptr);
-
-    out_ptr->_prev = {self_ptr, other_ptr};
-    out_ptr->_backward = [self_ptr, other_ptr, out_ptr]() {
-        Eigen::MatrixXd grad_self = other_ptr->data.array() * out_ptr->grad.array();
-        Eigen::MatrixXd grad_other = self_ptr->data.array() * out_ptr->grad.array();
-        self_ptr->grad += broadcast_backward(grad_self, self_ptr->data.rows(), self_ptr->data.cols());
-        other_ptr->grad += broadcast_backward(grad_other, other_ptr->data.rows(), other_ptr->data.cols());
+    auto out_ptr = make_node(pool_eval(data.array() * other.data.array()), "*", {self_ptr, other_ptr});
+
+    // Both inputs have the output's shape, so gradients accumulate in place
+    Value* a = self_ptr.get();
+    Value* b = other_ptr.get();
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [out]() {
+        Value* a = out->_prev[0].get();
+        Value* b = out->_prev[1].get();
+        a->grad.array() += b->data.array() * out->grad.array();
+        b->grad.array() += a->data.array() * out->grad.array();
+    };
+    out_ptr->_backward_graph = [a, b](const Value& g) {
+        return std::vector<Value>{(g * *b).sum_to(a->rows(), a->cols()), (g * *a).sum_to(b->rows(), b->cols())};
     };
 
     return *out_ptr;
 }
 
 Value Value::operator*(const double scalar) const {
-    return *this * Value(scalar);
+    auto self_ptr = this->get_self_ptr();
+    auto out_ptr = make_node(pool_eval(data * scalar), "*", {self_ptr});
+    out_ptr->_attrs = {scalar};
+
+    Value* a = self_ptr.get();
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [a, out]() {
+        a->grad += out->_attrs[0] * out->grad;
+    };
+    out_ptr->_backward_graph = [scalar](const Value& g) {
+        return std::vector<Value>{g * scalar};
+    };
+
+    return *out_ptr;
 }
 
 Value Value::operator-(const Value& other) const {
-    return *this + (other * -1.0);
+    Eigen::MatrixXd result;
+
+    if (data.rows() == other.data.rows() && data.cols() == other.data.cols()) {
+        result = pool_eval(data - other.data);
+    } else if (other.data.rows() == 1 && data.cols() == other.data.cols()) {
+        result = pool_eval(data.rowwise() - other.data.row(0));
+    } else if (data.rows() == 1 && data.cols() == other.data.cols()) {
+        result = pool_eval((-other.data).rowwise() + data.row(0));
+    } else {
+        result = pool_eval(data - other.data);
+    }
+
+    auto self_ptr = this->get_self_ptr();
+    auto other_ptr = other.get_self_ptr();
+    auto out_ptr = make_node(std::move(result), "-", {self_ptr, other_ptr});
+
+    Value* a = self_ptr.get();
+    Value* b = other_ptr.get();
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [out]() {
+        accumulate(out->_prev[0]->grad, out->grad);
+        accumulate(out->_prev[1]->grad, out->grad, -1.0);
+    };
+    out_ptr->_backward_graph = [a, b](const Value& g) {
+        return std::vector<Value>{g.sum_to(a->rows(), a->cols()), (g * -1.0).sum_to(b->rows(), b->cols())};
+    };
+
+    return *out_ptr;
 }
 
 Value Value::operator-(const double scalar) const {
@@ -116,7 +340,27 @@ Value Value::operator-(const double scalar) const {
 }
 
 Value Value::operator/(const Value& other) const {
-    return *this * other.pow(-1.0);
+    auto self_ptr = this->get_self_ptr();
+    auto other_ptr = other.get_self_ptr();
+    auto out_ptr = make_node(pool_eval(data.array() / other.data.array()), "/", {self_ptr, other_ptr});
+
+    // Both inputs have the output's shape, so gradients accumulate in place
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [out]() {
+        Value* a = out->_prev[0].get();
+        Value* b = out->_prev[1].get();
+        a->grad.array() += out->grad.array() / b->data.array();
+        b->grad.array() -= out->grad.array() / b->data.array() * out->data.array();
+    };
+    out_ptr->_backward_graph = [out](const Value& g) {
+        Value* a = out->_prev[0].get();
+        Value* b = out->_prev[1].get();
+        Value grad_self = g / *b;
+        Value grad_other = grad_self * *out * -1.0;
+        return std::vector<Value>{grad_self.sum_to(a->rows(), a->cols()), grad_other.sum_to(b->rows(), b->cols())};
+    };
+
+    return *out_ptr;
 }
 
 Value Value::operator/(const double scalar) const {
@@ -124,153 +368,432 @@ Value Value::operator/(const double scalar) const {
 }
 
 Value Value::matmul(const Value& other) const {
-    Value out(data * other.data);
-    out._op = "@";
-
     auto self_ptr = this->get_self_ptr();
     auto other_ptr = other.get_self_ptr();
-    auto out_ptr = std::make_shared<Value>(out);
-    out_ptr->set_self(out_ptr);
-
-    out_ptr->_prev = {self_ptr, other_ptr};
-    out_ptr->_backward = [self_ptr, other_ptr, out_ptr]() {
-        self_ptr->grad += out_ptr->grad * other_ptr->data.transpose();
-        other_ptr->grad += self_ptr->data.transpose() * out_ptr->grad;
+    auto out_ptr = make_node(pool_eval(data * other.data), "@", {self_ptr, other_ptr});
+
+    Value* a = self_ptr.get();
+    Value* b = other_ptr.get();
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [out]() {
+        Value* a = out->_prev[0].get();
+        Value* b = out->_prev[1].get();
+        // Distinct nodes' buffers never alias, so the product accumulates without a temporary
+        a->grad.noalias() += out->grad * b->data.transpose();
+        // Sums over the rows of a (the batch for a weight), so it goes through the ordered reduction
+        add_matmul_tn(b->grad, a->data, out->grad);
+    };
+    out_ptr->_backward_graph = [a, b](const Value& g) {
+        return std::vector<Value>{g.matmul(b->transpose()), a->transpose().matmul(g)};
     };
 
     return *out_ptr;
 }
 
 Value Value::pow(double exponent) const {
-    Value out(data.array().pow(exponent));
-    out._op = "pow";
+    auto self_ptr = this->get_self_ptr();
+    auto out_ptr = make_node(pool_eval(data.array().pow(exponent)), "pow", {self_ptr});
+    out_ptr->_attrs = {exponent};
+
+    Value* a = self_ptr.get();
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [a, out]() {
+        const double exponent = out->_attrs[0];
+        a->grad += ((exponent * a->data.array().pow(exponent - 1)) * out->grad.array()).matrix();
+    };
+    out_ptr->_backward_graph = [a, exponent](const Value& g) {
+        return std::vector<Value>{g * (a->pow(exponent - 1) * exponent)};
+    };
+
+    return *out_ptr;
+}
 
+Value Value::relu() const {
     auto self_ptr = this->get_self_ptr();
-    auto out_ptr = std::make_shared<Value>(out);
-    out_ptr->set_self(out_ptr);
+    auto out_ptr = make_node(pool_eval(data.array().max(0.0)), "relu", {self_ptr});
 
-    out_ptr->_prev = {self_ptr};
-    out_ptr->_backward = [self_ptr, out_ptr, exponent]() {
-        self_ptr->grad += ((exponent * self_ptr->data.array().pow(exponent - 1)) * out_ptr->grad.array()).matrix();
+    Value* a = self_ptr.get();
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [a, out]() {
+        a->grad += ((out->data.array() > 0.0).cast<double>() * out->grad.array()).matrix();
+    };
+    // The mask is piecewise constant, so it enters the gradient graph as a constant
+    out_ptr->_backward_graph = [out](const Value& g) {
+        Value mask((out->data.array() > 0.0).cast<double>().matrix());
+        return std::vector<Value>{g * mask};
     };
 
     return *out_ptr;
 }
 
-Value Value::relu() const {
-    Value out(data.array().max(0.0));
-    out._op = "relu";
+Value Value::sigmoid() const {
+    auto self_ptr = this->get_self_ptr();
+    auto out_ptr = make_node(pool_eval(1.0 / (1.0 + (-data.array()).exp())), "sigmoid", {self_ptr});
+
+    // The output is the sigmoid itself, so backward reads it instead of keeping a copy
+    Value* a = self_ptr.get();
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [a, out]() {
+        const auto s = out->data.array();
+        a->grad += ((s * (1.0 - s)) * out->grad.array()).matrix();
+    };
+    out_ptr->_backward_graph = [out](const Value& g) {
+        return std::vector<Value>{g * (*out * (*out * -1.0 + 1.0))};
+    };
+
+    return *out_ptr;
+}
 
+Value Value::tanh() const {
     auto self_ptr = this->get_self_ptr();
-    auto out_ptr = std::make_shared<Value>(out);
-    out_ptr->set_self(out_ptr);
+    auto out_ptr = make_node(pool_eval(data.array().tanh()), "tanh", {self_ptr});
 
-    out_ptr->_prev = {self_ptr};
-    out_ptr->_backward = [self_ptr, out_ptr]() {
-        self_ptr->grad += ((out_ptr->data.array() > 0.0).cast<double>() * out_ptr->grad.array()).matrix();
+    Value* a = self_ptr.get();
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [a, out]() {
+        a->grad.array() += (1.0 - out->data.array().square()) * out->grad.array();
+    };
+    out_ptr->_backward_graph = [out](const Value& g) {
+        return std::vector<Value>{g * (*out * *out * -1.0 + 1.0)};
     };
 
     return *out_ptr;
 }
 
-Value Value::sigmoid() const {
-    Eigen::MatrixXd s = 1.0 / (1.0 + (-data.array()).exp());
-    Value out(s);
-    out._op = "sigmoid";
+Value Value::gelu() const {
+    // tanh approximation: 0.5 x (1 + tanh(k (x + 0.044715 x^3)))
+    const double k = std::sqrt(2.0 / M_PI);
+    const auto x = data.array();
+    PooledMatrix tanh_term(pool_eval((k * (x + 0.044715 * x.cube())).tanh()));
+    const auto t = tanh_term.matrix.array();
+
+    auto self_ptr = this->get_self_ptr();
+    auto out_ptr = make_node(pool_eval(0.5 * x * (1.0 + t)), "gelu", {self_ptr});
+
+    Value* a = self_ptr.get();
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [a, out, tanh_term = std::move(tanh_term), k]() {
+        const auto x = a->data.array();
+        const auto t = tanh_term.matrix.array();
+        const auto slope = 0.5 * (1.0 + t) + 0.5 * x * (1.0 - t.square()) * k * (1.0 + 3 * 0.044715 * x.square());
+        a->grad.array() += slope * out->grad.array();
+    };
+    out_ptr->_backward_graph = [a, k](const Value& g) {
+        Value t = ((*a + a->pow(3.0) * 0.044715) * k).tanh();
+        Value slope = (t + 1.0) * 0.5 + *a * (t * t * -1.0 + 1.0) * (a->pow(2.0) * (3 * 0.044715 * k) + k) * 0.5;
+        return std::vector<Value>{g * slope};
+    };
+
+    return *out_ptr;
+}
+
+Value Value::leaky_relu(const double negative_slope) const {
+    auto self_ptr = this->get_self_ptr();
+    auto out_ptr = make_node(pool_eval((data.array() > 0.0).select(data, negative_slope * data)), "leaky_relu", {self_ptr});
+    out_ptr->_attrs = {negative_slope};
+
+    Value* a = self_ptr.get();
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [a, out]() {
+        const double negative_slope = out->_attrs[0];
+        a->grad.array() += (a->data.array() > 0.0).select(out->grad, negative_slope * out->grad).array();
+    };
+    out_ptr->_backward_graph = [a, negative_slope](const Value& g) {
+        Value slope((a->data.array() > 0.0).select(Eigen::MatrixXd::Ones(a->rows(), a->cols()), negative_slope));
+        return std::vector<Value>{g * slope};
+    };
+
+    return *out_ptr;
+}
+
+Value Value::silu() const {
+    PooledMatrix sigmoid(pool_eval(1.0 / (1.0 + (-data.array()).exp())));
+
+    auto self_ptr = this->get_self_ptr();
+    auto out_ptr = make_node(pool_eval(data.array() * sigmoid.matrix.array()), "silu", {self_ptr});
+
+    Value* a = self_ptr.get();
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [a, out, sigmoid = std::move(sigmoid)]() {
+        const auto s = sigmoid.matrix.array();
+        a->grad.array() += s * (1.0 + a->data.array() * (1.0 - s)) * out->grad.array();
+    };
+    out_ptr->_backward_graph = [a](const Value& g) {
+        Value s = a->sigmoid();
+        return std::vector<Value>{g * (s * (*a * (s * -1.0 + 1.0) + 1.0))};
+    };
+
+    return *out_ptr;
+}
+
+Value Value::softmax() const {
+    Eigen::MatrixXd result = pool_eval((data.colwise() - data.rowwise().maxCoeff()).array().exp());
+    result.array().colwise() /= result.rowwise().sum().array();
 
     auto self_ptr = this->get_self_ptr();
-    auto out_ptr = std::make_shared<Value>(out);
-    out_ptr->set_self(out_ptr);
+    auto out_ptr = make_node(std::move(result), "softmax", {self_ptr});
 
-    out_ptr->_prev = {self_ptr};
-    out_ptr->_backward = [self_ptr, out_ptr, s]() {
-        self_ptr->grad += ((s.array() * (1.0 - s.array())) * out_ptr->grad.array()).matrix();
+    Value* a = self_ptr.get();
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [a, out]() {
+        const Eigen::MatrixXd gs = out->grad.cwiseProduct(out->data);
+        a->grad += gs - out->data.cwiseProduct(gs.rowwise().sum().replicate(1, gs.cols()));
+    };
+    out_ptr->_backward_graph = [out](const Value& g) {
+        Value gs = g * *out;
+        return std::vector<Value>{gs - *out * gs.sum_to(gs.rows(), 1).broadcast_to(gs.rows(), gs.cols())};
     };
 
     return *out_ptr;
 }
 
 Value Value::transpose() const {
-    Value out(data.transpose());
-    out._op = "T";
+    auto self_ptr = this->get_self_ptr();
+    auto out_ptr = make_node(pool_eval(data.transpose()), "T", {self_ptr});
+
+    Value* a = self_ptr.get();
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [a, out]() {
+        a->grad += out->grad.transpose();
+    };
+    out_ptr->_backward_graph = [](const Value& g) {
+        return std::vector<Value>{g.transpose()};
+    };
+
+    return *out_ptr;
+}
 
+Value Value::reshape(const int rows, const int cols) const {
     auto self_ptr = this->get_self_ptr();
-    auto out_ptr = std::make_shared<Value>(out);
-    out_ptr->set_self(out_ptr);
+    if (rows == data.rows() && cols == data.cols()) {
+        return *self_ptr;
+    }
+    eigen_assert(rows * cols == data.size());
+
+    const int orig_rows = data.rows();
+    const int orig_cols = data.cols();
+    auto out_ptr = make_node(pool_eval(Eigen::Map<const Eigen::MatrixXd>(data.data(), rows, cols)), "reshape", {self_ptr});
 
-    out_ptr->_prev = {self_ptr};
-    out_ptr->_backward = [self_ptr, out_ptr]() {
-        self_ptr->grad += out_ptr->grad.transpose();
+    Value* a = self_ptr.get();
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [a, out]() {
+        a->grad += Eigen::Map<const Eigen::MatrixXd>(out->grad.data(), a->rows(), a->cols());
+    };
+    out_ptr->_backward_graph = [orig_rows, orig_cols](const Value& g) {
+        return std::vector<Value>{g.reshape(orig_rows, orig_cols)};
     };
 
     return *out_ptr;
 }
 
 Value Value::flatten() const {
-    int orig_rows = data.rows();
-    int orig_cols = data.cols();
+    if (data.cols() <= 1) {
+        return *this->get_self_ptr();
+    }
+    return reshape(1, data.size());
+}
+
+Value Value::sum_to(const int rows, const int cols) const {
+    auto self_ptr = this->get_self_ptr();
+    if (rows == data.rows() && cols == data.cols()) {
+        return *self_ptr;
+    }
+
+    auto out_ptr = make_node(broadcast_backward(data, rows, cols), "sum_to", {self_ptr});
+
+    Value* a = self_ptr.get();
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [a, out]() {
+        a->grad += out->grad.replicate(a->data.rows() / out->grad.rows(), a->data.cols() / out->grad.cols());
+    };
+    out_ptr->_backward_graph = [a](const Value& g) {
+        return std::vector<Value>{g.broadcast_to(a->rows(), a->cols())};
+    };
+
+    return *out_ptr;
+}
 
-    if (orig_cols <= 1) {
-        return *this;
+Value Value::broadcast_to(const int rows, const int cols) const {
+    auto self_ptr = this->get_self_ptr();
+    if (rows == data.rows() && cols == data.cols()) {
+        return *self_ptr;
     }
+    eigen_assert((data.rows() == 1 || data.rows() == rows) && (data.cols() == 1 || data.cols() == cols));
+
+    auto out_ptr = make_node(pool_eval(data.replicate(rows / data.rows(), cols / data.cols())), "broadcast_to", {self_ptr});
+
+    Value* a = self_ptr.get();
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [a, out]() {
+        accumulate(a->grad, out->grad);
+    };
+    out_ptr->_backward_graph = [a](const Value& g) {
+        return std::vector<Value>{g.sum_to(a->rows(), a->cols())};
+    };
 
-    int flattened_cols = orig_rows * orig_cols;
-    Eigen::MatrixXd flattened = Eigen::Map<const Eigen::MatrixXd>(data.data(), 1, flattened_cols);
+    return *out_ptr;
+}
 
-    Value out(flattened);
-    out._op = "flatten";
+Value Value::sum() const {
+    return sum_to(1, 1);
+}
 
+Value Value::cast(const Precision precision) const {
     auto self_ptr = this->get_self_ptr();
-    auto out_ptr = std::make_shared<Value>(out);
-    out_ptr->set_self(out_ptr);
+    auto out_ptr = make_node(round_to(data, precision), "cast", {self_ptr});
+    out_ptr->_attrs = {static_cast<double>(precision)};
 
-    out_ptr->_prev = {self_ptr};
-    out_ptr->_backward = [self_ptr, out_ptr, orig_rows, orig_cols]() {
-        Eigen::MatrixXd reshaped = Eigen::Map<const Eigen::MatrixXd>(out_ptr->grad.data(), orig_rows, orig_cols);
-        self_ptr->grad += reshaped;
+    Value* a = self_ptr.get();
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [a, out]() {
+        a->grad += round_to(out->grad, static_cast<Precision>(out->_attrs[0]));
+    };
+    out_ptr->_backward_graph = [precision](const Value& g) {
+        return std::vector<Value>{g.cast(precision)};
     };
 
     return *out_ptr;
 }
 
-void Value::build_topo(std::shared_ptr<Value> v, std::set<std::shared_ptr<Value>>& visited,
-                       std::vector<std::shared_ptr<Value>>& topo) {
-    if (visited.find(v) == visited.end()) {
-        visited.insert(v);
-        for (auto& child : v->_prev) {
-            build_topo(child, visited, topo);
+void Value::build_topo(std::shared_ptr<Value> v, NodeSet& visited, NodeList& topo) {
+    // Post-order walk with an explicit stack, so long chains such as unrolled
+    // sequences cannot overflow the call stack. Each entry is a node and the
+    // index of the next child to visit.
+    if (!visited.insert(v).second) {
+        return;
+    }
+    std::vector<std::pair<std::shared_ptr<Value>, size_t>, PoolAllocator<std::pair<std::shared_ptr<Value>, size_t>>>
+        stack;
+    stack.emplace_back(std::move(v), 0);
+    while (!stack.empty()) {
+        auto& [node, next] = stack.back();
+        if (next < node->_prev.size()) {
+            const auto& child = node->_prev[next++];
+            if (visited.insert(child).second) {
+                stack.emplace_back(child, 0);
+            }
+        } else {
+            topo.push_back(std::move(node));
+            stack.pop_back();
         }
-        topo.push_back(v);
     }
 }
 
-void Value::backward() {
-    std::vector<std::shared_ptr<Value>> topo;
-    std::set<std::shared_ptr<Value>> visited;
+void Value::backward(const bool retain_graph) {
+    NodeList topo;
+    NodeSet visited;
 
     auto self_ptr = this->get_self_ptr();
     build_topo(self_ptr, visited, topo);
 
-    self_ptr->grad = Eigen::MatrixXd::Ones(data.rows(), data.cols());
+    // The seed reuses grad's pooled buffer, as pool_assign does
+    if (self_ptr->grad.size() != data.size()) {
+        pool_release(self_ptr->grad);
+        self_ptr->grad = pool_acquire(data.rows(), data.cols());
+    }
+    self_ptr->grad.setOnes(data.rows(), data.cols());
 
+    // Reverse topological order: every consumer of a node runs before it, so
+    // its gradient is final once its own step has run
     for (auto it = topo.rbegin(); it != topo.rend(); ++it) {
         (*it)->_backward();
+        if ((*it)->_grad_ready) {
+            (*it)->_grad_ready();
+        }
+    }
+
+    // Hand the gradients to the handles that user code holds
+    for (auto& node : topo) {
+        for (auto* handle : node->_handles) {
+            handle->grad = node->grad;
+        }
+    }
+
+    if (!retain_graph) {
+        visited.clear();
+        self_ptr.reset();
+        release(topo);
+    }
+}
+
+void Value::release_graph() {
+    auto self_ptr = _self.lock();
+    if (!self_ptr) {
+        return;
+    }
+
+    NodeList topo;
+    NodeSet visited;
+    build_topo(self_ptr, visited, topo);
+    visited.clear();
+    self_ptr.reset();
+    release(topo);
+}
+
+void Value::release(NodeList& topo) {
+    // topo keeps every node alive while the edges are cut, so nodes are then
+    // freed one at a time instead of through a deep chain of destructors.
+    // Inputs are all in topo, so the edges are noted as raw pointers, each
+    // node's list ended by a nullptr, to put them back if the graph is shared.
+    std::vector<Value*, PoolAllocator<Value*>> edges;
+    for (auto& node : topo) {
+        for (auto& input : node->_prev) {
+            edges.push_back(input.get());
+        }
+        edges.push_back(nullptr);
+        node->_prev.clear();
+    }
+
+    // Once the edges are cut, an op result is owned by topo and its handles
+    // only. Any other owner is an op of another graph that still needs the
+    // edges below it, so cutting them would break that graph's backward.
+    size_t next = 0;
+    bool shared = false;
+    for (auto& node : topo) {
+        const bool has_inputs = edges[next] != nullptr;
+        while (edges[next] != nullptr) {
+            ++next;
+        }
+        ++next;
+        if (has_inputs && node.use_count() > 1 + static_cast<long>(node->_handles.size())) {
+            shared = true;
+        }
+    }
+    if (shared) {
+        next = 0;
+        for (auto& node : topo) {
+            for (; edges[next] != nullptr; ++next) {
+                node->_prev.push_back(edges[next]->_self.lock());
+            }
+            ++next;
+        }
+        topo.clear();
+        throw std::logic_error("Value: the graph shares nodes with another live graph and cannot be released; "
+                               "use backward(true) and release the graph that is used last");
     }
 
-    // If this was a stack variable, copy gradients back
-    if (!_self.lock()) {
-        *this = *self_ptr;
+    for (auto& node : topo) {
+        node->_backward = []() {};
+        node->_backward_graph = nullptr;
     }
+    topo.clear();
 }
 
 void Value::zero_grad() {
     grad = Eigen::MatrixXd::Zero(data.rows(), data.cols());
+    if (_node) {
+        _node->grad.setZero();
+    }
 }
 
 // ValuePtr implementations
-ValuePtr::ValuePtr(const Eigen::MatrixXd& data) : ptr(std::make_shared<Value>(data)) {}
+ValuePtr::ValuePtr(const Eigen::MatrixXd& data) : ptr(std::make_shared<Value>(data)) {
+    ptr->set_self(ptr);
+}
 
-ValuePtr::ValuePtr(double scalar) : ptr(std::make_shared<Value>(scalar)) {}
+ValuePtr::ValuePtr(double scalar) : ptr(std::make_shared<Value>(scalar)) {
+    ptr->set_self(ptr);
+}
 
 ValuePtr ValuePtr::operator+(const ValuePtr& other) const {
     return {std::make_shared<Value>(*ptr + *other.ptr)};
@@ -328,4 +851,8 @@ ValuePtr ValuePtr::flatten() const {
     return {std::make_shared<Value>(ptr->flatten())};
 }
 
+ValuePtr ValuePtr::cast(Precision precision) const {
+    return {std::make_shared<Value>(ptr->cast(precision))};
+}
+
 } // namespace micrograd
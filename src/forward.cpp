@@ -0,0 +1,336 @@
+#include "forward.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace micrograd {
+
+namespace {
+
+const double EPS = 1e-12;
+
+int combined_tangents(const Dual& a, const Dual& b) {
+    eigen_assert(a.num_tangents == 0 || b.num_tangents == 0 || a.num_tangents == b.num_tangents);
+    return std::max(a.num_tangents, b.num_tangents);
+}
+
+// Per-direction sums of a stacked K * rows x cols matrix, as a K x 1 column
+Eigen::MatrixXd block_sums(const Eigen::MatrixXd& stacked, const int rows, const int k) {
+    Eigen::MatrixXd sums(k, 1);
+    for (int i = 0; i < k; ++i) {
+        sums(i, 0) = stacked.middleRows(i * rows, rows).sum();
+    }
+    return sums;
+}
+
+// Elementwise function given its values and derivatives at x
+Dual elementwise(const Dual& x, const Eigen::MatrixXd& value, const Eigen::MatrixXd& slope) {
+    return Dual(value, x.tangent.cwiseProduct(slope.replicate(x.num_tangents, 1)), x.num_tangents);
+}
+
+} // namespace
+
+Dual::Dual(const Eigen::MatrixXd& data, const int num_tangents)
+    : data(data), tangent(Eigen::MatrixXd::Zero(num_tangents * data.rows(), data.cols())),
+      num_tangents(num_tangents) {}
+
+Dual::Dual(const double scalar, const int num_tangents) : Dual(Eigen::MatrixXd::Constant(1, 1, scalar), num_tangents) {}
+
+Dual::Dual(const Eigen::MatrixXd& data, const Eigen::MatrixXd& tangent, const int num_tangents)
+    : data(data), tangent(tangent), num_tangents(num_tangents) {
+    eigen_assert(tangent.rows() == num_tangents * data.rows() && tangent.cols() == data.cols());
+}
+
+Dual Dual::variable(const Eigen::MatrixXd& data, const std::vector<Eigen::MatrixXd>& directions) {
+    const int k = directions.size();
+    Dual out(data, k);
+    for (int i = 0; i < k; ++i) {
+        out.tangent_at(i) = directions[i];
+    }
+    return out;
+}
+
+Eigen::Block<Eigen::MatrixXd> Dual::tangent_at(const int k) {
+    return tangent.middleRows(k * data.rows(), data.rows());
+}
+
+Eigen::Block<const Eigen::MatrixXd> Dual::tangent_at(const int k) const {
+    return tangent.middleRows(k * data.rows(), data.rows());
+}
+
+Eigen::MatrixXd Dual::broadcast_tangent(const int rows, const int cols, const int k) const {
+    if (num_tangents == 0) {
+        return Eigen::MatrixXd::Zero(k * rows, cols);
+    }
+    if (rows == data.rows() && cols == data.cols()) {
+        return tangent;
+    }
+
+    Eigen::MatrixXd out(k * rows, cols);
+    for (int i = 0; i < k; ++i) {
+        out.middleRows(i * rows, rows) = tangent_at(i).replicate(rows / data.rows(), cols / data.cols());
+    }
+    return out;
+}
+
+Dual Dual::operator+(const Dual& other) const {
+    Eigen::MatrixXd result;
+
+    if (data.rows() == other.data.rows() && data.cols() == other.data.cols()) {
+        result = data + other.data;
+    } else if (other.data.rows() == 1 && data.cols() == other.data.cols()) {
+        // Broadcast other (bias) across rows
+        result = data.rowwise() + other.data.row(0);
+    } else if (data.rows() == 1 && data.cols() == other.data.cols()) {
+        result = other.data.rowwise() + data.row(0);
+    } else {
+        result = data + other.data;
+    }
+
+    const int k = combined_tangents(*this, other);
+    Eigen::MatrixXd t = broadcast_tangent(result.rows(), result.cols(), k);
+    if (other.num_tangents > 0) {
+        t += other.broadcast_tangent(result.rows(), result.cols(), k);
+    }
+    return Dual(result, t, k);
+}
+
+Dual Dual::operator+(const double scalar) const {
+    return Dual(data.array() + scalar, tangent, num_tangents);
+}
+
+Dual Dual::operator*(const Dual& other) const {
+    const int k = combined_tangents(*this, other);
+    Eigen::MatrixXd t = Eigen::MatrixXd::Zero(k * data.rows(), data.cols());
+    if (num_tangents > 0) {
+        t.array() += tangent.array() * other.data.replicate(k, 1).array();
+    }
+    if (other.num_tangents > 0) {
+        t.array() += data.replicate(k, 1).array() * other.tangent.array();
+    }
+    return Dual(data.cwiseProduct(other.data), t, k);
+}
+
+Dual Dual::operator*(const double scalar) const {
+    return Dual(data * scalar, tangent * scalar, num_tangents);
+}
+
+Dual Dual::operator-(const Dual& other) const {
+    return *this + other * -1.0;
+}
+
+Dual Dual::operator-(const double scalar) const {
+    return *this + (-scalar);
+}
+
+Dual Dual::operator/(const Dual& other) const {
+    const int k = combined_tangents(*this, other);
+    Eigen::MatrixXd result = data.array() / other.data.array();
+
+    // d(a / b) = (da - (a / b) db) / b
+    Eigen::MatrixXd t = broadcast_tangent(data.rows(), data.cols(), k);
+    if (other.num_tangents > 0) {
+        t.array() -= result.replicate(k, 1).array() * other.tangent.array();
+    }
+    t.array() /= other.data.replicate(k, 1).array();
+    return Dual(result, t, k);
+}
+
+Dual Dual::operator/(const double scalar) const {
+    return *this * (1.0 / scalar);
+}
+
+Dual Dual::matmul(const Dual& other) const {
+    const int k = combined_tangents(*this, other);
+    Dual out = matmul(other.data);
+    if (out.num_tangents == 0) {
+        out.tangent = Eigen::MatrixXd::Zero(k * out.rows(), out.cols());
+        out.num_tangents = k;
+    }
+    if (other.num_tangents > 0) {
+        for (int i = 0; i < k; ++i) {
+            out.tangent_at(i).noalias() += data * other.tangent_at(i);
+        }
+    }
+    return out;
+}
+
+Dual Dual::matmul(const Eigen::MatrixXd& other) const {
+    // The stacked tangents times a constant is one (K * rows) x cols GEMM
+    Eigen::MatrixXd t;
+    if (num_tangents > 0) {
+        t.noalias() = tangent * other;
+    } else {
+        t.resize(0, other.cols());
+    }
+    return Dual(data * other, t, num_tangents);
+}
+
+Dual Dual::pow(const double exponent) const {
+    Eigen::MatrixXd slope = exponent * data.array().pow(exponent - 1);
+    return Dual(data.array().pow(exponent), tangent.cwiseProduct(slope.replicate(num_tangents, 1)), num_tangents);
+}
+
+Dual Dual::relu() const {
+    Eigen::MatrixXd mask = (data.array() > 0.0).cast<double>();
+    return Dual(data.cwiseMax(0.0), tangent.cwiseProduct(mask.replicate(num_tangents, 1)), num_tangents);
+}
+
+Dual Dual::sigmoid() const {
+    Eigen::MatrixXd s = 1.0 / (1.0 + (-data.array()).exp());
+    Eigen::MatrixXd slope = s.array() * (1.0 - s.array());
+    return Dual(s, tangent.cwiseProduct(slope.replicate(num_tangents, 1)), num_tangents);
+}
+
+Dual Dual::softmax() const {
+    Eigen::MatrixXd s = (data.colwise() - data.rowwise().maxCoeff()).array().exp();
+    s.array().colwise() /= s.rowwise().sum().array();
+
+    // ds = s * (dx - sum(s * dx)) row by row; rows of different directions are independent
+    const Eigen::MatrixXd s_rep = s.replicate(num_tangents, 1);
+    const Eigen::MatrixXd gs = s_rep.cwiseProduct(tangent);
+    Eigen::MatrixXd t = gs - s_rep.cwiseProduct(gs.rowwise().sum().replicate(1, data.cols()));
+    return Dual(s, t, num_tangents);
+}
+
+Dual Dual::transpose() const {
+    Eigen::MatrixXd t(num_tangents * data.cols(), data.rows());
+    for (int i = 0; i < num_tangents; ++i) {
+        t.middleRows(i * data.cols(), data.cols()) = tangent_at(i).transpose();
+    }
+    return Dual(data.transpose(), t, num_tangents);
+}
+
+Dual Dual::reshape(const int rows, const int cols) const {
+    eigen_assert(rows * cols == data.size());
+    Eigen::MatrixXd t(num_tangents * rows, cols);
+    for (int i = 0; i < num_tangents; ++i) {
+        // tangent_at is a strided block, so copy it out before reinterpreting the storage
+        const Eigen::MatrixXd block = tangent_at(i);
+        t.middleRows(i * rows, rows) = Eigen::Map<const Eigen::MatrixXd>(block.data(), rows, cols);
+    }
+    return Dual(Eigen::Map<const Eigen::MatrixXd>(data.data(), rows, cols), t, num_tangents);
+}
+
+Dual Dual::flatten() const {
+    if (data.cols() <= 1) {
+        return *this;
+    }
+    return reshape(1, data.size());
+}
+
+Dual Dual::sum() const {
+    return Dual(Eigen::MatrixXd::Constant(1, 1, data.sum()), block_sums(tangent, data.rows(), num_tangents),
+                num_tangents);
+}
+
+Dual Dual::cast(const Precision precision) const {
+    return Dual(round_to(data, precision), round_to(tangent, precision), num_tangents);
+}
+
+Dual activate(const Activation activation, const Dual& x, const double negative_slope) {
+    const Eigen::ArrayXXd a = x.data.array();
+    switch (activation) {
+        case Activation::ReLU:
+            return x.relu();
+        case Activation::Sigmoid:
+            return x.sigmoid();
+        case Activation::Tanh: {
+            const Eigen::ArrayXXd t = a.tanh();
+            return elementwise(x, t.matrix(), (1.0 - t.square()).matrix());
+        }
+        case Activation::GELU: {
+            const double k = std::sqrt(2.0 / M_PI);
+            const Eigen::ArrayXXd t = (k * (a + 0.044715 * a.cube())).tanh();
+            const Eigen::ArrayXXd slope =
+                0.5 * (1.0 + t) + 0.5 * a * (1.0 - t.square()) * k * (1.0 + 3 * 0.044715 * a.square());
+            return elementwise(x, (0.5 * a * (1.0 + t)).matrix(), slope.matrix());
+        }
+        case Activation::LeakyReLU:
+            return elementwise(x, activate(activation, x.data, negative_slope),
+                               (a > 0.0).select(Eigen::ArrayXXd::Ones(a.rows(), a.cols()), negative_slope).matrix());
+        case Activation::SiLU: {
+            const Eigen::ArrayXXd s = 1.0 / (1.0 + (-a).exp());
+            return elementwise(x, (a * s).matrix(), (s * (1.0 + a * (1.0 - s))).matrix());
+        }
+        case Activation::Identity:
+            break;
+    }
+    return x;
+}
+
+Dual forward(const Layer& layer, const Dual& x) {
+    Dual z = x.matmul(layer.w->data) + Dual(layer.b->data);
+    Dual a = layer.nonlin ? activate(layer.activation, z) : z;
+    return layer.precision == Precision::FP64 ? a : a.cast(layer.precision);
+}
+
+Dual forward(const MLP& model, const Dual& x) {
+    Dual out = forward(model.layers.front(), x);
+    for (size_t i = 0; i < model.layers.size(); ++i) {
+        if (i > 0) {
+            out = forward(model.layers[i], out);
+        }
+        // Eval-mode batch norm is a per-feature affine map; dropout is the identity
+        if (i < model.norms.size()) {
+            const auto affine = model.norms[i].eval_affine();
+            out = (out * Dual(affine.first.replicate(out.rows(), 1)) + Dual(affine.second)).relu();
+        }
+    }
+    return out;
+}
+
+Dual cross_entropy(const Dual& logits, const Eigen::VectorXi& labels) {
+    const int n_samples = logits.rows();
+    Eigen::MatrixXd probs = logits.softmax().data;
+    probs = probs.array().max(EPS).min(1.0 - EPS);
+
+    Eigen::MatrixXd true_labels_oh = Eigen::MatrixXd::Zero(n_samples, logits.cols());
+    for (int i = 0; i < n_samples; ++i) {
+        true_labels_oh(i, labels(i)) = 1.0;
+    }
+
+    const double loss_val = -(true_labels_oh.array() * probs.array().log()).sum() / n_samples;
+
+    // dL = sum((p - y) * dlogits) / n for each direction
+    const Eigen::MatrixXd slope = (probs - true_labels_oh).replicate(logits.num_tangents, 1) / n_samples;
+    return Dual(Eigen::MatrixXd::Constant(1, 1, loss_val),
+                block_sums(slope.cwiseProduct(logits.tangent), n_samples, logits.num_tangents),
+                logits.num_tangents);
+}
+
+Dual mse(const Dual& y_pred, const Eigen::MatrixXd& y_true) {
+    const Eigen::MatrixXd diff = y_pred.data - y_true;
+    const double size = diff.size();
+
+    const Eigen::MatrixXd slope = 2.0 * diff.replicate(y_pred.num_tangents, 1) / size;
+    return Dual(Eigen::MatrixXd::Constant(1, 1, diff.array().square().mean()),
+                block_sums(slope.cwiseProduct(y_pred.tangent), y_pred.rows(), y_pred.num_tangents),
+                y_pred.num_tangents);
+}
+
+Eigen::MatrixXd jacobian(const std::function<Dual(const Dual&)>& f, const Eigen::MatrixXd& x,
+                         const int chunk_size) {
+    const int n = x.size();
+    Eigen::MatrixXd jac;
+
+    std::vector<Eigen::MatrixXd> directions;
+    for (int start = 0; start < n; start += chunk_size) {
+        const int k = std::min(chunk_size, n - start);
+        directions.assign(k, Eigen::MatrixXd::Zero(x.rows(), x.cols()));
+        for (int i = 0; i < k; ++i) {
+            directions[i](start + i) = 1.0;
+        }
+
+        const Dual y = f(Dual::variable(x, directions));
+        if (jac.size() == 0) {
+            jac.resize(y.data.size(), n);
+        }
+        for (int i = 0; i < k; ++i) {
+            const Eigen::MatrixXd column = y.tangent_at(i);
+            jac.col(start + i) = Eigen::Map<const Eigen::VectorXd>(column.data(), column.size());
+        }
+    }
+    return jac;
+}
+
+} // namespace micrograd
@@ -0,0 +1,434 @@
+#include "graph_ir.hpp"
+#include "parallel.hpp"
+#include "precision.hpp"
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+namespace micrograd {
+
+namespace {
+
+const char IR_MAGIC[4] = {'M', 'G', 'I', 'R'};
+const int IR_VERSION = 1;
+
+// Number of graph inputs each exportable op takes; ops taking a scalar
+// argument instead of a second operand store it in attrs
+const std::map<std::string, std::set<size_t>>& exportable_ops() {
+    static const std::map<std::string, std::set<size_t>> ops = {
+        {"+", {1, 2}},        {"-", {2}},          {"*", {1, 2}},           {"/", {2}},       {"@", {2}},
+        {"pow", {1}},         {"relu", {1}},       {"sigmoid", {1}},        {"tanh", {1}},    {"gelu", {1}},
+        {"leaky_relu", {1}},  {"silu", {1}},       {"softmax", {1}},        {"T", {1}},       {"reshape", {1}},
+        {"sum_to", {1}},      {"broadcast_to", {1}}, {"cast", {1}},         {"batchnorm", {3}},
+    };
+    return ops;
+}
+
+// Element (i, j) of m, repeating a row or column vector like the engine's broadcasting
+double at(const Eigen::MatrixXd& m, const Eigen::Index i, const Eigen::Index j) {
+    return m(m.rows() == 1 ? 0 : i, m.cols() == 1 ? 0 : j);
+}
+
+template <typename Op>
+Eigen::MatrixXd broadcast(const Eigen::MatrixXd& a, const Eigen::MatrixXd& b, const int rows, const int cols, Op op) {
+    Eigen::MatrixXd out(rows, cols);
+    for (int j = 0; j < cols; ++j) {
+        for (int i = 0; i < rows; ++i) {
+            out(i, j) = op(at(a, i, j), at(b, i, j));
+        }
+    }
+    return out;
+}
+
+Eigen::MatrixXd evaluate(const IRNode& node, const std::vector<const Eigen::MatrixXd*>& args) {
+    const Eigen::MatrixXd& a = *args[0];
+    const std::string& op = node.op;
+    if (op == "+" && args.size() == 1) {
+        return a.array() + node.attrs[0];
+    }
+    if (op == "*" && args.size() == 1) {
+        return a * node.attrs[0];
+    }
+    if (op == "+") {
+        return broadcast(a, *args[1], node.rows, node.cols, [](double x, double y) { return x + y; });
+    }
+    if (op == "-") {
+        return broadcast(a, *args[1], node.rows, node.cols, [](double x, double y) { return x - y; });
+    }
+    if (op == "*") {
+        return broadcast(a, *args[1], node.rows, node.cols, [](double x, double y) { return x * y; });
+    }
+    if (op == "/") {
+        return broadcast(a, *args[1], node.rows, node.cols, [](double x, double y) { return x / y; });
+    }
+    if (op == "@") {
+        return a * *args[1];
+    }
+    if (op == "pow") {
+        return a.array().pow(node.attrs[0]);
+    }
+    if (op == "relu") {
+        return a.array().max(0.0);
+    }
+    if (op == "sigmoid") {
+        return 1.0 / (1.0 + (-a.array()).exp());
+    }
+    if (op == "tanh") {
+        return a.array().tanh();
+    }
+    if (op == "gelu") {
+        const double k = std::sqrt(2.0 / M_PI);
+        const Eigen::ArrayXXd x = a.array();
+        return (0.5 * x * (1.0 + (k * (x + 0.044715 * x.cube())).tanh())).matrix();
+    }
+    if (op == "leaky_relu") {
+        return (a.array() > 0.0).select(a, node.attrs[0] * a);
+    }
+    if (op == "silu") {
+        const Eigen::ArrayXXd s = 1.0 / (1.0 + (-a.array()).exp());
+        return (a.array() * s).matrix();
+    }
+    if (op == "softmax") {
+        Eigen::MatrixXd result = (a.colwise() - a.rowwise().maxCoeff()).array().exp();
+        result.array().colwise() /= result.rowwise().sum().array();
+        return result;
+    }
+    if (op == "T") {
+        return a.transpose();
+    }
+    if (op == "reshape") {
+        return Eigen::Map<const Eigen::MatrixXd>(a.data(), node.rows, node.cols);
+    }
+    if (op == "sum_to") {
+        Eigen::MatrixXd result = node.rows == 1 && a.rows() > 1 ? sum_rows(a) : a;
+        return node.cols == 1 && a.cols() > 1 ? Eigen::MatrixXd(result.rowwise().sum()) : result;
+    }
+    if (op == "broadcast_to") {
+        return a.replicate(node.rows / a.rows(), node.cols / a.cols());
+    }
+    if (op == "cast") {
+        return round_to(a, static_cast<Precision>(static_cast<int>(node.attrs[0])));
+    }
+    if (op == "batchnorm") {
+        const Eigen::MatrixXd& gamma = *args[1];
+        const Eigen::MatrixXd& beta = *args[2];
+        Eigen::MatrixXd result(a.rows(), a.cols());
+        for (Eigen::Index j = 0; j < a.cols(); ++j) {
+            const Eigen::VectorXd xhat = (a.col(j).array() - node.attrs[j]) * node.attrs[a.cols() + j];
+            result.col(j) = xhat * gamma(0, j) + Eigen::VectorXd::Constant(a.rows(), beta(0, j));
+        }
+        return result;
+    }
+    return Eigen::MatrixXd();
+}
+
+// Checks a loaded node's operand shapes and attrs, so that a corrupt file
+// cannot make the interpreter or code generator index out of bounds
+bool valid_node(const IRNode& node, const std::vector<IRNode>& nodes) {
+    const int r = node.rows;
+    const int c = node.cols;
+    auto fits = [&](const IRNode& a) { return (a.rows == r || a.rows == 1) && (a.cols == c || a.cols == 1); };
+    auto same = [&](const IRNode& a) { return a.rows == r && a.cols == c; };
+    const std::string& op = node.op;
+    const IRNode& a = nodes[node.inputs[0]];
+
+    if (node.inputs.size() == 2 && (op == "+" || op == "-" || op == "*" || op == "/")) {
+        return fits(a) && fits(nodes[node.inputs[1]]);
+    }
+    if (op == "+" || op == "*" || op == "pow" || op == "leaky_relu" || op == "cast") {
+        return same(a) && node.attrs.size() == 1;
+    }
+    if (op == "@") {
+        const IRNode& b = nodes[node.inputs[1]];
+        return a.rows == r && b.cols == c && a.cols == b.rows;
+    }
+    if (op == "T") {
+        return a.rows == c && a.cols == r;
+    }
+    if (op == "reshape") {
+        return static_cast<long long>(a.rows) * a.cols == static_cast<long long>(r) * c;
+    }
+    if (op == "sum_to") {
+        return (r == a.rows || r == 1) && (c == a.cols || c == 1);
+    }
+    if (op == "broadcast_to") {
+        return fits(a);
+    }
+    if (op == "batchnorm") {
+        const IRNode& gamma = nodes[node.inputs[1]];
+        const IRNode& beta = nodes[node.inputs[2]];
+        return same(a) && gamma.rows == 1 && gamma.cols == c && beta.rows == 1 && beta.cols == c &&
+               node.attrs.size() == 2 * static_cast<size_t>(c);
+    }
+    return same(a);
+}
+
+template <typename T>
+void write_pod(std::ostream& out, const T& v) {
+    out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+template <typename T>
+bool read_pod(std::istream& in, T& v) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&v), sizeof(T)));
+}
+
+} // namespace
+
+bool export_graph(const Value& output, const std::vector<Value*>& inputs, IRGraph& graph) {
+    graph = IRGraph();
+    std::unordered_map<const Value*, int> index;
+    std::vector<std::shared_ptr<Value>> keep_alive;
+
+    for (auto* input : inputs) {
+        auto node = input->get_self_ptr();
+        if (index.count(node.get())) {
+            std::cerr << "Error: The same value is listed twice as a graph input" << std::endl;
+            return false;
+        }
+        index[node.get()] = static_cast<int>(graph.nodes.size());
+        graph.inputs.push_back(static_cast<int>(graph.nodes.size()));
+        graph.nodes.push_back({"input", node->rows(), node->cols(), {}, {}, Eigen::MatrixXd()});
+        keep_alive.push_back(node);
+    }
+
+    // Iterative post-order walk that stops at the inputs, so every node is
+    // appended after its operands
+    auto root = output.get_self_ptr();
+    std::vector<std::pair<std::shared_ptr<Value>, size_t>> stack;
+    std::set<const Value*> visited;
+    if (!index.count(root.get())) {
+        visited.insert(root.get());
+        stack.emplace_back(root, 0);
+    }
+    while (!stack.empty()) {
+        auto& [node, next] = stack.back();
+        if (next < node->_prev.size()) {
+            const auto& child = node->_prev[next++];
+            if (!index.count(child.get()) && visited.insert(child.get()).second) {
+                stack.emplace_back(child, 0);
+            }
+            continue;
+        }
+
+        IRNode ir;
+        ir.rows = node->rows();
+        ir.cols = node->cols();
+        if (node->_prev.empty()) {
+            ir.op = "param";
+            ir.data = node->data;
+        } else {
+            const auto op = exportable_ops().find(node->_op);
+            if (op == exportable_ops().end() || !op->second.count(node->_prev.size())) {
+                std::cerr << "Error: Op '" << node->_op << "' cannot be exported" << std::endl;
+                return false;
+            }
+            if (node->_op == "batchnorm" && node->_attrs.empty()) {
+                std::cerr << "Error: Batch norm used batch statistics; trace the model in eval mode" << std::endl;
+                return false;
+            }
+            if (node->_prev.size() == 1 && (node->_op == "+" || node->_op == "*" || node->_op == "pow" ||
+                                            node->_op == "leaky_relu" || node->_op == "cast") &&
+                node->_attrs.size() != 1) {
+                std::cerr << "Error: Op '" << node->_op << "' is missing its scalar argument" << std::endl;
+                return false;
+            }
+            ir.op = node->_op;
+            ir.attrs.assign(node->_attrs.begin(), node->_attrs.end());
+            for (const auto& child : node->_prev) {
+                ir.inputs.push_back(index.at(child.get()));
+            }
+        }
+        index[node.get()] = static_cast<int>(graph.nodes.size());
+        graph.nodes.push_back(std::move(ir));
+        stack.pop_back();
+    }
+
+    graph.output = index.at(root.get());
+    return true;
+}
+
+Eigen::MatrixXd IRGraph::run(const std::vector<Eigen::MatrixXd>& values) const {
+    if (values.size() != inputs.size()) {
+        std::cerr << "Error: Graph expects " << inputs.size() << " inputs, got " << values.size() << std::endl;
+        return Eigen::MatrixXd();
+    }
+
+    std::vector<Eigen::MatrixXd> results(nodes.size());
+    std::vector<const Eigen::MatrixXd*> value_of(nodes.size(), nullptr);
+    for (size_t k = 0; k < inputs.size(); ++k) {
+        const IRNode& node = nodes[inputs[k]];
+        if (values[k].rows() != node.rows || values[k].cols() != node.cols) {
+            std::cerr << "Error: Graph input " << k << " must be " << node.rows << "x" << node.cols << ", got "
+                      << values[k].rows() << "x" << values[k].cols() << std::endl;
+            return Eigen::MatrixXd();
+        }
+        value_of[inputs[k]] = &values[k];
+    }
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const IRNode& node = nodes[i];
+        if (node.op == "input") {
+            continue;
+        }
+        if (node.op == "param") {
+            value_of[i] = &node.data;
+            continue;
+        }
+        std::vector<const Eigen::MatrixXd*> args;
+        for (int input : node.inputs) {
+            if (!value_of[input]) {
+                std::cerr << "Error: Graph input node " << input << " was not given a value" << std::endl;
+                return Eigen::MatrixXd();
+            }
+            args.push_back(value_of[input]);
+        }
+        results[i] = evaluate(node, args);
+        if (results[i].rows() != node.rows || results[i].cols() != node.cols) {
+            std::cerr << "Error: Op '" << node.op << "' produced the wrong shape" << std::endl;
+            return Eigen::MatrixXd();
+        }
+        value_of[i] = &results[i];
+    }
+    return output >= 0 ? *value_of[output] : Eigen::MatrixXd();
+}
+
+// Layout: "MGIR", version, node count, then per node the op name (length and
+// characters), rows, cols, input indices, attrs and, for parameters, the
+// column-major data; then the graph inputs and the output index.
+bool IRGraph::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file " << path << " for writing" << std::endl;
+        return false;
+    }
+
+    file.write(IR_MAGIC, sizeof(IR_MAGIC));
+    write_pod(file, IR_VERSION);
+    write_pod(file, static_cast<int32_t>(nodes.size()));
+    for (const auto& node : nodes) {
+        write_pod(file, static_cast<int32_t>(node.op.size()));
+        file.write(node.op.data(), node.op.size());
+        write_pod(file, static_cast<int32_t>(node.rows));
+        write_pod(file, static_cast<int32_t>(node.cols));
+        write_pod(file, static_cast<int32_t>(node.inputs.size()));
+        for (int input : node.inputs) {
+            write_pod(file, static_cast<int32_t>(input));
+        }
+        write_pod(file, static_cast<int32_t>(node.attrs.size()));
+        file.write(reinterpret_cast<const char*>(node.attrs.data()), node.attrs.size() * sizeof(double));
+        if (node.op == "param") {
+            file.write(reinterpret_cast<const char*>(node.data.data()), node.data.size() * sizeof(double));
+        }
+    }
+    write_pod(file, static_cast<int32_t>(inputs.size()));
+    for (int input : inputs) {
+        write_pod(file, static_cast<int32_t>(input));
+    }
+    write_pod(file, static_cast<int32_t>(output));
+
+    if (!file) {
+        std::cerr << "Error: Failed writing " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool IRGraph::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file " << path << " for reading" << std::endl;
+        return false;
+    }
+
+    char magic[4];
+    int version = 0;
+    int32_t count = 0;
+    if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + 4, IR_MAGIC) || !read_pod(file, version) ||
+        version != IR_VERSION || !read_pod(file, count) || count < 0) {
+        std::cerr << "Error: " << path << " is not a graph file" << std::endl;
+        return false;
+    }
+
+    IRGraph loaded;
+    for (int32_t i = 0; i < count; ++i) {
+        IRNode node;
+        int32_t length = 0, rows = 0, cols = 0, num_inputs = 0, num_attrs = 0;
+        if (!read_pod(file, length) || length < 0 || length > 64) {
+            std::cerr << "Error: Corrupt node in " << path << std::endl;
+            return false;
+        }
+        node.op.resize(length);
+        file.read(node.op.data(), length);
+        if (!read_pod(file, rows) || !read_pod(file, cols) || !read_pod(file, num_inputs) || rows < 0 || cols < 0 ||
+            num_inputs < 0 || num_inputs > 3) {
+            std::cerr << "Error: Corrupt node in " << path << std::endl;
+            return false;
+        }
+        node.rows = rows;
+        node.cols = cols;
+        for (int32_t k = 0; k < num_inputs; ++k) {
+            int32_t input = -1;
+            if (!read_pod(file, input) || input < 0 || input >= i) {
+                std::cerr << "Error: Node " << i << " in " << path << " has an invalid input" << std::endl;
+                return false;
+            }
+            node.inputs.push_back(input);
+        }
+        if (!read_pod(file, num_attrs) || num_attrs < 0 || num_attrs > 2 * cols + 1) {
+            std::cerr << "Error: Corrupt node in " << path << std::endl;
+            return false;
+        }
+        node.attrs.resize(num_attrs);
+        file.read(reinterpret_cast<char*>(node.attrs.data()), num_attrs * sizeof(double));
+        if (node.op == "param") {
+            node.data.resize(rows, cols);
+            file.read(reinterpret_cast<char*>(node.data.data()), node.data.size() * sizeof(double));
+        } else if (node.op != "input") {
+            const auto op = exportable_ops().find(node.op);
+            if (op == exportable_ops().end() || !op->second.count(node.inputs.size())) {
+                std::cerr << "Error: Unknown op '" << node.op << "' in " << path << std::endl;
+                return false;
+            }
+            if (!valid_node(node, loaded.nodes)) {
+                std::cerr << "Error: Node " << i << " ('" << node.op << "') in " << path << " has inconsistent shapes"
+                          << std::endl;
+                return false;
+            }
+        }
+        if (!file) {
+            std::cerr << "Error: Unexpected end of " << path << std::endl;
+            return false;
+        }
+        loaded.nodes.push_back(std::move(node));
+    }
+
+    int32_t num_inputs = 0;
+    if (!read_pod(file, num_inputs) || num_inputs < 0 || num_inputs > count) {
+        std::cerr << "Error: Corrupt graph inputs in " << path << std::endl;
+        return false;
+    }
+    for (int32_t k = 0; k < num_inputs; ++k) {
+        int32_t input = -1;
+        if (!read_pod(file, input) || input < 0 || input >= count || loaded.nodes[input].op != "input") {
+            std::cerr << "Error: Corrupt graph inputs in " << path << std::endl;
+            return false;
+        }
+        loaded.inputs.push_back(input);
+    }
+    int32_t out = -1;
+    if (!read_pod(file, out) || out < 0 || out >= count) {
+        std::cerr << "Error: Corrupt graph output in " << path << std::endl;
+        return false;
+    }
+    loaded.output = out;
+
+    *this = std::move(loaded);
+    return true;
+}
+
+} // namespace micrograd
@@ -0,0 +1,347 @@
+#include "inference_server.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace micrograd {
+
+namespace {
+
+const int NUM_LATENCY_BUCKETS = 32;
+// Largest reply a client accepts, in doubles
+const uint32_t MAX_REPLY_SIZE = 1 << 20;
+
+bool read_all(const int fd, void* buf, size_t size) {
+    auto* p = static_cast<char*>(buf);
+    while (size > 0) {
+        const ssize_t n = ::read(fd, p, size);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+// Every fd here is a socket: MSG_NOSIGNAL turns a peer that hung up into an
+// error instead of a SIGPIPE that would kill the process
+bool write_all(const int fd, const void* buf, size_t size) {
+    auto* p = static_cast<const char*>(buf);
+    while (size > 0) {
+        const ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool write_vector(const int fd, const Eigen::RowVectorXd& v) {
+    const uint32_t n = v.size();
+    return write_all(fd, &n, sizeof(n)) && write_all(fd, v.data(), n * sizeof(double));
+}
+
+// The count comes from the peer, so it is checked before anything is allocated
+bool read_vector(const int fd, Eigen::RowVectorXd& v, const uint32_t max_size) {
+    uint32_t n = 0;
+    if (!read_all(fd, &n, sizeof(n))) {
+        return false;
+    }
+    if (n > max_size) {
+        std::cerr << "Error: Expected at most " << max_size << " values, got " << n << std::endl;
+        return false;
+    }
+    v.resize(n);
+    return read_all(fd, v.data(), n * sizeof(double));
+}
+
+sockaddr_un make_address(const std::string& path) {
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    return addr;
+}
+
+} // namespace
+
+double InferenceStats::mean_batch_size() const {
+    return batches > 0 ? static_cast<double>(requests) / batches : 0.0;
+}
+
+double InferenceStats::latency_percentile_us(const double percentile) const {
+    long long total = 0;
+    for (auto count : latency_histogram) {
+        total += count;
+    }
+    if (total == 0) {
+        return 0.0;
+    }
+
+    const double target = percentile / 100.0 * total;
+    long long seen = 0;
+    for (size_t k = 0; k < latency_histogram.size(); ++k) {
+        seen += latency_histogram[k];
+        if (seen >= target) {
+            return static_cast<double>(1LL << (k + 1));
+        }
+    }
+    return static_cast<double>(1LL << latency_histogram.size());
+}
+
+InferenceServer::InferenceServer(const MLP& model, const Options options)
+    : model(model.clone()), options(options) {
+    counters.latency_histogram.assign(NUM_LATENCY_BUCKETS, 0);
+    for (int i = 0; i < std::max(1, options.num_workers); ++i) {
+        workers.emplace_back(&InferenceServer::worker, this);
+    }
+}
+
+InferenceServer::InferenceServer(const MLP& model) : InferenceServer(model, Options()) {}
+
+InferenceServer::~InferenceServer() {
+    stop();
+}
+
+std::future<Eigen::RowVectorXd> InferenceServer::submit(const Eigen::RowVectorXd& sample) {
+    Request request;
+    request.input = sample;
+    request.enqueued = clock::now();
+    auto result = request.result.get_future();
+
+    // Workers copy each sample into a row of the batch, so every sample needs the model's width
+    if (sample.size() != input_size()) {
+        request.result.set_exception(std::make_exception_ptr(
+            std::invalid_argument("InferenceServer: expected " + std::to_string(input_size()) + " features, got " +
+                                  std::to_string(sample.size()))));
+        return result;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            request.result.set_exception(std::make_exception_ptr(std::runtime_error("InferenceServer is stopped")));
+            return result;
+        }
+        queue.push_back(std::move(request));
+        counters.queue_depth = queue.size();
+        counters.max_queue_depth = std::max(counters.max_queue_depth, counters.queue_depth);
+    }
+    cv.notify_one();
+    return result;
+}
+
+Eigen::RowVectorXd InferenceServer::infer(const Eigen::RowVectorXd& sample) {
+    return submit(sample).get();
+}
+
+InferenceStats InferenceServer::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+void InferenceServer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    for (auto& t : workers) {
+        if (t.joinable()) {
+            t.join();
+        }
+    }
+}
+
+void InferenceServer::worker() {
+    std::vector<Request> batch;
+    Eigen::MatrixXd inputs;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this]() { return !queue.empty() || stopping; });
+            if (queue.empty()) {
+                return;
+            }
+
+            // Give the batch until max_delay_us after its oldest request to fill up
+            const auto deadline = queue.front().enqueued + std::chrono::microseconds(options.max_delay_us);
+            cv.wait_until(lock, deadline, [this]() {
+                return static_cast<int>(queue.size()) >= options.max_batch_size || stopping;
+            });
+            // Another worker may have taken the whole queue while this one waited
+            if (queue.empty()) {
+                continue;
+            }
+
+            const int n = std::min<int>(queue.size(), options.max_batch_size);
+            for (int i = 0; i < n; ++i) {
+                batch.push_back(std::move(queue.front()));
+                queue.pop_front();
+            }
+            counters.queue_depth = queue.size();
+        }
+        // Let another worker start collecting the next batch
+        cv.notify_one();
+
+        const int n = batch.size();
+        inputs.resize(n, batch.front().input.size());
+        for (int i = 0; i < n; ++i) {
+            inputs.row(i) = batch[i].input;
+        }
+
+        Eigen::MatrixXd outputs = model.predict(inputs);
+
+        // Record the batch before answering so stats() covers every returned result
+        const auto done = clock::now();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            counters.requests += n;
+            counters.batches++;
+            for (auto& request : batch) {
+                const auto us = std::chrono::duration_cast<std::chrono::microseconds>(done - request.enqueued).count();
+                int k = 0;
+                while (k + 1 < NUM_LATENCY_BUCKETS && (2LL << k) <= us) {
+                    k++;
+                }
+                counters.latency_histogram[k]++;
+            }
+        }
+
+        for (int i = 0; i < n; ++i) {
+            batch[i].result.set_value(outputs.row(i));
+        }
+        batch.clear();
+    }
+}
+
+UnixSocketFrontend::UnixSocketFrontend(InferenceServer& server, const std::string& socket_path)
+    : server(server), socket_path(socket_path) {}
+
+UnixSocketFrontend::~UnixSocketFrontend() {
+    stop();
+}
+
+bool UnixSocketFrontend::start() {
+    listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        std::cerr << "Error: Could not create socket" << std::endl;
+        return false;
+    }
+
+    ::unlink(socket_path.c_str());
+    sockaddr_un addr = make_address(socket_path);
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(listen_fd, 64) < 0) {
+        std::cerr << "Error: Could not listen on " << socket_path << std::endl;
+        ::close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+
+    acceptor = std::thread(&UnixSocketFrontend::accept_loop, this);
+    return true;
+}
+
+void UnixSocketFrontend::stop() {
+    if (listen_fd < 0) {
+        return;
+    }
+
+    // Shutting the sockets down wakes the threads blocked in accept/read
+    ::shutdown(listen_fd, SHUT_RDWR);
+    acceptor.join();
+    ::close(listen_fd);
+    listen_fd = -1;
+
+    // Each handler moves its thread to `finished` as it exits. Joining them
+    // means none still touches the mutex or drained once stop() returns.
+    std::vector<std::thread> exited;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (auto& [fd, handler] : connections) {
+            ::shutdown(fd, SHUT_RDWR);
+        }
+        drained.wait(lock, [this]() { return connections.empty(); });
+        exited.swap(finished);
+    }
+    for (auto& handler : exited) {
+        handler.join();
+    }
+    ::unlink(socket_path.c_str());
+}
+
+void UnixSocketFrontend::accept_loop() {
+    while (true) {
+        const int fd = ::accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            return;
+        }
+        // Handlers that have exited are joined here, so a long-running server
+        // does not keep a finished thread per client. The handler cannot
+        // deregister before it is registered, since that takes the lock.
+        std::vector<std::thread> exited;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            connections.emplace(fd, std::thread(&UnixSocketFrontend::serve, this, fd));
+            exited.swap(finished);
+        }
+        for (auto& handler : exited) {
+            handler.join();
+        }
+    }
+}
+
+void UnixSocketFrontend::serve(const int fd) {
+    Eigen::RowVectorXd sample;
+    while (read_vector(fd, sample, server.input_size())) {
+        if (sample.size() != server.input_size()) {
+            std::cerr << "Error: Expected " << server.input_size() << " features, got " << sample.size() << std::endl;
+            break;
+        }
+        Eigen::RowVectorXd output;
+        try {
+            output = server.infer(sample);
+        } catch (const std::exception& e) {
+            // E.g. the server was stopped while this client was connected
+            std::cerr << "Error: " << e.what() << std::endl;
+            break;
+        }
+        if (!write_vector(fd, output)) {
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto self = connections.find(fd);
+    finished.push_back(std::move(self->second));
+    connections.erase(self);
+    ::close(fd);
+    if (connections.empty()) {
+        drained.notify_all();
+    }
+}
+
+bool unix_socket_infer(const std::string& socket_path, const Eigen::RowVectorXd& sample,
+                       Eigen::RowVectorXd& output) {
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    sockaddr_un addr = make_address(socket_path);
+    const bool ok = ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+                    write_vector(fd, sample) && read_vector(fd, output, MAX_REPLY_SIZE);
+    ::close(fd);
+    return ok;
+}
+
+} // namespace micrograd
@@ -1,4 +1,6 @@
 #include "loss.hpp"
+#include "parallel.hpp"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
@@ -6,67 +8,90 @@ namespace micrograd {
 
 const double EPS = 1e-12;
 
-Eigen::MatrixXd softmax(const Value& x) {
-    Eigen::MatrixXd result(x.data.rows(), x.data.cols());
+namespace {
 
-    for (int i = 0; i < x.data.rows(); ++i) {
-        double max_val = x.data.row(i).maxCoeff();
-        Eigen::RowVectorXd exp_vals = (x.data.row(i).array() - max_val).exp();
-        double sum = exp_vals.sum();
-        result.row(i) = exp_vals / sum;
+// Row-wise softmax of x into out, which must already have x's shape
+void softmax_rows(const Eigen::MatrixXd& x, Eigen::MatrixXd& out) {
+    for (int i = 0; i < x.rows(); ++i) {
+        const double max_val = x.row(i).maxCoeff();
+        out.row(i) = (x.row(i).array() - max_val).exp().matrix();
+        out.row(i) /= out.row(i).sum();
     }
+}
+
+} // namespace
 
+Eigen::MatrixXd softmax(const Value& x) {
+    Eigen::MatrixXd result(x.data.rows(), x.data.cols());
+    softmax_rows(x.data, result);
     return result;
 }
 
 Value CrossEntropyLoss::forward(const Value& y_pred, const Eigen::VectorXi& y_true) {
-    Eigen::MatrixXd probs = softmax(y_pred);
-    probs = probs.array().max(EPS).min(1.0 - EPS);
-
-    int n_samples = y_pred.data.rows();
-    int n_classes = y_pred.data.cols();
+    const int n_samples = y_pred.data.rows();
 
-    // Create one-hot encoding
-    Eigen::MatrixXd true_labels_oh = Eigen::MatrixXd::Zero(n_samples, n_classes);
+    // Only the label's clipped probability is needed, so no softmax is stored
+    double log_likelihood = 0.0;
     for (int i = 0; i < n_samples; ++i) {
-        true_labels_oh(i, y_true(i)) = 1.0;
+        const auto row = y_pred.data.row(i).array();
+        const double max_val = row.maxCoeff();
+        const double p = std::exp(y_pred.data(i, y_true(i)) - max_val) / (row - max_val).exp().sum();
+        log_likelihood += std::log(std::min(std::max(p, EPS), 1.0 - EPS));
     }
-
-    // Compute loss
-    double loss_val = -(true_labels_oh.array() * probs.array().log()).sum() / n_samples;
-
-    Value out(Eigen::MatrixXd::Constant(1, 1, loss_val));
-    out._op = "CELoss";
+    const double loss_val = -log_likelihood / n_samples;
 
     auto y_pred_ptr = y_pred.get_self_ptr();
-    auto out_ptr = std::make_shared<Value>(out);
-    out_ptr->set_self(out_ptr);
-
-    out_ptr->_prev = {y_pred_ptr};
-    out_ptr->_backward = [y_pred_ptr, out_ptr, probs, true_labels_oh, n_samples]() {
-        Eigen::MatrixXd grad = (probs - true_labels_oh) / n_samples;
-        y_pred_ptr->grad += grad * out_ptr->grad(0, 0);
+    auto out_ptr = Value::make_node(pool_eval(Eigen::MatrixXd::Constant(1, 1, loss_val)), "CELoss", {y_pred_ptr});
+    // The labels live in _attrs and backward recomputes the softmax, so both
+    // closures hold one pointer and fit in std::function's inline storage
+    out_ptr->_attrs.assign(y_true.data(), y_true.data() + n_samples);
+
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [out]() {
+        // (clipped softmax - one_hot) / n, added row by row without a temporary
+        Value* pred = out->_prev[0].get();
+        const double scale = out->grad(0, 0) / pred->rows();
+        for (int i = 0; i < pred->rows(); ++i) {
+            const auto row = pred->data.row(i).array();
+            const double max_val = row.maxCoeff();
+            const double sum = (row - max_val).exp().sum();
+            pred->grad.row(i).array() += scale * ((row - max_val).exp() / sum).max(EPS).min(1.0 - EPS);
+            pred->grad(i, static_cast<int>(out->_attrs[i])) -= scale;
+        }
+    };
+    out_ptr->_backward_graph = [out](const Value& g) {
+        Value* pred = out->_prev[0].get();
+        const int n_samples = pred->rows();
+        Eigen::MatrixXd true_labels_oh = Eigen::MatrixXd::Zero(pred->rows(), pred->cols());
+        for (int i = 0; i < n_samples; ++i) {
+            true_labels_oh(i, static_cast<int>(out->_attrs[i])) = 1.0;
+        }
+        Value diff = pred->softmax() - Value(true_labels_oh);
+        return std::vector<Value>{diff * g.broadcast_to(diff.rows(), diff.cols()) * (1.0 / n_samples)};
     };
 
     return *out_ptr;
 }
 
 Value MSELoss::forward(const Value& y_pred, const Value& y_true) {
-    double loss_val = (y_pred.data - y_true.data).array().square().mean();
-
-    Value out(Eigen::MatrixXd::Constant(1, 1, loss_val));
-    out._op = "MSELoss";
+    Eigen::MatrixXd squared = pool_eval((y_pred.data - y_true.data).array().square());
+    const double loss_val = sum_all(squared) / y_pred.data.size();
+    pool_release(squared);
 
     auto y_pred_ptr = y_pred.get_self_ptr();
-    auto y_true_ptr = y_true.get_self_ptr();
-    auto out_ptr = std::make_shared<Value>(out);
-    out_ptr->set_self(out_ptr);
-
-    out_ptr->_prev = {y_pred_ptr};
-    out_ptr->_backward = [y_pred_ptr, y_true_ptr, out_ptr]() {
-        int size = y_pred_ptr->data.size();
-        Eigen::MatrixXd grad = 2.0 * (y_pred_ptr->data - y_true_ptr->data) / size;
-        y_pred_ptr->grad += grad * out_ptr->grad(0, 0);
+    auto out_ptr = Value::make_node(pool_eval(Eigen::MatrixXd::Constant(1, 1, loss_val)), "MSELoss", {y_pred_ptr});
+
+    // Targets get no gradient, so keep a copy of the data instead of a graph edge
+    Value* pred = y_pred_ptr.get();
+    Value* out = out_ptr.get();
+    PooledMatrix target(pool_eval(y_true.data));
+    out_ptr->_backward_graph = [pred, target](const Value& g) {
+        Value diff = *pred - Value(target.matrix);
+        return std::vector<Value>{diff * g.broadcast_to(diff.rows(), diff.cols()) * (2.0 / diff.data.size())};
+    };
+    out_ptr->_backward = [pred, out, target = std::move(target)]() {
+        const int size = pred->data.size();
+        pred->grad += 2.0 * (pred->data - target.matrix) / size * out->grad(0, 0);
     };
 
     return *out_ptr;
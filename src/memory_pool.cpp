@@ -0,0 +1,235 @@
+#include "memory_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+namespace micrograd {
+
+namespace {
+
+// Block size classes are 2^MIN_BLOCK_SHIFT .. 2^MAX_BLOCK_SHIFT bytes
+const int MIN_BLOCK_SHIFT = 4;
+const int MAX_BLOCK_SHIFT = 16;
+const int NUM_BLOCK_CLASSES = MAX_BLOCK_SHIFT - MIN_BLOCK_SHIFT + 1;
+
+std::atomic<long long> requests{0};
+std::atomic<long long> hits{0};
+std::atomic<long long> bytes_live{0};
+std::atomic<long long> bytes_cached{0};
+
+class MatrixPool {
+public:
+    Eigen::MatrixXd acquire(const int rows, const int cols) {
+        const Eigen::Index size = Eigen::Index(rows) * cols;
+        if (size == 0) {
+            return Eigen::MatrixXd(rows, cols);
+        }
+        const long long bytes = size * sizeof(double);
+        requests++;
+        std::lock_guard<std::mutex> lock(mutex);
+        Bucket& bucket = buckets[size];
+        Eigen::MatrixXd m;
+        if (!bucket.free.empty()) {
+            m = std::move(bucket.free.back());
+            bucket.free.pop_back();
+            hits++;
+            bytes_cached -= bytes;
+        }
+        // For a cached buffer the element count matches, so this only changes the shape
+        m.resize(rows, cols);
+        bucket.live++;
+        bytes_live += bytes;
+        bucket.peak = std::max(bucket.peak, bucket.live);
+        return m;
+    }
+
+    void release(Eigen::MatrixXd& m) {
+        const Eigen::Index size = m.size();
+        if (size == 0) {
+            return;
+        }
+        const long long bytes = size * sizeof(double);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Bucket& bucket = buckets[size];
+            // Any buffer of this size stands in for one handed out: a Value
+            // whose pooled data was replaced by assignment returns the new
+            // buffer instead. With none outstanding it was allocated elsewhere.
+            if (bucket.live > 0) {
+                bucket.live--;
+                bytes_live -= bytes;
+            }
+            if (bucket.free.size() < bucket.peak && bytes_cached + bytes <= capacity) {
+                bucket.free.push_back(std::move(m));
+                bytes_cached += bytes;
+                return;
+            }
+        }
+        m = Eigen::MatrixXd();
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& [size, bucket] : buckets) {
+            bytes_cached -= static_cast<long long>(size * sizeof(double) * bucket.free.size());
+            bucket.free.clear();
+            bucket.free.shrink_to_fit();
+        }
+    }
+
+    void set_capacity(const std::size_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        capacity = bytes;
+    }
+
+private:
+    // Buffers of one element count. `live` counts the ones handed out and not
+    // yet returned. At most `peak` are cached, the most that were ever live at
+    // once, so buffers that were allocated elsewhere and returned cannot grow
+    // the cache without bound.
+    struct Bucket {
+        std::vector<Eigen::MatrixXd> free;
+        std::size_t live = 0;
+        std::size_t peak = 0;
+    };
+
+    std::mutex mutex;
+    std::unordered_map<Eigen::Index, Bucket> buckets;
+    long long capacity = 1LL << 30;
+};
+
+class BlockPool {
+public:
+    void* allocate(const std::size_t bytes) {
+        const int c = size_class(bytes);
+        if (c >= NUM_BLOCK_CLASSES) {
+            return ::operator new(bytes);
+        }
+        const long long block_bytes = 1LL << (c + MIN_BLOCK_SHIFT);
+        requests++;
+        bytes_live += block_bytes;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (FreeBlock* block = free_lists[c]) {
+                free_lists[c] = block->next;
+                hits++;
+                bytes_cached -= block_bytes;
+                return block;
+            }
+        }
+        return ::operator new(block_bytes);
+    }
+
+    void deallocate(void* p, const std::size_t bytes) {
+        const int c = size_class(bytes);
+        if (c >= NUM_BLOCK_CLASSES) {
+            ::operator delete(p);
+            return;
+        }
+        const long long block_bytes = 1LL << (c + MIN_BLOCK_SHIFT);
+        bytes_live -= block_bytes;
+        bytes_cached += block_bytes;
+        std::lock_guard<std::mutex> lock(mutex);
+        auto* block = static_cast<FreeBlock*>(p);
+        block->next = free_lists[c];
+        free_lists[c] = block;
+    }
+
+    void clear() {
+        FreeBlock* lists[NUM_BLOCK_CLASSES];
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (int c = 0; c < NUM_BLOCK_CLASSES; ++c) {
+                lists[c] = free_lists[c];
+                free_lists[c] = nullptr;
+            }
+        }
+        for (int c = 0; c < NUM_BLOCK_CLASSES; ++c) {
+            while (FreeBlock* block = lists[c]) {
+                lists[c] = block->next;
+                ::operator delete(block);
+                bytes_cached -= 1LL << (c + MIN_BLOCK_SHIFT);
+            }
+        }
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    // Smallest class holding `bytes`
+    static int size_class(const std::size_t bytes) {
+        int c = 0;
+        while (c < NUM_BLOCK_CLASSES && (std::size_t(1) << (c + MIN_BLOCK_SHIFT)) < bytes) {
+            ++c;
+        }
+        return c;
+    }
+
+    std::mutex mutex;
+    FreeBlock* free_lists[NUM_BLOCK_CLASSES] = {};
+};
+
+// Never destroyed, so values freed during static destruction still find them
+MatrixPool& matrix_pool() {
+    static auto* instance = new MatrixPool;
+    return *instance;
+}
+
+BlockPool& block_pool() {
+    static auto* instance = new BlockPool;
+    return *instance;
+}
+
+} // namespace
+
+PoolStats pool_stats() {
+    PoolStats stats;
+    stats.requests = requests;
+    stats.hits = hits;
+    stats.bytes_live = bytes_live;
+    stats.bytes_cached = bytes_cached;
+    return stats;
+}
+
+void reset_pool_stats() {
+    requests = 0;
+    hits = 0;
+}
+
+void clear_pool() {
+    matrix_pool().clear();
+    block_pool().clear();
+}
+
+void set_pool_capacity(const std::size_t bytes) {
+    matrix_pool().set_capacity(bytes);
+}
+
+Eigen::MatrixXd pool_acquire(const int rows, const int cols) {
+    return matrix_pool().acquire(rows, cols);
+}
+
+Eigen::MatrixXd pool_zeros(const int rows, const int cols) {
+    Eigen::MatrixXd m = pool_acquire(rows, cols);
+    m.setZero();
+    return m;
+}
+
+void pool_release(Eigen::MatrixXd& m) {
+    matrix_pool().release(m);
+}
+
+void* pool_allocate(const std::size_t bytes) {
+    return block_pool().allocate(bytes);
+}
+
+void pool_deallocate(void* p, const std::size_t bytes) {
+    block_pool().deallocate(p, bytes);
+}
+
+} // namespace micrograd
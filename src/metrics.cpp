@@ -0,0 +1,144 @@
+#include "metrics.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace micrograd {
+
+Metrics::Accumulator::Accumulator(const int num_classes, const int num_bins)
+    : rank_counts(num_classes, 0), confusion(Eigen::MatrixXi::Zero(num_classes, num_classes)),
+      bin_counts(num_bins, 0), bin_correct(num_bins, 0), bin_confidence(num_bins, 0.0) {}
+
+void Metrics::Accumulator::add(const Accumulator& other) {
+    for (size_t r = 0; r < rank_counts.size(); ++r) {
+        rank_counts[r] += other.rank_counts[r];
+    }
+    confusion += other.confusion;
+    loss_sum += other.loss_sum;
+    for (size_t b = 0; b < bin_counts.size(); ++b) {
+        bin_counts[b] += other.bin_counts[b];
+        bin_correct[b] += other.bin_correct[b];
+        bin_confidence[b] += other.bin_confidence[b];
+    }
+    total += other.total;
+}
+
+Metrics::Metrics(const int num_classes, const int num_bins) : counts(num_classes, std::max(1, num_bins)) {}
+
+void Metrics::accumulate(const Eigen::MatrixXd& logits, const Eigen::VectorXi& labels, const int begin,
+                         const int end, Accumulator& acc) const {
+    const int classes = logits.cols();
+    const int num_bins = acc.bin_counts.size();
+
+    for (int i = begin; i < end; ++i) {
+        const int label = labels(i);
+        const double* row = logits.data() + i;
+        const Eigen::Index stride = logits.rows();
+
+        // One pass for the argmax and the rank of the true label; ties rank by
+        // class index, matching maxCoeff
+        const double target = row[label * stride];
+        int pred = 0;
+        double max_logit = row[0];
+        int rank = 0;
+        for (int j = 0; j < classes; ++j) {
+            const double v = row[j * stride];
+            if (v > max_logit) {
+                max_logit = v;
+                pred = j;
+            }
+            if (v > target || (v == target && j < label)) {
+                rank++;
+            }
+        }
+
+        double sum_exp = 0.0;
+        for (int j = 0; j < classes; ++j) {
+            sum_exp += std::exp(row[j * stride] - max_logit);
+        }
+        const double log_sum_exp = max_logit + std::log(sum_exp);
+
+        acc.rank_counts[rank]++;
+        acc.confusion(label, pred)++;
+        acc.loss_sum += log_sum_exp - target;
+
+        // Softmax probability of the predicted class
+        const double confidence = 1.0 / sum_exp;
+        const int bin = std::min(num_bins - 1, static_cast<int>(confidence * num_bins));
+        acc.bin_counts[bin]++;
+        acc.bin_correct[bin] += pred == label;
+        acc.bin_confidence[bin] += confidence;
+    }
+    acc.total += end - begin;
+}
+
+void Metrics::update(const Eigen::MatrixXd& logits, const Eigen::VectorXi& labels) {
+    if (logits.cols() != num_classes() || logits.rows() != labels.size()) {
+        std::cerr << "Error: Metrics expected " << labels.size() << " x " << num_classes() << " logits, got "
+                  << logits.rows() << " x " << logits.cols() << std::endl;
+        return;
+    }
+    if (labels.size() > 0 && (labels.minCoeff() < 0 || labels.maxCoeff() >= num_classes())) {
+        std::cerr << "Error: Metrics label out of range [0, " << num_classes() << ")" << std::endl;
+        return;
+    }
+
+    const int rows = logits.rows();
+    const RowChunks chunks = row_chunks(rows);
+    std::vector<Accumulator> parts(chunks.count, Accumulator(num_classes(), counts.bin_counts.size()));
+    parallel_for(chunks.count, [&](const int c) {
+        const int begin = std::min(rows, c * chunks.size);
+        accumulate(logits, labels, begin, std::min(rows, begin + chunks.size), parts[c]);
+    });
+
+    // Combined in chunk order, so the floating-point sums are reproducible in deterministic mode
+    for (const auto& part : parts) {
+        counts.add(part);
+    }
+}
+
+void Metrics::merge(const Metrics& other) {
+    if (other.num_classes() != num_classes() || other.counts.bin_counts.size() != counts.bin_counts.size()) {
+        std::cerr << "Error: Cannot merge Metrics with different classes or bins" << std::endl;
+        return;
+    }
+    counts.add(other.counts);
+}
+
+void Metrics::reset() {
+    counts = Accumulator(num_classes(), counts.bin_counts.size());
+}
+
+double Metrics::accuracy() const {
+    return top_k_accuracy(1);
+}
+
+double Metrics::top_k_accuracy(const int k) const {
+    if (counts.total == 0) {
+        return 0.0;
+    }
+    long long hits = 0;
+    for (int r = 0; r < std::min<int>(k, counts.rank_counts.size()); ++r) {
+        hits += counts.rank_counts[r];
+    }
+    return static_cast<double>(hits) / counts.total;
+}
+
+double Metrics::log_loss() const {
+    return counts.total > 0 ? counts.loss_sum / counts.total : 0.0;
+}
+
+double Metrics::calibration_error() const {
+    if (counts.total == 0) {
+        return 0.0;
+    }
+    // sum_b (n_b / N) |acc_b - conf_b| = sum_b |correct_b - confidence_sum_b| / N
+    double error = 0.0;
+    for (size_t b = 0; b < counts.bin_counts.size(); ++b) {
+        error += std::abs(static_cast<double>(counts.bin_correct[b]) - counts.bin_confidence[b]);
+    }
+    return error / counts.total;
+}
+
+} // namespace micrograd
@@ -1,6 +1,9 @@
 #include "mnist_loader.hpp"
+#include "random.hpp"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <numeric>
 #include <stdexcept>
 
 namespace micrograd {
@@ -88,13 +91,22 @@ bool MNISTLoader::load(const std::string& images_path, const std::string& labels
     return true;
 }
 
-void MNISTLoader::get_batch(int batch_idx, int batch_size, Eigen::MatrixXd& batch_images, Eigen::VectorXi& batch_labels) {
+void MNISTLoader::get_batch(int batch_idx, int batch_size, Eigen::MatrixXd& batch_images, Eigen::VectorXi& batch_labels) const {
     int start_idx = batch_idx * batch_size;
     int end_idx = std::min(start_idx + batch_size, num_images);
     int actual_batch_size = end_idx - start_idx;
 
-    batch_images = images.block(start_idx, 0, actual_batch_size, images.cols());
-    batch_labels = labels.segment(start_idx, actual_batch_size);
+    if (order.empty()) {
+        batch_images = images.block(start_idx, 0, actual_batch_size, images.cols());
+        batch_labels = labels.segment(start_idx, actual_batch_size);
+    } else {
+        batch_images.resize(actual_batch_size, images.cols());
+        batch_labels.resize(actual_batch_size);
+        for (int i = 0; i < actual_batch_size; ++i) {
+            batch_images.row(i) = images.row(order[start_idx + i]);
+            batch_labels(i) = labels(order[start_idx + i]);
+        }
+    }
 
     batch_images /= 255.0;
 }
@@ -103,4 +115,11 @@ int MNISTLoader::get_num_batches(const int batch_size) const {
     return (num_images + batch_size - 1) / batch_size;
 }
 
+void MNISTLoader::shuffle() {
+    // Start from file order so the permutation depends only on the generator state
+    order.resize(num_images);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), global_generator());
+}
+
 } // namespace micrograd
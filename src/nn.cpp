@@ -1,11 +1,122 @@
 #include "nn.hpp"
+#include "autodiff.hpp"
+#include "random.hpp"
+#include <algorithm>
 #include <random>
+#include <stdexcept>
+#include <string>
 #include <cmath>
 #include <fstream>
 #include <iostream>
 
 namespace micrograd {
 
+void write_weights(std::ostream& out, const std::vector<const Eigen::MatrixXd*>& weights) {
+    const int num_params = weights.size();
+    out.write(reinterpret_cast<const char*>(&num_params), sizeof(int));
+
+    for (auto* w : weights) {
+        int rows = w->rows();
+        int cols = w->cols();
+        out.write(reinterpret_cast<const char*>(&rows), sizeof(int));
+        out.write(reinterpret_cast<const char*>(&cols), sizeof(int));
+        out.write(reinterpret_cast<const char*>(w->data()), rows * cols * sizeof(double));
+    }
+}
+
+bool read_weights(std::istream& in, const std::vector<Eigen::MatrixXd*>& weights) {
+    int num_params = 0;
+    in.read(reinterpret_cast<char*>(&num_params), sizeof(int));
+    if (num_params != static_cast<int>(weights.size())) {
+        std::cerr << "Error: Architecture mismatch. Model has " << weights.size()
+                  << " parameters, but file has " << num_params << std::endl;
+        return false;
+    }
+
+    for (auto* w : weights) {
+        int rows = 0;
+        int cols = 0;
+        in.read(reinterpret_cast<char*>(&rows), sizeof(int));
+        in.read(reinterpret_cast<char*>(&cols), sizeof(int));
+
+        if (rows != w->rows() || cols != w->cols()) {
+            std::cerr << "Error: Shape mismatch for parameter" << std::endl;
+            return false;
+        }
+
+        in.read(reinterpret_cast<char*>(w->data()), rows * cols * sizeof(double));
+    }
+    return true;
+}
+
+namespace {
+
+// Dropout keep-mask, one bit per element
+using DropoutMask = std::vector<uint64_t, PoolAllocator<uint64_t>>;
+
+// dst = scale * src where the mask keeps an element and 0 elsewhere, or with
+// Accumulate dst += that. Whole words that keep or drop every element become
+// one vectorized block; mixed words multiply by the bit instead of branching.
+template <bool Accumulate>
+void apply_mask(const DropoutMask& bits, const double* src, double* dst, const Eigen::Index size,
+                const double scale) {
+    for (size_t w = 0; w < bits.size(); ++w) {
+        const Eigen::Index begin = static_cast<Eigen::Index>(w) * 64;
+        const int len = static_cast<int>(std::min<Eigen::Index>(64, size - begin));
+        const uint64_t valid = len == 64 ? ~uint64_t{0} : (uint64_t{1} << len) - 1;
+        const uint64_t word = bits[w] & valid;
+        Eigen::Map<const Eigen::ArrayXd> in(src + begin, len);
+        Eigen::Map<Eigen::ArrayXd> out(dst + begin, len);
+        if (word == valid) {
+            if (Accumulate) {
+                out += scale * in;
+            } else {
+                out = scale * in;
+            }
+        } else if (word == 0) {
+            if (!Accumulate) {
+                out.setZero();
+            }
+        } else {
+            for (int k = 0; k < len; ++k) {
+                const double kept = scale * static_cast<double>((word >> k) & 1);
+                out[k] = (Accumulate ? out[k] : 0.0) + kept * in[k];
+            }
+        }
+    }
+}
+
+Eigen::MatrixXd unpack_mask(const DropoutMask& bits, const int rows, const int cols, const double scale) {
+    Eigen::MatrixXd mask = pool_acquire(rows, cols);
+    mask.setOnes();
+    apply_mask<false>(bits, mask.data(), mask.data(), mask.size(), scale);
+    return mask;
+}
+
+// Batch norm from plain Value ops, for create_graph backward passes
+Value batch_norm_graph(const Value& x, const Value& gamma, const Value& beta, const Eigen::MatrixXd* mean,
+                       const Eigen::MatrixXd* var, const double eps) {
+    const int n = x.rows();
+    const int c = x.cols();
+    Value centered = mean ? x - Value(*mean) : x - x.sum_to(1, c) * (1.0 / n);
+    Value inv_std = var ? Value((var->array() + eps).rsqrt().matrix())
+                        : ((centered * centered).sum_to(1, c) * (1.0 / n) + eps).pow(-0.5);
+    return centered * inv_std.broadcast_to(n, c) * gamma.broadcast_to(n, c) + beta;
+}
+
+} // namespace
+
+std::vector<Eigen::MatrixXd*> Module::state() {
+    std::vector<Eigen::MatrixXd*> result;
+    for (auto* p : parameters()) {
+        result.push_back(&p->data);
+    }
+    for (auto* b : buffers()) {
+        result.push_back(b);
+    }
+    return result;
+}
+
 void Module::zero_grad() {
     for (auto* p : parameters()) {
         p->zero_grad();
@@ -19,17 +130,11 @@ void Module::save_weights(const std::string& path) {
         return;
     }
 
-    const auto params = parameters();
-    const int num_params = params.size();
-    file.write(reinterpret_cast<const char*>(&num_params), sizeof(int));
-
-    for (auto* p : params) {
-        int rows = p->data.rows();
-        int cols = p->data.cols();
-        file.write(reinterpret_cast<const char*>(&rows), sizeof(int));
-        file.write(reinterpret_cast<const char*>(&cols), sizeof(int));
-        file.write(reinterpret_cast<const char*>(p->data.data()), rows * cols * sizeof(double));
+    std::vector<const Eigen::MatrixXd*> weights;
+    for (auto* m : state()) {
+        weights.push_back(m);
     }
+    write_weights(file, weights);
 
     file.close();
     std::cout << "Model saved to " << path << std::endl;
@@ -42,29 +147,10 @@ void Module::load_weights(const std::string& path) {
         return;
     }
 
-    int num_params;
-    file.read(reinterpret_cast<char*>(&num_params), sizeof(int));
-
-    auto params = parameters();
-    if (num_params != params.size()) {
-        std::cerr << "Error: Architecture mismatch. Model has " << params.size()
-                  << " parameters, but file has " << num_params << std::endl;
+    if (!read_weights(file, state())) {
         return;
     }
 
-    for (auto* p : params) {
-        int rows, cols;
-        file.read(reinterpret_cast<char*>(&rows), sizeof(int));
-        file.read(reinterpret_cast<char*>(&cols), sizeof(int));
-
-        if (rows != p->data.rows() || cols != p->data.cols()) {
-            std::cerr << "Error: Shape mismatch for parameter" << std::endl;
-            return;
-        }
-
-        file.read(reinterpret_cast<char*>(p->data.data()), rows * cols * sizeof(double));
-    }
-
     file.close();
     std::cout << "Model loaded from " << path << std::endl;
 }
@@ -72,8 +158,7 @@ void Module::load_weights(const std::string& path) {
 Layer::Layer(const int nin, const int nout, const bool nonlin)
     : nonlin(nonlin) {
     // He initialization
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    auto& gen = global_generator();
     double stddev = std::sqrt(2.0 / nin);
     std::normal_distribution<> d(0.0, stddev);
 
@@ -91,40 +176,288 @@ Layer::Layer(const int nin, const int nout, const bool nonlin)
     b->set_self(b);
 }
 
+Layer::Layer(const int nin, const int nout, const Activation activation)
+    : Layer(nin, nout, activation != Activation::Identity) {
+    if (nonlin) {
+        this->activation = activation;
+    }
+}
+
 Value Layer::forward(const Value& x) const {
     Value z = x.matmul(*w) + *b;
-    return nonlin ? z.relu() : z;
+    Value a = nonlin ? activate(activation, z) : z;
+    return precision == Precision::FP64 ? a : a.cast(precision);
+}
+
+Eigen::MatrixXd Layer::predict(const Eigen::MatrixXd& x) const {
+    Eigen::MatrixXd z = x * w->data;
+    z.rowwise() += b->data.row(0);
+    return nonlin ? activate(activation, z) : z;
 }
 
 std::vector<Value*> Layer::parameters() {
     return {w.get(), b.get()};
 }
 
-MLP::MLP(int nin, const std::vector<int>& nouts) {
+BatchNorm1d::BatchNorm1d(const int num_features, const double momentum, const double eps)
+    : running_mean(Eigen::MatrixXd::Zero(1, num_features)),
+      running_var(Eigen::MatrixXd::Ones(1, num_features)),
+      momentum(momentum),
+      eps(eps) {
+    gamma = std::make_shared<Value>(Eigen::MatrixXd::Ones(1, num_features));
+    gamma->set_self(gamma);
+
+    beta = std::make_shared<Value>(Eigen::MatrixXd::Zero(1, num_features));
+    beta->set_self(beta);
+}
+
+Value BatchNorm1d::forward(const Value& x) {
+    const int n = x.rows();
+    const int c = x.cols();
+    // A single sample has no batch variance, so it is normalized with the running statistics
+    const bool batch_stats = training && n > 1;
+
+    // One pass per column while it is in cache: statistics, then normalize and
+    // scale. The buffers come from the pool; xhat and inv_std move into the
+    // backward closure and result into the output node.
+    PooledMatrix xhat(pool_acquire(n, c));
+    PooledMatrix inv_std(pool_acquire(1, c));
+    Eigen::MatrixXd result = pool_acquire(n, c);
+    for (int j = 0; j < c; ++j) {
+        double mean, var;
+        if (batch_stats) {
+            mean = x.data.col(j).mean();
+            var = (x.data.col(j).array() - mean).square().sum() / n;
+            running_mean(0, j) = (1.0 - momentum) * running_mean(0, j) + momentum * mean;
+            running_var(0, j) = (1.0 - momentum) * running_var(0, j) + momentum * var * n / (n - 1);
+        } else {
+            mean = running_mean(0, j);
+            var = running_var(0, j);
+        }
+        inv_std.matrix(0, j) = 1.0 / std::sqrt(var + eps);
+        xhat.matrix.col(j) = (x.data.col(j).array() - mean) * inv_std.matrix(0, j);
+        result.col(j) = (xhat.matrix.col(j).array() * gamma->data(0, j) + beta->data(0, j)).matrix();
+    }
+
+    auto x_ptr = x.get_self_ptr();
+    auto out_ptr = Value::make_node(std::move(result), "batchnorm", {x_ptr, gamma, beta});
+
+    Value* a = x_ptr.get();
+    Value* g = gamma.get();
+    Value* b = beta.get();
+    Value* out = out_ptr.get();
+    const double eps_value = eps;
+    if (batch_stats) {
+        out_ptr->_backward_graph = [a, g, b, eps_value](const Value& grad_out) {
+            Value y = batch_norm_graph(*a, *g, *b, nullptr, nullptr, eps_value);
+            return grad(y, {a, g, b}, &grad_out, true);
+        };
+    } else {
+        // With fixed statistics the op is an affine map; record it for graph export
+        out_ptr->_attrs.assign(running_mean.data(), running_mean.data() + c);
+        out_ptr->_attrs.insert(out_ptr->_attrs.end(), inv_std.matrix.data(), inv_std.matrix.data() + c);
+        out_ptr->_backward_graph = [a, g, b, mean = PooledMatrix(pool_eval(running_mean)),
+                                    var = PooledMatrix(pool_eval(running_var)), eps_value](const Value& grad_out) {
+            Value y = batch_norm_graph(*a, *g, *b, &mean.matrix, &var.matrix, eps_value);
+            return grad(y, {a, g, b}, &grad_out, true);
+        };
+    }
+
+    out_ptr->_backward = [a, g, b, out, xhat = std::move(xhat), inv_std = std::move(inv_std), batch_stats]() {
+        const int n = out->grad.rows();
+        for (int j = 0; j < out->grad.cols(); ++j) {
+            const auto dy = out->grad.col(j).array();
+            const auto xhat_j = xhat.matrix.col(j).array();
+            const double sum_dy = dy.sum();
+            const double sum_dy_xhat = (dy * xhat_j).sum();
+            g->grad(0, j) += sum_dy_xhat;
+            b->grad(0, j) += sum_dy;
+
+            const double scale = g->data(0, j) * inv_std.matrix(0, j);
+            if (batch_stats) {
+                // Gradient through the batch mean and variance as well
+                a->grad.col(j).array() += scale / n * (n * dy - sum_dy - xhat_j * sum_dy_xhat);
+            } else {
+                a->grad.col(j).array() += scale * dy;
+            }
+        }
+    };
+
+    return *out_ptr;
+}
+
+std::pair<Eigen::MatrixXd, Eigen::MatrixXd> BatchNorm1d::eval_affine() const {
+    Eigen::MatrixXd scale = gamma->data.array() * (running_var.array() + eps).rsqrt();
+    Eigen::MatrixXd shift = beta->data.array() - running_mean.array() * scale.array();
+    return {scale, shift};
+}
+
+Eigen::MatrixXd BatchNorm1d::predict(const Eigen::MatrixXd& x) const {
+    const auto affine = eval_affine();
+    return (x.array().rowwise() * affine.first.row(0).array()).rowwise() + affine.second.row(0).array();
+}
+
+std::vector<Value*> BatchNorm1d::parameters() {
+    return {gamma.get(), beta.get()};
+}
+
+std::vector<Eigen::MatrixXd*> BatchNorm1d::buffers() {
+    return {&running_mean, &running_var};
+}
+
+Dropout::Dropout(const double p) : p(p), seed(global_generator()()) {
+    // p = 1 would scale the kept elements by 1 / 0; the negated test also rejects NaN
+    if (!(p >= 0.0 && p < 1.0)) {
+        throw std::invalid_argument("Dropout: p must be in [0, 1), got " + std::to_string(p));
+    }
+}
+
+Value Dropout::forward(const Value& x) {
+    auto x_ptr = x.get_self_ptr();
+    if (!training || p <= 0.0) {
+        return *x_ptr;
+    }
+
+    const Eigen::Index size = x_ptr->data.size();
+    const uint64_t key = splitmix64(seed ^ splitmix64(counter++));
+    // Keep an element when the top 53 bits of its hash fall below (1 - p) * 2^53
+    const uint64_t threshold = static_cast<uint64_t>(std::ldexp(1.0 - p, 53));
+    const double scale = 1.0 / (1.0 - p);
+
+    // One mask shared by both backward closures, built a word at a time
+    auto bits = std::allocate_shared<DropoutMask>(PoolAllocator<DropoutMask>(), (size + 63) / 64);
+    for (size_t w = 0; w < bits->size(); ++w) {
+        uint64_t word = 0;
+        for (int k = 0; k < 64; ++k) {
+            word |= static_cast<uint64_t>((splitmix64(key + w * 64 + k) >> 11) < threshold) << k;
+        }
+        (*bits)[w] = word;
+    }
+
+    Eigen::MatrixXd result = pool_acquire(x_ptr->rows(), x_ptr->cols());
+    apply_mask<false>(*bits, x_ptr->data.data(), result.data(), size, scale);
+
+    auto out_ptr = Value::make_node(std::move(result), "dropout", {x_ptr});
+
+    Value* a = x_ptr.get();
+    Value* out = out_ptr.get();
+    out_ptr->_backward = [a, out, bits, scale]() {
+        apply_mask<true>(*bits, out->grad.data(), a->grad.data(), out->grad.size(), scale);
+    };
+    out_ptr->_backward_graph = [out, bits, scale](const Value& g) {
+        return std::vector<Value>{g * Value(unpack_mask(*bits, out->rows(), out->cols(), scale))};
+    };
+
+    return *out_ptr;
+}
+
+ActivationLayer::ActivationLayer(const Activation activation, const double negative_slope)
+    : activation(activation), negative_slope(negative_slope) {}
+
+MLP::MLP(int nin, const std::vector<int>& nouts) : MLP(nin, nouts, Options()) {}
+
+MLP::MLP(int nin, const std::vector<int>& nouts, const Options& options) {
     std::vector<int> sz = {nin};
     sz.insert(sz.end(), nouts.begin(), nouts.end());
 
     for (size_t i = 0; i < nouts.size(); ++i) {
         bool is_last = (i == nouts.size() - 1);
-        layers.emplace_back(sz[i], sz[i + 1], !is_last);
+        // With batch norm the ReLU comes after the norm, so MLP applies it
+        layers.emplace_back(sz[i], sz[i + 1], !is_last && !options.batch_norm);
+        if (!is_last && options.batch_norm) {
+            norms.emplace_back(sz[i + 1]);
+        }
+        if (!is_last && options.dropout > 0.0) {
+            dropouts.emplace_back(options.dropout);
+        }
     }
 }
 
-Value MLP::forward(const Value& x) const {
-    Value out = x;
-    for (auto& layer : layers) {
-        out = layer.forward(out);
+Value MLP::forward(const Value& x) {
+    // With no layers the model is the identity, as predict() is
+    if (layers.empty()) {
+        return *x.get_self_ptr();
+    }
+    // Start from the first layer so x itself (not a copy) becomes the graph input
+    Value out = layers.front().forward(x);
+    for (size_t i = 0; i < layers.size(); ++i) {
+        if (i > 0) {
+            out = layers[i].forward(out);
+        }
+        if (i < norms.size()) {
+            out = norms[i].forward(out).relu();
+        }
+        if (i < dropouts.size()) {
+            out = dropouts[i].forward(out);
+        }
+    }
+    return out;
+}
+
+Eigen::MatrixXd MLP::predict(const Eigen::MatrixXd& x) const {
+    Eigen::MatrixXd out = x;
+    for (size_t i = 0; i < layers.size(); ++i) {
+        out = layers[i].predict(out);
+        if (i < norms.size()) {
+            out = norms[i].predict(out).cwiseMax(0.0);
+        }
     }
     return out;
 }
 
 std::vector<Value*> MLP::parameters() {
     std::vector<Value*> params;
-    for (auto& layer : layers) {
-        auto layer_params = layer.parameters();
+    for (size_t i = 0; i < layers.size(); ++i) {
+        auto layer_params = layers[i].parameters();
         params.insert(params.end(), layer_params.begin(), layer_params.end());
+        if (i < norms.size()) {
+            auto norm_params = norms[i].parameters();
+            params.insert(params.end(), norm_params.begin(), norm_params.end());
+        }
     }
     return params;
 }
 
+std::vector<Eigen::MatrixXd*> MLP::buffers() {
+    std::vector<Eigen::MatrixXd*> result;
+    for (auto& norm : norms) {
+        auto norm_buffers = norm.buffers();
+        result.insert(result.end(), norm_buffers.begin(), norm_buffers.end());
+    }
+    return result;
+}
+
+void MLP::train(const bool mode) {
+    training = mode;
+    for (auto& norm : norms) {
+        norm.train(mode);
+    }
+    for (auto& dropout : dropouts) {
+        dropout.train(mode);
+    }
+}
+
+MLP MLP::clone() const {
+    MLP copy = *this;
+    for (auto& layer : copy.layers) {
+        layer.w = std::make_shared<Value>(layer.w->data);
+        layer.w->set_self(layer.w);
+        layer.b = std::make_shared<Value>(layer.b->data);
+        layer.b->set_self(layer.b);
+    }
+    for (auto& norm : copy.norms) {
+        norm.gamma = std::make_shared<Value>(norm.gamma->data);
+        norm.gamma->set_self(norm.gamma);
+        norm.beta = std::make_shared<Value>(norm.beta->data);
+        norm.beta->set_self(norm.beta);
+    }
+    return copy;
+}
+
+void MLP::set_precision(const Precision precision) {
+    for (auto& layer : layers) {
+        layer.precision = precision;
+    }
+}
+
 } // namespace micrograd
@@ -1,13 +1,25 @@
 #include "optimizer.hpp"
+#include <algorithm>
+#include <cmath>
 
 namespace micrograd {
 
+void Optimizer::use_master_weights(const Precision storage) {
+    this->storage = storage;
+    master.resize(parameters.size());
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        master[i] = parameters[i]->data.cast<float>();
+        parameters[i]->data = master[i].cast<double>();
+        round_in_place(parameters[i]->data, storage);
+    }
+}
+
 SGD::SGD(const std::vector<Value*>& params, double learning_rate)
-    : parameters(params), lr(learning_rate) {}
+    : Optimizer(params, learning_rate) {}
 
 void SGD::step() {
-    for (auto* p : parameters) {
-        p->data -= lr * p->grad;
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        apply_update(i, -lr * parameters[i]->grad);
     }
 }
 
@@ -18,7 +30,7 @@ void SGD::zero_grad() {
 }
 
 NesterovSGD::NesterovSGD(const std::vector<Value*>& params, double learning_rate, double momentum)
-    : parameters(params), lr(learning_rate), mu(momentum) {
+    : Optimizer(params, learning_rate), mu(momentum) {
     v.resize(params.size());
     for (size_t i = 0; i < params.size(); ++i) {
         v[i] = Eigen::MatrixXd::Zero(params[i]->data.rows(), params[i]->data.cols());
@@ -27,9 +39,9 @@ NesterovSGD::NesterovSGD(const std::vector<Value*>& params, double learning_rate
 
 void NesterovSGD::step() {
     for (size_t i = 0; i < parameters.size(); ++i) {
-        Eigen::MatrixXd v_prev = v[i];
+        // -mu * v_prev + (1 + mu) * v_new, expanded so v is only updated in place
+        apply_update(i, mu * mu * v[i] - (1.0 + mu) * lr * parameters[i]->grad);
         v[i] = mu * v[i] - lr * parameters[i]->grad;
-        parameters[i]->data += -mu * v_prev + (1.0 + mu) * v[i];
     }
 }
 
@@ -39,4 +51,132 @@ void NesterovSGD::zero_grad() {
     }
 }
 
+namespace {
+
+// Ratio used to rescale a layer's step; falls back to 1 when either norm vanishes
+double trust_ratio(double numerator, double denominator) {
+    return numerator > 0.0 && denominator > 0.0 ? numerator / denominator : 1.0;
+}
+
+} // namespace
+
+LARS::LARS(const std::vector<Value*>& params, double learning_rate, double momentum,
+           double weight_decay, double eta)
+    : Optimizer(params, learning_rate), mu(momentum), weight_decay(weight_decay), eta(eta) {
+    v.resize(params.size());
+    for (size_t i = 0; i < params.size(); ++i) {
+        v[i] = Eigen::MatrixXd::Zero(params[i]->data.rows(), params[i]->data.cols());
+    }
+}
+
+void LARS::step() {
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        const Eigen::MatrixXd& w = parameters[i]->data;
+        const Eigen::MatrixXd& g = parameters[i]->grad;
+
+        // A parameter or gradient with no norm, such as a zero-initialized bias,
+        // steps at the plain rate rather than at eta times it
+        const double w_norm = w.norm();
+        const double g_norm = g.norm();
+        const double local_lr =
+            w_norm > 0.0 && g_norm > 0.0 ? eta * w_norm / (g_norm + weight_decay * w_norm) : 1.0;
+
+        v[i] = mu * v[i] + (lr * local_lr) * (g + weight_decay * w);
+        apply_update(i, -v[i]);
+    }
+}
+
+void LARS::zero_grad() {
+    for (auto* p : parameters) {
+        p->zero_grad();
+    }
+}
+
+LAMB::LAMB(const std::vector<Value*>& params, double learning_rate, double beta1,
+           double beta2, double eps, double weight_decay)
+    : Optimizer(params, learning_rate), beta1(beta1), beta2(beta2), eps(eps), weight_decay(weight_decay) {
+    m.resize(params.size());
+    v.resize(params.size());
+    for (size_t i = 0; i < params.size(); ++i) {
+        m[i] = Eigen::MatrixXd::Zero(params[i]->data.rows(), params[i]->data.cols());
+        v[i] = Eigen::MatrixXd::Zero(params[i]->data.rows(), params[i]->data.cols());
+    }
+}
+
+void LAMB::step() {
+    t++;
+    const double correction1 = 1.0 - std::pow(beta1, t);
+    const double correction2 = 1.0 - std::pow(beta2, t);
+
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        const Eigen::MatrixXd& w = parameters[i]->data;
+        const Eigen::MatrixXd& g = parameters[i]->grad;
+
+        m[i] = beta1 * m[i] + (1.0 - beta1) * g;
+        v[i] = beta2 * v[i] + (1.0 - beta2) * g.cwiseProduct(g);
+
+        Eigen::MatrixXd update = (m[i] / correction1).array() / ((v[i] / correction2).array().sqrt() + eps);
+        update += weight_decay * w;
+
+        apply_update(i, -(lr * trust_ratio(w.norm(), update.norm())) * update);
+    }
+}
+
+void LAMB::zero_grad() {
+    for (auto* p : parameters) {
+        p->zero_grad();
+    }
+}
+
+LRSchedule::LRSchedule(double base_lr, int warmup_steps, int total_steps, Decay decay, double min_lr)
+    : base_lr(base_lr), warmup_steps(warmup_steps), total_steps(total_steps), decay(decay), min_lr(min_lr) {}
+
+double LRSchedule::at(const int step) const {
+    if (step < warmup_steps) {
+        return base_lr * (step + 1) / warmup_steps;
+    }
+    if (decay == Decay::Constant) {
+        return base_lr;
+    }
+
+    const int decay_steps = std::max(1, total_steps - warmup_steps);
+    const double progress = std::min(1.0, static_cast<double>(step - warmup_steps) / decay_steps);
+
+    if (decay == Decay::Linear) {
+        return min_lr + (base_lr - min_lr) * (1.0 - progress);
+    }
+    return min_lr + (base_lr - min_lr) * 0.5 * (1.0 + std::cos(M_PI * progress));
+}
+
+DynamicLossScaler::DynamicLossScaler(double init_scale, double growth_factor,
+                                     double backoff_factor, int growth_interval)
+    : scale(init_scale), growth_factor(growth_factor),
+      backoff_factor(backoff_factor), growth_interval(growth_interval) {}
+
+bool DynamicLossScaler::unscale(const std::vector<Value*>& params) {
+    bool finite = true;
+    for (auto* p : params) {
+        if (!p->grad.allFinite()) {
+            finite = false;
+            break;
+        }
+    }
+
+    if (!finite) {
+        scale *= backoff_factor;
+        good_steps = 0;
+        return false;
+    }
+
+    for (auto* p : params) {
+        p->grad /= scale;
+    }
+
+    if (++good_steps >= growth_interval) {
+        scale *= growth_factor;
+        good_steps = 0;
+    }
+    return true;
+}
+
 } // namespace micrograd
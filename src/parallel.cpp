@@ -0,0 +1,241 @@
+#include "parallel.hpp"
+#include "memory_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace micrograd {
+
+namespace {
+
+// Chunk size of deterministic reductions; fixed so chunk boundaries never depend on the thread count
+const int DETERMINISTIC_CHUNK_ROWS = 256;
+// Below this many rows per thread a split costs more than it saves
+const int MIN_ROWS_PER_THREAD = 64;
+
+std::atomic<bool> deterministic{false};
+
+class ThreadPool {
+public:
+    ~ThreadPool() { resize(0); }
+
+    int size() const { return threads.size() + 1; }
+
+    void resize(const int workers) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto& t : threads) {
+            t.join();
+        }
+        threads.clear();
+        stopping = false;
+        // Workers start from the current generation so a job posted before they run is not missed
+        for (int i = 0; i < workers; ++i) {
+            threads.emplace_back(&ThreadPool::worker, this, generation);
+        }
+    }
+
+    void run(const int num_chunks, const std::function<void(int)>& fn) {
+        // Nested or concurrent calls run inline rather than waiting for the pool
+        std::unique_lock<std::mutex> busy(run_mutex, std::try_to_lock);
+        if (threads.empty() || num_chunks <= 1 || !busy.owns_lock()) {
+            for (int c = 0; c < num_chunks; ++c) {
+                fn(c);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &fn;
+            job_chunks = num_chunks;
+            next_chunk = 0;
+            running = threads.size();
+            generation++;
+        }
+        cv.notify_all();
+        work(fn, num_chunks);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done_cv.wait(lock, [this]() { return running == 0; });
+        job = nullptr;
+    }
+
+private:
+    void work(const std::function<void(int)>& fn, const int num_chunks) {
+        for (int c = next_chunk++; c < num_chunks; c = next_chunk++) {
+            fn(c);
+        }
+    }
+
+    void worker(uint64_t seen) {
+        while (true) {
+            const std::function<void(int)>* fn;
+            int num_chunks;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&]() { return stopping || generation != seen; });
+                if (stopping) {
+                    return;
+                }
+                seen = generation;
+                fn = job;
+                num_chunks = job_chunks;
+            }
+            work(*fn, num_chunks);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                running--;
+            }
+            done_cv.notify_one();
+        }
+    }
+
+    std::vector<std::thread> threads;
+    std::mutex run_mutex;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::condition_variable done_cv;
+    const std::function<void(int)>* job = nullptr;
+    int job_chunks = 0;
+    std::atomic<int> next_chunk{0};
+    int running = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+};
+
+ThreadPool& pool() {
+    static ThreadPool instance;
+    return instance;
+}
+
+// Sums partial(begin, end) over row chunks of [0, rows)
+template <typename Partial>
+Eigen::MatrixXd reduce_rows(const int rows, const Partial& partial) {
+    const RowChunks chunks = row_chunks(rows);
+    const int num_chunks = chunks.count;
+    const int chunk_rows = chunks.size;
+    if (num_chunks == 1) {
+        return partial(0, rows);
+    }
+
+    std::vector<Eigen::MatrixXd> parts(num_chunks);
+    parallel_for(num_chunks, [&](const int c) {
+        const int begin = c * chunk_rows;
+        parts[c] = partial(begin, std::min(rows, begin + chunk_rows));
+    });
+
+    // Fixed pairwise tree: ((0 + 1) + (2 + 3)) + ...
+    for (int stride = 1; stride < num_chunks; stride *= 2) {
+        for (int i = 0; i + stride < num_chunks; i += 2 * stride) {
+            parts[i] += parts[i + stride];
+        }
+    }
+    return std::move(parts[0]);
+}
+
+// target += scale * the sum over row chunks of [0, rows), where
+// partial(begin, end, out, scale) adds scale times one chunk's result to out
+template <typename Partial>
+void accumulate_rows(Eigen::MatrixXd& target, const int rows, const double scale, const Partial& partial) {
+    const RowChunks chunks = row_chunks(rows);
+    const int num_chunks = chunks.count;
+    const int chunk_rows = chunks.size;
+    if (num_chunks == 1) {
+        partial(0, rows, target, scale);
+        return;
+    }
+
+    std::vector<Eigen::MatrixXd, PoolAllocator<Eigen::MatrixXd>> parts(num_chunks);
+    parallel_for(num_chunks, [&](const int c) {
+        const int begin = c * chunk_rows;
+        parts[c] = pool_zeros(target.rows(), target.cols());
+        partial(begin, std::min(rows, begin + chunk_rows), parts[c], 1.0);
+    });
+
+    // Same fixed pairwise tree as reduce_rows
+    for (int stride = 1; stride < num_chunks; stride *= 2) {
+        for (int i = 0; i + stride < num_chunks; i += 2 * stride) {
+            parts[i] += parts[i + stride];
+        }
+    }
+    target += scale * parts[0];
+    for (auto& part : parts) {
+        pool_release(part);
+    }
+}
+
+} // namespace
+
+void set_num_threads(const int n) {
+    pool().resize(std::max(1, n) - 1);
+}
+
+int get_num_threads() {
+    return pool().size();
+}
+
+void set_deterministic(const bool enabled) {
+    deterministic = enabled;
+}
+
+bool is_deterministic() {
+    return deterministic;
+}
+
+void parallel_for(const int num_chunks, const std::function<void(int)>& fn) {
+    pool().run(num_chunks, fn);
+}
+
+RowChunks row_chunks(const int rows) {
+    RowChunks chunks;
+    if (is_deterministic()) {
+        chunks.size = DETERMINISTIC_CHUNK_ROWS;
+        chunks.count = std::max(1, (rows + chunks.size - 1) / chunks.size);
+    } else {
+        chunks.count = std::max(1, std::min(get_num_threads(), rows / MIN_ROWS_PER_THREAD));
+        chunks.size = std::max(1, (rows + chunks.count - 1) / chunks.count);
+    }
+    return chunks;
+}
+
+Eigen::MatrixXd sum_rows(const Eigen::MatrixXd& m) {
+    Eigen::MatrixXd result = Eigen::MatrixXd::Zero(1, m.cols());
+    add_sum_rows(result, m);
+    return result;
+}
+
+double sum_all(const Eigen::MatrixXd& m) {
+    return reduce_rows(m.rows(), [&m](const int begin, const int end) -> Eigen::MatrixXd {
+        return Eigen::MatrixXd::Constant(1, 1, m.middleRows(begin, end - begin).sum());
+    })(0, 0);
+}
+
+Eigen::MatrixXd matmul_tn(const Eigen::MatrixXd& a, const Eigen::MatrixXd& b) {
+    Eigen::MatrixXd result = Eigen::MatrixXd::Zero(a.cols(), b.cols());
+    add_matmul_tn(result, a, b);
+    return result;
+}
+
+void add_sum_rows(Eigen::MatrixXd& target, const Eigen::MatrixXd& m, const double scale) {
+    accumulate_rows(target, m.rows(), scale,
+                    [&m](const int begin, const int end, Eigen::MatrixXd& out, const double scale) {
+                        out += scale * m.middleRows(begin, end - begin).colwise().sum();
+                    });
+}
+
+void add_matmul_tn(Eigen::MatrixXd& target, const Eigen::MatrixXd& a, const Eigen::MatrixXd& b) {
+    accumulate_rows(target, a.rows(), 1.0,
+                    [&a, &b](const int begin, const int end, Eigen::MatrixXd& out, const double scale) {
+                        out.noalias() += scale * (a.middleRows(begin, end - begin).transpose() *
+                                                  b.middleRows(begin, end - begin));
+                    });
+}
+
+} // namespace micrograd
@@ -0,0 +1,103 @@
+#include "precision.hpp"
+#include <cmath>
+#include <cstring>
+
+namespace micrograd {
+
+uint16_t float_to_bf16(const float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    if ((bits & 0x7FFFFFFF) > 0x7F800000) {
+        // Keep NaNs quiet instead of letting rounding turn them into infinities
+        return static_cast<uint16_t>((bits >> 16) | 0x0040);
+    }
+
+    const uint32_t lsb = (bits >> 16) & 1;
+    bits += 0x7FFF + lsb;
+    return static_cast<uint16_t>(bits >> 16);
+}
+
+float bf16_to_float(const uint16_t bits) {
+    const uint32_t widened = static_cast<uint32_t>(bits) << 16;
+    float value;
+    std::memcpy(&value, &widened, sizeof(value));
+    return value;
+}
+
+uint16_t float_to_fp16(const float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const uint32_t abs = bits & 0x7FFFFFFF;
+
+    if (abs > 0x7F800000) {
+        return static_cast<uint16_t>(sign | 0x7E00);
+    }
+    // Anything at or above 65520 rounds to infinity
+    if (abs >= 0x477FF000) {
+        return static_cast<uint16_t>(sign | 0x7C00);
+    }
+    // Below the smallest normal half (2^-14): encode as a multiple of 2^-24
+    if (abs < 0x38800000) {
+        float magnitude;
+        std::memcpy(&magnitude, &abs, sizeof(magnitude));
+        return static_cast<uint16_t>(sign | static_cast<uint32_t>(std::nearbyint(magnitude * 16777216.0f)));
+    }
+
+    // Round the 13 dropped mantissa bits to nearest even, then rebias the exponent
+    const uint32_t rounded = abs + 0x0FFF + ((abs >> 13) & 1);
+    return static_cast<uint16_t>(sign | ((rounded - 0x38000000) >> 13));
+}
+
+float fp16_to_float(const uint16_t bits) {
+    const uint32_t sign = static_cast<uint32_t>(bits & 0x8000) << 16;
+    const uint32_t exponent = (bits >> 10) & 0x1F;
+    const uint32_t mantissa = bits & 0x03FF;
+
+    if (exponent == 0) {
+        const float magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign ? -magnitude : magnitude;
+    }
+
+    uint32_t widened;
+    if (exponent == 0x1F) {
+        widened = sign | 0x7F800000 | (mantissa << 13);
+    } else {
+        widened = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+
+    float value;
+    std::memcpy(&value, &widened, sizeof(value));
+    return value;
+}
+
+Eigen::MatrixXd round_to(const Eigen::MatrixXd& m, const Precision precision) {
+    Eigen::MatrixXd rounded = m;
+    round_in_place(rounded, precision);
+    return rounded;
+}
+
+void round_in_place(Eigen::MatrixXd& m, const Precision precision) {
+    switch (precision) {
+        case Precision::FP32:
+            m = m.cast<float>().cast<double>();
+            break;
+        case Precision::BF16:
+            m = m.unaryExpr([](double x) {
+                return static_cast<double>(bf16_to_float(float_to_bf16(static_cast<float>(x))));
+            });
+            break;
+        case Precision::FP16:
+            m = m.unaryExpr([](double x) {
+                return static_cast<double>(fp16_to_float(float_to_fp16(static_cast<float>(x))));
+            });
+            break;
+        case Precision::FP64:
+        default:
+            break;
+    }
+}
+
+} // namespace micrograd
@@ -0,0 +1,350 @@
+#include "prune.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+
+namespace micrograd {
+
+namespace {
+
+const char SPARSE_MAGIC[4] = {'M', 'G', 'S', 'P'};
+const int SPARSE_VERSION = 1;
+
+// Zeroes the pruned entries of every weight and returns the masks
+PruningMask make_mask(MLP& model, const std::vector<Eigen::MatrixXd>& masks) {
+    PruningMask result;
+    for (auto& layer : model.layers) {
+        result.weights.push_back(layer.w.get());
+    }
+    result.masks = masks;
+    result.apply();
+    return result;
+}
+
+// Keeps the listed columns (or rows) of a parameter and resets its gradient.
+// The old buffers go back to the pool and the new ones come from it.
+void keep_cols(Value& value, const std::vector<int>& keep) {
+    Eigen::MatrixXd kept = pool_eval(value.data(Eigen::all, keep));
+    pool_release(value.data);
+    pool_release(value.grad);
+    value.data = std::move(kept);
+    value.grad = pool_zeros(value.data.rows(), value.data.cols());
+}
+
+void keep_cols(Eigen::MatrixXd& m, const std::vector<int>& keep) {
+    Eigen::MatrixXd kept = m(Eigen::all, keep);
+    m = kept;
+}
+
+void keep_rows(Value& value, const std::vector<int>& keep) {
+    Eigen::MatrixXd kept = pool_eval(value.data(keep, Eigen::all));
+    pool_release(value.data);
+    pool_release(value.grad);
+    value.data = std::move(kept);
+    value.grad = pool_zeros(value.data.rows(), value.data.cols());
+}
+
+template <typename T>
+void write_pod(std::ostream& out, const T& v) {
+    out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+template <typename T>
+bool read_pod(std::istream& in, T& v) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&v), sizeof(T)));
+}
+
+} // namespace
+
+void PruningMask::apply() const {
+    for (size_t i = 0; i < weights.size(); ++i) {
+        weights[i]->data.array() *= masks[i].array();
+    }
+}
+
+double PruningMask::sparsity() const {
+    double total = 0.0;
+    double pruned = 0.0;
+    for (const auto& m : masks) {
+        total += m.size();
+        pruned += m.size() - m.sum();
+    }
+    return total > 0.0 ? pruned / total : 0.0;
+}
+
+PruningMask prune_magnitude(MLP& model, const double sparsity) {
+    std::vector<double> magnitudes;
+    for (const auto& layer : model.layers) {
+        const Eigen::MatrixXd& w = layer.w->data;
+        magnitudes.insert(magnitudes.end(), w.data(), w.data() + w.size());
+    }
+    for (double& m : magnitudes) {
+        m = std::abs(m);
+    }
+
+    const size_t k = static_cast<size_t>(std::clamp(sparsity, 0.0, 1.0) * magnitudes.size());
+    std::vector<Eigen::MatrixXd> masks;
+    for (const auto& layer : model.layers) {
+        masks.push_back(Eigen::MatrixXd::Ones(layer.w->data.rows(), layer.w->data.cols()));
+    }
+    if (k == 0) {
+        return make_mask(model, masks);
+    }
+
+    std::nth_element(magnitudes.begin(), magnitudes.begin() + (k - 1), magnitudes.end());
+    const double threshold = magnitudes[k - 1];
+    for (size_t i = 0; i < model.layers.size(); ++i) {
+        masks[i] = (model.layers[i].w->data.array().abs() > threshold).cast<double>();
+    }
+    return make_mask(model, masks);
+}
+
+PruningMask prune_n_m(MLP& model, const int n, const int m) {
+    std::vector<Eigen::MatrixXd> masks;
+    if (n < 0 || m <= 0 || n > m) {
+        std::cerr << "Error: N:M pruning needs 0 <= n <= m, got " << n << ":" << m << std::endl;
+        for (const auto& layer : model.layers) {
+            masks.push_back(Eigen::MatrixXd::Ones(layer.w->data.rows(), layer.w->data.cols()));
+        }
+        return make_mask(model, masks);
+    }
+
+    std::vector<int> order(m);
+    for (const auto& layer : model.layers) {
+        const Eigen::MatrixXd& w = layer.w->data;
+        Eigen::MatrixXd mask = Eigen::MatrixXd::Zero(w.rows(), w.cols());
+        for (Eigen::Index j = 0; j < w.cols(); ++j) {
+            for (Eigen::Index start = 0; start < w.rows(); start += m) {
+                const int size = static_cast<int>(std::min<Eigen::Index>(m, w.rows() - start));
+                std::iota(order.begin(), order.begin() + size, 0);
+                const int keep = std::min(n, size);
+                std::partial_sort(order.begin(), order.begin() + keep, order.begin() + size, [&](int a, int b) {
+                    return std::abs(w(start + a, j)) > std::abs(w(start + b, j));
+                });
+                for (int t = 0; t < keep; ++t) {
+                    mask(start + order[t], j) = 1.0;
+                }
+            }
+        }
+        masks.push_back(mask);
+    }
+    return make_mask(model, masks);
+}
+
+void prune_neurons(MLP& model, const double fraction) {
+    for (size_t i = 0; i + 1 < model.layers.size(); ++i) {
+        Layer& layer = model.layers[i];
+        Layer& next = model.layers[i + 1];
+        const int nout = static_cast<int>(layer.w->data.cols());
+        const int drop = std::min(nout - 1, static_cast<int>(std::round(std::clamp(fraction, 0.0, 1.0) * nout)));
+        if (drop <= 0) {
+            continue;
+        }
+
+        const Eigen::VectorXd norms = next.w->data.rowwise().norm();
+        std::vector<int> keep(nout);
+        std::iota(keep.begin(), keep.end(), 0);
+        std::nth_element(keep.begin(), keep.begin() + drop, keep.end(),
+                         [&](int a, int b) { return norms(a) < norms(b); });
+        keep.erase(keep.begin(), keep.begin() + drop);
+        std::sort(keep.begin(), keep.end());
+
+        keep_cols(*layer.w, keep);
+        keep_cols(*layer.b, keep);
+        keep_rows(*next.w, keep);
+        if (i < model.norms.size()) {
+            BatchNorm1d& norm = model.norms[i];
+            keep_cols(*norm.gamma, keep);
+            keep_cols(*norm.beta, keep);
+            keep_cols(norm.running_mean, keep);
+            keep_cols(norm.running_var, keep);
+        }
+    }
+}
+
+SparseMLP::SparseMLP(const MLP& model) {
+    for (size_t i = 0; i < model.layers.size(); ++i) {
+        const Layer& layer = model.layers[i];
+        SparseLayer sparse;
+        sparse.w = layer.w->data.sparseView();
+        sparse.w.makeCompressed();
+        sparse.b = layer.b->data.row(0);
+        sparse.nonlin = layer.nonlin;
+        sparse.activation = layer.activation;
+        if (i < model.norms.size()) {
+            const auto affine = model.norms[i].eval_affine();
+            sparse.has_norm = true;
+            sparse.norm_scale = affine.first.row(0);
+            sparse.norm_shift = affine.second.row(0);
+        }
+        layers.push_back(std::move(sparse));
+    }
+}
+
+Eigen::MatrixXd SparseMLP::predict(const Eigen::MatrixXd& x) const {
+    Eigen::MatrixXd out = x;
+    for (const auto& layer : layers) {
+        if (out.cols() != layer.w.rows()) {
+            std::cerr << "Error: SparseMLP expected " << layer.w.rows() << " input features, got " << out.cols() << std::endl;
+            return Eigen::MatrixXd();
+        }
+
+        // Each output column is a sum of scaled input columns, so columns are
+        // independent and the result does not depend on the thread count
+        Eigen::MatrixXd z(out.rows(), layer.w.cols());
+        parallel_for(static_cast<int>(layer.w.cols()), [&](const int j) {
+            z.col(j).setConstant(layer.b(j));
+            for (Eigen::SparseMatrix<double>::InnerIterator it(layer.w, j); it; ++it) {
+                z.col(j).noalias() += it.value() * out.col(it.row());
+            }
+        });
+
+        if (layer.nonlin) {
+            z = activate(layer.activation, z);
+        }
+        if (layer.has_norm) {
+            z = ((z.array().rowwise() * layer.norm_scale.array()).rowwise() + layer.norm_shift.array()).cwiseMax(0.0);
+        }
+        out = std::move(z);
+    }
+    return out;
+}
+
+long long SparseMLP::nonzeros() const {
+    long long total = 0;
+    for (const auto& layer : layers) {
+        total += layer.w.nonZeros();
+    }
+    return total;
+}
+
+// Layout: "MGSP", version, layer count, then per layer nin, nout, nnz,
+// activation, nonlin, has_norm, column starts (int32, nout + 1), row indices
+// (uint16 when nin fits, else int32), values, bias and the folded norm.
+bool SparseMLP::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file " << path << " for writing" << std::endl;
+        return false;
+    }
+
+    file.write(SPARSE_MAGIC, sizeof(SPARSE_MAGIC));
+    write_pod(file, SPARSE_VERSION);
+    write_pod(file, static_cast<int32_t>(layers.size()));
+    for (const auto& layer : layers) {
+        const int32_t nin = static_cast<int32_t>(layer.w.rows());
+        const int32_t nout = static_cast<int32_t>(layer.w.cols());
+        const int32_t nnz = static_cast<int32_t>(layer.w.nonZeros());
+        write_pod(file, nin);
+        write_pod(file, nout);
+        write_pod(file, nnz);
+        write_pod(file, static_cast<int32_t>(layer.activation));
+        write_pod(file, static_cast<uint8_t>(layer.nonlin));
+        write_pod(file, static_cast<uint8_t>(layer.has_norm));
+
+        for (int32_t j = 0; j <= nout; ++j) {
+            write_pod(file, static_cast<int32_t>(layer.w.outerIndexPtr()[j]));
+        }
+        const auto* rows = layer.w.innerIndexPtr();
+        for (int32_t k = 0; k < nnz; ++k) {
+            if (nin <= 65536) {
+                write_pod(file, static_cast<uint16_t>(rows[k]));
+            } else {
+                write_pod(file, static_cast<int32_t>(rows[k]));
+            }
+        }
+        file.write(reinterpret_cast<const char*>(layer.w.valuePtr()), nnz * sizeof(double));
+        file.write(reinterpret_cast<const char*>(layer.b.data()), nout * sizeof(double));
+        if (layer.has_norm) {
+            file.write(reinterpret_cast<const char*>(layer.norm_scale.data()), nout * sizeof(double));
+            file.write(reinterpret_cast<const char*>(layer.norm_shift.data()), nout * sizeof(double));
+        }
+    }
+
+    if (!file) {
+        std::cerr << "Error: Failed writing " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool SparseMLP::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file " << path << " for reading" << std::endl;
+        return false;
+    }
+
+    char magic[4];
+    int version = 0;
+    int32_t num_layers = 0;
+    if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + 4, SPARSE_MAGIC) ||
+        !read_pod(file, version) || version != SPARSE_VERSION || !read_pod(file, num_layers) || num_layers < 0) {
+        std::cerr << "Error: " << path << " is not a sparse model file" << std::endl;
+        return false;
+    }
+
+    std::vector<SparseLayer> loaded(num_layers);
+    for (auto& layer : loaded) {
+        int32_t nin = 0, nout = 0, nnz = 0, activation = 0;
+        uint8_t nonlin = 0, has_norm = 0;
+        if (!read_pod(file, nin) || !read_pod(file, nout) || !read_pod(file, nnz) || !read_pod(file, activation) ||
+            !read_pod(file, nonlin) || !read_pod(file, has_norm) || nin < 0 || nout < 0 || nnz < 0 ||
+            static_cast<long long>(nnz) > static_cast<long long>(nin) * nout) {
+            std::cerr << "Error: Corrupt layer header in " << path << std::endl;
+            return false;
+        }
+
+        std::vector<int32_t> outer(nout + 1);
+        std::vector<int32_t> inner(nnz);
+        std::vector<double> values(nnz);
+        file.read(reinterpret_cast<char*>(outer.data()), outer.size() * sizeof(int32_t));
+        for (int32_t k = 0; k < nnz && file; ++k) {
+            if (nin <= 65536) {
+                uint16_t row = 0;
+                read_pod(file, row);
+                inner[k] = row;
+            } else {
+                read_pod(file, inner[k]);
+            }
+        }
+        file.read(reinterpret_cast<char*>(values.data()), nnz * sizeof(double));
+        bool valid = outer.front() == 0 && outer.back() == nnz;
+        for (int32_t j = 0; j < nout && valid; ++j) {
+            valid = outer[j] <= outer[j + 1];
+        }
+        for (int32_t k = 0; k < nnz && valid; ++k) {
+            valid = inner[k] >= 0 && inner[k] < nin;
+        }
+        if (!file || !valid) {
+            std::cerr << "Error: Corrupt sparse weights in " << path << std::endl;
+            return false;
+        }
+
+        layer.w = Eigen::Map<const Eigen::SparseMatrix<double>>(nin, nout, nnz, outer.data(), inner.data(), values.data());
+        layer.activation = static_cast<Activation>(activation);
+        layer.nonlin = nonlin != 0;
+        layer.has_norm = has_norm != 0;
+        layer.b.resize(nout);
+        file.read(reinterpret_cast<char*>(layer.b.data()), nout * sizeof(double));
+        if (layer.has_norm) {
+            layer.norm_scale.resize(nout);
+            layer.norm_shift.resize(nout);
+            file.read(reinterpret_cast<char*>(layer.norm_scale.data()), nout * sizeof(double));
+            file.read(reinterpret_cast<char*>(layer.norm_shift.data()), nout * sizeof(double));
+        }
+        if (!file) {
+            std::cerr << "Error: Unexpected end of " << path << std::endl;
+            return false;
+        }
+    }
+
+    layers = std::move(loaded);
+    return true;
+}
+
+} // namespace micrograd
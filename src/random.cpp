@@ -0,0 +1,24 @@
+#include "random.hpp"
+#include <cstdlib>
+
+namespace micrograd {
+
+namespace {
+
+std::mt19937_64& generator_instance() {
+    static std::mt19937_64 gen(std::random_device{}());
+    return gen;
+}
+
+} // namespace
+
+void manual_seed(const uint64_t seed) {
+    generator_instance().seed(seed);
+    std::srand(static_cast<unsigned>(seed));
+}
+
+std::mt19937_64& global_generator() {
+    return generator_instance();
+}
+
+} // namespace micrograd
@@ -0,0 +1,342 @@
+#include "rnn.hpp"
+#include "autodiff.hpp"
+#include "parallel.hpp"
+#include "random.hpp"
+#include <cmath>
+#include <iostream>
+#include <random>
+
+namespace micrograd {
+
+namespace {
+
+std::shared_ptr<Value> make_parameter(const int rows, const int cols, const int hidden_size) {
+    // Uniform in [-1/sqrt(hidden), 1/sqrt(hidden)], the usual recurrent init
+    const double bound = 1.0 / std::sqrt(static_cast<double>(hidden_size));
+    std::uniform_real_distribution<double> d(-bound, bound);
+    auto& gen = global_generator();
+    Eigen::MatrixXd data(rows, cols);
+    for (int j = 0; j < cols; ++j) {
+        for (int i = 0; i < rows; ++i) {
+            data(i, j) = d(gen);
+        }
+    }
+    auto p = std::make_shared<Value>(data);
+    p->set_self(p);
+    return p;
+}
+
+bool check_sequence(const char* name, const Eigen::MatrixXd& x, const Eigen::MatrixXd& state, const int input_size,
+                    const int hidden_size) {
+    if (x.cols() != input_size) {
+        std::cerr << "Error: " << name << " expects " << input_size << " input features, got " << x.cols() << std::endl;
+        return false;
+    }
+    if (x.rows() == 0 || state.rows() == 0 || state.cols() != hidden_size || x.rows() % state.rows() != 0) {
+        std::cerr << "Error: " << name << " state of shape " << state.rows() << "x" << state.cols()
+                  << " does not fit a sequence batch with " << x.rows() << " rows and hidden size " << hidden_size
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// True when step t starts a new truncation window, so no gradient reaches h_{t-1}
+bool cuts_gradient(const int t, const int window) {
+    return window > 0 && t > 0 && t % window == 0;
+}
+
+// Hidden state before each step: the initial state, then every step but the last
+Eigen::MatrixXd previous_states(const Eigen::MatrixXd& initial, const Eigen::MatrixXd& hidden) {
+    const int batch = initial.rows();
+    Eigen::MatrixXd previous(hidden.rows(), hidden.cols());
+    previous.topRows(batch) = initial;
+    previous.bottomRows(hidden.rows() - batch) = hidden.topRows(hidden.rows() - batch);
+    return previous;
+}
+
+Eigen::ArrayXXd sigmoid(const Eigen::MatrixXd& x) {
+    return 1.0 / (1.0 + (-x.array()).exp());
+}
+
+// Constant that picks rows [begin, begin + count) of an n-row matrix by matmul,
+// for the unrolled reference graphs below
+Value row_selector(const int begin, const int count, const int n) {
+    Eigen::MatrixXd s = Eigen::MatrixXd::Zero(count, n);
+    s.middleCols(begin, count).setIdentity();
+    return Value(s);
+}
+
+// Same for columns: x.matmul(col_selector(...)) keeps columns [begin, begin + count)
+Value col_selector(const int begin, const int count, const int n) {
+    Eigen::MatrixXd s = Eigen::MatrixXd::Zero(n, count);
+    s.middleRows(begin, count).setIdentity();
+    return Value(s);
+}
+
+// The recurrence written with per-step Value ops. Too slow for training, but
+// every op in it supports create_graph, so the fused nodes differentiate this
+// graph when a second-order gradient is requested.
+template <typename Step>
+Value unrolled(const Value& projected, const Eigen::MatrixXd& initial, const int window, Step step) {
+    const int batch = initial.rows();
+    const int rows = projected.rows();
+    const int steps = rows / batch;
+    Value h(initial);
+    Value out(Eigen::MatrixXd::Zero(rows, initial.cols()));
+    for (int t = 0; t < steps; ++t) {
+        if (cuts_gradient(t, window)) {
+            h = Value(Eigen::MatrixXd(h.data));
+        }
+        h = step(row_selector(t * batch, batch, rows).matmul(projected), h);
+        out = out + row_selector(t * batch, batch, rows).transpose().matmul(h);
+    }
+    return out;
+}
+
+std::vector<Value> unrolled_grads(const Value& out, const std::vector<Value*>& inputs, const Value& g) {
+    return grad(out, inputs, &g, true);
+}
+
+Eigen::MatrixXd run_rnn(const Eigen::MatrixXd& x, const Eigen::MatrixXd& w_ih, const Eigen::MatrixXd& w_hh,
+                        const Eigen::MatrixXd& b, Eigen::MatrixXd& state) {
+    const int batch = state.rows();
+    const int steps = x.rows() / batch;
+    // Input projections of every step in one GEMM
+    Eigen::MatrixXd hidden = x * w_ih;
+    hidden.rowwise() += b.row(0);
+    for (int t = 0; t < steps; ++t) {
+        auto h = hidden.middleRows(t * batch, batch);
+        h.noalias() += (t == 0 ? state : hidden.middleRows((t - 1) * batch, batch).eval()) * w_hh;
+        h = h.array().tanh().matrix();
+    }
+    state = hidden.bottomRows(batch);
+    return hidden;
+}
+
+// Fills hidden plus the per-step gates [r | z | n] and h W_hn + b_hn needed by backward
+void run_gru(const Eigen::MatrixXd& x, const Eigen::MatrixXd& w_ih, const Eigen::MatrixXd& w_hh,
+             const Eigen::MatrixXd& b_ih, const Eigen::MatrixXd& b_hh, Eigen::MatrixXd& state, Eigen::MatrixXd& hidden,
+             Eigen::MatrixXd& gates, Eigen::MatrixXd& candidate_hh) {
+    const int batch = state.rows();
+    const int hs = state.cols();
+    const int steps = x.rows() / batch;
+    gates = x * w_ih;
+    gates.rowwise() += b_ih.row(0);
+    hidden.resize(x.rows(), hs);
+    candidate_hh.resize(x.rows(), hs);
+
+    Eigen::MatrixXd h = state;
+    Eigen::MatrixXd hh(batch, 3 * hs);
+    for (int t = 0; t < steps; ++t) {
+        auto g = gates.middleRows(t * batch, batch);
+        hh.noalias() = h * w_hh;
+        hh.rowwise() += b_hh.row(0);
+        g.leftCols(2 * hs) = sigmoid(g.leftCols(2 * hs) + hh.leftCols(2 * hs)).matrix();
+        g.rightCols(hs) = (g.rightCols(hs).array() + g.leftCols(hs).array() * hh.rightCols(hs).array()).tanh().matrix();
+        candidate_hh.middleRows(t * batch, batch) = hh.rightCols(hs);
+        const auto z = g.middleCols(hs, hs).array();
+        const auto n = g.rightCols(hs).array();
+        h = (n + z * (h.array() - n)).matrix();
+        hidden.middleRows(t * batch, batch) = h;
+    }
+    state = h;
+}
+
+} // namespace
+
+RNN::RNN(const int input_size, const int hidden_size)
+    : w_ih(make_parameter(input_size, hidden_size, hidden_size)),
+      w_hh(make_parameter(hidden_size, hidden_size, hidden_size)),
+      b(make_parameter(1, hidden_size, hidden_size)),
+      input_size(input_size),
+      hidden_size(hidden_size) {}
+
+Value RNN::forward(const Value& x, const int batch) const {
+    Eigen::MatrixXd state = Eigen::MatrixXd::Zero(batch, hidden_size);
+    return forward(x, state);
+}
+
+Value RNN::forward(const Value& x, Eigen::MatrixXd& state) const {
+    if (!check_sequence("RNN", x.data, state, input_size, hidden_size)) {
+        return Value(Eigen::MatrixXd(0, hidden_size));
+    }
+
+    const Eigen::MatrixXd initial = state;
+    auto x_ptr = x.get_self_ptr();
+    auto out_ptr = Value::make_node(run_rnn(x_ptr->data, w_ih->data, w_hh->data, b->data, state), "rnn",
+                                    {x_ptr, w_ih, w_hh, b});
+
+    Value* a = x_ptr.get();
+    Value* wi = w_ih.get();
+    Value* wh = w_hh.get();
+    Value* bias = b.get();
+    Value* out = out_ptr.get();
+    const int window = bptt_window;
+    out_ptr->_backward = [a, wi, wh, bias, out, initial, window]() {
+        const int batch = initial.rows();
+        const int steps = out->rows() / batch;
+        const Eigen::MatrixXd& hidden = out->data;
+
+        // Gradient at each step's pre-activation, walking the steps in reverse
+        Eigen::MatrixXd dpre(out->rows(), out->cols());
+        Eigen::MatrixXd carry = Eigen::MatrixXd::Zero(batch, out->cols());
+        for (int t = steps - 1; t >= 0; --t) {
+            auto dz = dpre.middleRows(t * batch, batch);
+            dz = ((out->grad.middleRows(t * batch, batch) + carry).array() *
+                  (1.0 - hidden.middleRows(t * batch, batch).array().square()))
+                     .matrix();
+            if (cuts_gradient(t, window)) {
+                carry.setZero();
+            } else {
+                carry.noalias() = dz * wh->data.transpose();
+            }
+        }
+
+        // The weight gradients sum over every step, so each is one GEMM
+        add_matmul_tn(wh->grad, previous_states(initial, hidden), dpre);
+        add_matmul_tn(wi->grad, a->data, dpre);
+        add_sum_rows(bias->grad, dpre);
+        a->grad.noalias() += dpre * wi->data.transpose();
+    };
+    out_ptr->_backward_graph = [a, wi, wh, bias, initial, window](const Value& g) {
+        const Value out = unrolled(a->matmul(*wi) + *bias, initial, window,
+                                   [wh](const Value& projected, const Value& h) {
+                                       return (projected + h.matmul(*wh)).tanh();
+                                   });
+        return unrolled_grads(out, {a, wi, wh, bias}, g);
+    };
+
+    return *out_ptr;
+}
+
+Eigen::MatrixXd RNN::predict(const Eigen::MatrixXd& x, const int batch) const {
+    Eigen::MatrixXd state = Eigen::MatrixXd::Zero(batch, hidden_size);
+    return predict(x, state);
+}
+
+Eigen::MatrixXd RNN::predict(const Eigen::MatrixXd& x, Eigen::MatrixXd& state) const {
+    if (!check_sequence("RNN", x, state, input_size, hidden_size)) {
+        return Eigen::MatrixXd(0, hidden_size);
+    }
+    return run_rnn(x, w_ih->data, w_hh->data, b->data, state);
+}
+
+std::vector<Value*> RNN::parameters() {
+    return {w_ih.get(), w_hh.get(), b.get()};
+}
+
+GRU::GRU(const int input_size, const int hidden_size)
+    : w_ih(make_parameter(input_size, 3 * hidden_size, hidden_size)),
+      w_hh(make_parameter(hidden_size, 3 * hidden_size, hidden_size)),
+      b_ih(make_parameter(1, 3 * hidden_size, hidden_size)),
+      b_hh(make_parameter(1, 3 * hidden_size, hidden_size)),
+      input_size(input_size),
+      hidden_size(hidden_size) {}
+
+Value GRU::forward(const Value& x, const int batch) const {
+    Eigen::MatrixXd state = Eigen::MatrixXd::Zero(batch, hidden_size);
+    return forward(x, state);
+}
+
+Value GRU::forward(const Value& x, Eigen::MatrixXd& state) const {
+    if (!check_sequence("GRU", x.data, state, input_size, hidden_size)) {
+        return Value(Eigen::MatrixXd(0, hidden_size));
+    }
+
+    const Eigen::MatrixXd initial = state;
+    // Forward runs on the node's data, which backward differentiates through
+    auto x_ptr = x.get_self_ptr();
+    Eigen::MatrixXd hidden, gates, candidate_hh;
+    run_gru(x_ptr->data, w_ih->data, w_hh->data, b_ih->data, b_hh->data, state, hidden, gates, candidate_hh);
+
+    auto out_ptr = Value::make_node(hidden, "gru", {x_ptr, w_ih, w_hh, b_ih, b_hh});
+
+    Value* a = x_ptr.get();
+    Value* wi = w_ih.get();
+    Value* wh = w_hh.get();
+    Value* bi = b_ih.get();
+    Value* bh = b_hh.get();
+    Value* out = out_ptr.get();
+    const int window = bptt_window;
+    out_ptr->_backward = [a, wi, wh, bi, bh, out, initial, gates, candidate_hh, window]() {
+        const int batch = initial.rows();
+        const int hs = initial.cols();
+        const int steps = out->rows() / batch;
+        const Eigen::MatrixXd& hidden = out->data;
+
+        // Gradients at the input-side and hidden-side pre-activations
+        Eigen::MatrixXd d_input(out->rows(), 3 * hs);
+        Eigen::MatrixXd d_hidden(out->rows(), 3 * hs);
+        Eigen::MatrixXd carry = Eigen::MatrixXd::Zero(batch, hs);
+        for (int t = steps - 1; t >= 0; --t) {
+            const Eigen::Index row = t * batch;
+            const Eigen::ArrayXXd dh = (out->grad.middleRows(row, batch) + carry).array();
+            const Eigen::ArrayXXd h_prev = t == 0 ? initial : hidden.middleRows(row - batch, batch);
+            const auto g = gates.middleRows(row, batch);
+            const Eigen::ArrayXXd r = g.leftCols(hs).array();
+            const Eigen::ArrayXXd z = g.middleCols(hs, hs).array();
+            const Eigen::ArrayXXd n = g.rightCols(hs).array();
+
+            const Eigen::ArrayXXd dn = dh * (1.0 - z) * (1.0 - n.square());
+            const Eigen::ArrayXXd dz = dh * (h_prev - n) * z * (1.0 - z);
+            const Eigen::ArrayXXd dr = dn * candidate_hh.middleRows(row, batch).array() * r * (1.0 - r);
+
+            auto di = d_input.middleRows(row, batch);
+            auto dhh = d_hidden.middleRows(row, batch);
+            di.leftCols(hs) = dr.matrix();
+            di.middleCols(hs, hs) = dz.matrix();
+            di.rightCols(hs) = dn.matrix();
+            dhh.leftCols(2 * hs) = di.leftCols(2 * hs);
+            dhh.rightCols(hs) = (dn * r).matrix();
+
+            if (cuts_gradient(t, window)) {
+                carry.setZero();
+            } else {
+                carry = (dh * z).matrix();
+                carry.noalias() += dhh * wh->data.transpose();
+            }
+        }
+
+        add_matmul_tn(wh->grad, previous_states(initial, hidden), d_hidden);
+        add_sum_rows(bh->grad, d_hidden);
+        add_matmul_tn(wi->grad, a->data, d_input);
+        add_sum_rows(bi->grad, d_input);
+        a->grad.noalias() += d_input * wi->data.transpose();
+    };
+    out_ptr->_backward_graph = [a, wi, wh, bi, bh, initial, window](const Value& g) {
+        const int hs = initial.cols();
+        const Value out = unrolled(a->matmul(*wi) + *bi, initial, window, [wh, bh, hs](const Value& projected, const Value& h) {
+            const Value hh = h.matmul(*wh) + *bh;
+            const Value r = (projected.matmul(col_selector(0, hs, 3 * hs)) + hh.matmul(col_selector(0, hs, 3 * hs))).sigmoid();
+            const Value z = (projected.matmul(col_selector(hs, hs, 3 * hs)) + hh.matmul(col_selector(hs, hs, 3 * hs))).sigmoid();
+            const Value n = (projected.matmul(col_selector(2 * hs, hs, 3 * hs)) +
+                             r * hh.matmul(col_selector(2 * hs, hs, 3 * hs)))
+                                .tanh();
+            return n + z * (h - n);
+        });
+        return unrolled_grads(out, {a, wi, wh, bi, bh}, g);
+    };
+
+    return *out_ptr;
+}
+
+Eigen::MatrixXd GRU::predict(const Eigen::MatrixXd& x, const int batch) const {
+    Eigen::MatrixXd state = Eigen::MatrixXd::Zero(batch, hidden_size);
+    return predict(x, state);
+}
+
+Eigen::MatrixXd GRU::predict(const Eigen::MatrixXd& x, Eigen::MatrixXd& state) const {
+    if (!check_sequence("GRU", x, state, input_size, hidden_size)) {
+        return Eigen::MatrixXd(0, hidden_size);
+    }
+    Eigen::MatrixXd hidden, gates, candidate_hh;
+    run_gru(x, w_ih->data, w_hh->data, b_ih->data, b_hh->data, state, hidden, gates, candidate_hh);
+    return hidden;
+}
+
+std::vector<Value*> GRU::parameters() {
+    return {w_ih.get(), w_hh.get(), b_ih.get(), b_hh.get()};
+}
+
+} // namespace micrograd
@@ -0,0 +1,129 @@
+#include "sequential.hpp"
+#include <iostream>
+#include <type_traits>
+
+namespace micrograd {
+
+namespace {
+
+// Input and output feature counts of a module; -1 for size-preserving modules
+std::pair<int, int> module_shape(const Sequential::Entry& entry) {
+    if (auto* layer = std::get_if<Layer>(&entry)) {
+        return {static_cast<int>(layer->w->data.rows()), static_cast<int>(layer->w->data.cols())};
+    }
+    if (auto* norm = std::get_if<BatchNorm1d>(&entry)) {
+        return {static_cast<int>(norm->gamma->data.cols()), static_cast<int>(norm->gamma->data.cols())};
+    }
+    return {-1, -1};
+}
+
+void copy_parameter(std::shared_ptr<Value>& p) {
+    p = std::make_shared<Value>(p->data);
+    p->set_self(p);
+}
+
+} // namespace
+
+Sequential::Sequential(const int in_features) : inputs(in_features), features(in_features) {}
+
+Sequential& Sequential::linear(const int out_features, const Activation activation) {
+    add(Layer(features, out_features, activation));
+    return *this;
+}
+
+Sequential& Sequential::batch_norm(const double momentum, const double eps) {
+    add(BatchNorm1d(features, momentum, eps));
+    return *this;
+}
+
+Sequential& Sequential::dropout(const double p) {
+    add(Dropout(p));
+    return *this;
+}
+
+Sequential& Sequential::activation(const Activation activation, const double negative_slope) {
+    add(ActivationLayer(activation, negative_slope));
+    return *this;
+}
+
+bool Sequential::add(Entry module) {
+    const auto shape = module_shape(module);
+    if (shape.first >= 0 && shape.first != features) {
+        std::cerr << "Error: Module expects " << shape.first << " input features, but the previous module produces "
+                  << features << std::endl;
+        return false;
+    }
+    if (shape.second >= 0) {
+        features = shape.second;
+    }
+    std::visit([this](auto& m) { m.train(training); }, module);
+    modules.push_back(std::move(module));
+    return true;
+}
+
+Value Sequential::forward(const Value& x) {
+    if (modules.empty()) {
+        return *x.get_self_ptr();
+    }
+
+    // The first module takes x itself (not a copy) so x becomes the graph input
+    Value out = std::visit([&x](auto& m) { return m.forward(x); }, modules.front());
+    for (size_t i = 1; i < modules.size(); ++i) {
+        out = std::visit([&out](auto& m) { return m.forward(out); }, modules[i]);
+    }
+    return out;
+}
+
+Eigen::MatrixXd Sequential::predict(const Eigen::MatrixXd& x) const {
+    Eigen::MatrixXd out = x;
+    for (auto& module : modules) {
+        out = std::visit([&out](const auto& m) { return m.predict(out); }, module);
+    }
+    return out;
+}
+
+std::vector<Value*> Sequential::parameters() {
+    std::vector<Value*> params;
+    for (auto& module : modules) {
+        auto module_params = std::visit([](auto& m) { return m.parameters(); }, module);
+        params.insert(params.end(), module_params.begin(), module_params.end());
+    }
+    return params;
+}
+
+std::vector<Eigen::MatrixXd*> Sequential::buffers() {
+    std::vector<Eigen::MatrixXd*> result;
+    for (auto& module : modules) {
+        auto module_buffers = std::visit([](auto& m) { return m.buffers(); }, module);
+        result.insert(result.end(), module_buffers.begin(), module_buffers.end());
+    }
+    return result;
+}
+
+void Sequential::train(const bool mode) {
+    training = mode;
+    for (auto& module : modules) {
+        std::visit([mode](auto& m) { m.train(mode); }, module);
+    }
+}
+
+Sequential Sequential::clone() const {
+    Sequential copy = *this;
+    for (auto& module : copy.modules) {
+        std::visit(
+            [](auto& m) {
+                using T = std::decay_t<decltype(m)>;
+                if constexpr (std::is_same_v<T, Layer>) {
+                    copy_parameter(m.w);
+                    copy_parameter(m.b);
+                } else if constexpr (std::is_same_v<T, BatchNorm1d>) {
+                    copy_parameter(m.gamma);
+                    copy_parameter(m.beta);
+                }
+            },
+            module);
+    }
+    return copy;
+}
+
+} // namespace micrograd
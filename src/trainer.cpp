@@ -0,0 +1,300 @@
+#include "trainer.hpp"
+#include "metrics.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+namespace micrograd {
+
+namespace {
+
+double seconds_since(const std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int count_correct(const Eigen::MatrixXd& logits, const Eigen::VectorXi& labels) {
+    int correct = 0;
+    for (int i = 0; i < logits.rows(); ++i) {
+        int pred_label;
+        logits.row(i).maxCoeff(&pred_label);
+        if (pred_label == labels(i)) {
+            correct++;
+        }
+    }
+    return correct;
+}
+
+BatchPrefetcher::BatchPrefetcher() { worker = std::thread(&BatchPrefetcher::run, this); }
+
+BatchPrefetcher::~BatchPrefetcher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    worker.join();
+}
+
+void BatchPrefetcher::start(const int num_batches, Load load) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->load = std::move(load);
+        this->num_batches = num_batches;
+        next_batch = 0;
+        full = false;
+        error = nullptr;
+    }
+    cv.notify_all();
+}
+
+void BatchPrefetcher::next(Eigen::MatrixXd& images, Eigen::VectorXi& labels) {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this]() { return full; });
+    full = false;
+    if (error) {
+        std::rethrow_exception(std::exchange(error, nullptr));
+    }
+    // Swapping hands the caller's previous buffers back for reuse
+    images.swap(this->images);
+    labels.swap(this->labels);
+    lock.unlock();
+    cv.notify_all();
+}
+
+void BatchPrefetcher::stop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    num_batches = 0;
+    cv.wait(lock, [this]() { return !busy; });
+    full = false;
+    error = nullptr;
+    load = nullptr;
+}
+
+void BatchPrefetcher::run() {
+    Eigen::MatrixXd loaded_images;
+    Eigen::VectorXi loaded_labels;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cv.wait(lock, [this]() { return stopping || (!full && next_batch < num_batches); });
+        if (stopping) {
+            return;
+        }
+        const int batch_idx = next_batch++;
+        busy = true;
+
+        lock.unlock();
+        std::exception_ptr failure;
+        try {
+            load(batch_idx, loaded_images, loaded_labels);
+        } catch (...) {
+            failure = std::current_exception();
+        }
+        lock.lock();
+
+        busy = false;
+        if (failure) {
+            // The consumer sees the error in place of this batch; nothing after it is loaded
+            error = failure;
+            num_batches = 0;
+        } else {
+            images.swap(loaded_images);
+            labels.swap(loaded_labels);
+        }
+        full = true;
+        cv.notify_all();
+    }
+}
+
+Trainer::Trainer(MLP& model, Optimizer& optimizer, const int batch_size)
+    : batch_size(batch_size), model(model), optimizer(optimizer), snapshot_model(model.clone()) {}
+
+Trainer::~Trainer() {
+    if (pending_eval.valid()) {
+        pending_eval.wait();
+    }
+}
+
+EpochStats Trainer::train_epoch(const MNISTLoader& loader) {
+    return run_epoch(loader.get_num_batches(batch_size), batch_size, loader.num_images,
+                     [&](const int batch_idx, Eigen::MatrixXd& images, Eigen::VectorXi& labels) {
+                         loader.get_batch(batch_idx, batch_size, images, labels);
+                     });
+}
+
+EpochStats Trainer::train_epoch(DataLoader& loader) {
+    loader.reset();
+    return run_epoch(loader.num_batches(), loader.batch_size(), loader.dataset().size(),
+                     [&](const int batch_idx, Eigen::MatrixXd& images, Eigen::VectorXi& labels) {
+                         if (!loader.next(images, labels)) {
+                             throw std::runtime_error("Trainer: failed to load batch " + std::to_string(batch_idx));
+                         }
+                     });
+}
+
+EpochStats Trainer::run_epoch(const int num_batches, const int batch_size, const long long num_samples,
+                              const std::function<void(int, Eigen::MatrixXd&, Eigen::VectorXi&)>& get_batch) {
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    const int group_size = std::max(1, accumulation_steps);
+
+    EpochStats stats = {};
+    stats.epoch = epoch;
+    model.train();
+
+    double total_loss = 0.0;
+    int correct = 0;
+
+    auto last = clock::now();
+    auto lap = [&last]() {
+        const auto now = clock::now();
+        const double elapsed = std::chrono::duration<double>(now - last).count();
+        last = now;
+        return elapsed;
+    };
+
+    // Batch i + 1 is loaded and augmented in the background while batch i trains
+    prefetcher.start(num_batches, [&](const int batch_idx, Eigen::MatrixXd& images, Eigen::VectorXi& labels) {
+        get_batch(batch_idx, images, labels);
+        if (augmentation) {
+            augmentation->apply(images);
+        }
+    });
+    // Stops the prefetcher on every exit, including a throw, so it never outlives get_batch
+    struct StopPrefetch {
+        BatchPrefetcher& prefetcher;
+        ~StopPrefetch() { prefetcher.stop(); }
+    } stop_prefetch{prefetcher};
+    Eigen::MatrixXd batch_images;
+    Eigen::VectorXi batch_labels;
+
+    for (int group_start = 0; group_start < num_batches; group_start += group_size) {
+        const int group_end = std::min(group_start + group_size, num_batches);
+        const int group_samples =
+            std::min<long long>(static_cast<long long>(group_end) * batch_size, num_samples) - group_start * batch_size;
+
+        if (schedule) {
+            optimizer.lr = schedule->at(step);
+        }
+        optimizer.zero_grad();
+        stats.optimizer_seconds += lap();
+
+        for (int batch_idx = group_start; batch_idx < group_end; ++batch_idx) {
+            prefetcher.next(batch_images, batch_labels);
+            stats.data_seconds += lap();
+
+            Value inputs(batch_images);
+            Value logits = model.forward(inputs);
+            Value loss = criterion.forward(logits, batch_labels);
+            stats.forward_seconds += lap();
+
+            // Weight each micro-batch by its share of the samples in this step
+            const int n = batch_labels.size();
+            if (distributed) {
+                // Only the last micro-batch's backward starts the all-reduce
+                distributed->require_sync = batch_idx + 1 == group_end;
+            }
+            if (n == group_samples) {
+                loss.backward();
+            } else {
+                Value weighted = loss * (static_cast<double>(n) / group_samples);
+                weighted.backward();
+            }
+            stats.backward_seconds += lap();
+
+            total_loss += loss.data(0, 0) * n;
+            correct += count_correct(logits.data, batch_labels);
+            stats.samples += n;
+
+            if (log_interval > 0 && (batch_idx + 1) % log_interval == 0) {
+                std::cout << "Epoch " << epoch + 1 << " [" << batch_idx + 1 << "/" << num_batches << "]"
+                          << " Loss: " << std::fixed << std::setprecision(4) << loss.data(0, 0) << std::endl;
+            }
+            lap();
+        }
+
+        if (distributed) {
+            // Stepping on gradients that were not averaged would let the ranks diverge
+            if (!distributed->synchronize()) {
+                throw std::runtime_error("Trainer: gradient synchronization failed at step " + std::to_string(step));
+            }
+            stats.communication_seconds += lap();
+        }
+        optimizer.step();
+        stats.optimizer_seconds += lap();
+        stats.steps++;
+        step++;
+    }
+
+    epoch++;
+    stats.loss = stats.samples > 0 ? total_loss / stats.samples : 0.0;
+    stats.accuracy = stats.samples > 0 ? static_cast<double>(correct) / stats.samples : 0.0;
+    stats.seconds = seconds_since(start);
+    stats.samples_per_sec = stats.seconds > 0.0 ? stats.samples / stats.seconds : 0.0;
+    return stats;
+}
+
+void Trainer::start_evaluation(const MNISTLoader& loader) {
+    if (pending_eval.valid()) {
+        pending_eval.wait();
+    }
+
+    auto dst = snapshot_model.state();
+    auto src = model.state();
+    for (size_t i = 0; i < dst.size(); ++i) {
+        *dst[i] = *src[i];
+    }
+
+    const int snapshot_epoch = epoch - 1;
+    const int eval_batch_size = batch_size;
+    const MLP* snapshot_ptr = &snapshot_model;
+    const MNISTLoader* loader_ptr = &loader;
+    pending_eval = std::async(std::launch::async, [=]() {
+        EvalStats stats = evaluate(*snapshot_ptr, *loader_ptr, eval_batch_size);
+        stats.epoch = snapshot_epoch;
+        return stats;
+    });
+}
+
+bool Trainer::evaluation_pending() const {
+    return pending_eval.valid();
+}
+
+EvalStats Trainer::wait_evaluation() {
+    if (!pending_eval.valid()) {
+        return {-1, 0, 0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    }
+    return pending_eval.get();
+}
+
+EvalStats Trainer::evaluate(const MLP& model, const MNISTLoader& loader, const int batch_size) {
+    const auto start = std::chrono::steady_clock::now();
+    const int num_batches = loader.get_num_batches(batch_size);
+
+    Metrics metrics(model.layers.back().w->data.cols());
+    for (int batch_idx = 0; batch_idx < num_batches; ++batch_idx) {
+        Eigen::MatrixXd batch_images;
+        Eigen::VectorXi batch_labels;
+        loader.get_batch(batch_idx, batch_size, batch_images, batch_labels);
+
+        // Evaluation needs no graph; predict also runs BatchNorm and Dropout in eval mode
+        metrics.update(model.predict(batch_images), batch_labels);
+    }
+
+    EvalStats stats;
+    stats.epoch = -1;
+    stats.total = metrics.count();
+    stats.correct = metrics.confusion_matrix().trace();
+    stats.accuracy = metrics.accuracy();
+    stats.top5_accuracy = metrics.top_k_accuracy(5);
+    stats.log_loss = metrics.log_loss();
+    stats.calibration_error = metrics.calibration_error();
+    stats.seconds = seconds_since(start);
+    return stats;
+}
+
+} // namespace micrograd
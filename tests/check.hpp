@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Shared by the test executables: each "(expected: ...)" line is followed by a
+// check, and main() returns finish() so that ctest sees any failure.
+
+namespace {
+
+int check_failures = 0;
+
+// Counts a failed check and reports it after the printed value
+inline bool check(const bool ok, const std::string& what) {
+    if (!ok) {
+        ++check_failures;
+        std::cout << "  ❌ FAILED: " << what << std::endl;
+    }
+    return ok;
+}
+
+inline bool check_near(const double actual, const double expected, const double tolerance, const std::string& what) {
+    std::ostringstream message;
+    message << what << " (got " << actual << ", expected " << expected << " +/- " << tolerance << ")";
+    return check(std::abs(actual - expected) <= tolerance, message.str());
+}
+
+// Prints the summary line and gives main()'s exit code
+inline int finish() {
+    if (check_failures > 0) {
+        std::cout << "\n❌ " << check_failures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "\n✅ All tests completed successfully!" << std::endl;
+    return 0;
+}
+
+} // namespace
@@ -0,0 +1,106 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include "augment.hpp"
+#include "parallel.hpp"
+#include "random.hpp"
+#include "trainer.hpp"
+#include "check.hpp"
+
+using namespace micrograd;
+
+int main() {
+    std::cout << "Testing data augmentation..." << std::endl;
+
+    // A filled square in the middle of each 28x28 image
+    const int n = 256;
+    Eigen::MatrixXd images = Eigen::MatrixXd::Zero(n, 784);
+    for (int i = 0; i < n; ++i) {
+        for (int y = 10; y < 18; ++y) {
+            for (int x = 10; x < 18; ++x) {
+                images(i, y * 28 + x) = 1.0;
+            }
+        }
+    }
+
+    // Test 1: Disabled transforms leave images untouched
+    std::cout << "\n=== Test 1: Identity ===" << std::endl;
+    Augmenter::Options identity;
+    identity.max_rotation = 0.0;
+    identity.max_scale = 0.0;
+    identity.max_shift = 0.0;
+    Augmenter none(identity);
+    Eigen::MatrixXd copy = images;
+    none.apply(copy);
+    std::cout << "Unchanged: " << (copy == images ? "yes" : "no") << " (expected: yes)" << std::endl;
+    check(copy == images, "disabled transforms are the identity");
+
+    // Test 2: Random warps move pixels but roughly preserve ink
+    std::cout << "\n=== Test 2: Affine and elastic warps ===" << std::endl;
+    manual_seed(11);
+    Augmenter::Options options;
+    options.elastic_alpha = 8.0;
+    Augmenter augmenter(options);
+    Eigen::MatrixXd warped = images;
+    augmenter.apply(warped);
+    const double mass_ratio = warped.sum() / images.sum();
+    std::cout << "Rows changed: " << ((warped - images).rowwise().norm().array() > 0).count() << " (expected: " << n
+              << ")" << std::endl;
+    std::cout << "Rows differ from each other: " << (warped.row(0) != warped.row(1) ? "yes" : "no")
+              << " (expected: yes)" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Ink ratio: " << mass_ratio << " (expected: ~1)" << std::endl;
+    std::cout << "Counter: " << augmenter.counter << " (expected: " << n << ")" << std::endl;
+    check(((warped - images).rowwise().norm().array() > 0).count() == n, "every row changed");
+    check(warped.row(0) != warped.row(1), "rows get different warps");
+    check_near(mass_ratio, 1.0, 0.15, "ink ratio");
+    check(augmenter.counter == n, "counter");
+
+    // Test 3: Same seed and counter give identical output for any thread count
+    std::cout << "\n=== Test 3: Thread-count independence ===" << std::endl;
+    augmenter.counter = 0;
+    set_num_threads(4);
+    Eigen::MatrixXd parallel = images;
+    const auto start = std::chrono::steady_clock::now();
+    augmenter.apply(parallel);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    set_num_threads(1);
+    std::cout << "Bit-identical: " << (parallel == warped ? "yes" : "no") << " (expected: yes)" << std::endl;
+    check(parallel == warped, "thread-count independence");
+    std::cout << "Time for " << n << " images: " << std::setprecision(1) << ms << "ms" << std::endl;
+
+    // Test 4: Noise stays in the pixel range
+    std::cout << "\n=== Test 4: Noise ===" << std::endl;
+    Augmenter::Options noisy = identity;
+    noisy.noise_std = 0.1;
+    Augmenter noise(noisy);
+    Eigen::MatrixXd noised = images;
+    noise.apply(noised);
+    std::cout << std::setprecision(2);
+    std::cout << "Pixel range: [" << noised.minCoeff() << ", " << noised.maxCoeff() << "] (expected: [0.00, 1.00])"
+              << std::endl;
+    std::cout << "Pixels changed: " << ((noised - images).array().abs() > 0).count() * 100 / noised.size()
+              << "% (expected: ~50%, noise below black clamps to 0)" << std::endl;
+    const double changed = double(((noised - images).array().abs() > 0).count()) / noised.size();
+    check(noised.minCoeff() >= 0.0 && noised.maxCoeff() <= 1.0, "noise stays in [0, 1]");
+    check_near(changed, 0.5, 0.1, "fraction of pixels changed by noise");
+
+    // Test 5: Trainer hook
+    std::cout << "\n=== Test 5: Trainer augmentation ===" << std::endl;
+    Eigen::VectorXi labels = Eigen::VectorXi::Zero(n);
+    TensorDataset dataset(images, labels);
+    DataLoader::Options loader_options;
+    loader_options.batch_size = 64;
+    DataLoader loader(dataset, loader_options);
+    MLP model(784, {16, 2});
+    NesterovSGD optimizer(model.parameters(), 0.01, 0.9);
+    Trainer trainer(model, optimizer, 64);
+    trainer.log_interval = 0;
+    trainer.augmentation.emplace(options);
+    EpochStats stats = trainer.train_epoch(loader);
+    std::cout << "Samples: " << stats.samples << ", augmented: " << trainer.augmentation->counter
+              << " (expected: " << n << ", " << n << ")" << std::endl;
+    check(stats.samples == n && trainer.augmentation->counter == n, "trainer augments every sample");
+
+    return finish();
+}
@@ -0,0 +1,117 @@
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+#include "engine.hpp"
+#include "autodiff.hpp"
+#include "expr.hpp"
+#include "nn.hpp"
+#include "loss.hpp"
+#include "check.hpp"
+
+using namespace micrograd;
+
+int main() {
+    std::cout << "Testing higher-order gradients..." << std::endl;
+
+    // Test 1: Second derivative of x^3
+    std::cout << "\n=== Test 1: Second derivative ===" << std::endl;
+    Value x(2.0);
+    Value y = x.pow(3.0);
+    Value dy = grad(y, {&x}, nullptr, true)[0];
+    Value d2y = grad(dy, {&x})[0];
+    std::cout << "dy/dx = " << dy.data(0, 0) << " (expected: 12)" << std::endl;
+    std::cout << "d2y/dx2 = " << d2y.data(0, 0) << " (expected: 12)" << std::endl;
+    check_near(dy.data(0, 0), 12.0, 1e-12, "dy/dx of x^3 at 2");
+    check_near(d2y.data(0, 0), 12.0, 1e-12, "d2y/dx2 of x^3 at 2");
+
+    // Test 2: Fused expressions are twice differentiable too
+    std::cout << "\n=== Test 2: Fused expression ===" << std::endl;
+    Value a(3.0);
+    Value b(0.5);
+    Value c = fuse(lazy(a) * lazy(a) * lazy(b) + sigmoid(lazy(b)));
+    Value dc = grad(c, {&a}, nullptr, true)[0];
+    std::vector<Value> d2c = grad(dc, {&a, &b});
+    std::cout << "dc/da = " << dc.data(0, 0) << " (expected: 3)" << std::endl;
+    std::cout << "d2c/da2 = " << d2c[0].data(0, 0) << ", d2c/dadb = " << d2c[1].data(0, 0)
+              << " (expected: 1, 6)" << std::endl;
+    check_near(dc.data(0, 0), 3.0, 1e-12, "dc/da = 2ab");
+    check_near(d2c[0].data(0, 0), 1.0, 1e-12, "d2c/da2 = 2b");
+    check_near(d2c[1].data(0, 0), 6.0, 1e-12, "d2c/dadb = 2a");
+
+    // Test 3: Hessian-vector product against finite differences of gradients
+    std::cout << "\n=== Test 3: Hessian-vector product ===" << std::endl;
+    MLP model(5, {8, 3});
+    for (auto& layer : model.layers) {
+        layer.nonlin = false;
+    }
+    CrossEntropyLoss criterion;
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(6, 5);
+    Eigen::VectorXi labels(6);
+    labels << 0, 1, 2, 0, 1, 2;
+
+    auto params = model.parameters();
+    auto loss_fn = [&]() { return criterion.forward(model.forward(Value(X)), labels); };
+
+    std::vector<Eigen::MatrixXd> vs;
+    for (auto* p : params) {
+        vs.push_back(Eigen::MatrixXd::Random(p->rows(), p->cols()));
+    }
+    std::vector<Eigen::MatrixXd> hv = hvp(loss_fn, params, vs);
+
+    const double h = 1e-5;
+    auto shifted_grads = [&](double scale) {
+        for (size_t i = 0; i < params.size(); ++i) {
+            params[i]->data += scale * vs[i];
+        }
+        Value loss = loss_fn();
+        auto g = grad(loss, params);
+        for (size_t i = 0; i < params.size(); ++i) {
+            params[i]->data -= scale * vs[i];
+        }
+        return g;
+    };
+    auto g_plus = shifted_grads(h);
+    auto g_minus = shifted_grads(-h);
+
+    double max_error = 0.0;
+    for (size_t i = 0; i < params.size(); ++i) {
+        Eigen::MatrixXd fd = (g_plus[i].data - g_minus[i].data) / (2 * h);
+        max_error = std::max(max_error, (fd - hv[i]).cwiseAbs().maxCoeff());
+    }
+    std::cout << "Max |Hv - finite difference|: " << std::scientific << std::setprecision(2) << max_error
+              << " (expected: < 1e-6)" << std::endl;
+    check(max_error < 1e-6, "Hessian-vector product matches finite differences");
+
+    // Test 4: <v, J t> equals <J^T v, t>
+    std::cout << "\n=== Test 4: jvp / vjp consistency ===" << std::endl;
+    Value input(X);
+    auto forward_fn = [&]() { return model.forward(input).sigmoid(); };
+    Eigen::MatrixXd t = Eigen::MatrixXd::Random(6, 5);
+    Eigen::MatrixXd v = Eigen::MatrixXd::Random(6, 3);
+    Eigen::MatrixXd jt = jvp(forward_fn, {&input}, {t});
+    Eigen::MatrixXd vj = vjp(forward_fn, {&input}, v)[0];
+    const double adjoint_error = v.cwiseProduct(jt).sum() - vj.cwiseProduct(t).sum();
+    std::cout << "<v, Jt> - <J^T v, t>: " << adjoint_error << " (expected: ~0)" << std::endl;
+    check(std::abs(adjoint_error) < 1e-10, "jvp and vjp are adjoint");
+
+    // Test 5: An op without a Value-op backward cannot be skipped silently
+    std::cout << "\n=== Test 5: Op without create_graph support ===" << std::endl;
+    Value z(2.0);
+    auto doubled = Value::make_node(z.data * 2.0, "custom", {z.get_self_ptr()});
+    Value* doubled_ptr = doubled.get();
+    doubled->_backward = [doubled_ptr]() { doubled_ptr->_prev[0]->grad += 2.0 * doubled_ptr->grad; };
+    Value w = *doubled * z;
+    bool threw = false;
+    try {
+        grad(w, {&z}, nullptr, true);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    const double plain = grad(w, {&z})[0].data(0, 0);
+    std::cout << "create_graph threw: " << (threw ? "yes" : "no") << " (expected: yes)" << std::endl;
+    std::cout << "dw/dz without create_graph: " << plain << " (expected: 8)" << std::endl;
+    check(threw, "missing _backward_graph throws");
+    check_near(plain, 8.0, 1e-12, "matrix backward still works");
+
+    return finish();
+}
@@ -2,6 +2,7 @@
 #include <iomanip>
 #include "engine.hpp"
 #include "nn.hpp"
+#include "check.hpp"
 
 using namespace micrograd;
 
@@ -19,6 +20,9 @@ int main() {
     std::cout << "c = a * b + a^2 = " << c.data(0, 0) << std::endl;
     std::cout << "dc/da = " << a.grad(0, 0) << " (expected: 7.0)" << std::endl;
     std::cout << "dc/db = " << b.grad(0, 0) << " (expected: 2.0)" << std::endl;
+    check_near(c.data(0, 0), 10.0, 1e-12, "c");
+    check_near(a.grad(0, 0), 7.0, 1e-12, "dc/da");
+    check_near(b.grad(0, 0), 2.0, 1e-12, "dc/db");
 
     // Test 2: Matrix operations
     std::cout << "\n=== Test 2: Matrix multiplication ===" << std::endl;
@@ -38,6 +42,10 @@ int main() {
     std::cout << "W shape: " << w.rows() << "x" << w.cols() << std::endl;
     std::cout << "Y shape: " << y.rows() << "x" << y.cols() << std::endl;
     std::cout << "Y =\n" << y.data << std::endl;
+    Eigen::MatrixXd y_expected(2, 2);
+    y_expected << 22, 28,
+                  49, 64;
+    check(y.data == y_expected, "Y = X W");
 
     // Test 3: ReLU
     std::cout << "\n=== Test 3: ReLU activation ===" << std::endl;
@@ -48,6 +56,7 @@ int main() {
 
     std::cout << "Input: " << relu_input.data << std::endl;
     std::cout << "ReLU output: " << relu_output.data << std::endl;
+    check(relu_output.data == Eigen::MatrixXd(relu_data.cwiseMax(0.0)), "ReLU output");
 
     // Test 4: Small neural network
     std::cout << "\n=== Test 4: Small MLP forward pass ===" << std::endl;
@@ -65,13 +74,14 @@ int main() {
     std::cout << "Input shape: " << input_val.rows() << "x" << input_val.cols() << std::endl;
     std::cout << "Output shape: " << output.rows() << "x" << output.cols() << std::endl;
     std::cout << "Output:\n" << output.data << std::endl;
+    check(output.rows() == 3 && output.cols() == 2, "output shape 3x2");
 
     // Test 5: Backward pass
     std::cout << "\n=== Test 5: Backward pass ===" << std::endl;
     output.backward();
     std::cout << "Gradient at input:\n" << input_val.grad << std::endl;
+    check(input_val.grad.rows() == 3 && input_val.grad.cols() == 4 && input_val.grad.allFinite(),
+          "input gradient is 3x4 and finite");
 
-    std::cout << "\n✅ All tests completed successfully!" << std::endl;
-
-    return 0;
+    return finish();
 }
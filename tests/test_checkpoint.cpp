@@ -0,0 +1,111 @@
+#include <iostream>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include "checkpoint.hpp"
+#include "nn.hpp"
+#include "random.hpp"
+#include "check.hpp"
+
+using namespace micrograd;
+
+namespace {
+
+// Loads path into a zeroed copy of `like` and compares every state matrix
+bool matches(const std::string& path, MLP& like, const std::vector<Eigen::MatrixXd>& expected) {
+    MLP loaded = like.clone();
+    for (auto* m : loaded.state()) {
+        m->setZero();
+    }
+    loaded.load_weights(path);
+    auto state = loaded.state();
+    for (size_t i = 0; i < state.size(); ++i) {
+        if (*state[i] != expected[i]) {
+            return false;
+        }
+    }
+    return state.size() == expected.size();
+}
+
+std::vector<Eigen::MatrixXd> copy_state(MLP& model) {
+    std::vector<Eigen::MatrixXd> result;
+    for (auto* m : model.state()) {
+        result.push_back(*m);
+    }
+    return result;
+}
+
+bool exists(const std::string& path) {
+    return std::ifstream(path).good();
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Testing asynchronous checkpoints..." << std::endl;
+    manual_seed(4);
+
+    const std::string path = "test_checkpoint.bin";
+    MLP::Options options;
+    options.batch_norm = true;
+    MLP model(6, {8, 3}, options);
+
+    // Test 1: Save and load round trip, including buffers
+    std::cout << "\n=== Test 1: Round trip ===" << std::endl;
+    std::vector<std::vector<Eigen::MatrixXd>> snapshots;
+    {
+        AsyncCheckpointer checkpointer(path, 3);
+        for (int i = 0; i < 4; ++i) {
+            for (auto* m : model.state()) {
+                m->setRandom();
+            }
+            snapshots.push_back(copy_state(model));
+            checkpointer.save(model);
+            checkpointer.wait();
+        }
+        std::cout << "Written: " << checkpointer.num_written() << " (expected: 4)" << std::endl;
+        check(checkpointer.num_written() == 4, "snapshots written");
+    }
+    const bool latest = matches(path, model, snapshots[3]);
+    std::cout << "Latest checkpoint matches the last snapshot: " << (latest ? "yes" : "no") << " (expected: yes)"
+              << std::endl;
+    check(latest, "latest checkpoint");
+
+    // Test 2: Rotation keeps the previous max_retained - 1 checkpoints
+    std::cout << "\n=== Test 2: Rotation ===" << std::endl;
+    const bool previous = matches(path + ".1", model, snapshots[2]);
+    const bool oldest = matches(path + ".2", model, snapshots[1]);
+    std::cout << "path.1 and path.2 hold the two before it: " << (previous && oldest ? "yes" : "no")
+              << " (expected: yes)" << std::endl;
+    std::cout << "path.3 exists: " << (exists(path + ".3") ? "yes" : "no") << " (expected: no)" << std::endl;
+    std::cout << "Temporary file left: " << (exists(path + ".tmp") ? "yes" : "no") << " (expected: no)" << std::endl;
+    check(previous, "path.1 holds the previous snapshot");
+    check(oldest, "path.2 holds the one before");
+    check(!exists(path + ".3"), "no more than max_retained files");
+    check(!exists(path + ".tmp"), "no temporary file left");
+
+    // Test 3: A single retained checkpoint is replaced in place
+    std::cout << "\n=== Test 3: No retention ===" << std::endl;
+    const std::string single = "test_checkpoint_single.bin";
+    MLP plain(6, {8, 3});
+    {
+        AsyncCheckpointer checkpointer(single);
+        checkpointer.save(plain.parameters());
+        checkpointer.wait();
+        for (auto* p : plain.parameters()) {
+            p->data.setRandom();
+        }
+        checkpointer.save(plain.parameters());
+    }
+    const bool replaced = matches(single, plain, copy_state(plain));
+    std::cout << "Destructor flushes the last snapshot: " << (replaced ? "yes" : "no") << " (expected: yes)"
+              << std::endl;
+    std::cout << "single.1 exists: " << (exists(single + ".1") ? "yes" : "no") << " (expected: no)" << std::endl;
+    check(replaced, "last snapshot written on destruction");
+    check(!exists(single + ".1"), "no retained copies");
+
+    for (const std::string& p : {path, path + ".1", path + ".2", single}) {
+        std::remove(p.c_str());
+    }
+    return finish();
+}
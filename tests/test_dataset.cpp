@@ -0,0 +1,257 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include "dataset.hpp"
+#include "mnist_loader.hpp"
+#include "random.hpp"
+#include "trainer.hpp"
+#include "check.hpp"
+
+using namespace micrograd;
+
+void write_big_endian(std::ofstream& file, const int value) {
+    const unsigned char bytes[4] = {static_cast<unsigned char>(value >> 24), static_cast<unsigned char>(value >> 16),
+                                    static_cast<unsigned char>(value >> 8), static_cast<unsigned char>(value)};
+    file.write(reinterpret_cast<const char*>(bytes), 4);
+}
+
+int main() {
+    std::cout << "Testing sharded datasets..." << std::endl;
+
+    // Small synthetic IDX pair: 50 images of 4x4
+    const int n = 50;
+    const std::string images_path = "/tmp/micrograd_test_images.idx";
+    const std::string labels_path = "/tmp/micrograd_test_labels.idx";
+    {
+        std::ofstream images(images_path, std::ios::binary);
+        std::ofstream labels(labels_path, std::ios::binary);
+        write_big_endian(images, 2051);
+        write_big_endian(images, n);
+        write_big_endian(images, 4);
+        write_big_endian(images, 4);
+        write_big_endian(labels, 2049);
+        write_big_endian(labels, n);
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < 16; ++j) {
+                images.put(static_cast<char>((i + j * 3) % 256));
+            }
+            labels.put(static_cast<char>(i % 10));
+        }
+    }
+
+    // Test 1: IDX conversion round-trips against MNISTLoader
+    std::cout << "\n=== Test 1: IDX converter ===" << std::endl;
+    const std::string idx_prefix = "/tmp/micrograd_test_idx";
+    if (!convert_idx(images_path, labels_path, idx_prefix, 16)) {
+        std::cerr << "IDX conversion failed" << std::endl;
+        return 1;
+    }
+    ShardedDataset idx;
+    MNISTLoader mnist;
+    if (!idx.open(idx_prefix) || !mnist.load(images_path, labels_path)) {
+        return 1;
+    }
+    Eigen::MatrixXd features, expected_features;
+    Eigen::VectorXi labels, expected_labels;
+    // Spans shards 0 through 3
+    idx.read(5, 40, features, labels);
+    mnist.get_batch(0, n, expected_features, expected_labels);
+    std::cout << "Records: " << idx.size() << ", shards: " << idx.num_shards() << " (expected: 50, 4)" << std::endl;
+    std::cout << std::scientific << std::setprecision(2);
+    std::cout << "Max feature error: " << (features - expected_features.middleRows(5, 40)).cwiseAbs().maxCoeff()
+              << " (expected: ~0)" << std::endl;
+    std::cout << "Labels match: " << (labels == expected_labels.segment(5, 40) ? "yes" : "no") << " (expected: yes)"
+              << std::endl;
+    check(idx.size() == 50 && idx.num_shards() == 4, "records and shards");
+    check((features - expected_features.middleRows(5, 40)).cwiseAbs().maxCoeff() < 1e-12, "IDX features");
+    check(labels == expected_labels.segment(5, 40), "IDX labels");
+
+    // Test 2: CSV conversion to fp16 features
+    std::cout << "\n=== Test 2: CSV converter ===" << std::endl;
+    const std::string csv_path = "/tmp/micrograd_test.csv";
+    {
+        std::ofstream csv(csv_path);
+        csv << "x0,label,x1\n0.5,1,-2.25\n3.1415,0,100\n1e-3,2,7\n";
+    }
+    ShardedDataset csv;
+    if (!convert_csv(csv_path, "/tmp/micrograd_test_csv", 1) || !csv.open("/tmp/micrograd_test_csv")) {
+        return 1;
+    }
+    csv.read(0, 3, features, labels);
+    Eigen::MatrixXd expected_csv(3, 2);
+    expected_csv << 0.5, -2.25, 3.1415, 100, 1e-3, 7;
+    std::cout << "Max relative error: "
+              << ((features - expected_csv).array() / expected_csv.array()).abs().maxCoeff()
+              << " (expected: < 1e-3, fp16)" << std::endl;
+    std::cout << "Labels: " << labels.transpose() << " (expected: 1 0 2)" << std::endl;
+    check(((features - expected_csv).array() / expected_csv.array()).abs().maxCoeff() < 1e-3, "CSV features");
+    check(labels == Eigen::Vector3i(1, 0, 2), "CSV labels");
+
+    // Test 3: Streaming in storage order
+    std::cout << "\n=== Test 3: Sequential DataLoader ===" << std::endl;
+    DataLoader::Options options;
+    options.batch_size = 16;
+    DataLoader sequential(idx, options);
+    std::vector<int> seen;
+    int batches = 0;
+    while (sequential.next(features, labels)) {
+        batches++;
+        seen.insert(seen.end(), labels.data(), labels.data() + labels.size());
+    }
+    std::cout << "Batches: " << batches << " (expected: " << sequential.num_batches() << ")" << std::endl;
+    std::cout << "In order: " << (Eigen::Map<Eigen::VectorXi>(seen.data(), n) == expected_labels ? "yes" : "no")
+              << " (expected: yes)" << std::endl;
+    check(batches == sequential.num_batches(), "batch count");
+    check(Eigen::Map<Eigen::VectorXi>(seen.data(), n) == expected_labels, "sequential order");
+
+    // Test 4: Shuffle buffer across shards
+    std::cout << "\n=== Test 4: Shuffled DataLoader ===" << std::endl;
+    // Each record's first pixel identifies it
+    auto epoch_ids = [&](DataLoader& loader) {
+        std::vector<int> ids;
+        loader.reset();
+        while (loader.next(features, labels)) {
+            for (int i = 0; i < features.rows(); ++i) {
+                ids.push_back(static_cast<int>(std::round(features(i, 0) * 255)));
+            }
+        }
+        return ids;
+    };
+    options.shuffle_buffer = 20;
+    options.block_size = 8;
+    // A loader draws its shuffles from a generator seeded when it is built
+    manual_seed(3);
+    DataLoader shuffled(idx, options);
+    std::vector<int> first = epoch_ids(shuffled);
+    manual_seed(3);
+    DataLoader replayed(idx, options);
+    std::vector<int> second = epoch_ids(replayed);
+    std::vector<int> sorted = first;
+    std::sort(sorted.begin(), sorted.end());
+    bool permutation = sorted.size() == static_cast<size_t>(n);
+    for (int i = 0; permutation && i < n; ++i) {
+        permutation = sorted[i] == i;
+    }
+    std::vector<int> identity(n);
+    for (int i = 0; i < n; ++i) {
+        identity[i] = i;
+    }
+    std::cout << "Every record once: " << (permutation ? "yes" : "no") << " (expected: yes)" << std::endl;
+    std::cout << "Shuffled: " << (first != identity ? "yes" : "no") << " (expected: yes)" << std::endl;
+    std::cout << "Reproducible: " << (first == second ? "yes" : "no") << " (expected: yes)" << std::endl;
+    check(permutation, "every record once");
+    check(first != identity, "shuffled");
+    check(first == second, "reproducible");
+
+    // Test 5: Training from a DataLoader
+    std::cout << "\n=== Test 5: Trainer over a DataLoader ===" << std::endl;
+    MLP model(16, {8, 10});
+    NesterovSGD optimizer(model.parameters(), 0.01, 0.9);
+    Trainer trainer(model, optimizer, 16);
+    trainer.log_interval = 0;
+    EpochStats stats = trainer.train_epoch(shuffled);
+    std::cout << std::fixed;
+    std::cout << "Samples: " << stats.samples << ", steps: " << stats.steps << " (expected: 50, 4)" << std::endl;
+    check(stats.samples == 50 && stats.steps == 4, "trainer samples and steps");
+
+    // Test 6: Bad ranges and labels are refused
+    std::cout << "\n=== Test 6: Validation ===" << std::endl;
+    TensorDataset tensors(expected_features, expected_labels);
+    tensors.read(45, 10, features, labels);
+    const bool tensor_refused = features.rows() == 0 && labels.size() == 0;
+    tensors.read(45, 5, features, labels);
+    const bool tensor_tail = features.rows() == 5 && labels == expected_labels.tail(5);
+
+    ShardWriter writer("/tmp/micrograd_test_negative", 2, FeatureType::UInt8);
+    const bool writer_refused =
+        !writer.write(Eigen::RowVector2d(1, 2), -1) && writer.write(Eigen::RowVector2d(1, 2), 3);
+    writer.close();
+
+    // Corrupt the first record's label of a valid file to -1
+    {
+        std::fstream shard("/tmp/micrograd_test_csv-00000.shard", std::ios::binary | std::ios::in | std::ios::out);
+        const char minus_one[4] = {'\xff', '\xff', '\xff', '\xff'};
+        shard.write(minus_one, 4);
+    }
+    csv.read(0, 3, features, labels);
+    const bool shard_refused = labels.size() == 0;
+
+    // The same failed read stops an epoch instead of training on an empty batch
+    MLP csv_model(2, {3});
+    SGD csv_optimizer(csv_model.parameters(), 0.01);
+    Trainer csv_trainer(csv_model, csv_optimizer, 3);
+    csv_trainer.log_interval = 0;
+    DataLoader::Options csv_options;
+    csv_options.batch_size = 3;
+    DataLoader csv_loader(csv, csv_options);
+    bool epoch_failed = false;
+    try {
+        csv_trainer.train_epoch(csv_loader);
+    } catch (const std::runtime_error&) {
+        epoch_failed = true;
+    }
+
+    // A shuffled pass fails the same way instead of dropping the unreadable block
+    DataLoader::Options shuffled_csv_options;
+    shuffled_csv_options.batch_size = 3;
+    shuffled_csv_options.shuffle_buffer = 3;
+    shuffled_csv_options.block_size = 1;
+    DataLoader shuffled_csv_loader(csv, shuffled_csv_options);
+    const bool shuffled_batch_failed = !shuffled_csv_loader.next(features, labels);
+    const bool shuffled_pass_stopped = !shuffled_csv_loader.next(features, labels);
+    bool shuffled_epoch_failed = false;
+    try {
+        csv_trainer.train_epoch(shuffled_csv_loader);
+    } catch (const std::runtime_error&) {
+        shuffled_epoch_failed = true;
+    }
+
+    // The index is little-endian: version 1 is stored as 01 00 00 00
+    std::ifstream index(idx_prefix + ".index", std::ios::binary);
+    unsigned char header[8] = {};
+    index.read(reinterpret_cast<char*>(header), 8);
+    const bool little_endian = header[4] == 1 && header[5] == 0 && header[6] == 0 && header[7] == 0;
+
+    std::cout << "Out-of-range TensorDataset read refused: " << (tensor_refused ? "yes" : "no") << " (expected: yes)"
+              << std::endl;
+    std::cout << "Negative labels refused by writer and reader: " << (writer_refused && shard_refused ? "yes" : "no")
+              << " (expected: yes)" << std::endl;
+    std::cout << "Epoch over an unreadable batch failed: " << (epoch_failed ? "yes" : "no") << " (expected: yes)"
+              << std::endl;
+    std::cout << "Shuffled epoch over an unreadable block failed: " << (shuffled_epoch_failed ? "yes" : "no")
+              << " (expected: yes)" << std::endl;
+    std::cout << "Index stored little-endian: " << (little_endian ? "yes" : "no") << " (expected: yes)" << std::endl;
+    check(tensor_refused, "TensorDataset range check");
+    check(tensor_tail, "TensorDataset reads the last records");
+    check(writer_refused, "ShardWriter rejects negative labels");
+    check(shard_refused, "ShardedDataset rejects negative labels");
+    check(epoch_failed, "trainer throws when a batch cannot be read");
+    check(shuffled_batch_failed && shuffled_pass_stopped, "shuffled loader fails on an unreadable block");
+    check(shuffled_epoch_failed, "trainer throws when a shuffled block cannot be read");
+    check(little_endian, "little-endian index");
+
+    // Test 7: A failed conversion leaves nothing that opens as a dataset
+    std::cout << "\n=== Test 7: Truncated conversion ===" << std::endl;
+    const std::string truncated_path = "/tmp/micrograd_test_truncated.idx";
+    {
+        std::ifstream full(images_path, std::ios::binary);
+        std::ofstream truncated(truncated_path, std::ios::binary);
+        std::vector<char> bytes(16 + 30 * 16);
+        full.read(bytes.data(), bytes.size());
+        truncated.write(bytes.data(), bytes.size());
+    }
+    const std::string truncated_prefix = "/tmp/micrograd_test_truncated";
+    const bool converted = convert_idx(truncated_path, labels_path, truncated_prefix, 16);
+    ShardedDataset partial;
+    const bool opened = partial.open(truncated_prefix);
+    const bool shards_removed = !std::ifstream(truncated_prefix + "-00000.shard").good();
+    std::cout << "Truncated conversion opened: " << (opened ? "yes" : "no") << " (expected: no)" << std::endl;
+    std::cout << "Partial shards removed: " << (shards_removed ? "yes" : "no") << " (expected: yes)" << std::endl;
+    check(!converted, "truncated conversion fails");
+    check(!opened, "partial dataset cannot be opened");
+    check(shards_removed, "partial shards removed");
+
+    return finish();
+}
@@ -0,0 +1,117 @@
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include "engine.hpp"
+#include "nn.hpp"
+#include "loss.hpp"
+#include "optimizer.hpp"
+#include "mnist_loader.hpp"
+#include "random.hpp"
+#include "parallel.hpp"
+#include "check.hpp"
+
+using namespace micrograd;
+
+// Trains a fresh model from a fixed seed and returns its final parameters
+std::vector<Eigen::MatrixXd> train_run(const int threads) {
+    set_num_threads(threads);
+    manual_seed(7);
+
+    MLP::Options options;
+    options.dropout = 0.2;
+    MLP model(20, {64, 5}, options);
+    CrossEntropyLoss criterion;
+    NesterovSGD optimizer(model.parameters(), 0.05, 0.9);
+
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(1500, 20);
+    Eigen::VectorXi y(1500);
+    for (int i = 0; i < 1500; ++i) {
+        y(i) = i % 5;
+    }
+
+    for (int step = 0; step < 5; ++step) {
+        optimizer.zero_grad();
+        Value loss = criterion.forward(model.forward(Value(X)), y);
+        loss.backward();
+        optimizer.step();
+    }
+
+    std::vector<Eigen::MatrixXd> params;
+    for (auto* p : model.parameters()) {
+        params.push_back(p->data);
+    }
+    return params;
+}
+
+bool bit_identical(const std::vector<Eigen::MatrixXd>& a, const std::vector<Eigen::MatrixXd>& b) {
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].size() != b[i].size() ||
+            std::memcmp(a[i].data(), b[i].data(), a[i].size() * sizeof(double)) != 0) {
+            return false;
+        }
+    }
+    return a.size() == b.size();
+}
+
+int main() {
+    std::cout << "Testing reproducibility..." << std::endl;
+
+    // Test 1: A seed fixes initialization
+    std::cout << "\n=== Test 1: Seeded initialization ===" << std::endl;
+    manual_seed(123);
+    MLP a(10, {8, 2});
+    manual_seed(123);
+    MLP b(10, {8, 2});
+    std::cout << "Same weights: " << (a.layers[0].w->data == b.layers[0].w->data ? "yes" : "no")
+              << " (expected: yes)" << std::endl;
+    check(a.layers[0].w->data == b.layers[0].w->data, "seeded initialization");
+
+    // Test 2: Seeded shuffling
+    std::cout << "\n=== Test 2: Seeded shuffling ===" << std::endl;
+    MNISTLoader loader;
+    loader.num_images = 100;
+    loader.images = Eigen::MatrixXd::Zero(100, 1);
+    loader.labels = Eigen::VectorXi::LinSpaced(100, 0, 99);
+    Eigen::MatrixXd images;
+    Eigen::VectorXi first, second;
+    manual_seed(5);
+    loader.shuffle();
+    loader.get_batch(0, 10, images, first);
+    manual_seed(5);
+    loader.shuffle();
+    loader.get_batch(0, 10, images, second);
+    std::cout << "Same order: " << (first == second ? "yes" : "no") << " (expected: yes)" << std::endl;
+    std::cout << "Shuffled: " << (first != Eigen::VectorXi::LinSpaced(10, 0, 9) ? "yes" : "no") << " (expected: yes)"
+              << std::endl;
+    check(first == second, "seeded shuffle order");
+    check(first != Eigen::VectorXi::LinSpaced(10, 0, 9), "shuffle changes the order");
+
+    // Test 3: Deterministic mode is bit-identical across thread counts
+    std::cout << "\n=== Test 3: Deterministic training across thread counts ===" << std::endl;
+    set_deterministic(true);
+    auto one = train_run(1);
+    auto two = train_run(2);
+    auto four = train_run(4);
+    std::cout << "1 vs 2 threads bit-identical: " << (bit_identical(one, two) ? "yes" : "no") << " (expected: yes)"
+              << std::endl;
+    std::cout << "1 vs 4 threads bit-identical: " << (bit_identical(one, four) ? "yes" : "no") << " (expected: yes)"
+              << std::endl;
+    check(bit_identical(one, two), "1 vs 2 threads");
+    check(bit_identical(one, four), "1 vs 4 threads");
+
+    // Test 4: Ordered reductions agree with Eigen up to rounding
+    std::cout << "\n=== Test 4: Reductions ===" << std::endl;
+    Eigen::MatrixXd m = Eigen::MatrixXd::Random(1000, 7);
+    Eigen::MatrixXd g = Eigen::MatrixXd::Random(1000, 3);
+    std::cout << std::scientific << std::setprecision(2);
+    std::cout << "sum_rows error: " << (sum_rows(m) - m.colwise().sum()).cwiseAbs().maxCoeff() << " (expected: ~0)"
+              << std::endl;
+    std::cout << "matmul_tn error: " << (matmul_tn(m, g) - m.transpose() * g).cwiseAbs().maxCoeff()
+              << " (expected: ~0)" << std::endl;
+    check((sum_rows(m) - m.colwise().sum()).cwiseAbs().maxCoeff() < 1e-10, "sum_rows");
+    check((matmul_tn(m, g) - m.transpose() * g).cwiseAbs().maxCoeff() < 1e-10, "matmul_tn");
+    set_deterministic(false);
+    set_num_threads(1);
+
+    return finish();
+}
@@ -0,0 +1,298 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "distributed.hpp"
+#include "loss.hpp"
+#include "optimizer.hpp"
+#include "random.hpp"
+#include "trainer.hpp"
+#include "check.hpp"
+
+using namespace micrograd;
+
+const int WORLD_SIZE = 3;
+const int ROWS_PER_RANK = 32;
+const int STEPS = 10;
+
+Eigen::MatrixXd make_inputs() {
+    Eigen::MatrixXd X(WORLD_SIZE * ROWS_PER_RANK, 8);
+    for (int i = 0; i < X.rows(); ++i) {
+        for (int j = 0; j < X.cols(); ++j) {
+            X(i, j) = std::sin(i * 7.0 + j * 3.0);
+        }
+    }
+    return X;
+}
+
+Eigen::VectorXi make_labels() {
+    Eigen::VectorXi y(WORLD_SIZE * ROWS_PER_RANK);
+    for (int i = 0; i < y.size(); ++i) {
+        y(i) = i % 4;
+    }
+    return y;
+}
+
+double max_difference(MLP& a, MLP& b) {
+    double diff = 0.0;
+    auto pa = a.parameters();
+    auto pb = b.parameters();
+    for (size_t i = 0; i < pa.size(); ++i) {
+        diff = std::max(diff, (pa[i]->data - pb[i]->data).cwiseAbs().maxCoeff());
+    }
+    return diff;
+}
+
+// Largest difference between this rank's parameters and rank 0's, the same on every rank
+double rank_divergence(MLP& model, ProcessGroup& group) {
+    double diff = 0.0;
+    for (auto* p : model.parameters()) {
+        Eigen::MatrixXd root = p->data;
+        group.broadcast(root.data(), root.size(), 0);
+        diff = std::max(diff, (root - p->data).cwiseAbs().maxCoeff());
+    }
+    group.all_reduce(&diff, 1);
+    return diff;
+}
+
+// Trains with DDP on this rank's shard; returns the largest deviation from
+// single-process training on the full batch, summed over ranks
+double train_distributed(ProcessGroup& group, const DistributedDataParallel::Options& options,
+                         double& divergence, CommStats& comm) {
+    const Eigen::MatrixXd X = make_inputs();
+    const Eigen::VectorXi y = make_labels();
+
+    // Different initial weights per rank; DDP copies rank 0's
+    manual_seed(100 + group.rank);
+    MLP model(8, {16, 4});
+    DistributedDataParallel ddp(model, group, options);
+    MLP reference = model.clone();
+
+    CrossEntropyLoss criterion;
+    SGD optimizer(model.parameters(), 0.5);
+    SGD reference_optimizer(reference.parameters(), 0.5);
+    for (int step = 0; step < STEPS; ++step) {
+        optimizer.zero_grad();
+        Value shard(X.middleRows(group.rank * ROWS_PER_RANK, ROWS_PER_RANK));
+        Value loss = criterion.forward(model.forward(shard), y.segment(group.rank * ROWS_PER_RANK, ROWS_PER_RANK));
+        loss.backward();
+        ddp.synchronize();
+        optimizer.step();
+
+        reference_optimizer.zero_grad();
+        Value full_loss = criterion.forward(reference.forward(Value(X)), y);
+        full_loss.backward();
+        reference_optimizer.step();
+    }
+
+    double diff = max_difference(model, reference);
+    group.all_reduce(&diff, 1);
+    divergence = rank_divergence(model, group);
+    comm = ddp.stats();
+    return diff;
+}
+
+int run_rank(const int rank, const int port) {
+    ProcessGroup group(rank, WORLD_SIZE, "127.0.0.1", port);
+    if (!group.connect()) {
+        return 1;
+    }
+    const bool print = rank == 0;
+    std::cout << std::scientific << std::setprecision(2);
+
+    // Test 1: Ring all-reduce
+    if (print) std::cout << "\n=== Test 1: Ring all-reduce ===" << std::endl;
+    std::vector<double> values(10);
+    for (int i = 0; i < 10; ++i) {
+        values[i] = rank * 10 + i;
+    }
+    group.all_reduce(values.data(), values.size());
+    // Sum over ranks of (10 r + i) = 30 + 3 i
+    bool sums_ok = true;
+    for (int i = 0; i < 10; ++i) {
+        sums_ok = sums_ok && values[i] == 30 + 3 * i;
+    }
+    if (print) std::cout << "Sums correct on rank 0: " << (sums_ok ? "yes" : "no") << " (expected: yes)" << std::endl;
+    check(sums_ok, "all-reduce sums on rank " + std::to_string(rank));
+
+    // Test 2: Exact averaging, with and without overlap
+    for (const bool overlap : {true, false}) {
+        DistributedDataParallel::Options options;
+        options.overlap = overlap;
+        // Small buckets, so reductions start while backward is still running
+        options.bucket_size = 40;
+        double divergence;
+        CommStats comm;
+        const double diff = train_distributed(group, options, divergence, comm);
+        if (print) {
+            std::cout << "\n=== Test 2" << (overlap ? "a: Overlapped" : "b: Non-overlapped")
+                      << " all-reduce ===" << std::endl;
+            std::cout << "Max difference from full-batch training: " << diff << " (expected: ~0)" << std::endl;
+            std::cout << "Ranks identical: " << (divergence == 0.0 ? "yes" : "no") << " (expected: yes)" << std::endl;
+            std::cout << std::fixed << std::setprecision(2);
+            std::cout << "Communication: " << comm.communication_seconds * 1000 << "ms, blocked: "
+                      << comm.blocked_seconds * 1000 << "ms over " << comm.steps << " steps, " << comm.bytes_sent
+                      << " bytes sent" << std::endl;
+            std::cout << std::scientific;
+        }
+        check(diff < 1e-10, "DDP matches full-batch training");
+        check(divergence == 0.0, "ranks identical");
+    }
+
+    // Test 3: Compressed gradients stay in sync across ranks
+    for (const Compression compression : {Compression::FP16, Compression::TopK}) {
+        DistributedDataParallel::Options options;
+        options.compression = compression;
+        options.topk_ratio = 0.25;
+        double divergence;
+        CommStats comm;
+        const double diff = train_distributed(group, options, divergence, comm);
+        if (print) {
+            std::cout << "\n=== Test 3" << (compression == Compression::FP16 ? "a: FP16" : "b: Top-k")
+                      << " compression ===" << std::endl;
+            std::cout << "Max difference from full-batch training: " << diff
+                      << (compression == Compression::FP16 ? " (expected: < 1e-2)" : " (expected: approximate)")
+                      << std::endl;
+            std::cout << "Ranks identical: " << (divergence == 0.0 ? "yes" : "no") << " (expected: yes)" << std::endl;
+            std::cout << "Bytes sent: " << std::fixed << std::setprecision(0) << static_cast<double>(comm.bytes_sent)
+                      << std::scientific << std::setprecision(2) << std::endl;
+        }
+        if (compression == Compression::FP16) {
+            check(diff < 1e-2, "FP16 compression stays close to full-batch training");
+        }
+        check(divergence == 0.0, "compressed ranks identical");
+    }
+
+    // Test 4: Trainer with gradient accumulation over each rank's shard
+    {
+        manual_seed(7 + rank);
+        MLP model(8, {16, 4});
+        DistributedDataParallel ddp(model, group);
+        NesterovSGD optimizer(model.parameters(), 0.1, 0.9);
+        Trainer trainer(model, optimizer, 8);
+        trainer.log_interval = 0;
+        trainer.accumulation_steps = 2;
+        trainer.distributed = &ddp;
+        TensorDataset shard(make_inputs().middleRows(rank * ROWS_PER_RANK, ROWS_PER_RANK),
+                            make_labels().segment(rank * ROWS_PER_RANK, ROWS_PER_RANK));
+        DataLoader::Options loader_options;
+        loader_options.batch_size = 8;
+        DataLoader loader(shard, loader_options);
+        EpochStats stats = trainer.train_epoch(loader);
+        const double divergence = rank_divergence(model, group);
+        if (print) {
+            std::cout << "\n=== Test 4: Trainer ===" << std::endl;
+            std::cout << "Steps: " << stats.steps << " (expected: 2)" << std::endl;
+            std::cout << "Ranks identical: " << (divergence == 0.0 ? "yes" : "no") << " (expected: yes)" << std::endl;
+        }
+        check(stats.steps == 2, "trainer steps");
+        check(divergence == 0.0, "trainer ranks identical");
+    }
+    return check_failures > 0 ? 1 : 0;
+}
+
+// Rank 1 leaves right after joining, so rank 0's first synchronize() fails
+int run_lost_peer(const int rank, const int port) {
+    ProcessGroup group(rank, 2, "127.0.0.1", port);
+    if (!group.connect()) {
+        return 1;
+    }
+    manual_seed(11);
+    MLP model(8, {16, 4});
+    DistributedDataParallel ddp(model, group);
+    if (rank == 1) {
+        return 0;
+    }
+
+    std::cout << "\n=== Test 5: Lost peer ===" << std::endl;
+    MLP before = model.clone();
+    SGD optimizer(model.parameters(), 0.1);
+    Trainer trainer(model, optimizer, 8);
+    trainer.log_interval = 0;
+    trainer.distributed = &ddp;
+    TensorDataset shard(make_inputs().topRows(ROWS_PER_RANK), make_labels().head(ROWS_PER_RANK));
+    DataLoader loader(shard);
+    bool threw = false;
+    try {
+        trainer.train_epoch(loader);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    std::cout << "Epoch stopped: " << (threw ? "yes" : "no") << " (expected: yes)" << std::endl;
+    check(threw, "failed synchronize stops the epoch");
+    check(max_difference(model, before) == 0.0, "no step on unsynchronized gradients");
+    return check_failures > 0 ? 1 : 0;
+}
+
+// Rank 0 hangs up before broadcasting its initial parameters
+int run_missing_root(const int rank, const int port) {
+    ProcessGroup group(rank, 2, "127.0.0.1", port);
+    if (!group.connect()) {
+        return 1;
+    }
+    if (rank == 0) {
+        return 0;
+    }
+
+    std::cout << "\n=== Test 6: Failed initial broadcast ===" << std::endl;
+    manual_seed(12);
+    MLP model(8, {16, 4});
+    bool threw = false;
+    try {
+        DistributedDataParallel ddp(model, group);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    std::cout << "Construction failed: " << (threw ? "yes" : "no") << " (expected: yes)" << std::endl;
+    check(threw, "failed broadcast throws from the constructor");
+    return check_failures > 0 ? 1 : 0;
+}
+
+int main() {
+    std::cout << "Testing distributed data-parallel training..." << std::endl;
+
+    const int port = 20000 + getpid() % 20000;
+    std::vector<pid_t> children;
+    for (int rank = 1; rank < WORLD_SIZE; ++rank) {
+        const pid_t pid = fork();
+        if (pid == 0) {
+            _exit(run_rank(rank, port));
+        }
+        children.push_back(pid);
+    }
+
+    int failures = run_rank(0, port);
+    for (pid_t pid : children) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        failures += !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+    if (failures > 0) {
+        std::cerr << failures << " rank(s) failed" << std::endl;
+        return 1;
+    }
+
+    const pid_t peer = fork();
+    if (peer == 0) {
+        _exit(run_lost_peer(1, port + WORLD_SIZE));
+    }
+    failures = run_lost_peer(0, port + WORLD_SIZE);
+    int status = 0;
+    waitpid(peer, &status, 0);
+    if (failures > 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return 1;
+    }
+
+    const pid_t root = fork();
+    if (root == 0) {
+        _exit(run_missing_root(0, port + 2 * WORLD_SIZE));
+    }
+    failures = run_missing_root(1, port + 2 * WORLD_SIZE);
+    waitpid(root, &status, 0);
+    if (failures > 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return 1;
+    }
+
+    return finish();
+}
@@ -0,0 +1,110 @@
+#include <iostream>
+#include <stdexcept>
+#include "engine.hpp"
+#include "expr.hpp"
+#include "check.hpp"
+
+using namespace micrograd;
+
+int main() {
+    std::cout << "Testing fused expressions..." << std::endl;
+
+    Value a(Eigen::MatrixXd::Random(4, 3));
+    Value b(Eigen::MatrixXd::Random(1, 3));
+    Value c(Eigen::MatrixXd::Random(4, 1));
+    Value s(Eigen::MatrixXd::Constant(1, 1, 1.5));
+    Value upstream(Eigen::MatrixXd::Random(4, 3));
+
+    // The same expression from regular ops, broadcasting explicitly
+    auto unfused = [&]() {
+        Value wide_b = b.broadcast_to(4, 3);
+        return a * wide_b + c.broadcast_to(4, 3).pow(2.0) / s.broadcast_to(4, 3) - a.relu() * 0.5 +
+               wide_b.sigmoid() - 1.0;
+    };
+    auto fused = [&]() {
+        return fuse(lazy(a) * lazy(b) + pow(lazy(c), 2.0) / lazy(s) - relu(lazy(a)) * 0.5 + sigmoid(lazy(b)) -
+                    1.0);
+    };
+    auto gradients = [&](Value out) {
+        for (Value* v : {&a, &b, &c, &s}) {
+            v->zero_grad();
+        }
+        (out * upstream).sum().backward();
+        return std::vector<Eigen::MatrixXd>{a.grad, b.grad, c.grad, s.grad};
+    };
+
+    // Test 1: Values with row, column and scalar broadcasting
+    std::cout << "\n=== Test 1: Values ===" << std::endl;
+    const Value expected = unfused();
+    const Value actual = fused();
+    const double value_error = (actual.data - expected.data).cwiseAbs().maxCoeff();
+    std::cout << "Shape: " << actual.rows() << "x" << actual.cols() << " (expected: 4x3)" << std::endl;
+    std::cout << "Max difference from unfused: " << value_error << " (expected: ~0)" << std::endl;
+    check(actual.rows() == 4 && actual.cols() == 3, "broadcast result shape");
+    check(value_error < 1e-12, "fused values match unfused ops");
+
+    // Test 2: Gradients, summed over the broadcast axes
+    std::cout << "\n=== Test 2: Gradients ===" << std::endl;
+    const auto expected_grads = gradients(unfused());
+    const auto actual_grads = gradients(fused());
+    const char* names[] = {"a", "b", "c", "s"};
+    for (size_t i = 0; i < expected_grads.size(); ++i) {
+        const bool same_shape = actual_grads[i].rows() == expected_grads[i].rows() &&
+                                actual_grads[i].cols() == expected_grads[i].cols();
+        const double error = same_shape ? (actual_grads[i] - expected_grads[i]).cwiseAbs().maxCoeff() : 1.0;
+        std::cout << "d/d" << names[i] << " max difference: " << error << " (expected: ~0)" << std::endl;
+        check(same_shape && error < 1e-12, std::string("gradient of ") + names[i]);
+    }
+
+    // Test 3: Shapes that cannot broadcast are rejected when the expression is built
+    std::cout << "\n=== Test 3: Shape checks ===" << std::endl;
+    Value tall(Eigen::MatrixXd::Random(2, 3));
+    Value wide(Eigen::MatrixXd::Random(4, 2));
+    int rejected = 0;
+    for (const Value* other : {&tall, &wide}) {
+        try {
+            fuse(lazy(a) * lazy(*other));
+        } catch (const std::invalid_argument&) {
+            ++rejected;
+        }
+    }
+    bool outer_accepted = true;
+    try {
+        outer_accepted = fuse(lazy(b) + lazy(c)).rows() == 4;
+    } catch (const std::invalid_argument&) {
+        outer_accepted = false;
+    }
+    std::cout << "Rejected mismatched operands: " << rejected << " of 2 (expected: 2)" << std::endl;
+    std::cout << "1x3 + 4x1 accepted: " << (outer_accepted ? "yes" : "no") << " (expected: yes)" << std::endl;
+    check(rejected == 2, "mismatched shapes throw");
+    check(outer_accepted, "row and column broadcasts combine");
+
+    // Test 4: Inputs are recorded once each, in the order the expression uses them
+    std::cout << "\n=== Test 4: Input order ===" << std::endl;
+    const Value combined = fuse(lazy(c) * lazy(a) + lazy(b) * lazy(c) - lazy(a));
+    const auto& inputs = combined.get_self_ptr()->_prev;
+    const bool ordered = inputs.size() == 3 && inputs[0].get() == c.get_self_ptr().get() &&
+                         inputs[1].get() == a.get_self_ptr().get() && inputs[2].get() == b.get_self_ptr().get();
+    std::cout << "Inputs: " << inputs.size() << " (expected: 3, ordered c, a, b)" << std::endl;
+    check(ordered, "fused inputs deduplicated in first-use order");
+
+    // Test 5: Fusing over an op result keeps it inside one releasable graph
+    std::cout << "\n=== Test 5: Op result as input ===" << std::endl;
+    a.zero_grad();
+    b.zero_grad();
+    Value product = a * b.broadcast_to(4, 3);
+    bool released = true;
+    try {
+        fuse(lazy(product) + 1.0).sum().backward();
+    } catch (const std::logic_error&) {
+        released = false;
+    }
+    const Eigen::MatrixXd expected_da = b.data.replicate(4, 1);
+    const double product_error = released ? (a.grad - expected_da).cwiseAbs().maxCoeff() : 1.0;
+    std::cout << "Backward released the graph: " << (released ? "yes" : "no") << " (expected: yes)" << std::endl;
+    std::cout << "d/da max difference: " << product_error << " (expected: ~0)" << std::endl;
+    check(released, "backward through a fused op result releases its graph");
+    check(product_error < 1e-12, "gradient flows through the op result");
+
+    return finish();
+}
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <iomanip>
+#include "engine.hpp"
+#include "autodiff.hpp"
+#include "forward.hpp"
+#include "nn.hpp"
+#include "loss.hpp"
+#include "check.hpp"
+
+using namespace micrograd;
+
+int main() {
+    std::cout << "Testing forward-mode autodiff..." << std::endl;
+    std::cout << std::scientific << std::setprecision(2);
+
+    // Test 1: Elementwise and shape ops against central differences
+    std::cout << "\n=== Test 1: Ops vs finite differences ===" << std::endl;
+    auto f = [](const Dual& x) {
+        Dual y = (x.sigmoid() * x / (x.pow(2.0) + 1.0)).transpose();
+        return (y.matmul(x) - y.matmul(x).pow(2.0)).softmax().flatten();
+    };
+    Eigen::MatrixXd x0 = Eigen::MatrixXd::Random(3, 2);
+    Eigen::MatrixXd jac = jacobian(f, x0, 4);
+
+    const double h = 1e-6;
+    double max_error = 0.0;
+    for (int j = 0; j < x0.size(); ++j) {
+        Eigen::MatrixXd xp = x0, xm = x0;
+        xp(j) += h;
+        xm(j) -= h;
+        Eigen::MatrixXd fd = (f(Dual(xp)).data - f(Dual(xm)).data) / (2 * h);
+        max_error = std::max(max_error, (jac.col(j) - fd.transpose()).cwiseAbs().maxCoeff());
+    }
+    std::cout << "Jacobian shape: " << jac.rows() << "x" << jac.cols() << " (expected: 4x6)" << std::endl;
+    std::cout << "Max error: " << max_error << " (expected: < 1e-8)" << std::endl;
+    check(jac.rows() == 4 && jac.cols() == 6, "Jacobian shape 4x6");
+    check(max_error < 1e-8, "Jacobian vs finite differences");
+
+    // Test 2: MLP input Jacobian matches reverse mode row by row
+    std::cout << "\n=== Test 2: MLP Jacobian vs reverse mode ===" << std::endl;
+    MLP model(4, {16, 3});
+    model.layers[0].nonlin = false;
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(5, 4);
+    Eigen::MatrixXd forward_jac = jacobian([&](const Dual& x) { return forward(model, x).sigmoid(); }, X);
+
+    Value input(X);
+    max_error = 0.0;
+    for (int i = 0; i < forward_jac.rows(); ++i) {
+        Eigen::MatrixXd seed = Eigen::MatrixXd::Zero(5, 3);
+        seed(i) = 1.0;
+        Eigen::MatrixXd row = vjp([&]() { return model.forward(input).sigmoid(); }, {&input}, seed)[0];
+        max_error = std::max(max_error,
+                             (forward_jac.row(i).transpose() - Eigen::Map<Eigen::VectorXd>(row.data(), row.size()))
+                                 .cwiseAbs()
+                                 .maxCoeff());
+    }
+    std::cout << "Max error: " << max_error << " (expected: ~0)" << std::endl;
+    check(max_error < 1e-12, "forward vs reverse Jacobian");
+
+    // Test 3: Several loss directional derivatives in one pass
+    std::cout << "\n=== Test 3: Loss directional derivatives ===" << std::endl;
+    Eigen::VectorXi labels(5);
+    labels << 0, 1, 2, 1, 0;
+    std::vector<Eigen::MatrixXd> directions = {Eigen::MatrixXd::Random(5, 4), Eigen::MatrixXd::Random(5, 4)};
+    Dual loss = cross_entropy(forward(model, Dual::variable(X, directions)), labels);
+
+    CrossEntropyLoss criterion;
+    Value input2(X);
+    Value reverse_loss = criterion.forward(model.forward(input2), labels);
+    Eigen::MatrixXd g = grad(reverse_loss, {&input2})[0].data;
+    std::cout << "Loss: " << std::fixed << std::setprecision(6) << loss.data(0, 0) << " vs " << reverse_loss.data(0, 0)
+              << " (expected: equal)" << std::endl;
+    check_near(loss.data(0, 0), reverse_loss.data(0, 0), 1e-12, "forward vs reverse loss");
+    std::cout << std::scientific << std::setprecision(2);
+    for (int k = 0; k < 2; ++k) {
+        const double error = std::abs(loss.tangent(k, 0) - g.cwiseProduct(directions[k]).sum());
+        std::cout << "Direction " << k << " error: " << error << " (expected: ~0)" << std::endl;
+        check(error < 1e-12, "directional derivative " + std::to_string(k));
+    }
+
+    return finish();
+}
@@ -0,0 +1,144 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include "engine.hpp"
+#include "autodiff.hpp"
+#include "nn.hpp"
+#include "loss.hpp"
+#include "random.hpp"
+#include "check.hpp"
+
+using namespace micrograd;
+
+namespace {
+
+const double TOLERANCE = 1e-6;
+
+using Fn = std::function<Value(const std::vector<Value>&)>;
+
+// Prints the largest error against central differences and checks it
+void check_grad(const std::string& name, const Fn& f, const std::vector<Eigen::MatrixXd>& inputs) {
+    const double error = gradcheck(f, inputs);
+    std::cout << "  " << std::left << std::setw(34) << name << std::right << error << std::endl;
+    check(error < TOLERANCE, "gradient of " + name);
+}
+
+Eigen::MatrixXd random(int rows, int cols) {
+    return Eigen::MatrixXd::Random(rows, cols);
+}
+
+// Values in [0.5, 1.5], away from zero for division and fractional powers
+Eigen::MatrixXd positive(int rows, int cols) {
+    return Eigen::MatrixXd::Random(rows, cols).array() * 0.5 + 1.0;
+}
+
+// Random values pushed away from zero, where relu-style ops have a kink
+Eigen::MatrixXd off_zero(int rows, int cols) {
+    Eigen::MatrixXd m = Eigen::MatrixXd::Random(rows, cols);
+    return m.array() + m.array().sign() * 0.1;
+}
+
+std::string shape(int rows, int cols) {
+    return std::to_string(rows) + "x" + std::to_string(cols);
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Gradient checks against central differences (expected: every error < 1e-6)..." << std::endl;
+    std::cout << std::scientific << std::setprecision(2);
+    manual_seed(7);
+
+    const std::vector<std::pair<int, int>> shapes = {{1, 1}, {1, 5}, {4, 1}, {3, 4}};
+
+    // Test 1: Binary ops, including row broadcasting on either side
+    std::cout << "\n=== Test 1: Binary ops ===" << std::endl;
+    for (auto [r, c] : shapes) {
+        const std::string s = shape(r, c);
+        check_grad("a + b " + s, [](const std::vector<Value>& v) { return v[0] + v[1]; }, {random(r, c), random(r, c)});
+        check_grad("a - b " + s, [](const std::vector<Value>& v) { return v[0] - v[1]; }, {random(r, c), random(r, c)});
+        check_grad("a * b " + s, [](const std::vector<Value>& v) { return v[0] * v[1]; }, {random(r, c), random(r, c)});
+        check_grad("a / b " + s, [](const std::vector<Value>& v) { return v[0] / v[1]; },
+              {random(r, c), positive(r, c)});
+    }
+    check_grad("a + row", [](const std::vector<Value>& v) { return v[0] + v[1]; }, {random(3, 4), random(1, 4)});
+    check_grad("row + a", [](const std::vector<Value>& v) { return v[0] + v[1]; }, {random(1, 4), random(3, 4)});
+    check_grad("a - row", [](const std::vector<Value>& v) { return v[0] - v[1]; }, {random(3, 4), random(1, 4)});
+    check_grad("row - a", [](const std::vector<Value>& v) { return v[0] - v[1]; }, {random(1, 4), random(3, 4)});
+
+    // Test 2: Scalar ops
+    std::cout << "\n=== Test 2: Scalar ops ===" << std::endl;
+    check_grad("a + 2.5", [](const std::vector<Value>& v) { return v[0] + 2.5; }, {random(3, 4)});
+    check_grad("a - 2.5", [](const std::vector<Value>& v) { return v[0] - 2.5; }, {random(3, 4)});
+    check_grad("a * -1.5", [](const std::vector<Value>& v) { return v[0] * -1.5; }, {random(3, 4)});
+    check_grad("a / 4.0", [](const std::vector<Value>& v) { return v[0] / 4.0; }, {random(3, 4)});
+    for (double exponent : {2.0, 3.0, 0.5, -1.5}) {
+        check_grad("pow " + std::to_string(exponent), [exponent](const std::vector<Value>& v) { return v[0].pow(exponent); },
+              {positive(3, 4)});
+    }
+
+    // Test 3: Matrix products
+    std::cout << "\n=== Test 3: matmul ===" << std::endl;
+    check_grad("3x4 @ 4x2", [](const std::vector<Value>& v) { return v[0].matmul(v[1]); }, {random(3, 4), random(4, 2)});
+    check_grad("1x5 @ 5x1", [](const std::vector<Value>& v) { return v[0].matmul(v[1]); }, {random(1, 5), random(5, 1)});
+    check_grad("5x1 @ 1x3", [](const std::vector<Value>& v) { return v[0].matmul(v[1]); }, {random(5, 1), random(1, 3)});
+
+    // Test 4: Activations
+    std::cout << "\n=== Test 4: Activations ===" << std::endl;
+    for (auto [r, c] : shapes) {
+        const std::string s = shape(r, c);
+        check_grad("relu " + s, [](const std::vector<Value>& v) { return v[0].relu(); }, {off_zero(r, c)});
+        check_grad("sigmoid " + s, [](const std::vector<Value>& v) { return v[0].sigmoid(); }, {random(r, c) * 3.0});
+        check_grad("tanh " + s, [](const std::vector<Value>& v) { return v[0].tanh(); }, {random(r, c) * 3.0});
+        check_grad("gelu " + s, [](const std::vector<Value>& v) { return v[0].gelu(); }, {random(r, c) * 3.0});
+        check_grad("leaky_relu " + s, [](const std::vector<Value>& v) { return v[0].leaky_relu(0.1); }, {off_zero(r, c)});
+        check_grad("silu " + s, [](const std::vector<Value>& v) { return v[0].silu(); }, {random(r, c) * 3.0});
+        check_grad("softmax " + s, [](const std::vector<Value>& v) { return v[0].softmax(); }, {random(r, c) * 3.0});
+    }
+
+    // Test 5: Shape ops and reductions
+    std::cout << "\n=== Test 5: Shape ops ===" << std::endl;
+    check_grad("transpose", [](const std::vector<Value>& v) { return v[0].transpose(); }, {random(3, 4)});
+    check_grad("reshape 3x4 -> 6x2", [](const std::vector<Value>& v) { return v[0].reshape(6, 2); }, {random(3, 4)});
+    check_grad("flatten", [](const std::vector<Value>& v) { return v[0].flatten(); }, {random(3, 4)});
+    check_grad("sum", [](const std::vector<Value>& v) { return v[0].sum(); }, {random(3, 4)});
+    for (auto [r, c] : std::vector<std::pair<int, int>>{{1, 4}, {3, 1}, {1, 1}, {3, 4}}) {
+        check_grad("sum_to " + shape(r, c), [r = r, c = c](const std::vector<Value>& v) { return v[0].sum_to(r, c); },
+              {random(3, 4)});
+        check_grad("broadcast_to from " + shape(r, c),
+              [](const std::vector<Value>& v) { return v[0].broadcast_to(3, 4); }, {random(r, c)});
+    }
+    check_grad("cast FP64", [](const std::vector<Value>& v) { return v[0].cast(Precision::FP64); }, {random(3, 4)});
+    check_grad("a * broadcast column", [](const std::vector<Value>& v) { return v[0] * v[1].broadcast_to(3, 4); },
+          {random(3, 4), random(3, 1)});
+    check_grad("a / broadcast scalar", [](const std::vector<Value>& v) { return v[0] / v[1].broadcast_to(3, 4); },
+          {random(3, 4), positive(1, 1)});
+
+    // Test 6: Losses and batch norm
+    std::cout << "\n=== Test 6: Losses and layers ===" << std::endl;
+    for (auto [n, k] : std::vector<std::pair<int, int>>{{1, 3}, {5, 4}, {8, 10}}) {
+        Eigen::VectorXi labels = Eigen::VectorXi::LinSpaced(n, 0, n - 1).unaryExpr([k = k](int i) { return i % k; });
+        check_grad("CrossEntropyLoss " + shape(n, k),
+              [labels](const std::vector<Value>& v) { return CrossEntropyLoss().forward(v[0], labels); },
+              {random(n, k) * 2.0});
+        const Eigen::MatrixXd target = random(n, k);
+        check_grad("MSELoss " + shape(n, k),
+              [target](const std::vector<Value>& v) { return MSELoss().forward(v[0], Value(target)); },
+              {random(n, k)});
+    }
+    BatchNorm1d norm(4);
+    norm.gamma->data = random(1, 4);
+    check_grad("BatchNorm1d (training)", [&norm](const std::vector<Value>& v) { return norm.forward(v[0]); },
+          {random(6, 4)});
+
+    // Test 7: A composite graph with shared subexpressions
+    std::cout << "\n=== Test 7: Composite ===" << std::endl;
+    check_grad("mlp-like composite",
+          [](const std::vector<Value>& v) {
+              Value h = (v[0].matmul(v[1]) + v[2]).tanh();
+              return MSELoss().forward((h * h.sigmoid()).softmax(), Value(Eigen::MatrixXd::Zero(4, 3)));
+          },
+          {random(4, 5), random(5, 3), random(1, 3)});
+
+    return finish();
+}
@@ -0,0 +1,194 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include "graph_ir.hpp"
+#include "random.hpp"
+#include "rnn.hpp"
+#include "sequential.hpp"
+#include "check.hpp"
+
+using namespace micrograd;
+
+namespace {
+
+const char* DRIVER = R"(#include <chrono>
+#include <cstdio>
+#include <vector>
+
+void forward(const double* input0, double* output);
+
+int main(int argc, char** argv) {
+    std::vector<double> in(IN_SIZE), out(OUT_SIZE + 1);
+    FILE* f = std::fopen(argv[1], "rb");
+    if (!f || std::fread(in.data(), sizeof(double), IN_SIZE, f) != IN_SIZE) return 1;
+    std::fclose(f);
+    forward(in.data(), out.data());
+    const int reps = 2000;
+    const auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r) {
+        forward(in.data(), out.data());
+    }
+    out[OUT_SIZE] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / reps;
+    f = std::fopen(argv[2], "wb");
+    std::fwrite(out.data(), sizeof(double), OUT_SIZE + 1, f);
+    std::fclose(f);
+    return 0;
+}
+)";
+
+// Generates code for the graph, builds it with the system compiler and runs it on input
+bool run_generated(const IRGraph& graph, const Eigen::MatrixXd& input, Eigen::MatrixXd& output, double& micros,
+                   const std::string& name) {
+    const IRNode& out_node = graph.nodes[graph.output];
+    const std::string source = name + ".cpp", driver = name + "_driver.cpp", binary = "./" + name + "_bin";
+    const std::string in_path = name + ".in", out_path = name + ".out";
+    if (!generate_cpp(graph, source)) {
+        return false;
+    }
+    std::ofstream(driver) << DRIVER;
+    std::ofstream in_file(in_path, std::ios::binary);
+    in_file.write(reinterpret_cast<const char*>(input.data()), input.size() * sizeof(double));
+    in_file.close();
+
+    const std::string build = "c++ -O2 -std=c++17 -DIN_SIZE=" + std::to_string(input.size()) +
+                              " -DOUT_SIZE=" + std::to_string(out_node.rows * out_node.cols) + " " + source + " " +
+                              driver + " -o " + binary + " 2>/dev/null";
+    bool ok = std::system(build.c_str()) == 0 && std::system((binary + " " + in_path + " " + out_path).c_str()) == 0;
+    if (ok) {
+        output.resize(out_node.rows, out_node.cols);
+        std::ifstream out_file(out_path, std::ios::binary);
+        out_file.read(reinterpret_cast<char*>(output.data()), output.size() * sizeof(double));
+        out_file.read(reinterpret_cast<char*>(&micros), sizeof(double));
+        ok = static_cast<bool>(out_file);
+    }
+    for (const auto& path : {source, driver, binary.substr(2), in_path, out_path}) {
+        std::remove(path.c_str());
+    }
+    return ok;
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Testing graph export and code generation..." << std::endl;
+    std::cout << std::scientific << std::setprecision(3);
+    manual_seed(21);
+
+    // Test 1: Export an MLP with batch norm and dropout in eval mode
+    std::cout << "\n=== Test 1: MLP export and interpreter ===" << std::endl;
+    MLP::Options options;
+    options.batch_norm = true;
+    options.dropout = 0.2;
+    MLP mlp(12, {16, 8, 3}, options);
+    for (auto& norm : mlp.norms) {
+        norm.running_mean = Eigen::MatrixXd::Random(1, norm.running_mean.cols());
+        norm.running_var = Eigen::MatrixXd::Random(1, norm.running_var.cols()).array().abs() + 0.5;
+        norm.gamma->data = Eigen::MatrixXd::Random(1, norm.gamma->data.cols());
+    }
+    const Eigen::MatrixXd x = Eigen::MatrixXd::Random(4, 12);
+    IRGraph mlp_graph;
+    const bool traced = trace(mlp, x, mlp_graph);
+    std::cout << "Traced: " << (traced ? "true" : "false") << " with " << mlp_graph.nodes.size()
+              << " nodes (expected: true)" << std::endl;
+    std::cout << "Still in training mode: " << (mlp.training ? "true" : "false") << " (expected: true)" << std::endl;
+    check(traced, "MLP traced");
+    check(mlp.training, "trace restores training mode");
+    mlp.eval();
+    const Eigen::MatrixXd expected = mlp.predict(x);
+    mlp.train();
+    std::cout << "Interpreter vs predict: " << (mlp_graph.run({x}) - expected).cwiseAbs().maxCoeff()
+              << " (expected: ~0)" << std::endl;
+    check((mlp_graph.run({x}) - expected).cwiseAbs().maxCoeff() < 1e-12, "interpreter vs predict");
+
+    // Test 2: A graph using the remaining ops
+    std::cout << "\n=== Test 2: Op coverage ===" << std::endl;
+    Value a(Eigen::MatrixXd::Random(3, 5));
+    Value w(Eigen::MatrixXd::Random(5, 4));
+    Value bias(Eigen::MatrixXd::Random(1, 4));
+    Value h = a.matmul(w) + bias;
+    Value u = ((h * 2.0 + 1.0).pow(2.0) / (h.sigmoid() + 1.0) - h.tanh()).leaky_relu(0.1);
+    Value v = (u.gelu() * h.silu()).relu() + h.softmax().cast(Precision::BF16) + h.cast(Precision::FP16);
+    Value t = v.transpose().reshape(6, 2).sum_to(1, 2).broadcast_to(3, 2) - bias.sum_to(1, 1).broadcast_to(3, 2);
+    Value y = t.cast(Precision::FP32) + v.reshape(2, 6).sum_to(2, 1).broadcast_to(2, 3).transpose();
+    IRGraph ops_graph;
+    const bool exported = export_graph(y, {&a}, ops_graph);
+    std::cout << "Exported: " << (exported ? "true" : "false") << " (expected: true)" << std::endl;
+    std::cout << "Interpreter vs engine: " << (ops_graph.run({a.data}) - y.data).cwiseAbs().maxCoeff()
+              << " (expected: ~0)" << std::endl;
+    check(exported, "op coverage graph exported");
+    check((ops_graph.run({a.data}) - y.data).cwiseAbs().maxCoeff() < 1e-12, "interpreter vs engine");
+
+    // Test 3: Ops without a fixed inference form are rejected
+    std::cout << "\n=== Test 3: Unsupported graphs ===" << std::endl;
+    Value train_x(x);
+    Value train_y = mlp.forward(train_x);
+    IRGraph rejected;
+    const bool train_exported = export_graph(train_y, {&train_x}, rejected);
+    std::cout << "Training-mode MLP exported: " << (train_exported ? "true" : "false") << " (expected: false)"
+              << std::endl;
+    check(!train_exported, "training-mode MLP rejected");
+    RNN rnn(3, 4);
+    Value seq(Eigen::MatrixXd::Random(6, 3));
+    const bool rnn_exported = export_graph(rnn.forward(seq, 2), {&seq}, rejected);
+    std::cout << "RNN exported: " << (rnn_exported ? "true" : "false") << " (expected: false)" << std::endl;
+    check(!rnn_exported, "RNN rejected");
+
+    // Test 4: Save and load
+    std::cout << "\n=== Test 4: Serialization ===" << std::endl;
+    const std::string path = "test_graph_ir.mgir";
+    IRGraph loaded;
+    const bool round_trip = mlp_graph.save(path) && loaded.load(path);
+    std::cout << "Round trip: " << (round_trip ? "true" : "false") << " (expected: true)" << std::endl;
+    std::cout << "Loaded graph vs predict: " << (loaded.run({x}) - expected).cwiseAbs().maxCoeff()
+              << " (expected: ~0)" << std::endl;
+    check(round_trip, "save/load round trip");
+    check((loaded.run({x}) - expected).cwiseAbs().maxCoeff() < 1e-12, "loaded graph vs predict");
+    std::remove(path.c_str());
+
+    // Test 5: Generated C++
+    std::cout << "\n=== Test 5: Code generation ===" << std::endl;
+    Eigen::MatrixXd generated;
+    double micros = 0.0;
+    if (std::system("c++ --version >/dev/null 2>&1") != 0) {
+        std::cout << "No C++ compiler available; skipped" << std::endl;
+    } else {
+        const bool built = run_generated(mlp_graph, x, generated, micros, "test_graph_ir_mlp");
+        std::cout << "Generated MLP built and ran: " << (built ? "true" : "false") << " (expected: true)" << std::endl;
+        std::cout << "MLP generated vs predict: " << (generated - expected).cwiseAbs().maxCoeff() << " (expected: ~0)"
+                  << std::endl;
+        check(built, "generated MLP built and ran");
+        check(built && (generated - expected).cwiseAbs().maxCoeff() < 1e-10, "generated MLP vs predict");
+        const bool ops_built = run_generated(ops_graph, a.data, generated, micros, "test_graph_ir_ops");
+        std::cout << "Op coverage generated vs engine: " << (generated - y.data).cwiseAbs().maxCoeff()
+                  << " (expected: ~0)" << std::endl;
+        check(ops_built && (generated - y.data).cwiseAbs().maxCoeff() < 1e-10, "generated op coverage vs engine");
+
+        // 784-128-10 inference on one sample, the edge deployment case
+        Sequential net(784);
+        net.linear(128, Activation::GELU).linear(64, Activation::LeakyReLU).linear(10).activation(Activation::Sigmoid);
+        const Eigen::MatrixXd sample = Eigen::MatrixXd::Random(1, 784);
+        IRGraph net_graph;
+        trace(net, sample, net_graph);
+        const bool net_built = run_generated(net_graph, sample, generated, micros, "test_graph_ir_net");
+        net.eval();
+        const int reps = 200;
+        Eigen::MatrixXd reference;
+        const auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < reps; ++r) {
+            reference = net.predict(sample);
+        }
+        const double predict_micros =
+            std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / reps;
+        std::cout << "Sequential generated vs predict: " << (generated - reference).cwiseAbs().maxCoeff()
+                  << " (expected: ~0)" << std::endl;
+        check(net_built && (generated - reference).cwiseAbs().maxCoeff() < 1e-10, "generated Sequential vs predict");
+        std::cout << std::fixed << std::setprecision(1) << "Generated (-O2): " << micros
+                  << " us per sample, Sequential::predict (this build): " << predict_micros << " us" << std::endl;
+    }
+
+    return finish();
+}
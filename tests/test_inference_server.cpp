@@ -0,0 +1,202 @@
+#include <iostream>
+#include <iomanip>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "nn.hpp"
+#include "inference_server.hpp"
+#include "check.hpp"
+
+using namespace micrograd;
+
+namespace {
+
+// Connected client socket, or -1
+int connect_to(const std::string& socket_path) {
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool send_request(const int fd, const Eigen::RowVectorXd& sample) {
+    const uint32_t count = sample.size();
+    return ::write(fd, &count, sizeof(count)) == sizeof(count) &&
+           ::write(fd, sample.data(), count * sizeof(double)) == static_cast<ssize_t>(count * sizeof(double));
+}
+
+bool closed_by_server(const int fd) {
+    char byte;
+    return ::read(fd, &byte, 1) == 0;
+}
+
+// Sends a request header announcing `count` features and reports whether the server closed the connection
+bool server_hangs_up(const std::string& socket_path, const uint32_t count) {
+    const int fd = connect_to(socket_path);
+    const bool closed = fd >= 0 && ::write(fd, &count, sizeof(count)) == sizeof(count) && closed_by_server(fd);
+    ::close(fd);
+    return closed;
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Testing batched inference server..." << std::endl;
+
+    MLP model(16, {32, 4});
+    const int num_requests = 500;
+    Eigen::MatrixXd inputs = Eigen::MatrixXd::Random(num_requests, 16);
+    Eigen::MatrixXd expected = model.predict(inputs);
+
+    // Test 1: Concurrent submissions are batched and answered per request
+    std::cout << "\n=== Test 1: Dynamic batching ===" << std::endl;
+    InferenceServer::Options options;
+    options.max_batch_size = 64;
+    options.max_delay_us = 2000;
+    options.num_workers = 2;
+    InferenceServer server(model, options);
+
+    std::vector<std::future<Eigen::RowVectorXd>> results;
+    for (int i = 0; i < num_requests; ++i) {
+        results.push_back(server.submit(inputs.row(i)));
+    }
+
+    double max_error = 0.0;
+    for (int i = 0; i < num_requests; ++i) {
+        max_error = std::max(max_error, (results[i].get() - expected.row(i)).cwiseAbs().maxCoeff());
+    }
+
+    InferenceStats stats = server.stats();
+    std::cout << "Requests: " << stats.requests << " (expected: " << num_requests << ")" << std::endl;
+    std::cout << "Batches: " << stats.batches << ", mean batch size: " << std::fixed << std::setprecision(1)
+              << stats.mean_batch_size() << std::endl;
+    std::cout << "Max queue depth: " << stats.max_queue_depth << std::endl;
+    std::cout << "p50 latency <= " << stats.latency_percentile_us(50) << "us, p99 latency <= "
+              << stats.latency_percentile_us(99) << "us" << std::endl;
+    std::cout << "Max abs error vs MLP::predict: " << std::scientific << max_error << " (expected: ~0)" << std::endl;
+    check(stats.requests == num_requests, "every request answered");
+    check(stats.batches < num_requests, "requests were batched");
+    check(max_error < 1e-12, "outputs match MLP::predict");
+
+    // Test 2: Samples of the wrong width are refused instead of batched
+    std::cout << "\n=== Test 2: Input width ===" << std::endl;
+    int refused = 0;
+    for (const int width : {8, 17}) {
+        try {
+            server.submit(Eigen::RowVectorXd::Random(width)).get();
+        } catch (const std::invalid_argument&) {
+            ++refused;
+        }
+    }
+    const double after_error = (server.infer(inputs.row(1)) - expected.row(1)).cwiseAbs().maxCoeff();
+    std::cout << "Refused: " << refused << " of 2 (expected: 2)" << std::endl;
+    check(refused == 2, "wrong widths rejected");
+    check(after_error < 1e-12, "server still answers after a rejection");
+
+    // Test 3: Unix socket front end
+    std::cout << "\n=== Test 3: Unix socket front end ===" << std::endl;
+    const std::string socket_path = "/tmp/micrograd_test_inference.sock";
+    UnixSocketFrontend frontend(server, socket_path);
+    if (!frontend.start()) {
+        std::cerr << "Failed to start socket front end" << std::endl;
+        return 1;
+    }
+
+    // Oversized headers are refused before the server allocates for them
+    const bool huge_refused = server_hangs_up(socket_path, 0xFFFFFFFFu);
+    const bool wide_refused = server_hangs_up(socket_path, 17);
+
+    // A client that leaves before its reply must not take the server down with SIGPIPE
+    for (int i = 0; i < 5; ++i) {
+        const int fd = connect_to(socket_path);
+        send_request(fd, inputs.row(i));
+        ::close(fd);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    Eigen::RowVectorXd output;
+    const bool ok = unix_socket_infer(socket_path, inputs.row(0), output);
+
+    if (!ok) {
+        std::cerr << "Socket request failed" << std::endl;
+        return 1;
+    }
+    const double socket_error = (output - expected.row(0)).cwiseAbs().maxCoeff();
+    std::cout << "Socket output error: " << socket_error << " (expected: ~0)" << std::endl;
+    std::cout << "Oversized requests closed: " << (huge_refused && wide_refused ? "yes" : "no") << " (expected: yes)"
+              << std::endl;
+    check(socket_error < 1e-12, "socket output matches MLP::predict");
+    check(huge_refused && wide_refused, "oversized requests close the connection");
+
+    // Test 4: Stopping the server under a connected client closes the connection
+    std::cout << "\n=== Test 4: Server stopped under a client ===" << std::endl;
+    const int waiting = connect_to(socket_path);
+    server.stop();
+    const bool stopped_closed = send_request(waiting, inputs.row(0)) && closed_by_server(waiting);
+    ::close(waiting);
+    const bool refused_after_stop = !unix_socket_infer(socket_path, inputs.row(0), output);
+    frontend.stop();
+    std::cout << "Connection closed after stop: " << (stopped_closed && refused_after_stop ? "yes" : "no")
+              << " (expected: yes)" << std::endl;
+    check(stopped_closed, "request on a stopped server closes the connection");
+    check(refused_after_stop, "new requests fail after stop");
+
+    // Test 5: A front end can be destroyed as soon as stop() returns, with clients still connected
+    std::cout << "\n=== Test 5: Destroy after stop ===" << std::endl;
+    InferenceServer live_server(model);
+    int answered = 0;
+    for (int round = 0; round < 20; ++round) {
+        auto temporary = std::make_unique<UnixSocketFrontend>(live_server, socket_path);
+        if (!temporary->start()) {
+            break;
+        }
+        const int idle = connect_to(socket_path);
+        answered += unix_socket_infer(socket_path, inputs.row(round), output) ? 1 : 0;
+        temporary->stop();
+        temporary.reset();
+        ::close(idle);
+    }
+    std::cout << "Rounds answered: " << answered << " (expected: 20)" << std::endl;
+    check(answered == 20, "front ends stop and are destroyed cleanly");
+
+    // Test 6: Workers that time out after another worker drained the queue go back to waiting
+    std::cout << "\n=== Test 6: Several workers with a batching delay ===" << std::endl;
+    InferenceServer::Options shared_options;
+    shared_options.max_batch_size = 64;
+    shared_options.max_delay_us = 2000;
+    shared_options.num_workers = 4;
+    double shared_error = 0.0;
+    int shared_answered = 0;
+    {
+        InferenceServer shared_server(model, shared_options);
+        for (int round = 0; round < 20; ++round) {
+            std::vector<std::future<Eigen::RowVectorXd>> pending;
+            for (int i = 0; i < 8; ++i) {
+                pending.push_back(shared_server.submit(inputs.row(round * 8 + i)));
+            }
+            for (int i = 0; i < 8; ++i) {
+                const Eigen::RowVectorXd row = pending[i].get();
+                shared_error = std::max(shared_error, (row - expected.row(round * 8 + i)).cwiseAbs().maxCoeff());
+                shared_answered++;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(3000));
+        }
+    }
+    std::cout << "Answered: " << shared_answered << " (expected: 160), max error: " << shared_error << std::endl;
+    check(shared_answered == 160, "every request answered with four workers");
+    check(shared_error < 1e-12, "outputs match MLP::predict with four workers");
+
+    return finish();
+}
@@ -0,0 +1,148 @@
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+#include "engine.hpp"
+#include "autodiff.hpp"
+#include "nn.hpp"
+#include "loss.hpp"
+#include "optimizer.hpp"
+#include "check.hpp"
+
+using namespace micrograd;
+
+int main() {
+    std::cout << "Testing BatchNorm1d and Dropout..." << std::endl;
+    std::cout << std::scientific << std::setprecision(2);
+
+    // Test 1: Training-mode batch norm output statistics and gradient
+    std::cout << "\n=== Test 1: BatchNorm1d training mode ===" << std::endl;
+    BatchNorm1d bn(4);
+    bn.gamma->data << 1.0, 2.0, 0.5, 1.5;
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(8, 4) * 3.0;
+    X.rowwise() += Eigen::RowVector4d(1.0, -2.0, 5.0, 0.0);
+    Eigen::MatrixXd W = Eigen::MatrixXd::Random(8, 4);
+
+    Value x(X);
+    Value y = bn.forward(x);
+    Eigen::MatrixXd normalized = (y.data.array().rowwise() / bn.gamma->data.row(0).array()).matrix();
+    std::cout << "Max |column mean|: " << normalized.colwise().mean().cwiseAbs().maxCoeff() << " (expected: ~0)"
+              << std::endl;
+    check(normalized.colwise().mean().cwiseAbs().maxCoeff() < 1e-12, "normalized columns have zero mean");
+
+    // Loss = sum(W * bn(x)); compare dL/dx with central differences
+    auto loss_at = [&](const Eigen::MatrixXd& input) {
+        BatchNorm1d probe = bn;
+        return (probe.forward(Value(input)).data.array() * W.array()).sum();
+    };
+    Value loss = (bn.forward(x) * Value(W)).sum();
+    Eigen::MatrixXd dx = grad(loss, {&x})[0].data;
+
+    const double h = 1e-6;
+    double max_error = 0.0;
+    for (int i = 0; i < X.size(); ++i) {
+        Eigen::MatrixXd xp = X, xm = X;
+        xp(i) += h;
+        xm(i) -= h;
+        max_error = std::max(max_error, std::abs((loss_at(xp) - loss_at(xm)) / (2 * h) - dx(i)));
+    }
+    std::cout << "Max input gradient error: " << max_error << " (expected: < 1e-6)" << std::endl;
+    check(max_error < 1e-6, "batch norm input gradient");
+
+    // Test 2: Eval mode uses running statistics and matches predict
+    std::cout << "\n=== Test 2: BatchNorm1d eval mode ===" << std::endl;
+    bn.eval();
+    Value y_eval = bn.forward(x);
+    std::cout << "forward vs predict: " << (y_eval.data - bn.predict(X)).cwiseAbs().maxCoeff() << " (expected: ~0)"
+              << std::endl;
+    check((y_eval.data - bn.predict(X)).cwiseAbs().maxCoeff() < 1e-12, "eval forward matches predict");
+
+    // Test 3: Dropout keeps about 1 - p of the elements, rescaled, and is the identity in eval mode
+    std::cout << "\n=== Test 3: Dropout ===" << std::endl;
+    Dropout dropout(0.25);
+    Value ones(Eigen::MatrixXd::Ones(200, 100));
+    Value dropped = dropout.forward(ones);
+    const double kept = (dropped.data.array() > 0.0).cast<double>().mean();
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Kept fraction: " << kept << " (expected: ~0.750)" << std::endl;
+    std::cout << "Kept value: " << dropped.data.maxCoeff() << " (expected: 1.333)" << std::endl;
+    check_near(kept, 0.75, 0.02, "kept fraction");
+    check_near(dropped.data.maxCoeff(), 1.0 / 0.75, 1e-12, "kept value");
+    dropped.sum().backward();
+    std::cout << "Gradient matches mask: " << (ones.grad.isApprox(dropped.data) ? "yes" : "no") << " (expected: yes)"
+              << std::endl;
+    check(ones.grad.isApprox(dropped.data), "dropout gradient matches mask");
+    dropout.eval();
+    std::cout << "Eval mode changes input: " << (dropout.forward(ones).data.isApprox(ones.data) ? "no" : "yes")
+              << " (expected: no)" << std::endl;
+    check(dropout.forward(ones).data.isApprox(ones.data), "eval-mode dropout is the identity");
+    int rejected = 0;
+    for (const double bad : {1.0, 1.5, -0.1}) {
+        try {
+            Dropout invalid(bad);
+        } catch (const std::invalid_argument&) {
+            ++rejected;
+        }
+    }
+    std::cout << "Invalid probabilities rejected: " << rejected << " of 3 (expected: 3)" << std::endl;
+    check(rejected == 3, "dropout rejects p outside [0, 1)");
+
+    // Test 4: MLP with batch norm and dropout trains, and buffers round-trip through save/load
+    std::cout << "\n=== Test 4: MLP with batch norm and dropout ===" << std::endl;
+    MLP::Options options;
+    options.batch_norm = true;
+    options.dropout = 0.1;
+    MLP model(6, {32, 3}, options);
+    CrossEntropyLoss criterion;
+    NesterovSGD optimizer(model.parameters(), 0.2, 0.9);
+
+    Eigen::MatrixXd data = Eigen::MatrixXd::Random(64, 6);
+    Eigen::VectorXi labels(64);
+    for (int i = 0; i < 64; ++i) {
+        labels(i) = data(i, 0) > 0.3 ? 0 : (data(i, 1) > 0.0 ? 1 : 2);
+    }
+
+    double first_loss = 0.0, last_loss = 0.0;
+    for (int step = 0; step < 100; ++step) {
+        optimizer.zero_grad();
+        Value out = criterion.forward(model.forward(Value(data)), labels);
+        out.backward();
+        optimizer.step();
+        (step == 0 ? first_loss : last_loss) = out.data(0, 0);
+    }
+    std::cout << "Loss: " << first_loss << " -> " << last_loss << " (expected: decreasing)" << std::endl;
+    check(last_loss < first_loss, "loss decreased");
+
+    model.eval();
+    model.save_weights("/tmp/micrograd_test_bn.bin");
+    MLP loaded(6, {32, 3}, options);
+    loaded.load_weights("/tmp/micrograd_test_bn.bin");
+    std::cout << std::scientific << std::setprecision(2);
+    std::cout << "Loaded model output difference: " << (loaded.predict(data) - model.predict(data)).cwiseAbs().maxCoeff()
+              << " (expected: ~0)" << std::endl;
+    check((loaded.predict(data) - model.predict(data)).cwiseAbs().maxCoeff() < 1e-12, "loaded model output");
+
+    // Test 5: Once warm, batch norm and dropout steps take every buffer from the pool and return it
+    std::cout << "\n=== Test 5: Pooled buffers ===" << std::endl;
+    BatchNorm1d pooled_bn(37);
+    Dropout pooled_dropout(0.3);
+    Eigen::MatrixXd batch = Eigen::MatrixXd::Random(50, 37);
+    auto pooled_step = [&]() {
+        Value input(batch);
+        pooled_dropout.forward(pooled_bn.forward(input)).sum().backward();
+    };
+    for (int i = 0; i < 3; ++i) {
+        pooled_step();
+    }
+    const long long live_before = pool_stats().bytes_live;
+    reset_pool_stats();
+    for (int i = 0; i < 10; ++i) {
+        pooled_step();
+    }
+    const PoolStats pooled = pool_stats();
+    std::cout << "Heap allocations over 10 steps: " << pooled.heap_allocations() << " (expected: 0)" << std::endl;
+    std::cout << "Bytes still live: " << pooled.bytes_live - live_before << " (expected: 0)" << std::endl;
+    check(pooled.heap_allocations() == 0, "batch norm and dropout reuse pooled buffers");
+    check(pooled.bytes_live == live_before, "batch norm and dropout return their buffers");
+
+    return finish();
+}
@@ -0,0 +1,148 @@
+#include <iostream>
+#include <cmath>
+#include <fstream>
+#include <unistd.h>
+#include "engine.hpp"
+#include "nn.hpp"
+#include "loss.hpp"
+#include "optimizer.hpp"
+#include "check.hpp"
+
+using namespace micrograd;
+
+// Resident set size in KiB, from /proc/self/statm
+long resident_kb() {
+    std::ifstream statm("/proc/self/statm");
+    long size = 0, resident = 0;
+    statm >> size >> resident;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+int main() {
+    std::cout << "Testing graph memory release..." << std::endl;
+
+    MLP model(32, {64, 10});
+    CrossEntropyLoss criterion;
+    SGD optimizer(model.parameters(), 0.01);
+
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(16, 32);
+    Eigen::VectorXi y = Eigen::VectorXi::LinSpaced(16, 0, 15).unaryExpr([](int i) { return i % 10; });
+
+    auto step = [&]() {
+        optimizer.zero_grad();
+        Value inputs(X);
+        Value loss = criterion.forward(model.forward(inputs), y);
+        loss.backward();
+        optimizer.step();
+    };
+
+    // Test 1: A training step leaves no graph nodes behind
+    std::cout << "\n=== Test 1: Live values per step ===" << std::endl;
+    const long long baseline = Value::live_count();
+    step();
+    std::cout << "Live values after one step: " << Value::live_count() - baseline << " (expected: 0)" << std::endl;
+    check(Value::live_count() == baseline, "no values left after one step");
+
+    // Test 2: Memory stays flat over a long run
+    std::cout << "\n=== Test 2: 10000 training steps ===" << std::endl;
+    for (int i = 0; i < 1000; ++i) {
+        step();
+    }
+    const long rss_before = resident_kb();
+    for (int i = 0; i < 10000; ++i) {
+        step();
+    }
+    const long rss_after = resident_kb();
+    std::cout << "Live values after 10000 steps: " << Value::live_count() - baseline << " (expected: 0)" << std::endl;
+    std::cout << "RSS growth: " << rss_after - rss_before << " KiB (expected: ~0)" << std::endl;
+    check(Value::live_count() == baseline, "no values left after 10000 steps");
+    check(rss_after - rss_before < 4096, "RSS stays flat");
+
+    // Test 3: retain_graph keeps the graph for a second backward pass
+    std::cout << "\n=== Test 3: retain_graph ===" << std::endl;
+    Value a(3.0);
+    Value c = a * a;
+    c.backward(true);
+    const double first = a.grad(0, 0);
+    c.backward();
+    std::cout << "dc/da after two backward passes: " << first << ", " << a.grad(0, 0) << " (expected: 6, 12)"
+              << std::endl;
+    check(first == 6.0 && a.grad(0, 0) == 12.0, "gradients accumulate over retained graph");
+
+    // Test 4: Backward after an update sees the updated data
+    std::cout << "\n=== Test 4: Updated parameter ===" << std::endl;
+    Value p(3.0);
+    SGD sgd({&p}, 0.1);
+    bool grads_follow = true;
+    for (int i = 0; i < 3; ++i) {
+        sgd.zero_grad();
+        Value loss = p * p;
+        loss.backward();
+        const double value = p.data(0, 0);
+        std::cout << "p = " << value << ", dp = " << p.grad(0, 0) << " (expected: " << 2 * value << ")" << std::endl;
+        grads_follow = grads_follow && p.grad(0, 0) == 2 * value;
+        sgd.step();
+    }
+    check(grads_follow, "gradient uses the updated parameter");
+
+    // Test 5: A graph whose result feeds another live graph is not cut
+    std::cout << "\n=== Test 5: Shared graph ===" << std::endl;
+    Value x(2.0);
+    Value square = x * x;
+    Value first_use = square * 3.0;
+    Value second_use = square * 5.0;
+    bool threw = false;
+    try {
+        first_use.release_graph();
+    } catch (const std::logic_error&) {
+        threw = true;
+    }
+    second_use.backward(true);
+    std::cout << "Releasing a shared graph threw: " << (threw ? "yes" : "no") << " (expected: yes)" << std::endl;
+    std::cout << "dz/dx afterwards: " << x.grad(0, 0) << " (expected: 20)" << std::endl;
+    check(threw, "release of a shared graph throws");
+    check(x.grad(0, 0) == 20.0, "other graph still differentiates");
+
+    // Test 6: An old copy of a parameter computes and differentiates with its own data
+    std::cout << "\n=== Test 6: Stale copy of a parameter ===" << std::endl;
+    Layer layer(3, 2, false);
+    Value old = *layer.w;
+    layer.w->data.setConstant(7.0);
+    layer.w->zero_grad();
+    Value weighted = (old * old).sum();
+    weighted.backward();
+    std::cout << "Parameter after using the copy: " << layer.w->data(0, 0) << " (expected: 7)" << std::endl;
+    std::cout << "d/dcopy: " << old.grad(0, 0) << " (expected: " << 2 * old.data(0, 0) << ")" << std::endl;
+    check((layer.w->data.array() == 7.0).all(), "parameter keeps its updated data");
+    check(std::abs(weighted.data(0, 0) - old.data.squaredNorm()) < 1e-12, "forward uses the copy's data");
+    check(old.grad.isApprox(2 * old.data), "backward uses the copy's data");
+    check(layer.w->grad.isZero(), "parameter gets no gradient from the copy");
+
+    // Test 7: Updating a value whose node an earlier graph still holds
+    std::cout << "\n=== Test 7: Updated value held by a live graph ===" << std::endl;
+    Value q(3.0), r(2.0);
+    Value earlier = q * r;
+    q.data(0, 0) = 10.0;
+    Value later = q * r;
+    later.backward();
+    std::cout << "y = " << later.data(0, 0) << " (expected: 20), dy/dr = " << r.grad(0, 0) << " (expected: 10)"
+              << std::endl;
+    check(later.data(0, 0) == 20.0, "forward uses the updated data");
+    check(r.grad(0, 0) == 10.0 && q.grad(0, 0) == 2.0, "backward uses the updated data");
+    earlier.backward();
+    std::cout << "Earlier graph dy/dr = " << r.grad(0, 0) - 10.0 << " (expected: 3)" << std::endl;
+    check(r.grad(0, 0) == 13.0, "earlier graph keeps the data it was built with");
+
+    // Test 8: A model without layers passes its input through
+    std::cout << "\n=== Test 8: Empty model ===" << std::endl;
+    MLP empty(3, {});
+    Value through(Eigen::MatrixXd::Constant(2, 3, 1.5));
+    Value passed = empty.forward(through);
+    passed.sum().backward();
+    std::cout << "Output equals input: " << (passed.data.isApprox(through.data) ? "yes" : "no") << " (expected: yes)"
+              << std::endl;
+    check(passed.data.isApprox(through.data), "empty model forward is the identity");
+    check((through.grad.array() == 1.0).all(), "empty model passes the gradient through");
+
+    return finish();
+}
@@ -0,0 +1,137 @@
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <iomanip>
+#include "engine.hpp"
+#include "memory_pool.hpp"
+#include "nn.hpp"
+#include "loss.hpp"
+#include "optimizer.hpp"
+#include "random.hpp"
+#include "check.hpp"
+
+// Every heap allocation, counted by wrapping glibc's allocator as test_perf
+// does: Eigen calls malloc directly and operator new goes through it too
+static std::atomic<long long> allocations{0};
+
+extern "C" void* __libc_malloc(std::size_t size);
+
+extern "C" void* malloc(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+using namespace micrograd;
+
+int main() {
+    std::cout << "Testing the memory pool..." << std::endl;
+    manual_seed(5);
+
+    // Test 1: Buffers come back from the pool
+    std::cout << "\n=== Test 1: Matrix buffers ===" << std::endl;
+    clear_pool();
+    reset_pool_stats();
+    Eigen::MatrixXd a = pool_zeros(3, 4);
+    const double* buffer = a.data();
+    pool_release(a);
+    std::cout << "Released matrix is empty: " << (a.size() == 0 ? "true" : "false") << " (expected: true)"
+              << std::endl;
+    check(a.size() == 0, "released matrix is empty");
+    Eigen::MatrixXd b = pool_acquire(4, 3);
+    std::cout << "Same-size request reuses the buffer: " << (b.data() == buffer ? "true" : "false")
+              << " (expected: true)" << std::endl;
+    std::cout << "Requests: " << pool_stats().requests << ", hits: " << pool_stats().hits << " (expected: 2, 1)"
+              << std::endl;
+    check(b.data() == buffer, "same-size request reuses the buffer");
+    check(pool_stats().requests == 2 && pool_stats().hits == 1, "requests and hits");
+    {
+        PooledMatrix kept(std::move(b));
+        PooledMatrix copy(kept);
+        std::cout << "Copy has its own buffer: " << (copy.matrix.data() != kept.matrix.data() ? "true" : "false")
+                  << " (expected: true)" << std::endl;
+        check(copy.matrix.data() != kept.matrix.data(), "copy has its own buffer");
+    }
+    std::cout << "Bytes live after PooledMatrix scope: " << pool_stats().bytes_live << " (expected: 0)" << std::endl;
+    std::cout << "Bytes cached: " << pool_stats().bytes_cached << " (expected: 192)" << std::endl;
+    check(pool_stats().bytes_live == 0, "bytes live after PooledMatrix scope");
+    check(pool_stats().bytes_cached == 192, "bytes cached");
+    Eigen::MatrixXd foreign = Eigen::MatrixXd::Ones(5, 5);
+    pool_release(foreign);
+    std::cout << "Bytes live after releasing a matrix the pool never handed out: " << pool_stats().bytes_live
+              << " (expected: 0)" << std::endl;
+    check(pool_stats().bytes_live == 0, "foreign release leaves bytes live unchanged");
+    clear_pool();
+    std::cout << "Bytes cached after clear_pool: " << pool_stats().bytes_cached << " (expected: 0)" << std::endl;
+    check(pool_stats().bytes_cached == 0, "bytes cached after clear_pool");
+
+    // Test 2: Steady-state training stops missing the pool after the first steps
+    std::cout << "\n=== Test 2: Training loop ===" << std::endl;
+    MLP model(20, {16, 4});
+    CrossEntropyLoss criterion;
+    NesterovSGD optimizer(model.parameters(), 0.05, 0.9);
+    const Eigen::MatrixXd X = Eigen::MatrixXd::Random(8, 20);
+    const Eigen::VectorXi y = Eigen::VectorXi::LinSpaced(8, 0, 7).unaryExpr([](int i) { return i % 4; });
+    auto step = [&]() {
+        optimizer.zero_grad();
+        Value inputs(X);
+        Value loss = criterion.forward(model.forward(inputs), y);
+        loss.backward();
+        optimizer.step();
+        return loss.data(0, 0);
+    };
+    const double first_loss = step();
+    step();
+    reset_pool_stats();
+    const long long live_before = pool_stats().bytes_live;
+    double last_loss = 0.0;
+    const long long allocations_before = allocations.load();
+    for (int i = 0; i < 10; ++i) {
+        last_loss = step();
+    }
+    const long long step_allocations = allocations.load() - allocations_before;
+    const PoolStats stats = pool_stats();
+    std::cout << "Pool requests over 10 steps: " << stats.requests << " (expected: > 0)" << std::endl;
+    std::cout << "Pool misses over 10 steps: " << stats.heap_allocations() << " (expected: 0)" << std::endl;
+    std::cout << "malloc calls over 10 steps: " << step_allocations << " (expected: 0)" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Hit rate: " << stats.hit_rate() << " (expected: 1.000)" << std::endl;
+    std::cout << "Bytes live unchanged across steps: " << (stats.bytes_live == live_before ? "true" : "false")
+              << " (expected: true)" << std::endl;
+    std::cout << "Loss decreased: " << first_loss << " -> " << last_loss << " ("
+              << (last_loss < first_loss ? "true" : "false") << ", expected: true)" << std::endl;
+    check(stats.requests > 0, "training draws from the pool");
+    check(stats.heap_allocations() == 0, "steady-state training never misses the pool");
+    check(step_allocations == 0, "steady-state training allocates nothing outside the pool");
+    check(stats.bytes_live == live_before, "bytes live unchanged across steps");
+    check(last_loss < first_loss, "loss decreased");
+
+    // Test 3: A capped pool frees what it cannot hold
+    std::cout << "\n=== Test 3: Capacity ===" << std::endl;
+    const long long cached_uncapped = pool_stats().bytes_cached;
+    clear_pool();
+    set_pool_capacity(0);
+    step();
+    const long long cached_capped = pool_stats().bytes_cached;
+    std::cout << "Zero capacity caches less: " << cached_uncapped << " -> " << cached_capped << " ("
+              << (cached_capped < cached_uncapped ? "true" : "false") << ", expected: true)" << std::endl;
+    check(cached_capped < cached_uncapped, "zero capacity caches less");
+    set_pool_capacity(std::size_t(1) << 30);
+
+    // Test 4: Replacing a Value's data by assignment leaves nothing counted as live
+    std::cout << "\n=== Test 4: Reassigned data ===" << std::endl;
+    const Eigen::MatrixXd square = Eigen::MatrixXd::Random(6, 6);
+    const long long live_start = pool_stats().bytes_live;
+    // The replaced buffers are kept, so the heap cannot hand their addresses out again
+    std::vector<Eigen::MatrixXd> replaced;
+    for (int i = 0; i < 100; ++i) {
+        Value v(square);
+        Eigen::MatrixXd doubled = square * 2.0;
+        v.data.swap(doubled);
+        replaced.push_back(std::move(doubled));
+    }
+    std::cout << "Bytes live after 100 reassigned values: " << pool_stats().bytes_live - live_start
+              << " (expected: 0)" << std::endl;
+    check(pool_stats().bytes_live == live_start, "reassigned data does not drift bytes live");
+
+    return finish();
+}
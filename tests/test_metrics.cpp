@@ -0,0 +1,101 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include "metrics.hpp"
+#include "parallel.hpp"
+#include "check.hpp"
+
+using namespace micrograd;
+
+int main() {
+    std::cout << "Testing streaming metrics..." << std::endl;
+
+    const int n = 2000;
+    const int classes = 10;
+    Eigen::MatrixXd logits = Eigen::MatrixXd::Random(n, classes) * 3.0;
+    Eigen::VectorXi labels(n);
+    for (int i = 0; i < n; ++i) {
+        labels(i) = (i * 7) % classes;
+        // Make the model right most of the time
+        if (i % 3 != 0) {
+            logits(i, labels(i)) += 4.0;
+        }
+    }
+
+    // Reference values from explicit softmax probabilities
+    int correct = 0, top3 = 0;
+    double loss = 0.0;
+    Eigen::VectorXd bin_count = Eigen::VectorXd::Zero(15), bin_correct = bin_count, bin_conf = bin_count;
+    for (int i = 0; i < n; ++i) {
+        Eigen::RowVectorXd p = (logits.row(i).array() - logits.row(i).maxCoeff()).exp();
+        p /= p.sum();
+        int pred;
+        const double conf = p.maxCoeff(&pred);
+        correct += pred == labels(i);
+        int rank = 0;
+        for (int j = 0; j < classes; ++j) {
+            rank += logits(i, j) > logits(i, labels(i));
+        }
+        top3 += rank < 3;
+        loss -= std::log(p(labels(i)));
+        const int b = std::min(14, static_cast<int>(conf * 15));
+        bin_count(b) += 1;
+        bin_correct(b) += pred == labels(i);
+        bin_conf(b) += conf;
+    }
+    const double ece = (bin_correct - bin_conf).cwiseAbs().sum() / n;
+
+    // Test 1: Streaming over uneven batches matches the reference
+    std::cout << "\n=== Test 1: Streaming batches ===" << std::endl;
+    Metrics metrics(classes);
+    for (int start = 0; start < n; start += 300) {
+        const int size = std::min(300, n - start);
+        metrics.update(logits.middleRows(start, size), labels.segment(start, size));
+    }
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "Count: " << metrics.count() << " (expected: " << n << ")" << std::endl;
+    std::cout << "Accuracy: " << metrics.accuracy() << " (expected: " << static_cast<double>(correct) / n << ")"
+              << std::endl;
+    std::cout << "Top-3: " << metrics.top_k_accuracy(3) << " (expected: " << static_cast<double>(top3) / n << ")"
+              << std::endl;
+    std::cout << "Top-10: " << metrics.top_k_accuracy(10) << " (expected: 1.0000)" << std::endl;
+    std::cout << "Log-loss: " << metrics.log_loss() << " (expected: " << loss / n << ")" << std::endl;
+    std::cout << "ECE: " << metrics.calibration_error() << " (expected: " << ece << ")" << std::endl;
+    std::cout << "Confusion total: " << metrics.confusion_matrix().sum() << ", trace: "
+              << metrics.confusion_matrix().trace() << " (expected: " << n << ", " << correct << ")" << std::endl;
+    check(metrics.count() == n, "count");
+    check_near(metrics.accuracy(), static_cast<double>(correct) / n, 1e-12, "accuracy");
+    check_near(metrics.top_k_accuracy(3), static_cast<double>(top3) / n, 1e-12, "top-3");
+    check_near(metrics.top_k_accuracy(10), 1.0, 1e-12, "top-10");
+    check_near(metrics.log_loss(), loss / n, 1e-9, "log-loss");
+    check_near(metrics.calibration_error(), ece, 1e-9, "ECE");
+    check(metrics.confusion_matrix().sum() == n && metrics.confusion_matrix().trace() == correct, "confusion matrix");
+
+    // Test 2: Per-thread accumulators give the same counts
+    std::cout << "\n=== Test 2: Parallel accumulation ===" << std::endl;
+    set_num_threads(4);
+    Metrics parallel(classes);
+    parallel.update(logits, labels);
+    set_num_threads(1);
+    std::cout << "Same confusion matrix: " << (parallel.confusion_matrix() == metrics.confusion_matrix() ? "yes" : "no")
+              << " (expected: yes)" << std::endl;
+    std::cout << "Log-loss difference: " << std::scientific << std::abs(parallel.log_loss() - metrics.log_loss())
+              << " (expected: ~0)" << std::endl;
+    check(parallel.confusion_matrix() == metrics.confusion_matrix(), "parallel confusion matrix");
+    check_near(parallel.log_loss(), metrics.log_loss(), 1e-12, "parallel log-loss");
+
+    // Test 3: Merging shards
+    std::cout << "\n=== Test 3: Merge ===" << std::endl;
+    Metrics first(classes), second(classes);
+    first.update(logits.topRows(n / 2), labels.head(n / 2));
+    second.update(logits.bottomRows(n - n / 2), labels.tail(n - n / 2));
+    first.merge(second);
+    std::cout << std::fixed;
+    std::cout << "Merged accuracy: " << first.accuracy() << " (expected: " << metrics.accuracy() << ")" << std::endl;
+    check_near(first.accuracy(), metrics.accuracy(), 1e-12, "merged accuracy");
+    first.reset();
+    std::cout << "Count after reset: " << first.count() << " (expected: 0)" << std::endl;
+    check(first.count() == 0, "count after reset");
+
+    return finish();
+}
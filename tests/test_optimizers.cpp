@@ -0,0 +1,170 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include "trainer.hpp"
+#include "random.hpp"
+#include "check.hpp"
+
+using namespace micrograd;
+
+namespace {
+
+Value row(const double a, const double b) {
+    Eigen::MatrixXd m(1, 2);
+    m << a, b;
+    return Value(m);
+}
+
+// Same synthetic data as test_trainer: 0-255 pixels, labelled by the brightest of the first three
+MNISTLoader make_loader(const int n) {
+    MNISTLoader loader;
+    loader.num_images = n;
+    loader.image_rows = 1;
+    loader.image_cols = 6;
+    loader.images = (Eigen::MatrixXd::Random(n, 6).array() + 1.0) * 127.5;
+    loader.labels.resize(n);
+    for (int i = 0; i < n; ++i) {
+        loader.images.row(i).head(3).maxCoeff(&loader.labels(i));
+    }
+    return loader;
+}
+
+double max_difference(MLP& a, MLP& b) {
+    double diff = 0.0;
+    auto pa = a.parameters();
+    auto pb = b.parameters();
+    for (size_t i = 0; i < pa.size(); ++i) {
+        diff = std::max(diff, (pa[i]->data - pb[i]->data).cwiseAbs().maxCoeff());
+    }
+    return diff;
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Testing optimizers and schedules..." << std::endl;
+    std::cout << std::fixed << std::setprecision(6);
+
+    // Test 1: LARS scales each step by eta * ||w|| / (||g|| + wd * ||w||)
+    std::cout << "\n=== Test 1: LARS ===" << std::endl;
+    Value w = row(3.0, 4.0);
+    LARS lars({&w}, 1.0, 0.9, 0.0, 0.1);
+    w.grad = row(0.6, 0.8).data;
+    lars.step();
+    std::cout << "After one step: " << w.data << " (expected: 2.7 3.6)" << std::endl;
+    check_near(w.data(0, 0), 2.7, 1e-12, "LARS step 1, w0");
+    check_near(w.data(0, 1), 3.6, 1e-12, "LARS step 1, w1");
+    // ||w|| = 4.5, so v = 0.9 * (0.3, 0.4) + 0.45 * (0.6, 0.8)
+    lars.step();
+    std::cout << "After two steps: " << w.data << " (expected: 2.16 2.88)" << std::endl;
+    check_near(w.data(0, 0), 2.16, 1e-12, "LARS step 2, w0");
+    check_near(w.data(0, 1), 2.88, 1e-12, "LARS step 2, w1");
+
+    // With weight decay 0.5 the trust ratio is 0.1 * 5 / 3.5 on g + 0.5 w = (2.1, 2.8)
+    Value decayed = row(3.0, 4.0);
+    LARS lars_decay({&decayed}, 1.0, 0.9, 0.5, 0.1);
+    decayed.grad = row(0.6, 0.8).data;
+    lars_decay.step();
+    std::cout << "With weight decay: " << decayed.data << " (expected: 2.7 3.6)" << std::endl;
+    check_near(decayed.data(0, 0), 2.7, 1e-12, "LARS weight decay, w0");
+    check_near(decayed.data(0, 1), 3.6, 1e-12, "LARS weight decay, w1");
+
+    // A zero-initialized bias has no trust ratio, so it steps at the plain rate lr * g
+    Value bias = row(0.0, 0.0);
+    LARS lars_bias({&bias}, 0.1);
+    bias.grad = row(0.5, -0.5).data;
+    lars_bias.step();
+    std::cout << "Zero bias after one step: " << bias.data << " (expected: -0.05 0.05)" << std::endl;
+    check_near(bias.data(0, 0), -0.05, 1e-12, "LARS zero bias, b0");
+    check_near(bias.data(0, 1), 0.05, 1e-12, "LARS zero bias, b1");
+
+    // Test 2: LAMB's bias-corrected step is sign(g) here, scaled to lr * ||w|| / ||update||
+    std::cout << "\n=== Test 2: LAMB ===" << std::endl;
+    Value u = row(3.0, 4.0);
+    LAMB lamb({&u}, 0.1, 0.9, 0.999, 0.0, 0.0);
+    u.grad = row(0.6, -0.8).data;
+    lamb.step();
+    const double first = 0.1 * 5.0 / std::sqrt(2.0);
+    std::cout << "After one step: " << u.data << " (expected: " << 3.0 - first << " " << 4.0 + first << ")"
+              << std::endl;
+    check_near(u.data(0, 0), 3.0 - first, 1e-12, "LAMB step 1, w0");
+    check_near(u.data(0, 1), 4.0 + first, 1e-12, "LAMB step 1, w1");
+    const double second = 0.1 * u.data.norm() / std::sqrt(2.0);
+    const double u0 = u.data(0, 0) - second;
+    const double u1 = u.data(0, 1) + second;
+    lamb.step();
+    std::cout << "After two steps: " << u.data << " (expected: " << u0 << " " << u1 << ")" << std::endl;
+    check_near(u.data(0, 0), u0, 1e-12, "LAMB step 2, w0");
+    check_near(u.data(0, 1), u1, 1e-12, "LAMB step 2, w1");
+
+    // Weight decay is added to the update before the trust ratio: (1.3, -0.6) for w = (3, 4)
+    Value decayed_lamb = row(3.0, 4.0);
+    LAMB lamb_decay({&decayed_lamb}, 0.1, 0.9, 0.999, 0.0, 0.1);
+    decayed_lamb.grad = row(0.6, -0.8).data;
+    lamb_decay.step();
+    const double scale = 0.1 * 5.0 / std::sqrt(1.3 * 1.3 + 0.6 * 0.6);
+    std::cout << "With weight decay: " << decayed_lamb.data << " (expected: " << 3.0 - 1.3 * scale << " "
+              << 4.0 + 0.6 * scale << ")" << std::endl;
+    check_near(decayed_lamb.data(0, 0), 3.0 - 1.3 * scale, 1e-12, "LAMB weight decay, w0");
+    check_near(decayed_lamb.data(0, 1), 4.0 + 0.6 * scale, 1e-12, "LAMB weight decay, w1");
+
+    // Test 3: Warmup then constant, linear and cosine decay
+    std::cout << "\n=== Test 3: LRSchedule ===" << std::endl;
+    using Decay = LRSchedule::Decay;
+    const LRSchedule constant(0.3, 2);
+    const LRSchedule linear(1.0, 4, 14, Decay::Linear);
+    const LRSchedule cosine(1.0, 0, 10, Decay::Cosine, 0.1);
+    std::cout << "Constant at 0, 1, 100: " << constant.at(0) << ", " << constant.at(1) << ", " << constant.at(100)
+              << " (expected: 0.15, 0.3, 0.3)" << std::endl;
+    check_near(constant.at(0), 0.15, 1e-12, "constant warmup step 0");
+    check_near(constant.at(1), 0.3, 1e-12, "constant warmup end");
+    check_near(constant.at(100), 0.3, 1e-12, "constant after warmup");
+    std::cout << "Linear at 0, 3, 9, 14, 20: " << linear.at(0) << ", " << linear.at(3) << ", " << linear.at(9)
+              << ", " << linear.at(14) << ", " << linear.at(20) << " (expected: 0.25, 1, 0.5, 0, 0)" << std::endl;
+    check_near(linear.at(0), 0.25, 1e-12, "linear warmup step 0");
+    check_near(linear.at(3), 1.0, 1e-12, "linear warmup end");
+    check_near(linear.at(9), 0.5, 1e-12, "linear halfway");
+    check_near(linear.at(14), 0.0, 1e-12, "linear end");
+    check_near(linear.at(20), 0.0, 1e-12, "linear past the end");
+    std::cout << "Cosine at 0, 5, 10: " << cosine.at(0) << ", " << cosine.at(5) << ", " << cosine.at(10)
+              << " (expected: 1, 0.55, 0.1)" << std::endl;
+    check_near(cosine.at(0), 1.0, 1e-12, "cosine start");
+    check_near(cosine.at(5), 0.55, 1e-12, "cosine halfway");
+    check_near(cosine.at(10), 0.1, 1e-12, "cosine end at min_lr");
+
+    // Test 4: k accumulated micro-batches of b match one batch of k * b, including a short last group
+    std::cout << "\n=== Test 4: Gradient accumulation ===" << std::endl;
+    manual_seed(4);
+    const MNISTLoader loader = make_loader(100);
+    MLP accumulated(6, {8, 3});
+    MLP single = accumulated.clone();
+
+    SGD accumulated_sgd(accumulated.parameters(), 0.1);
+    Trainer accumulated_trainer(accumulated, accumulated_sgd, 8);
+    accumulated_trainer.accumulation_steps = 4;
+    accumulated_trainer.log_interval = 0;
+    accumulated_trainer.schedule = LRSchedule(0.1, 2, 8, Decay::Linear);
+
+    SGD single_sgd(single.parameters(), 0.1);
+    Trainer single_trainer(single, single_sgd, 32);
+    single_trainer.log_interval = 0;
+    single_trainer.schedule = LRSchedule(0.1, 2, 8, Decay::Linear);
+
+    EpochStats a = {};
+    EpochStats b = {};
+    for (int epoch = 0; epoch < 2; ++epoch) {
+        a = accumulated_trainer.train_epoch(loader);
+        b = single_trainer.train_epoch(loader);
+    }
+    std::cout << std::scientific << std::setprecision(2);
+    std::cout << "Steps per epoch: " << a.steps << " vs " << b.steps << " (expected: 4 vs 4)" << std::endl;
+    std::cout << "Weight difference: " << max_difference(accumulated, single) << " (expected: < 1e-12)" << std::endl;
+    std::cout << "Learning rate after 8 steps: " << accumulated_sgd.lr << " (expected: " << single_sgd.lr << ")"
+              << std::endl;
+    check(a.steps == 4 && b.steps == 4, "accumulation gives one step per group");
+    check(max_difference(accumulated, single) < 1e-12, "accumulated weights match the large batch");
+    check_near(a.loss, b.loss, 1e-12, "epoch loss");
+    check(accumulated_sgd.lr == LRSchedule(0.1, 2, 8, Decay::Linear).at(7), "schedule follows optimizer steps");
+
+    return finish();
+}
@@ -0,0 +1,236 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include "engine.hpp"
+#include "nn.hpp"
+#include "loss.hpp"
+#include "optimizer.hpp"
+#include "random.hpp"
+
+// Performance regression test. Measures the training and inference hot paths
+// and compares them with the baselines file given as the first argument:
+//
+//     test_perf tests/perf_baselines.txt            # check
+//     test_perf tests/perf_baselines.txt --update   # record the current numbers
+//
+// ctest runs it only in the perf configuration (ctest -C perf). Baselines are
+// kept per build flavour (optimized or not), since the two differ by an order
+// of magnitude. Metrics without a baseline are reported and pass. Throughput
+// is compared relative to a plain Eigen computation of the same step, timed
+// in the same run, so that a slower or faster machine does not shift it.
+// Allocation counting relies on glibc.
+
+// Every heap allocation, including Eigen's, which calls malloc directly
+// rather than operator new. Counted by wrapping glibc's allocator.
+static std::atomic<long long> allocations{0};
+
+extern "C" void* __libc_malloc(std::size_t size);
+
+extern "C" void* malloc(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+using namespace micrograd;
+
+namespace {
+
+#ifdef __OPTIMIZE__
+const std::string FLAVOUR = "optimized";
+#else
+const std::string FLAVOUR = "unoptimized";
+#endif
+
+// How much worse than the baseline a metric may get before the test fails
+const double MAX_SLOWDOWN = 0.30;
+const double MAX_EXTRA_ALLOCATIONS = 0.10;
+const double MAX_EXTRA_RSS = 0.25;
+
+struct Measurement {
+    double steps_per_sec;
+    double allocations_per_step;
+};
+
+// One timed run of at least min_seconds
+Measurement time_run(const std::function<void()>& step, double min_seconds) {
+    const long long allocations_before = allocations.load();
+    const auto start = std::chrono::steady_clock::now();
+    long long steps = 0;
+    double elapsed = 0.0;
+    do {
+        step();
+        ++steps;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < min_seconds);
+    return {steps / elapsed, double(allocations.load() - allocations_before) / steps};
+}
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    const size_t mid = values.size() / 2;
+    return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2;
+}
+
+// Throughput of each step relative to the reference, as the median over
+// several rounds. Each round times the reference and then every step back to
+// back, so a stall or frequency change hits both sides of a ratio instead of
+// one. Allocations per step are the fewest seen in any round.
+std::vector<Measurement> measure_relative(const std::vector<std::function<void()>>& steps,
+                                          const std::function<void()>& reference, double min_seconds = 0.2,
+                                          int rounds = 9) {
+    for (int i = 0; i < 3; ++i) {
+        reference();
+        for (const auto& step : steps) {
+            step();
+        }
+    }
+    std::vector<std::vector<double>> ratios(steps.size());
+    std::vector<Measurement> result(steps.size(), Measurement{0.0, 1e300});
+    for (int round = 0; round < rounds; ++round) {
+        const double reference_speed = time_run(reference, min_seconds).steps_per_sec;
+        for (size_t i = 0; i < steps.size(); ++i) {
+            const Measurement m = time_run(steps[i], min_seconds);
+            ratios[i].push_back(m.steps_per_sec / reference_speed);
+            result[i].allocations_per_step = std::min(result[i].allocations_per_step, m.allocations_per_step);
+        }
+    }
+    for (size_t i = 0; i < steps.size(); ++i) {
+        result[i].steps_per_sec = median(ratios[i]);
+    }
+    return result;
+}
+
+// Peak resident set size in KiB
+double peak_rss_kb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+std::map<std::string, double> load_baselines(const std::string& path) {
+    std::map<std::string, double> baselines;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        double value;
+        if (line.empty() || line[0] == '#' || !(fields >> key >> value)) {
+            continue;
+        }
+        baselines[key] = value;
+    }
+    return baselines;
+}
+
+bool save_baselines(const std::string& path, const std::map<std::string, double>& baselines) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Error: Cannot write " << path << std::endl;
+        return false;
+    }
+    out << "# Performance baselines for tests/test_perf.cpp: <flavour>.<metric> <value>\n";
+    out << "# Regenerate with: test_perf tests/perf_baselines.txt --update\n";
+    for (const auto& [key, value] : baselines) {
+        out << key << " " << std::fixed << std::setprecision(3) << value << "\n";
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string path = argc > 1 ? argv[1] : "perf_baselines.txt";
+    const bool update = argc > 2 && std::string(argv[2]) == "--update";
+    std::cout << "Performance regression check (" << FLAVOUR << " build)..." << std::endl;
+    manual_seed(3);
+
+    std::map<std::string, double> current;
+
+    // Training step: 784-128-10 MLP, batch of 32, cross-entropy and SGD
+    MLP train_model(784, {128, 10});
+    CrossEntropyLoss criterion;
+    SGD optimizer(train_model.parameters(), 0.01);
+    const Eigen::MatrixXd X = Eigen::MatrixXd::Random(32, 784);
+    const Eigen::VectorXi y = Eigen::VectorXi::LinSpaced(32, 0, 31).unaryExpr([](int i) { return i % 10; });
+    auto train_step = [&]() {
+        optimizer.zero_grad();
+        Value inputs(X);
+        Value loss = criterion.forward(train_model.forward(inputs), y);
+        loss.backward();
+        optimizer.step();
+    };
+
+    // Inference: the same network on a batch of 32 through predict
+    MLP predict_model(784, {128, 10});
+    predict_model.eval();
+    Eigen::MatrixXd predicted;
+    auto predict_step = [&]() { predicted = predict_model.predict(X); };
+
+    // Reference: the same step's matrix products in plain Eigen, without the engine
+    const Eigen::MatrixXd w1 = Eigen::MatrixXd::Random(784, 128);
+    const Eigen::MatrixXd w2 = Eigen::MatrixXd::Random(128, 10);
+    Eigen::MatrixXd h, out, grad_w1, grad_w2;
+    auto reference_step = [&]() {
+        h = (X * w1).cwiseMax(0.0);
+        out = h * w2;
+        grad_w2.noalias() = h.transpose() * out;
+        grad_w1.noalias() = X.transpose() * ((out * w2.transpose()).array() * (h.array() > 0.0).cast<double>()).matrix();
+    };
+
+    const std::vector<Measurement> m = measure_relative({train_step, predict_step}, reference_step);
+    current["mlp_train.relative_speed"] = m[0].steps_per_sec;
+    current["mlp_train.allocations_per_step"] = m[0].allocations_per_step;
+    current["mlp_predict.relative_speed"] = m[1].steps_per_sec;
+    current["mlp_predict.allocations_per_step"] = m[1].allocations_per_step;
+
+    current["peak_rss_kb"] = peak_rss_kb();
+
+    std::map<std::string, double> baselines = load_baselines(path);
+    int failures = 0;
+    std::cout << std::setprecision(3);
+    for (const auto& [metric, value] : current) {
+        const std::string key = FLAVOUR + "." + metric;
+        std::cout << "  " << std::left << std::setw(40) << key << std::right << std::setw(12) << value;
+        auto baseline = baselines.find(key);
+        if (update || baseline == baselines.end()) {
+            std::cout << (update ? "  recorded" : "  no baseline") << std::endl;
+            baselines[key] = value;
+            continue;
+        }
+
+        // Throughput must not drop; allocation counts and memory must not grow
+        bool ok;
+        if (metric.find("relative_speed") != std::string::npos) {
+            ok = value >= baseline->second * (1.0 - MAX_SLOWDOWN);
+        } else if (metric.find("allocations") != std::string::npos) {
+            ok = value <= baseline->second * (1.0 + MAX_EXTRA_ALLOCATIONS) + 1;
+        } else {
+            ok = value <= baseline->second * (1.0 + MAX_EXTRA_RSS);
+        }
+        std::cout << "  baseline " << baseline->second << (ok ? "  ok" : "  REGRESSION") << std::endl;
+        if (!ok) {
+            ++failures;
+        }
+    }
+
+    if (update) {
+        return save_baselines(path, baselines) ? 0 : 1;
+    }
+    if (failures > 0) {
+        std::cout << "\n❌ " << failures << " metrics regressed beyond the allowed threshold" << std::endl;
+        return 1;
+    }
+    std::cout << "\n✅ All tests completed successfully!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <limits>
+#include "engine.hpp"
+#include "optimizer.hpp"
+#include "precision.hpp"
+#include "check.hpp"
+
+using namespace micrograd;
+
+int main() {
+    std::cout << "Testing mixed precision..." << std::endl;
+    std::cout << std::hex << std::showbase;
+
+    // Test 1: FP16 encoding of known values, with round-to-nearest-even
+    std::cout << "\n=== Test 1: FP16 codec ===" << std::endl;
+    std::cout << "1.0 -> " << float_to_fp16(1.0f) << " (expected: 0x3c00)" << std::endl;
+    check(float_to_fp16(1.0f) == 0x3C00, "fp16(1)");
+    check(float_to_fp16(-2.0f) == 0xC000, "fp16(-2)");
+    check(float_to_fp16(65504.0f) == 0x7BFF, "fp16 max");
+    check(float_to_fp16(65520.0f) == 0x7C00, "fp16 overflow to infinity");
+    check(float_to_fp16(1.0f / 3.0f) == 0x3555, "fp16(1/3)");
+    check(float_to_fp16(std::ldexp(1.0f, -24)) == 0x0001, "smallest fp16 subnormal");
+    check(float_to_fp16(std::ldexp(1.0f, -25)) == 0x0000, "half the smallest subnormal rounds to even (0)");
+    check(float_to_fp16(std::ldexp(3.0f, -25)) == 0x0002, "1.5 subnormal steps round to even (2)");
+    check(float_to_fp16(1.0f + std::ldexp(1.0f, -11)) == 0x3C00, "tie rounds down to even");
+    check(float_to_fp16(1.0f + std::ldexp(3.0f, -11)) == 0x3C02, "tie rounds up to even");
+    check(std::isnan(fp16_to_float(float_to_fp16(std::numeric_limits<float>::quiet_NaN()))), "fp16 NaN");
+    check(std::isinf(fp16_to_float(0x7C00)) && fp16_to_float(0xFC00) < 0, "fp16 infinities");
+
+    // Every non-NaN half converts to float and back unchanged
+    int fp16_mismatches = 0;
+    for (uint32_t bits = 0; bits <= 0xFFFF; ++bits) {
+        const bool nan = (bits & 0x7C00) == 0x7C00 && (bits & 0x03FF) != 0;
+        fp16_mismatches += !nan && float_to_fp16(fp16_to_float(static_cast<uint16_t>(bits))) != bits;
+    }
+    std::cout << std::dec << "Round-trip mismatches over all halves: " << fp16_mismatches << " (expected: 0)"
+              << std::endl;
+    check(fp16_mismatches == 0, "fp16 round trip");
+
+    // Test 2: BF16
+    std::cout << std::hex << "\n=== Test 2: BF16 codec ===" << std::endl;
+    std::cout << "1.0 -> " << float_to_bf16(1.0f) << " (expected: 0x3f80)" << std::endl;
+    check(float_to_bf16(1.0f) == 0x3F80, "bf16(1)");
+    check(float_to_bf16(-0.5f) == 0xBF00, "bf16(-0.5)");
+    check(float_to_bf16(1.0f + std::ldexp(1.0f, -8)) == 0x3F80, "tie rounds down to even");
+    check(float_to_bf16(1.0f + std::ldexp(3.0f, -8)) == 0x3F82, "tie rounds up to even");
+    check(std::isnan(bf16_to_float(float_to_bf16(std::numeric_limits<float>::quiet_NaN()))), "bf16 NaN stays NaN");
+    int bf16_mismatches = 0;
+    for (uint32_t bits = 0; bits <= 0xFFFF; ++bits) {
+        const bool nan = (bits & 0x7F80) == 0x7F80 && (bits & 0x007F) != 0;
+        bf16_mismatches += !nan && float_to_bf16(bf16_to_float(static_cast<uint16_t>(bits))) != bits;
+    }
+    std::cout << std::dec << "Round-trip mismatches over all bf16 values: " << bf16_mismatches << " (expected: 0)"
+              << std::endl;
+    check(bf16_mismatches == 0, "bf16 round trip");
+
+    Eigen::MatrixXd m(1, 3);
+    m << 0.1, 1.0 / 3.0, 1e5;
+    check(round_to(m, Precision::FP32) == m.cast<float>().cast<double>(), "round_to FP32");
+    check(round_to(m, Precision::FP64) == m, "round_to FP64 is exact");
+    check(std::isinf(round_to(m, Precision::FP16)(2)), "round_to FP16 overflows 1e5");
+
+    // Test 3: Master weights keep updates smaller than the storage precision can hold
+    std::cout << "\n=== Test 3: Master weights ===" << std::endl;
+    Value w(Eigen::MatrixXd::Ones(2, 2));
+    SGD optimizer({&w}, 1e-4);
+    optimizer.use_master_weights(Precision::BF16);
+    for (int step = 0; step < 100; ++step) {
+        w.grad.setOnes();
+        optimizer.step();
+    }
+    // Each step moves the weight by 1e-4, far below bf16's spacing of 2^-8 near 1
+    std::cout << std::setprecision(6) << "Weight after 100 steps: " << w.data(0, 0) << " (expected: ~0.99)"
+              << std::endl;
+    check_near(w.data(0, 0), 0.99, std::ldexp(1.0, -8), "master weights accumulate small updates");
+    check(round_to(w.data, Precision::BF16) == w.data, "parameters are stored in bf16");
+
+    // Test 4: Dynamic loss scaling
+    std::cout << "\n=== Test 4: DynamicLossScaler ===" << std::endl;
+    DynamicLossScaler scaler(1024.0, 2.0, 0.5, 2);
+    Value p(Eigen::MatrixXd::Zero(1, 2));
+    p.grad << 2048.0, -512.0;
+    const bool first = scaler.unscale({&p});
+    std::cout << "Unscaled gradient: " << p.grad << " (expected: 2 -0.5)" << std::endl;
+    check(first && p.grad(0) == 2.0 && p.grad(1) == -0.5, "gradients divided by the scale");
+    check(scaler.scale == 1024.0, "no growth before growth_interval");
+    p.grad << 1.0, 1.0;
+    scaler.unscale({&p});
+    check(scaler.scale == 2048.0, "growth after growth_interval clean steps");
+    p.grad << std::numeric_limits<double>::infinity(), 1.0;
+    const bool overflow = scaler.unscale({&p});
+    std::cout << "Overflowing step accepted: " << (overflow ? "yes" : "no") << ", scale " << scaler.scale
+              << " (expected: no, 1024)" << std::endl;
+    check(!overflow, "overflow skips the step");
+    check(scaler.scale == 1024.0, "overflow backs off the scale");
+    check(p.grad(1) == 1.0, "skipped step leaves gradients alone");
+    p.grad << 1.0, 1.0;
+    scaler.unscale({&p});
+    check(scaler.scale == 1024.0, "overflow restarts the growth count");
+
+    return finish();
+}
@@ -0,0 +1,185 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include "prune.hpp"
+#include "random.hpp"
+#include "check.hpp"
+
+using namespace micrograd;
+
+namespace {
+
+double zero_fraction(const Eigen::MatrixXd& m) {
+    return (m.array() == 0.0).cast<double>().mean();
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Testing pruning and sparse inference..." << std::endl;
+    std::cout << std::fixed << std::setprecision(4);
+    manual_seed(3);
+
+    // Test 1: Global magnitude pruning
+    std::cout << "\n=== Test 1: Global magnitude pruning ===" << std::endl;
+    MLP model(64, {32, 32, 10});
+    PruningMask mask = prune_magnitude(model, 0.8);
+    long long total = 0, zeros = 0;
+    for (const auto& layer : model.layers) {
+        total += layer.w->data.size();
+        zeros += (layer.w->data.array() == 0.0).count();
+    }
+    std::cout << "Mask sparsity: " << mask.sparsity() << " (expected: ~0.8000)" << std::endl;
+    std::cout << "Zero weights: " << static_cast<double>(zeros) / total << " (expected: ~0.8000)" << std::endl;
+    // He init scales by 1/sqrt(nin), so the wide input layer has the smallest weights
+    std::cout << "Input layer sparsity: " << zero_fraction(model.layers[0].w->data)
+              << " > output layer sparsity: " << zero_fraction(model.layers[2].w->data) << " (expected: true)"
+              << std::endl;
+    check_near(mask.sparsity(), 0.8, 0.01, "mask sparsity");
+    check_near(static_cast<double>(zeros) / total, 0.8, 0.01, "zero weights");
+    check(zero_fraction(model.layers[0].w->data) > zero_fraction(model.layers[2].w->data),
+          "input layer pruned more than output layer");
+
+    // Pruned weights stay zero after an update once the mask is reapplied
+    for (const auto& layer : model.layers) {
+        layer.w->data.array() += 0.5;
+    }
+    mask.apply();
+    zeros = 0;
+    for (const auto& layer : model.layers) {
+        zeros += (layer.w->data.array() == 0.0).count();
+    }
+    std::cout << "Zero weights after update + apply: " << static_cast<double>(zeros) / total << " (expected: ~0.8000)"
+              << std::endl;
+    check_near(static_cast<double>(zeros) / total, 0.8, 0.01, "zero weights after update + apply");
+
+    // Test 2: N:M structured sparsity
+    std::cout << "\n=== Test 2: 2:4 structured sparsity ===" << std::endl;
+    MLP nm_model(64, {32, 10});
+    PruningMask nm_mask = prune_n_m(nm_model, 2, 4);
+    bool pattern_ok = true;
+    for (const auto& layer : nm_model.layers) {
+        const Eigen::MatrixXd& w = layer.w->data;
+        for (Eigen::Index j = 0; j < w.cols(); ++j) {
+            for (Eigen::Index start = 0; start < w.rows(); start += 4) {
+                pattern_ok = pattern_ok && (w.col(j).segment(start, 4).array() != 0.0).count() == 2;
+            }
+        }
+    }
+    std::cout << "Sparsity: " << nm_mask.sparsity() << " (expected: 0.5000)" << std::endl;
+    std::cout << "Every group of 4 keeps exactly 2: " << (pattern_ok ? "true" : "false") << " (expected: true)"
+              << std::endl;
+    check_near(nm_mask.sparsity(), 0.5, 1e-12, "2:4 sparsity");
+    check(pattern_ok, "2:4 pattern");
+    // The kept pair is the largest pair of the original weights
+    manual_seed(5);
+    MLP reference(8, {1});
+    const Eigen::VectorXd original = reference.layers[0].w->data.col(0);
+    prune_n_m(reference, 2, 4);
+    bool largest_kept = true;
+    for (int start = 0; start < 8; start += 4) {
+        for (int a = start; a < start + 4; ++a) {
+            for (int b = start; b < start + 4; ++b) {
+                if (reference.layers[0].w->data(a, 0) != 0.0 && reference.layers[0].w->data(b, 0) == 0.0) {
+                    largest_kept = largest_kept && std::abs(original(a)) >= std::abs(original(b));
+                }
+            }
+        }
+    }
+    std::cout << "Kept weights are the largest in their group: " << (largest_kept ? "true" : "false")
+              << " (expected: true)" << std::endl;
+    check(largest_kept, "kept weights are the largest");
+
+    // Test 3: Neuron pruning shrinks the layers
+    std::cout << "\n=== Test 3: Neuron pruning ===" << std::endl;
+    MLP::Options options;
+    options.batch_norm = true;
+    MLP bn_model(16, {40, 20, 3}, options);
+    bn_model.eval();
+    prune_neurons(bn_model, 0.25);
+    std::cout << "Layer 0: " << bn_model.layers[0].w->data.rows() << "x" << bn_model.layers[0].w->data.cols()
+              << " (expected: 16x30)" << std::endl;
+    std::cout << "Layer 1: " << bn_model.layers[1].w->data.rows() << "x" << bn_model.layers[1].w->data.cols()
+              << " (expected: 30x15)" << std::endl;
+    std::cout << "Layer 2: " << bn_model.layers[2].w->data.rows() << "x" << bn_model.layers[2].w->data.cols()
+              << " (expected: 15x3)" << std::endl;
+    std::cout << "Norm 0 features: " << bn_model.norms[0].gamma->data.cols() << ", running_var "
+              << bn_model.norms[0].running_var.cols() << " (expected: 30, 30)" << std::endl;
+    std::cout << "Bias grad shape: " << bn_model.layers[1].b->grad.cols() << " (expected: 15)" << std::endl;
+    const Eigen::MatrixXd bn_input = Eigen::MatrixXd::Random(5, 16);
+    const Eigen::MatrixXd bn_out = bn_model.predict(bn_input);
+    std::cout << "Predict output: " << bn_out.rows() << "x" << bn_out.cols() << " (expected: 5x3)" << std::endl;
+    check(bn_model.layers[0].w->data.rows() == 16 && bn_model.layers[0].w->data.cols() == 30, "layer 0 shape");
+    check(bn_model.layers[1].w->data.rows() == 30 && bn_model.layers[1].w->data.cols() == 15, "layer 1 shape");
+    check(bn_model.layers[2].w->data.rows() == 15 && bn_model.layers[2].w->data.cols() == 3, "layer 2 shape");
+    check(bn_model.norms[0].gamma->data.cols() == 30 && bn_model.norms[0].running_var.cols() == 30, "norm 0 shape");
+    check(bn_model.layers[1].b->grad.cols() == 15, "bias grad shape");
+    check(bn_out.rows() == 5 && bn_out.cols() == 3, "predict output shape");
+
+    // Test 4: Sparse inference matches the masked dense model
+    std::cout << "\n=== Test 4: SparseMLP matches dense predict ===" << std::endl;
+    const Eigen::MatrixXd x = Eigen::MatrixXd::Random(20, 64);
+    SparseMLP sparse(model);
+    std::cout << "Nonzeros: " << sparse.nonzeros() << " (expected: " << total - zeros << ")" << std::endl;
+    std::cout << "Max difference: " << std::scientific << (sparse.predict(x) - model.predict(x)).cwiseAbs().maxCoeff()
+              << std::fixed << " (expected: ~0)" << std::endl;
+    SparseMLP sparse_bn(bn_model);
+    std::cout << "Max difference with batch norm: " << std::scientific
+              << (sparse_bn.predict(bn_input) - bn_out).cwiseAbs().maxCoeff() << std::fixed << " (expected: ~0)"
+              << std::endl;
+    check(sparse.nonzeros() == total - zeros, "sparse nonzeros");
+    check((sparse.predict(x) - model.predict(x)).cwiseAbs().maxCoeff() < 1e-12, "sparse predict");
+    check((sparse_bn.predict(bn_input) - bn_out).cwiseAbs().maxCoeff() < 1e-12, "sparse predict with batch norm");
+
+    // Test 5: Speed and file size at 90% sparsity
+    std::cout << "\n=== Test 5: 90% sparse 784-256-10 ===" << std::endl;
+    MLP big(784, {256, 10});
+    prune_magnitude(big, 0.9);
+    SparseMLP big_sparse(big);
+    const Eigen::MatrixXd batch = Eigen::MatrixXd::Random(256, 784);
+    const int reps = 5;
+    auto start = std::chrono::steady_clock::now();
+    Eigen::MatrixXd dense_out;
+    for (int r = 0; r < reps; ++r) {
+        dense_out = big.predict(batch);
+    }
+    const double dense_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / reps;
+    start = std::chrono::steady_clock::now();
+    Eigen::MatrixXd sparse_out;
+    for (int r = 0; r < reps; ++r) {
+        sparse_out = big_sparse.predict(batch);
+    }
+    const double sparse_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / reps;
+    std::cout << "Dense: " << dense_ms << " ms, sparse: " << sparse_ms << " ms per batch of 256" << std::endl;
+    std::cout << "Max difference: " << std::scientific << (sparse_out - dense_out).cwiseAbs().maxCoeff() << std::fixed
+              << " (expected: ~0)" << std::endl;
+    check((sparse_out - dense_out).cwiseAbs().maxCoeff() < 1e-12, "90% sparse predict");
+
+    const std::string dense_path = "test_prune_dense.bin";
+    const std::string sparse_path = "test_prune_sparse.bin";
+    big.save_weights(dense_path);
+    const bool saved = big_sparse.save(sparse_path);
+    const auto dense_size = std::filesystem::file_size(dense_path);
+    const auto sparse_size = saved ? std::filesystem::file_size(sparse_path) : 0;
+    std::cout << "Dense file: " << dense_size << " bytes, sparse file: " << sparse_size << " bytes" << std::endl;
+    std::cout << "Sparse file ratio: " << static_cast<double>(sparse_size) / dense_size << " (expected: < 0.2000)"
+              << std::endl;
+    check(saved && static_cast<double>(sparse_size) / dense_size < 0.2, "sparse file ratio");
+
+    SparseMLP reloaded;
+    const bool loaded = reloaded.load(sparse_path);
+    std::cout << "Reload: " << (loaded ? "ok" : "failed") << ", nonzeros " << reloaded.nonzeros() << " (expected: ok, "
+              << big_sparse.nonzeros() << ")" << std::endl;
+    std::cout << "Reloaded max difference: " << std::scientific
+              << (reloaded.predict(batch) - sparse_out).cwiseAbs().maxCoeff() << std::fixed << " (expected: 0)"
+              << std::endl;
+    check(loaded && reloaded.nonzeros() == big_sparse.nonzeros(), "sparse reload");
+    check((reloaded.predict(batch) - sparse_out).cwiseAbs().maxCoeff() == 0.0, "reloaded predict");
+    std::remove(dense_path.c_str());
+    std::remove(sparse_path.c_str());
+
+    return finish();
+}
@@ -0,0 +1,223 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include "rnn.hpp"
+#include "autodiff.hpp"
+#include "loss.hpp"
+#include "optimizer.hpp"
+#include "random.hpp"
+#include "check.hpp"
+
+using namespace micrograd;
+
+namespace {
+
+// Largest relative difference between analytic and central-difference
+// gradients of sum(f() * weights) for every entry of each parameter
+double gradcheck(const std::function<Eigen::MatrixXd()>& f, const std::vector<Value*>& params,
+                 const std::vector<Eigen::MatrixXd>& analytic, const Eigen::MatrixXd& weights) {
+    const double h = 1e-6;
+    double worst = 0.0;
+    for (size_t p = 0; p < params.size(); ++p) {
+        for (Eigen::Index i = 0; i < params[p]->data.size(); ++i) {
+            const double saved = params[p]->data(i);
+            params[p]->data(i) = saved + h;
+            const double up = (f().array() * weights.array()).sum();
+            params[p]->data(i) = saved - h;
+            const double down = (f().array() * weights.array()).sum();
+            params[p]->data(i) = saved;
+            const double numeric = (up - down) / (2 * h);
+            worst = std::max(worst, std::abs(numeric - analytic[p](i)) / std::max(1.0, std::abs(numeric)));
+        }
+    }
+    return worst;
+}
+
+double max_diff(const std::vector<Value>& a, const std::vector<Value>& b) {
+    double worst = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        worst = std::max(worst, (a[i].data - b[i].data).cwiseAbs().maxCoeff());
+    }
+    return worst;
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Testing recurrent layers..." << std::endl;
+    manual_seed(11);
+
+    const int batch = 3, steps = 6, input_size = 4, hidden_size = 5;
+    const Eigen::MatrixXd x_data = Eigen::MatrixXd::Random(steps * batch, input_size);
+    const Eigen::MatrixXd weights = Eigen::MatrixXd::Random(steps * batch, hidden_size);
+
+    // Test 1: RNN gradients against finite differences
+    std::cout << "\n=== Test 1: RNN gradient check ===" << std::endl;
+    RNN rnn(input_size, hidden_size);
+    Value x(x_data);
+    Value out = rnn.forward(x, batch);
+    std::cout << "Output shape: " << out.rows() << "x" << out.cols() << " (expected: 18x5)" << std::endl;
+    std::cout << "Predict matches forward: " << std::scientific
+              << (rnn.predict(x_data, batch) - out.data).cwiseAbs().maxCoeff() << " (expected: 0)" << std::endl;
+    check(out.rows() == 18 && out.cols() == 5, "RNN output shape");
+    check((rnn.predict(x_data, batch) - out.data).cwiseAbs().maxCoeff() < 1e-12, "RNN predict matches forward");
+    (out * Value(weights)).sum().backward();
+    std::vector<Value*> rnn_params = {rnn.w_ih.get(), rnn.w_hh.get(), rnn.b.get()};
+    std::vector<Eigen::MatrixXd> rnn_grads;
+    for (auto* p : rnn_params) {
+        rnn_grads.push_back(p->grad);
+    }
+    Value x_param(x_data);
+    auto rnn_f = [&]() { return rnn.predict(x_param.data, batch); };
+    const double rnn_param_error = gradcheck(rnn_f, rnn_params, rnn_grads, weights);
+    const double rnn_input_error = gradcheck(rnn_f, {&x_param}, {x.grad}, weights);
+    std::cout << "Parameter gradients: " << rnn_param_error << " (expected: < 1e-6)" << std::endl;
+    std::cout << "Input gradient: " << rnn_input_error << " (expected: < 1e-6)" << std::endl;
+    check(rnn_param_error < 1e-6, "RNN parameter gradients");
+    check(rnn_input_error < 1e-6, "RNN input gradient");
+
+    // Test 2: GRU gradients against finite differences
+    std::cout << "\n=== Test 2: GRU gradient check ===" << std::endl;
+    GRU gru(input_size, hidden_size);
+    Value gx(x_data);
+    Value gout = gru.forward(gx, batch);
+    std::cout << "Predict matches forward: " << (gru.predict(x_data, batch) - gout.data).cwiseAbs().maxCoeff()
+              << " (expected: 0)" << std::endl;
+    check((gru.predict(x_data, batch) - gout.data).cwiseAbs().maxCoeff() < 1e-12, "GRU predict matches forward");
+    (gout * Value(weights)).sum().backward();
+    std::vector<Value*> gru_params = gru.parameters();
+    std::vector<Eigen::MatrixXd> gru_grads;
+    for (auto* p : gru_params) {
+        gru_grads.push_back(p->grad);
+    }
+    Value gx_param(x_data);
+    auto gru_f = [&]() { return gru.predict(gx_param.data, batch); };
+    const double gru_param_error = gradcheck(gru_f, gru_params, gru_grads, weights);
+    const double gru_input_error = gradcheck(gru_f, {&gx_param}, {gx.grad}, weights);
+    std::cout << "Parameter gradients: " << gru_param_error << " (expected: < 1e-6)" << std::endl;
+    std::cout << "Input gradient: " << gru_input_error << " (expected: < 1e-6)" << std::endl;
+    check(gru_param_error < 1e-6, "GRU parameter gradients");
+    check(gru_input_error < 1e-6, "GRU input gradient");
+
+    // Test 3: The fused backward matches the unrolled per-op graph that
+    // create_graph differentiates, with and without truncation windows
+    std::cout << "\n=== Test 3: Fused vs unrolled backward ===" << std::endl;
+    for (int window : {0, 2}) {
+        rnn.bptt_window = window;
+        gru.bptt_window = window;
+        Value rx(x_data), ux(x_data);
+        Value seed(weights);
+        Value r_out = rnn.forward(rx, batch);
+        std::vector<Value*> r_inputs = {&rx, rnn.w_ih.get(), rnn.w_hh.get(), rnn.b.get()};
+        const double rnn_diff = max_diff(grad(r_out, r_inputs, &seed), grad(r_out, r_inputs, &seed, true));
+        Value g_out = gru.forward(ux, batch);
+        std::vector<Value*> g_inputs = {&ux, gru.w_ih.get(), gru.w_hh.get(), gru.b_ih.get(),
+                                        gru.b_hh.get()};
+        const double gru_diff = max_diff(grad(g_out, g_inputs, &seed), grad(g_out, g_inputs, &seed, true));
+        std::cout << "Window " << window << ": RNN " << rnn_diff << ", GRU " << gru_diff << " (expected: ~0)"
+                  << std::endl;
+        check(rnn_diff < 1e-12 && gru_diff < 1e-12, "fused vs unrolled backward, window " + std::to_string(window));
+    }
+
+    // Truncation drops the gradient that crosses window boundaries
+    rnn.bptt_window = 2;
+    Value tx(x_data);
+    Eigen::MatrixXd only_last = Eigen::MatrixXd::Zero(steps * batch, hidden_size);
+    only_last.bottomRows(batch).setOnes();
+    (rnn.forward(tx, batch) * Value(only_last)).sum().backward();
+    std::cout << "Input gradient before the last window: " << tx.grad.topRows((steps - 2) * batch).cwiseAbs().maxCoeff()
+              << " (expected: 0)" << std::endl;
+    std::cout << "Input gradient inside the last window is nonzero: "
+              << (tx.grad.bottomRows(2 * batch).cwiseAbs().maxCoeff() > 0 ? "true" : "false") << " (expected: true)"
+              << std::endl;
+    check(tx.grad.topRows((steps - 2) * batch).cwiseAbs().maxCoeff() == 0.0, "no gradient before the last window");
+    check(tx.grad.bottomRows(2 * batch).cwiseAbs().maxCoeff() > 0, "gradient inside the last window");
+    rnn.bptt_window = 0;
+    gru.bptt_window = 0;
+
+    // Test 4: Carrying state across chunks continues the sequence
+    std::cout << "\n=== Test 4: Chunked sequences with carried state ===" << std::endl;
+    Eigen::MatrixXd state = Eigen::MatrixXd::Zero(batch, hidden_size);
+    Value first(x_data.topRows(3 * batch)), second(x_data.bottomRows(3 * batch));
+    Value first_out = gru.forward(first, state);
+    Value second_out = gru.forward(second, state);
+    const Eigen::MatrixXd full = gru.predict(x_data, batch);
+    std::cout << "Chunked vs whole sequence: "
+              << std::max((first_out.data - full.topRows(3 * batch)).cwiseAbs().maxCoeff(),
+                          (second_out.data - full.bottomRows(3 * batch)).cwiseAbs().maxCoeff())
+              << " (expected: 0)" << std::endl;
+    std::cout << "Final state matches last step: "
+              << (state - full.bottomRows(batch)).cwiseAbs().maxCoeff() << " (expected: 0)" << std::endl;
+    check(std::max((first_out.data - full.topRows(3 * batch)).cwiseAbs().maxCoeff(),
+                   (second_out.data - full.bottomRows(3 * batch)).cwiseAbs().maxCoeff()) < 1e-12,
+          "chunked vs whole sequence");
+    check((state - full.bottomRows(batch)).cwiseAbs().maxCoeff() < 1e-12, "final state");
+
+    // Test 5: Long sequences are a single node; long chains of ops no longer recurse
+    std::cout << "\n=== Test 5: Long sequences ===" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    RNN long_rnn(2, 8);
+    Value long_x(Eigen::MatrixXd::Random(20000, 2));
+    auto start = std::chrono::steady_clock::now();
+    long_rnn.forward(long_x, 1).sum().backward();
+    const double long_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "20000-step RNN forward + backward: " << long_ms << " ms, gradient finite: "
+              << (long_rnn.w_hh->grad.allFinite() ? "true" : "false") << " (expected: true)" << std::endl;
+    check(long_rnn.w_hh->grad.allFinite(), "long sequence gradient finite");
+
+    Value chain_in(Eigen::MatrixXd::Ones(1, 1));
+    Value chain = chain_in * 1.0;
+    for (int i = 0; i < 200000; ++i) {
+        chain = chain + 1.0;
+    }
+    chain.backward();
+    std::cout << "200000-op chain gradient: " << chain_in.grad(0, 0) << " (expected: 1.00)" << std::endl;
+    check_near(chain_in.grad(0, 0), 1.0, 1e-12, "long chain gradient");
+
+    // Fused vs per-step Value ops for one training step
+    std::cout << std::setprecision(1);
+    GRU timed(16, 32);
+    const Eigen::MatrixXd timed_x = Eigen::MatrixXd::Random(50 * 16, 16);
+    start = std::chrono::steady_clock::now();
+    Value fused_x(timed_x);
+    timed.forward(fused_x, 16).sum().backward();
+    const double fused_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    Value unrolled_x(timed_x);
+    Value unrolled_out = timed.forward(unrolled_x, 16).sum();
+    grad(unrolled_out, timed.parameters(), nullptr, true);
+    const double unrolled_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "GRU 50 steps x 16: fused " << fused_ms << " ms, per-op graph " << unrolled_ms << " ms" << std::endl;
+
+    // Test 6: A GRU learns to echo the previous step's input
+    std::cout << "\n=== Test 6: Training ===" << std::endl;
+    std::cout << std::setprecision(4);
+    GRU echo(1, 8);
+    Layer readout(8, 1, false);
+    std::vector<Value*> params = echo.parameters();
+    params.push_back(readout.w.get());
+    params.push_back(readout.b.get());
+    LAMB optimizer(params, 0.02);
+    MSELoss mse;
+    const int echo_batch = 16, echo_steps = 8;
+    double first_loss = 0.0, last_loss = 0.0;
+    for (int it = 0; it < 300; ++it) {
+        const Eigen::MatrixXd seq = Eigen::MatrixXd::Random(echo_steps * echo_batch, 1);
+        Eigen::MatrixXd target = Eigen::MatrixXd::Zero(echo_steps * echo_batch, 1);
+        target.bottomRows((echo_steps - 1) * echo_batch) = seq.topRows((echo_steps - 1) * echo_batch);
+        optimizer.zero_grad();
+        Value loss = mse.forward(readout.forward(echo.forward(Value(seq), echo_batch)), Value(target));
+        loss.backward();
+        optimizer.step();
+        if (it == 0) {
+            first_loss = loss.data(0, 0);
+        }
+        last_loss = loss.data(0, 0);
+    }
+    std::cout << "Loss: " << first_loss << " -> " << last_loss << " (expected: < 0.1 of the start)" << std::endl;
+    check(last_loss < 0.1 * first_loss, "GRU echo training");
+
+    return finish();
+}
@@ -0,0 +1,86 @@
+#include <iostream>
+#include <iomanip>
+#include "engine.hpp"
+#include "autodiff.hpp"
+#include "activation.hpp"
+#include "sequential.hpp"
+#include "loss.hpp"
+#include "optimizer.hpp"
+#include "check.hpp"
+
+using namespace micrograd;
+
+int main() {
+    std::cout << "Testing Sequential and activations..." << std::endl;
+
+    // Test 1: Activation gradients against central differences
+    std::cout << "\n=== Test 1: Activation gradients ===" << std::endl;
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(4, 5) * 3.0;
+    for (const char* name : {"sigmoid", "tanh", "gelu", "leaky_relu", "silu"}) {
+        const Activation act = *activation_from_name(name);
+        Value x(X);
+        Value y = activate(act, x).sum();
+        Eigen::MatrixXd dx = grad(y, {&x})[0].data;
+        Value dy = grad(y, {&x}, nullptr, true)[0];
+        Eigen::MatrixXd dx_graph = dy.data;
+
+        const double h = 1e-6;
+        Eigen::MatrixXd fd = (activate(act, Eigen::MatrixXd(X.array() + h)) -
+                              activate(act, Eigen::MatrixXd(X.array() - h))) / (2 * h);
+        const double error = std::max((dx - fd).cwiseAbs().maxCoeff(), (dx_graph - fd).cwiseAbs().maxCoeff());
+        std::cout << std::setw(10) << activation_name(act) << ": max error " << std::scientific << std::setprecision(2)
+                  << error << " (expected: < 1e-8)" << std::endl;
+        check(error < 1e-8, std::string(name) + " gradient");
+    }
+
+    // Test 2: Shape inference and mismatch detection
+    std::cout << "\n=== Test 2: Shape inference ===" << std::endl;
+    Sequential model(6);
+    model.linear(32, Activation::GELU).batch_norm().dropout(0.1).linear(16).activation(Activation::Tanh).linear(3);
+    std::cout << "Modules: " << model.modules.size() << " (expected: 6)" << std::endl;
+    std::cout << "Features: " << model.in_features() << " -> " << model.out_features() << " (expected: 6 -> 3)"
+              << std::endl;
+    std::cout << "Parameter matrices: " << model.parameters().size() << " (expected: 8)" << std::endl;
+    const bool accepted = model.add(Layer(4, 2, false));
+    std::cout << "Mismatched add accepted: " << (accepted ? "yes" : "no") << " (expected: no)" << std::endl;
+    check(model.modules.size() == 6, "module count");
+    check(model.in_features() == 6 && model.out_features() == 3, "features 6 -> 3");
+    check(model.parameters().size() == 8, "parameter matrices");
+    check(!accepted, "mismatched add rejected");
+
+    // Test 3: Training and eval-mode consistency
+    std::cout << "\n=== Test 3: Training ===" << std::endl;
+    Eigen::MatrixXd data = Eigen::MatrixXd::Random(64, 6);
+    Eigen::VectorXi labels(64);
+    for (int i = 0; i < 64; ++i) {
+        labels(i) = data(i, 0) > 0.3 ? 0 : (data(i, 1) > 0.0 ? 1 : 2);
+    }
+
+    CrossEntropyLoss criterion;
+    NesterovSGD optimizer(model.parameters(), 0.1, 0.9);
+    double first_loss = 0.0, last_loss = 0.0;
+    for (int step = 0; step < 100; ++step) {
+        optimizer.zero_grad();
+        Value loss = criterion.forward(model.forward(Value(data)), labels);
+        loss.backward();
+        optimizer.step();
+        (step == 0 ? first_loss : last_loss) = loss.data(0, 0);
+    }
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Loss: " << first_loss << " -> " << last_loss << " (expected: decreasing)" << std::endl;
+    check(last_loss < first_loss, "loss decreased");
+
+    model.eval();
+    Sequential copy = model.clone();
+    copy.parameters()[0]->data.setZero();
+    Value logits = model.forward(Value(data));
+    std::cout << std::scientific << std::setprecision(2);
+    std::cout << "forward vs predict in eval mode: " << (logits.data - model.predict(data)).cwiseAbs().maxCoeff()
+              << " (expected: ~0)" << std::endl;
+    std::cout << "Clone shares weights: " << (copy.predict(data).isApprox(model.predict(data)) ? "yes" : "no")
+              << " (expected: no)" << std::endl;
+    check((logits.data - model.predict(data)).cwiseAbs().maxCoeff() < 1e-12, "eval forward matches predict");
+    check(!copy.predict(data).isApprox(model.predict(data)), "clone has its own weights");
+
+    return finish();
+}
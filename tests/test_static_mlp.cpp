@@ -0,0 +1,162 @@
+#include <iostream>
+#include <cstdio>
+#include <memory>
+#include "static_mlp.hpp"
+#include "loss.hpp"
+#include "optimizer.hpp"
+#include "random.hpp"
+#include "check.hpp"
+
+using namespace micrograd;
+
+namespace {
+
+using Net = StaticMLP<6, 8, 5, 3>;
+
+double max_difference(const std::vector<Eigen::MatrixXd>& a, const std::vector<Eigen::MatrixXd>& b) {
+    double diff = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        diff = std::max(diff, (a[i] - b[i]).cwiseAbs().maxCoeff());
+    }
+    return diff;
+}
+
+std::vector<Eigen::MatrixXd> weights_of(Net& net) {
+    std::vector<Eigen::MatrixXd> result;
+    std::apply([&result](auto&... layer) {
+        ((result.emplace_back(layer.weight()), result.emplace_back(layer.bias())), ...);
+    }, net.layers);
+    return result;
+}
+
+std::vector<Eigen::MatrixXd> grads_of(Net& net) {
+    std::vector<Eigen::MatrixXd> result;
+    std::apply([&result](auto&... layer) {
+        ((result.emplace_back(layer.weight_grad()), result.emplace_back(layer.bias_grad())), ...);
+    }, net.layers);
+    return result;
+}
+
+std::vector<Eigen::MatrixXd> weights_of(MLP& model) {
+    std::vector<Eigen::MatrixXd> result;
+    for (auto* p : model.parameters()) {
+        result.push_back(p->data);
+    }
+    return result;
+}
+
+std::vector<Eigen::MatrixXd> grads_of(MLP& model) {
+    std::vector<Eigen::MatrixXd> result;
+    for (auto* p : model.parameters()) {
+        result.push_back(p->grad);
+    }
+    return result;
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Testing StaticMLP..." << std::endl;
+    manual_seed(31);
+
+    auto net = std::make_unique<Net>();
+    MLP model(6, {8, 5, 3});
+    net->copy_to(model);
+
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(10, 6);
+    Eigen::VectorXi labels(10);
+    labels << 0, 1, 2, 0, 1, 2, 0, 1, 2, 0;
+
+    // Test 1: Same logits as MLP with the same weights
+    std::cout << "\n=== Test 1: Forward ===" << std::endl;
+    const Eigen::MatrixXd logits = net->forward(X);
+    const double forward_error = (logits - model.forward(Value(X)).data).cwiseAbs().maxCoeff();
+    std::cout << "Max logit difference: " << forward_error << " (expected: ~0)" << std::endl;
+    check(forward_error < 1e-12, "forward matches MLP");
+
+    // Test 2: Cross-entropy loss and parameter gradients match autograd
+    std::cout << "\n=== Test 2: Cross-entropy backward ===" << std::endl;
+    CrossEntropyLoss criterion;
+    model.zero_grad();
+    Value loss = criterion.forward(model.forward(Value(X)), labels);
+    loss.backward();
+    const double static_loss = net->cross_entropy_backward(labels);
+    const double grad_error = max_difference(grads_of(*net), grads_of(model));
+    std::cout << "Loss: " << static_loss << " (expected: " << loss.data(0, 0) << ")" << std::endl;
+    std::cout << "Max gradient difference: " << grad_error << " (expected: ~0)" << std::endl;
+    check_near(static_loss, loss.data(0, 0), 1e-12, "cross-entropy loss");
+    check(grad_error < 1e-12, "cross-entropy gradients match MLP");
+
+    // Test 3: backward() with an arbitrary upstream gradient
+    std::cout << "\n=== Test 3: Backward ===" << std::endl;
+    const Eigen::MatrixXd upstream = Eigen::MatrixXd::Random(10, 3);
+    model.zero_grad();
+    (model.forward(Value(X)) * Value(upstream)).sum().backward();
+    net->forward(X);
+    net->backward(upstream);
+    const double upstream_error = max_difference(grads_of(*net), grads_of(model));
+    std::cout << "Max gradient difference: " << upstream_error << " (expected: ~0)" << std::endl;
+    check(upstream_error < 1e-12, "backward matches MLP");
+
+    // Test 4: An SGD step on the same gradients gives the same weights
+    std::cout << "\n=== Test 4: SGD step ===" << std::endl;
+    SGD sgd(model.parameters(), 0.1);
+    sgd.step();
+    net->sgd_step(0.1);
+    const double step_error = max_difference(weights_of(*net), weights_of(model));
+    std::cout << "Max weight difference: " << step_error << " (expected: ~0)" << std::endl;
+    check(step_error < 1e-12, "sgd_step matches SGD");
+
+    // Test 5: Weight files round trip and are interchangeable with MLP
+    std::cout << "\n=== Test 5: Save and load ===" << std::endl;
+    const std::string path = "test_static_mlp.bin";
+    net->save_weights(path);
+    auto loaded = std::make_unique<Net>();
+    loaded->load_weights(path);
+    MLP from_static(6, {8, 5, 3});
+    from_static.load_weights(path);
+    std::cout << "Static round trip difference: " << max_difference(weights_of(*loaded), weights_of(*net))
+              << " (expected: 0)" << std::endl;
+    std::cout << "MLP load difference: " << max_difference(weights_of(from_static), weights_of(*net))
+              << " (expected: 0)" << std::endl;
+    check(max_difference(weights_of(*loaded), weights_of(*net)) == 0.0, "StaticMLP save/load round trip");
+    check(max_difference(weights_of(from_static), weights_of(*net)) == 0.0, "MLP loads StaticMLP weights");
+
+    MLP other(6, {8, 5, 3});
+    other.save_weights(path);
+    loaded->load_weights(path);
+    check(max_difference(weights_of(*loaded), weights_of(other)) == 0.0, "StaticMLP loads MLP weights");
+
+    // A file for another topology is rejected and leaves the weights alone
+    MLP smaller(6, {4, 3});
+    smaller.save_weights(path);
+    const auto before = weights_of(*loaded);
+    loaded->load_weights(path);
+    std::cout << "Weights changed by a mismatched file: "
+              << (max_difference(weights_of(*loaded), before) == 0.0 ? "no" : "yes") << " (expected: no)" << std::endl;
+    check(max_difference(weights_of(*loaded), before) == 0.0, "mismatched file rejected");
+    std::remove(path.c_str());
+
+    // Test 6: copy_from and copy_to with a model whose middle layer differs copy nothing
+    std::cout << "\n=== Test 6: copy_from/copy_to shape mismatch ===" << std::endl;
+    MLP narrower(6, {8, 4, 3});
+    const bool copied = loaded->copy_from(narrower);
+    std::cout << "Copied: " << (copied ? "yes" : "no") << " (expected: no)" << std::endl;
+    std::cout << "Weights changed by the failed copy: "
+              << (max_difference(weights_of(*loaded), before) == 0.0 ? "no" : "yes") << " (expected: no)" << std::endl;
+    check(!copied, "mismatched copy_from fails");
+    check(max_difference(weights_of(*loaded), before) == 0.0, "failed copy_from leaves every layer alone");
+
+    // copy_to a model of the same depth but other widths writes nothing
+    const auto narrower_before = weights_of(narrower);
+    const bool copied_to = loaded->copy_to(narrower);
+    std::cout << "Copied to: " << (copied_to ? "yes" : "no") << " (expected: no)" << std::endl;
+    check(!copied_to, "mismatched copy_to fails");
+    check(max_difference(weights_of(narrower), narrower_before) == 0.0, "failed copy_to leaves every layer alone");
+
+    // A successful copy_to writes into the existing buffers
+    const double* model_buffer = model.parameters()[0]->data.data();
+    check(net->copy_to(model) && model.parameters()[0]->data.data() == model_buffer, "copy_to keeps the buffers");
+
+    return finish();
+}
@@ -0,0 +1,160 @@
+#include <iostream>
+#include <iomanip>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include "trainer.hpp"
+#include "random.hpp"
+#include "check.hpp"
+
+using namespace micrograd;
+
+namespace {
+
+// A loader over synthetic pixels where the label is the brightest of the first three
+MNISTLoader make_loader(const int n) {
+    MNISTLoader loader;
+    loader.num_images = n;
+    loader.image_rows = 1;
+    loader.image_cols = 6;
+    loader.images = (Eigen::MatrixXd::Random(n, 6).array() + 1.0) * 127.5;
+    loader.labels.resize(n);
+    for (int i = 0; i < n; ++i) {
+        loader.images.row(i).head(3).maxCoeff(&loader.labels(i));
+    }
+    return loader;
+}
+
+double max_difference(MLP& a, MLP& b) {
+    double diff = 0.0;
+    auto sa = a.state();
+    auto sb = b.state();
+    for (size_t i = 0; i < sa.size(); ++i) {
+        diff = std::max(diff, (*sa[i] - *sb[i]).cwiseAbs().maxCoeff());
+    }
+    return diff;
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Testing Trainer..." << std::endl;
+    std::cout << std::scientific << std::setprecision(2);
+    manual_seed(9);
+    const MNISTLoader loader = make_loader(100);
+
+    // Test 1: clone copies weights and buffers into new storage
+    std::cout << "\n=== Test 1: MLP::clone ===" << std::endl;
+    MLP::Options options;
+    options.batch_norm = true;
+    MLP original(6, {12, 3}, options);
+    original.norms[0].running_mean.setRandom();
+    MLP copy = original.clone();
+    std::cout << "Clone state difference: " << max_difference(original, copy) << " (expected: 0)" << std::endl;
+    check(max_difference(original, copy) == 0.0, "clone copies weights and buffers");
+    copy.layers[0].w->data.setZero();
+    copy.norms[0].gamma->data.setZero();
+    copy.norms[0].running_mean.setZero();
+    const bool independent = original.layers[0].w->data.cwiseAbs().maxCoeff() > 0 &&
+                             original.norms[0].gamma->data.cwiseAbs().maxCoeff() > 0 &&
+                             original.norms[0].running_mean.cwiseAbs().maxCoeff() > 0;
+    std::cout << "Original unchanged after editing the clone: " << (independent ? "yes" : "no") << " (expected: yes)"
+              << std::endl;
+    check(independent, "clone storage is independent");
+    check(copy.parameters()[0] != original.parameters()[0], "clone has its own parameter Values");
+
+    // Test 2: An epoch is the same as a hand-written SGD loop over the same batches
+    std::cout << "\n=== Test 2: train_epoch vs manual loop ===" << std::endl;
+    MLP model(6, {12, 3});
+    MLP manual = model.clone();
+    SGD optimizer(model.parameters(), 0.1);
+    Trainer trainer(model, optimizer, 32);
+    trainer.log_interval = 0;
+    EpochStats stats = trainer.train_epoch(loader);
+
+    SGD manual_optimizer(manual.parameters(), 0.1);
+    CrossEntropyLoss criterion;
+    for (int b = 0; b < loader.get_num_batches(32); ++b) {
+        Eigen::MatrixXd images;
+        Eigen::VectorXi labels;
+        loader.get_batch(b, 32, images, labels);
+        manual_optimizer.zero_grad();
+        criterion.forward(manual.forward(Value(images)), labels).backward();
+        manual_optimizer.step();
+    }
+    std::cout << "Steps: " << stats.steps << ", samples: " << stats.samples << " (expected: 4, 100)" << std::endl;
+    std::cout << "Difference from the manual loop: " << max_difference(model, manual) << " (expected: ~0)"
+              << std::endl;
+    check(stats.steps == 4 && stats.samples == 100, "steps and samples");
+    check(max_difference(model, manual) < 1e-12, "train_epoch matches the manual loop");
+
+    double last_loss = stats.loss;
+    for (int e = 0; e < 30; ++e) {
+        last_loss = trainer.train_epoch(loader).loss;
+    }
+    std::cout << std::fixed << std::setprecision(4) << "Loss: " << stats.loss << " -> " << last_loss
+              << " (expected: decreasing)" << std::endl;
+    check(last_loss < stats.loss, "loss decreased");
+
+    // Test 3: Evaluation runs on a snapshot while training continues
+    std::cout << "\n=== Test 3: Asynchronous evaluation ===" << std::endl;
+    MLP weights_at_start = model.clone();
+    trainer.start_evaluation(loader);
+    const bool pending = trainer.evaluation_pending();
+    trainer.train_epoch(loader);
+    const EvalStats eval = trainer.wait_evaluation();
+    const EvalStats expected = Trainer::evaluate(weights_at_start, loader, 32);
+    std::cout << "Pending after start: " << (pending ? "yes" : "no") << " (expected: yes)" << std::endl;
+    std::cout << "Epoch: " << eval.epoch << ", total: " << eval.total << " (expected: 30, 100)" << std::endl;
+    std::cout << "Accuracy: " << eval.accuracy << " (expected: " << expected.accuracy << ")" << std::endl;
+    check(pending, "evaluation pending after start");
+    check(eval.epoch == 30 && eval.total == 100, "evaluated epoch and sample count");
+    check(eval.correct == expected.correct && eval.log_loss == expected.log_loss,
+          "evaluation used the weights from when it started");
+    check(max_difference(trainer.snapshot(), weights_at_start) == 0.0, "snapshot holds the evaluated weights");
+    check(max_difference(model, weights_at_start) > 0.0, "training continued during evaluation");
+    check(!trainer.evaluation_pending() && trainer.wait_evaluation().epoch == -1, "no evaluation left pending");
+
+    // Test 4: One prefetch thread serves every epoch, in order, and reports load failures
+    std::cout << "\n=== Test 4: Batch prefetcher ===" << std::endl;
+    BatchPrefetcher prefetcher;
+    std::set<std::thread::id> loader_threads;
+    bool in_order = true;
+    for (int e = 0; e < 3; ++e) {
+        prefetcher.start(5, [&](const int batch_idx, Eigen::MatrixXd& images, Eigen::VectorXi& labels) {
+            loader_threads.insert(std::this_thread::get_id());
+            images = Eigen::MatrixXd::Constant(2, 2, batch_idx);
+            labels = Eigen::VectorXi::Constant(2, batch_idx);
+        });
+        Eigen::MatrixXd images;
+        Eigen::VectorXi labels;
+        for (int b = 0; b < 5; ++b) {
+            prefetcher.next(images, labels);
+            in_order = in_order && images(0, 0) == b && labels(0) == b;
+        }
+        prefetcher.stop();
+    }
+    prefetcher.start(5, [](const int batch_idx, Eigen::MatrixXd& images, Eigen::VectorXi&) {
+        if (batch_idx == 1) {
+            throw std::runtime_error("unreadable batch");
+        }
+        images = Eigen::MatrixXd::Zero(2, 2);
+    });
+    Eigen::MatrixXd images;
+    Eigen::VectorXi labels;
+    prefetcher.next(images, labels);
+    bool rethrown = false;
+    try {
+        prefetcher.next(images, labels);
+    } catch (const std::runtime_error&) {
+        rethrown = true;
+    }
+    prefetcher.stop();
+    std::cout << "Loader threads over 3 epochs: " << loader_threads.size() << " (expected: 1)" << std::endl;
+    std::cout << "Load error rethrown: " << (rethrown ? "yes" : "no") << " (expected: yes)" << std::endl;
+    check(loader_threads.size() == 1, "one thread loads every batch");
+    check(in_order, "batches arrive in order");
+    check(rethrown, "load error reaches next()");
+
+    return finish();
+}
@@ -4,6 +4,7 @@
 #include "nn.hpp"
 #include "loss.hpp"
 #include "optimizer.hpp"
+#include "check.hpp"
 
 using namespace micrograd;
 
@@ -28,9 +29,11 @@ int main() {
     auto params = model.parameters();
     std::cout << "Number of parameter matrices: " << params.size() << std::endl;
     std::cout << "First weight matrix (first 2x2 block):\n" << params[0]->data.block(0, 0, 2, 2) << std::endl;
+    const Eigen::MatrixXd initial_weights = params[0]->data;
 
     // Training for a few iterations
     std::cout << "\nTraining for 5 iterations..." << std::endl;
+    double first_loss = 0.0, last_loss = 0.0;
     for (int iter = 0; iter < 5; ++iter) {
         optimizer.zero_grad();
 
@@ -43,6 +46,11 @@ int main() {
         // Check if gradients are computed BEFORE step
         std::cout << "Iter " << iter + 1 << " - Loss: " << std::fixed << std::setprecision(4) << loss.data(0, 0);
         std::cout << ", Grad norm (first param): " << params[0]->grad.norm() << std::endl;
+        check(params[0]->grad.norm() > 0.0, "first parameter has a gradient");
+        if (iter == 0) {
+            first_loss = loss.data(0, 0);
+        }
+        last_loss = loss.data(0, 0);
 
         optimizer.step();
     }
@@ -50,8 +58,9 @@ int main() {
     std::cout << "\nAfter training:" << std::endl;
     std::cout << "First weight matrix (first 2x2 block):\n" << params[0]->data.block(0, 0, 2, 2) << std::endl;
 
-    // Verify parameters changed
-    std::cout << "\n✅ If parameters changed and loss decreased, training works correctly!" << std::endl;
+    // Verify parameters changed and loss decreased
+    check(params[0]->data != initial_weights, "parameters changed");
+    check(last_loss < first_loss, "loss decreased");
 
-    return 0;
+    return finish();
 }